@@ -262,26 +262,24 @@ int Log_Create_Record_Timestamp_Set(struct tm time_tm,struct Log_Record_Struct *
 	return TRUE; 
 }
 
-/* ---------------------------------------------------------------
-**  Internal functions 
-** --------------------------------------------------------------- */
 /**
- * Fill in the timestamp field of the log record with the current time.
- * @param log_record A pointer to the log record instance.
+ * Get the current time, in the form used for a log record's timestamp (milliseconds since 1970).
+ * @param timestamp The address of an int64_t to fill in with the current time.
  * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #ONE_MICROSECOND_NS
+ * @see #ONE_MILLISECOND_NS
  */
-static int Log_Create_Timestamp(struct Log_Record_Struct *log_record)
+int Log_Create_Timestamp_Get(int64_t *timestamp)
 {
 	struct timespec current_time;
 #ifndef _POSIX_TIMERS
 	struct timeval gtod_current_time;
 #endif
-	int64_t long_current_time;
 
-	if(log_record == NULL)
+	if(timestamp == NULL)
 	{
-		Log_Error_Number = 109;
-		sprintf(Log_Error_String,"Log_Create_Timestamp:log_record was NULL.");
+		Log_Error_Number = 112;
+		sprintf(Log_Error_String,"Log_Create_Timestamp_Get:timestamp was NULL.");
 		return FALSE;
 	}
 #ifdef _POSIX_TIMERS
@@ -291,11 +289,62 @@ static int Log_Create_Timestamp(struct Log_Record_Struct *log_record)
 	current_time.tv_sec = gtod_current_time.tv_sec;
 	current_time.tv_nsec = gtod_current_time.tv_usec*ONE_MICROSECOND_NS;
 #endif
-	long_current_time = (((int64_t)current_time.tv_sec)*1000)+
-		(((int64_t)current_time.tv_nsec)/ONE_MILLISECOND_NS);
-	log_record->Timestamp = long_current_time;
+	(*timestamp) = (((int64_t)current_time.tv_sec)*1000)+(((int64_t)current_time.tv_nsec)/ONE_MILLISECOND_NS);
 	return TRUE;
 }
+
+/**
+ * Get the current time in microseconds since 1970, for the version 2 wire format's optional microsecond
+ * timestamps.
+ * @param timestamp_us The address of an int64_t to fill in with the current time.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #ONE_MICROSECOND_NS
+ * @see log_udp_wire.html#LOG_UDP_V2_FLAG_MICROSECONDS
+ */
+int Log_Create_Timestamp_Us_Get(int64_t *timestamp_us)
+{
+	struct timespec current_time;
+#ifndef _POSIX_TIMERS
+	struct timeval gtod_current_time;
+#endif
+
+	if(timestamp_us == NULL)
+	{
+		Log_Error_Number = 113;
+		sprintf(Log_Error_String,"Log_Create_Timestamp_Us_Get:timestamp_us was NULL.");
+		return FALSE;
+	}
+#ifdef _POSIX_TIMERS
+	clock_gettime(CLOCK_REALTIME,&current_time);
+#else
+	gettimeofday(&gtod_current_time,NULL);
+	current_time.tv_sec = gtod_current_time.tv_sec;
+	current_time.tv_nsec = gtod_current_time.tv_usec*ONE_MICROSECOND_NS;
+#endif
+	(*timestamp_us) = (((int64_t)current_time.tv_sec)*1000000)+
+		(((int64_t)current_time.tv_nsec)/ONE_MICROSECOND_NS);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions 
+** --------------------------------------------------------------- */
+/**
+ * Fill in the timestamp field of the log record with the current time.
+ * @param log_record A pointer to the log record instance.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_Create_Timestamp_Get
+ */
+static int Log_Create_Timestamp(struct Log_Record_Struct *log_record)
+{
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 109;
+		sprintf(Log_Error_String,"Log_Create_Timestamp:log_record was NULL.");
+		return FALSE;
+	}
+	return Log_Create_Timestamp_Get(&(log_record->Timestamp));
+}
 /*
 ** $Log: not supported by cvs2svn $
 ** Revision 1.1  2009/01/09 14:54:37  cjm
@@ -25,14 +25,16 @@
 
 /* external variables */
 /**
- * The error number.
+ * The error number. Each thread has it's own copy.
+ * @see #LOG_GENERAL_THREAD
  */
-int Log_Error_Number = 0;
+LOG_GENERAL_THREAD int Log_Error_Number = 0;
 /**
- * The error string.
+ * The error string. Each thread has it's own copy.
  * @see #LOG_GENERAL_ERROR_LENGTH
+ * @see #LOG_GENERAL_THREAD
  */
-char Log_Error_String[LOG_GENERAL_ERROR_LENGTH];
+LOG_GENERAL_THREAD char Log_Error_String[LOG_GENERAL_ERROR_LENGTH];
 
 /* internal variables */
 /**
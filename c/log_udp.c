@@ -8,10 +8,16 @@
  * @version $Revision: 1.7 $
  */
 /**
- * Define BSD Source to get BSD prototypes, including gethostbyname_r.
+ * Define BSD Source to get BSD prototypes, including inet_aton.
  */
 #define _BSD_SOURCE (1)
 #ifdef __linux
+/**
+ * Define GNU Source to get the sendmmsg prototype under Linux.
+ */
+#define _GNU_SOURCE (1)
+#endif
+#ifdef __linux
 #include <endian.h>  /* Used to determine whether to byte swap to get network byte order */ 
 #include <byteswap.h> /* Get machine dependent optimized versions of byte swapping functions.  */
 #endif
@@ -29,49 +35,183 @@
 #include <netinet/in.h> /* htons etc */
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h> /* struct iovec */
 #include <unistd.h>
 #include "log_general.h"
 #include "log_udp.h"
+#include "log_udp_coalesce.h"
+#include "log_udp_fragment.h"
+#include "log_udp_rate.h"
+#include "log_udp_resolve.h"
 
 /* hash defines */
 /**
- * Magic word (4 bytes) to distinguish Java and C packets.
+ * The maximum number of records Log_UDP_Send_Batch encodes and passes to the kernel in one sendmmsg call.
+ */
+#define UDP_BATCH_LENGTH                       (64)
+/**
+ * The maximum number of iovecs Log_UDP_Send_Record_Gather puts on the stack. Records needing more
+ * (those with lots of contexts) are sent using Log_UDP_Send_Record instead.
+ * @see #LOG_UDP_IOVEC_LENGTH
+ */
+#define UDP_GATHER_IOVEC_LENGTH                (128)
+/**
+ * The maximum number of destinations Log_UDP_Send_Encoded_List passes to the kernel in one sendmmsg call.
+ */
+#define UDP_DESTINATION_BATCH_LENGTH           (16)
+/**
+ * The default multicast time to live: multicast packets stay on the local subnet.
+ */
+#define UDP_DEFAULT_MULTICAST_TTL              (1)
+/**
+ * The length of an IPv4 header and a UDP header, subtracted from the path MTU to get the longest datagram.
+ */
+#define UDP_IPV4_HEADER_LENGTH                 (28)
+/**
+ * The length of an IPv6 header and a UDP header, subtracted from the path MTU to get the longest datagram.
+ */
+#define UDP_IPV6_HEADER_LENGTH                 (48)
+/**
+ * The maximum number of contexts in a rate limiter or coalescer summary record sent over a socket.
+ * @see #UDP_Summary_Send
  */
-#define UDP_PACKET_MAGIC_WORD                  (0xC0C0)
+#define UDP_SUMMARY_CONTEXT_COUNT              (8)
+
+/* structures */
+/**
+ * Per-thread buffer used by Log_UDP_Send to encode packets into.
+ * <dl>
+ * <dt>Buffer</dt> <dd>The allocated buffer.</dd>
+ * <dt>Length</dt> <dd>The allocated length of Buffer in bytes.</dd>
+ * </dl>
+ */
+struct Send_Buffer_Struct
+{
+	char *Buffer;
+	size_t Length;
+};
+
+/* external variables */
+/**
+ * The process-wide severity filter. Log records with a lower severity are not sent.
+ * @see #Log_UDP_Filter_Set
+ * @see #Log_UDP_Is_Enabled
+ */
+int Log_UDP_Filter_Severity = LOG_SEVERITY_INFO;
+/**
+ * The process-wide verbosity filter. Log records with a higher (more verbose) verbosity are not sent.
+ * @see #Log_UDP_Filter_Set
+ * @see #Log_UDP_Is_Enabled
+ */
+int Log_UDP_Filter_Verbosity = LOG_VERBOSITY_VERY_VERBOSE;
 
 /* internal variables */
 /**
  * Revision Control System identifier.
  */
 static char rcsid[] = "$Id: log_udp.c,v 1.7 2012-03-07 10:50:48 cjm Exp $";
+/**
+ * Thread specific data key, used to find the calling thread's Send_Buffer_Struct.
+ * @see #Send_Buffer_Struct
+ */
+static pthread_key_t Send_Buffer_Key;
+/**
+ * Used to make sure Send_Buffer_Key is only created once.
+ * @see #Send_Buffer_Key
+ * @see #Send_Buffer_Key_Create
+ */
+static pthread_once_t Send_Buffer_Key_Once = PTHREAD_ONCE_INIT;
+/**
+ * The time to live (hop limit) given to sockets sending to a multicast group.
+ * @see #Log_UDP_Multicast_Set
+ * @see #UDP_DEFAULT_MULTICAST_TTL
+ */
+static int Multicast_TTL = UDP_DEFAULT_MULTICAST_TTL;
+/**
+ * Whether multicast packets are looped back to receivers on the sending machine (TRUE), or not (FALSE).
+ * @see #Log_UDP_Multicast_Set
+ */
+static int Multicast_Loopback = TRUE;
+/**
+ * The address of the local interface multicast packets are sent from, or INADDR_ANY to let the
+ * routing table choose.
+ * @see #Log_UDP_Multicast_Set
+ */
+static struct in_addr Multicast_Interface = {INADDR_ANY};
+/**
+ * Whether sockets opened by Log_UDP_Open are non-blocking (TRUE), or not (FALSE).
+ * @see #Log_UDP_Socket_Options_Set
+ */
+static int Socket_Non_Blocking = FALSE;
+/**
+ * The send buffer length (SO_SNDBUF) given to sockets opened by Log_UDP_Open, in bytes,
+ * or 0 to use the system default.
+ * @see #Log_UDP_Socket_Options_Set
+ */
+static int Socket_Send_Buffer_Length = 0;
+/**
+ * The process-wide send counters. Updated with atomic adds, as any thread can send.
+ * @see #Log_UDP_Send_Stats_Get
+ * @see #UDP_Send_Count
+ * @see #UDP_Send_Drop
+ */
+static struct Log_UDP_Send_Stats_Struct Send_Stats;
+/**
+ * The longest datagram sent before a packet is split into fragments, in bytes, 0 to never fragment packets,
+ * or LOG_UDP_FRAGMENT_PATH_MTU to fragment packets that don't fit in the socket's path MTU.
+ * @see #Log_UDP_Fragment_Set
+ */
+static int Fragment_Length = 0;
 
 /* internal function declarations */
-static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len);
+static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len,int *dropped);
 static int UDP_Raw_Recv(int socket_id,char *message_buff,size_t message_buff_len);
 static int64_t hton64bitl(int64_t n);
-static int Get_Host_By_Name(const char *name,struct in_addr *inaddr);
+static void UDP_Send_Count(int packet_count,size_t byte_count);
+static int UDP_Send_Drop(int send_errno);
+static int UDP_Fragment_Length_Get(int socket_id,size_t message_buff_len,size_t *datagram_length);
+static int UDP_Fragment_Send(int socket_id,struct sockaddr_storage *address,socklen_t address_length,
+			     char *message_buff,size_t message_buff_len,size_t datagram_length,int *dropped);
+static void Send_Buffer_Key_Create(void);
+static void Send_Buffer_Destroy(void *send_buffer);
+static char *Send_Buffer_Get(size_t message_buffer_length);
+static int UDP_Summary_Send(void *summary_arg,const struct Log_Record_Struct *log_record,
+			    int log_context_count,const struct Log_Context_Struct *log_context_list);
 
 /* ---------------------------------------------------------------
 **  External functions 
 ** --------------------------------------------------------------- */
 /**
  * Routine to open a UDP socket and connect the default endpoint to a specified host/port.
- * @param hostname The hostname the socket will talk to, either numeric or via /etc/hosts.
+ * The host can have an IPv4 or IPv6 address. A hostname of the form "unix:/path" opens an AF_UNIX datagram
+ * socket connected to a relay on this machine instead, and the same packets are sent over it: delivery
+ * is reliable (a blocking socket waits for the relay to read, a non-blocking one counts a drop) and
+ * cheaper than the UDP stack. Under Linux the socket is bound to a unique abstract address, so the relay
+ * can tell senders apart.
+ * If hostname is a multicast group (224.0.0.0/4 or ff00::/8), the socket is given the
+ * multicast time to live, loopback and interface set with Log_UDP_Multicast_Set, so one send reaches
+ * every receiver that has joined the group. The socket is made non-blocking, and given a send buffer length,
+ * if Log_UDP_Socket_Options_Set has been called.
+ * @param hostname The hostname the socket will talk to, either numeric (IPv4 or IPv6), resolved via
+ *        /etc/hosts or DNS, or "unix:" followed by the path of a Unix domain datagram socket.
  * @param port_number The port number to send to in host (normal) byte order.
  * @param socket_id The address of an integer to store the created socket file descriptor.
  * @return The routine returns TRUE on success and FALSE on failure. If the routine failed,
  *     Log_Error_Number and Log_Error_String are set.
- * @see #Get_Host_By_Name
+ * @see #Log_UDP_Resolve
+ * @see #Log_UDP_Multicast_Configure
+ * @see #Log_UDP_Socket_Configure
  * @see log_general.html#Log_Error_Number
  * @see log_general.html#Log_Error_String
  */
 int Log_UDP_Open(char *hostname,int port_number,int *socket_id)
 {
-	struct in_addr inaddr;
+	struct sockaddr_storage remote_addr;
+	socklen_t remote_addr_length;
+#ifdef __linux
+	sa_family_t local_addr_family;
+#endif
 	int socket_errno,retval;
-	unsigned short int network_port_number;
-	in_addr_t saddr;
-	struct sockaddr_in remote_addr;
 
 	if(hostname == NULL)
 	{
@@ -88,8 +228,11 @@ int Log_UDP_Open(char *hostname,int port_number,int *socket_id)
 		sprintf(Log_Error_String,"Log_UDP_Open:socket_id was NULL.");
 		return FALSE;
 	}
-	/* open datagram socket */
-	(*socket_id) = socket(AF_INET,SOCK_DGRAM,0);
+	/* convert hostname and port number to an address */
+	if(!Log_UDP_Resolve(hostname,port_number,&remote_addr,&remote_addr_length))
+		return FALSE;
+	/* open datagram socket, in the address family of the address */
+	(*socket_id) = socket(remote_addr.ss_family,SOCK_DGRAM,0);
 	if((*socket_id) < 0)
 	{
 		socket_errno = errno;
@@ -98,31 +241,39 @@ int Log_UDP_Open(char *hostname,int port_number,int *socket_id)
 			strerror(socket_errno));
 		return FALSE;
 	}
-	/* convert port number to network short */
-	network_port_number = htons((short)port_number);
-	/* try to convert hostname to address in network byte order */
-	/* try numeric address conversion first */
-	saddr = inet_addr(hostname);
-	if(saddr == INADDR_NONE)
+	/* make the socket non-blocking and set it's send buffer length, if asked to */
+	if(!Log_UDP_Socket_Configure((*socket_id)))
 	{
-#if DEBUG > 5
-		fprintf(stdout,"Log_UDP_Open:inet_addr didn't work:trying gethostbyname(%s).\n",hostname);
-#endif
-		/* try getting by hostname instead */
-		if(!Get_Host_By_Name(hostname,&inaddr))
+		close((*socket_id));
+		(*socket_id) = 0;
+		return FALSE;
+	}
+	/* set the multicast options, if the address is a multicast group */
+	if(!Log_UDP_Multicast_Configure((*socket_id),&remote_addr))
+	{
+		shutdown((*socket_id),SHUT_RDWR);
+		(*socket_id) = 0;
+		return FALSE;
+	}
+#ifdef __linux
+	/* give a Unix domain socket an autobound abstract address, so the relay sees where each packet came from */
+	if(remote_addr.ss_family == AF_UNIX)
+	{
+		local_addr_family = AF_UNIX;
+		if(bind((*socket_id),(struct sockaddr *)&local_addr_family,sizeof(sa_family_t)) < 0)
 		{
-			shutdown((*socket_id),SHUT_RDWR);
+			socket_errno = errno;
+			close((*socket_id));
 			(*socket_id) = 0;
+			Log_Error_Number = 51;
+			sprintf(Log_Error_String,"Log_UDP_Open:Failed to bind Unix domain socket (%d:%s).",socket_errno,
+				strerror(socket_errno));
 			return FALSE;
 		}
-		saddr = inaddr.s_addr;
 	}
+#endif
 	/* set up socket so sends go to remote Hostname/Port_Number */
-	memset((char *) &remote_addr,0,sizeof(remote_addr));
-	remote_addr.sin_family = AF_INET;
-	remote_addr.sin_addr.s_addr = saddr;
-	remote_addr.sin_port = network_port_number;
-	retval = connect((*socket_id),(struct sockaddr *)&remote_addr,sizeof(remote_addr));
+	retval = connect((*socket_id),(struct sockaddr *)&remote_addr,remote_addr_length);
 	if(retval < 0)
 	{
 		socket_errno = errno;
@@ -140,52 +291,475 @@ int Log_UDP_Open(char *hostname,int port_number,int *socket_id)
 }
 
 /**
- * Send the log message as a UDP packet.
+ * Routine to convert a hostname and port number into an IPv4 or IPv6 socket address.
+ * Hostnames are resolved with getaddrinfo the first time they are seen, and then cached and re-resolved
+ * in the background, see Log_UDP_Resolve_Address.
+ * @param hostname The hostname, either numeric (IPv4 or IPv6) or resolved via /etc/hosts or DNS.
+ * @param port_number The port number in host (normal) byte order.
+ * @param address The address of a socket address structure to fill in.
+ * @param address_length The address of a socklen_t, filled in with the length of the address used.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see log_udp_resolve.html#Log_UDP_Resolve_Address
+ */
+int Log_UDP_Resolve(char *hostname,int port_number,struct sockaddr_storage *address,socklen_t *address_length)
+{
+	if((hostname == NULL)||(address == NULL)||(address_length == NULL))
+	{
+		Log_Error_Number = 34;
+		sprintf(Log_Error_String,"Log_UDP_Resolve:NULL argument.");
+		return FALSE;
+	}
+	return Log_UDP_Resolve_Address(hostname,port_number,address,address_length);
+}
+
+/**
+ * Send the log message as a UDP packet. This routine takes the log record by value, and is kept
+ * for compatibility with existing programs. New code should call Log_UDP_Send_Record, which avoids
+ * copying the whole log record onto the stack.
  * @param int socket_id The previously opened socket to send the message over.
  * @param log_record The log record.
  * @param log_context_count The number of context records in log_context_list.
  * @param log_context_list An allocated list of log contexts.
  * @return The routine returns TRUE on success and FALSE on failure.
- * @see #UDP_PACKET_MAGIC_WORD
+ * @see #Log_UDP_Send_Record
+ */
+int Log_UDP_Send(int socket_id,struct Log_Record_Struct log_record,
+		 int log_context_count,struct Log_Context_Struct *log_context_list)
+{
+	return Log_UDP_Send_Record(socket_id,&log_record,log_context_count,log_context_list);
+}
+
+/**
+ * Send the log message as a UDP packet. The packet is encoded into a buffer owned by the calling thread,
+ * which is only (re-)allocated when a record needs more space than any previous record sent by that thread,
+ * so steady-state sends do no heap allocation. Records that don't pass the process-wide filter 
+ * (see Log_UDP_Filter_Set), are repeats (see Log_UDP_Coalesce_Set), or are suppressed by the rate limiter
+ * (see Log_UDP_Rate_Limit_Set), are not sent.
+ * @param int socket_id The previously opened socket to send the message over.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_BUFFER_LENGTH
  * @see #Log_Record_Struct
  * @see #Log_Context_Struct
+ * @see #Log_UDP_Encode
+ * @see #Send_Buffer_Get
  * @see #UDP_Raw_Send
+ * @see #Log_UDP_Is_Enabled
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Allow
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Allow
  */
-int Log_UDP_Send(int socket_id,struct Log_Record_Struct log_record,
-		 int log_context_count,struct Log_Context_Struct *log_context_list)
+int Log_UDP_Send_Record(int socket_id,const struct Log_Record_Struct *log_record,
+			int log_context_count,const struct Log_Context_Struct *log_context_list)
 {
 	char *message_buffer = NULL;
 	size_t message_buffer_length = 0;
-	int message_buffer_position,i,network_int;
-	int64_t network_java_long;
+	size_t message_buffer_position = 0;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Send_Record(%d):started.\n",log_context_count);
+#endif
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 22;
+		sprintf(Log_Error_String,"Log_UDP_Send_Record:log_record was NULL.");
+		return FALSE;
+	}
+	/* filtered out records are not an error */
+	if(!Log_UDP_Is_Enabled(log_record->Severity,log_record->Verbosity))
+		return TRUE;
+	/* repeated and rate limited records are not an error */
+	if(!Log_UDP_Coalesce_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,log_record->System,log_record->Sub_System,log_record->Source_File,
+				   log_record->Source_Instance,log_record->Function,log_record->Severity,
+				   log_record->Verbosity,log_record->Category,log_record->Message,log_record->Timestamp,
+				   log_context_count,log_context_list))
+		return TRUE;
+	if(!Log_UDP_Rate_Limit_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,log_record->System,log_record->Sub_System,log_record->Category,
+				     log_record->Severity))
+		return TRUE;
+	if(log_context_count < 0)
+	{
+		Log_Error_Number = 7;
+		sprintf(Log_Error_String,"Log_UDP_Send_Record:Log context count should be positive/zero(%d).",
+			log_context_count);
+		return FALSE;
+	}
+	/* determine length of buffer */
+	message_buffer_length = LOG_UDP_BUFFER_LENGTH(log_context_count);
+	message_buffer = Send_Buffer_Get(message_buffer_length);
+	if(message_buffer == NULL)
+		return FALSE;
+	if(!Log_UDP_Encode(log_record,log_context_count,log_context_list,message_buffer,message_buffer_length,
+			   &message_buffer_position))
+		return FALSE;
+	/* send buffer */
+	if(!UDP_Raw_Send(socket_id,message_buffer,message_buffer_position,NULL))
+		return FALSE;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Send_Record():finished.\n");
+#endif
+	return TRUE;
+}
+
+/**
+ * Send the log message as a UDP packet, using a scatter/gather sendmsg call. The iovec list passed to the 
+ * kernel points straight at the log record's and contexts' string fields, so none of the field bytes are 
+ * copied in user space. Records with more contexts than fit into UDP_GATHER_IOVEC_LENGTH iovecs are
+ * sent with Log_UDP_Send_Record instead. The bytes on the wire are the same as Log_UDP_Send_Record.
+ * Records that are fragmented (see Log_UDP_Fragment_Set) are encoded into the calling thread's send buffer.
+ * @param socket_id The previously opened socket to send the message over.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #UDP_GATHER_IOVEC_LENGTH
+ * @see #LOG_UDP_IOVEC_LENGTH
+ * @see #Log_UDP_Encode_Iovec
+ * @see #Log_UDP_Send_Record
+ */
+int Log_UDP_Send_Record_Gather(int socket_id,const struct Log_Record_Struct *log_record,
+			       int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	struct Log_UDP_Iovec_Header_Struct header;
+	struct iovec iovec_list[UDP_GATHER_IOVEC_LENGTH];
+	struct msghdr message_header;
+	char *message_buffer = NULL;
+	size_t message_length,datagram_length,encoded_length;
+	int iovec_count,retval,send_errno,i;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Send_Record_Gather(%d):started.\n",log_context_count);
+#endif
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 22;
+		sprintf(Log_Error_String,"Log_UDP_Send_Record_Gather:log_record was NULL.");
+		return FALSE;
+	}
+	/* filtered out records are not an error */
+	if(!Log_UDP_Is_Enabled(log_record->Severity,log_record->Verbosity))
+		return TRUE;
+	/* repeated and rate limited records are not an error */
+	if(!Log_UDP_Coalesce_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,log_record->System,log_record->Sub_System,log_record->Source_File,
+				   log_record->Source_Instance,log_record->Function,log_record->Severity,
+				   log_record->Verbosity,log_record->Category,log_record->Message,log_record->Timestamp,
+				   log_context_count,log_context_list))
+		return TRUE;
+	if(!Log_UDP_Rate_Limit_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,log_record->System,log_record->Sub_System,log_record->Category,
+				     log_record->Severity))
+		return TRUE;
+	if((log_context_count > 0)&&(LOG_UDP_IOVEC_LENGTH(log_context_count) > UDP_GATHER_IOVEC_LENGTH))
+		return Log_UDP_Send_Record(socket_id,log_record,log_context_count,log_context_list);
+	if(!Log_UDP_Encode_Iovec(log_record,log_context_count,log_context_list,&header,iovec_list,
+				 UDP_GATHER_IOVEC_LENGTH,&iovec_count))
+		return FALSE;
+	message_length = 0;
+	for(i = 0; i < iovec_count; i++)
+		message_length += iovec_list[i].iov_len;
+	/* fragments are cut from a contiguous packet, so encode one */
+	if(UDP_Fragment_Length_Get(socket_id,message_length,&datagram_length))
+	{
+		message_buffer = Send_Buffer_Get(LOG_UDP_BUFFER_LENGTH(log_context_count));
+		if(message_buffer == NULL)
+			return FALSE;
+		if(!Log_UDP_Encode(log_record,log_context_count,log_context_list,message_buffer,
+				   LOG_UDP_BUFFER_LENGTH(log_context_count),&encoded_length))
+			return FALSE;
+		return UDP_Fragment_Send(socket_id,NULL,0,message_buffer,encoded_length,datagram_length,NULL);
+	}
+	memset(&message_header,0,sizeof(struct msghdr));
+	message_header.msg_iov = iovec_list;
+	message_header.msg_iovlen = iovec_count;
+	retval = sendmsg(socket_id,&message_header,0);
+	if(retval < 0)
+	{
+		send_errno = errno;
+		if(UDP_Send_Drop(send_errno))
+			return TRUE;
+		Log_Error_Number = 12;
+		sprintf(Log_Error_String,"Log_UDP_Send_Record_Gather:Send failed %d (%s).",send_errno,
+			strerror(send_errno));
+		return FALSE;
+	}
+	if(retval != message_length)
+	{
+		Log_Error_Number = 13;
+		sprintf(Log_Error_String,"Log_UDP_Send_Record_Gather:Send returned %d vs %d.",retval,message_length);
+		return FALSE;
+	}
+	UDP_Send_Count(1,message_length);
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Send_Record_Gather():finished.\n");
+#endif
+	return TRUE;
+}
+
+/**
+ * Send a list of log messages as UDP packets, one packet per log record. The records are encoded 
+ * (UDP_BATCH_LENGTH records at a time) into the calling thread's send buffer, and passed to the kernel
+ * with one sendmmsg system call (under Linux, on other systems one send call per record is used).
+ * Records that are fragmented (see Log_UDP_Fragment_Set) are sent as soon as they are encoded, so they can
+ * arrive before earlier records in the same batch.
+ * @param socket_id The previously opened socket to send the messages over.
+ * @param log_record_list A list of record_count log records.
+ * @param log_context_count_list A list of record_count integers, the number of contexts in each log record's
+ *        context list. Can be NULL, in which case no contexts are sent.
+ * @param log_context_list_list A list of record_count pointers to each log record's context list. 
+ *        Can be NULL if log_context_count_list is NULL.
+ * @param record_count The number of log records in the lists.
+ * @param sent_list A list of record_count integers, filled in with TRUE if the log record was accepted by 
+ *        the kernel (or was removed by the process-wide filter, coalescing or rate limiter) and FALSE if it was not. 
+ *        Can be NULL.
+ * @return The routine returns TRUE if all the log records were sent, and FALSE if any of them failed 
+ *         (Log_Error_Number and Log_Error_String describe the last failure).
+ * @see #UDP_BATCH_LENGTH
+ * @see #LOG_UDP_BUFFER_LENGTH
+ * @see #Log_UDP_Encode
+ * @see #Send_Buffer_Get
+ */
+int Log_UDP_Send_Batch(int socket_id,const struct Log_Record_Struct *log_record_list,
+		       const int *log_context_count_list,
+		       const struct Log_Context_Struct * const *log_context_list_list,
+		       int record_count,int *sent_list)
+{
+#ifdef __linux
+	struct mmsghdr message_header_list[UDP_BATCH_LENGTH];
+#endif
+	struct iovec iovec_list[UDP_BATCH_LENGTH];
+	int record_index_list[UDP_BATCH_LENGTH];
+	const struct Log_Context_Struct *log_context_list = NULL;
+	char *message_buffer = NULL;
+	size_t message_buffer_length,message_buffer_position,encoded_length,datagram_length;
+	int batch_start,batch_end,message_count,message_index,log_context_count,retval,send_errno,dropped,i;
+	int all_sent = TRUE;
 
 #if DEBUG > 1
-	fprintf(stdout,"Log_UDP_Send(%d):started.\n",log_context_count);
+	fprintf(stdout,"Log_UDP_Send_Batch(socket=%d,count=%d):started.\n",socket_id,record_count);
+#endif
+	if(log_record_list == NULL)
+	{
+		Log_Error_Number = 25;
+		sprintf(Log_Error_String,"Log_UDP_Send_Batch:log_record_list was NULL.");
+		return FALSE;
+	}
+	if((log_context_count_list != NULL)&&(log_context_list_list == NULL))
+	{
+		Log_Error_Number = 26;
+		sprintf(Log_Error_String,"Log_UDP_Send_Batch:log_context_list_list was NULL.");
+		return FALSE;
+	}
+	if(record_count < 0)
+	{
+		Log_Error_Number = 27;
+		sprintf(Log_Error_String,"Log_UDP_Send_Batch:record_count should be positive/zero(%d).",record_count);
+		return FALSE;
+	}
+	if(sent_list != NULL)
+	{
+		for(i = 0; i < record_count; i++)
+			sent_list[i] = FALSE;
+	}
+	for(batch_start = 0; batch_start < record_count; batch_start = batch_end)
+	{
+		batch_end = batch_start+UDP_BATCH_LENGTH;
+		if(batch_end > record_count)
+			batch_end = record_count;
+		/* determine length of buffer needed to encode this batch */
+		message_buffer_length = 0;
+		for(i = batch_start; i < batch_end; i++)
+		{
+			if(log_context_count_list != NULL)
+				log_context_count = log_context_count_list[i];
+			else
+				log_context_count = 0;
+			if(log_context_count > 0)
+				message_buffer_length += LOG_UDP_BUFFER_LENGTH(log_context_count);
+			else
+				message_buffer_length += LOG_UDP_BUFFER_LENGTH(0);
+		}
+		message_buffer = Send_Buffer_Get(message_buffer_length);
+		if(message_buffer == NULL)
+			return FALSE;
+		/* encode each record in the batch one after another into the buffer */
+		message_buffer_position = 0;
+		message_count = 0;
+		for(i = batch_start; i < batch_end; i++)
+		{
+			if(log_context_count_list != NULL)
+			{
+				log_context_count = log_context_count_list[i];
+				log_context_list = log_context_list_list[i];
+			}
+			else
+			{
+				log_context_count = 0;
+				log_context_list = NULL;
+			}
+			/* filtered out, repeated and rate limited records are treated as sent */
+			if((!Log_UDP_Is_Enabled(log_record_list[i].Severity,log_record_list[i].Verbosity))||
+			   (!Log_UDP_Coalesce_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,
+						    log_record_list[i].System,log_record_list[i].Sub_System,
+						    log_record_list[i].Source_File,log_record_list[i].Source_Instance,
+						    log_record_list[i].Function,log_record_list[i].Severity,
+						    log_record_list[i].Verbosity,log_record_list[i].Category,
+						    log_record_list[i].Message,log_record_list[i].Timestamp,
+						    log_context_count,log_context_list))||
+			   (!Log_UDP_Rate_Limit_Allow(UDP_Summary_Send,(void *)(intptr_t)socket_id,
+						      log_record_list[i].System,log_record_list[i].Sub_System,
+						      log_record_list[i].Category,log_record_list[i].Severity)))
+			{
+				if(sent_list != NULL)
+					sent_list[i] = TRUE;
+				continue;
+			}
+			if(!Log_UDP_Encode(&(log_record_list[i]),log_context_count,log_context_list,
+					   message_buffer+message_buffer_position,
+					   message_buffer_length-message_buffer_position,&encoded_length))
+			{
+				/* this record can't be sent, but try the rest */
+				all_sent = FALSE;
+				continue;
+			}
+			/* records that are fragmented are sent straight away, ahead of the rest of the batch */
+			if(UDP_Fragment_Length_Get(socket_id,encoded_length,&datagram_length))
+			{
+				if(UDP_Fragment_Send(socket_id,NULL,0,message_buffer+message_buffer_position,encoded_length,
+						     datagram_length,&dropped))
+				{
+					if((sent_list != NULL)&&(!dropped))
+						sent_list[i] = TRUE;
+				}
+				else
+					all_sent = FALSE;
+				continue;
+			}
+			iovec_list[message_count].iov_base = message_buffer+message_buffer_position;
+			iovec_list[message_count].iov_len = encoded_length;
+			record_index_list[message_count] = i;
+			message_buffer_position += encoded_length;
+			message_count++;
+		}
+#ifdef __linux
+		for(i = 0; i < message_count; i++)
+		{
+			memset(&(message_header_list[i]),0,sizeof(struct mmsghdr));
+			message_header_list[i].msg_hdr.msg_iov = &(iovec_list[i]);
+			message_header_list[i].msg_hdr.msg_iovlen = 1;
+		}
+		message_index = 0;
+		while(message_index < message_count)
+		{
+			retval = sendmmsg(socket_id,message_header_list+message_index,message_count-message_index,0);
+			if(retval < 0)
+			{
+				/* the first remaining message failed, mark it as not sent and carry on with the rest */
+				send_errno = errno;
+				message_index++;
+				if(UDP_Send_Drop(send_errno))
+					continue;
+				Log_Error_Number = 28;
+				sprintf(Log_Error_String,"Log_UDP_Send_Batch:sendmmsg failed for record %d: %d (%s).",
+					record_index_list[message_index-1],send_errno,strerror(send_errno));
+				all_sent = FALSE;
+				continue;
+			}
+			for(i = message_index; i < message_index+retval; i++)
+			{
+				if(message_header_list[i].msg_len != iovec_list[i].iov_len)
+				{
+					Log_Error_Number = 29;
+					sprintf(Log_Error_String,"Log_UDP_Send_Batch:sendmmsg sent %d vs %d for record %d.",
+						message_header_list[i].msg_len,iovec_list[i].iov_len,
+						record_index_list[i]);
+					all_sent = FALSE;
+				}
+				else
+				{
+					UDP_Send_Count(1,iovec_list[i].iov_len);
+					if(sent_list != NULL)
+						sent_list[record_index_list[i]] = TRUE;
+				}
+			}
+			message_index += retval;
+		}
+#else
+		for(message_index = 0; message_index < message_count; message_index++)
+		{
+			if(UDP_Raw_Send(socket_id,iovec_list[message_index].iov_base,iovec_list[message_index].iov_len,
+					NULL))
+			{
+				if(sent_list != NULL)
+					sent_list[record_index_list[message_index]] = TRUE;
+			}
+			else
+				all_sent = FALSE;
+		}
+#endif
+	}
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Send_Batch(socket=%d,count=%d):finished.\n",socket_id,record_count);
 #endif
+	return all_sent;
+}
+
+/**
+ * Encode the log record and it's contexts into a caller supplied buffer, in the format sent as a UDP packet.
+ * No memory is allocated by this routine.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @param message_buffer The buffer to encode the packet into.
+ * @param message_buffer_length The length of message_buffer in bytes. A buffer of length 
+ *        LOG_UDP_BUFFER_LENGTH(log_context_count) is always big enough.
+ * @param encoded_length The address of a size_t, on success filled in with the number of bytes of 
+ *        message_buffer used by the encoded packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_PACKET_MAGIC_WORD
+ * @see #LOG_UDP_BUFFER_LENGTH
+ * @see #Log_Record_Struct
+ * @see #Log_Context_Struct
+ * @see #Log_UDP_Encode_Int
+ * @see #Log_UDP_Encode_Int64
+ * @see #Log_UDP_Encode_String
+ */
+int Log_UDP_Encode(const struct Log_Record_Struct *log_record,int log_context_count,
+		   const struct Log_Context_Struct *log_context_list,char *message_buffer,
+		   size_t message_buffer_length,size_t *encoded_length)
+{
+	size_t message_buffer_position;
+	int i;
+
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 22;
+		sprintf(Log_Error_String,"Log_UDP_Encode:log_record was NULL.");
+		return FALSE;
+	}
 	if(log_context_count < 0)
 	{
 		Log_Error_Number = 7;
-		sprintf(Log_Error_String,"Log_UDP_Send:Log context count should be positive/zero(%d).",
+		sprintf(Log_Error_String,"Log_UDP_Encode:Log context count should be positive/zero(%d).",
 			log_context_count);
 		return FALSE;
 	}
 	if((log_context_count > 0)&&(log_context_list == NULL))
 	{
 		Log_Error_Number = 8;
-		sprintf(Log_Error_String,"Log_UDP_Send:Log context list was NULL when log context count was %d.",
+		sprintf(Log_Error_String,"Log_UDP_Encode:Log context list was NULL when log context count was %d.",
 			log_context_count);
 		return FALSE;
 	}
-	/* determine length of buffer 
-	** Size of log record + all log contexts + 4 bytes for log context count + 4 bytes for magic word */
-	message_buffer_length = sizeof(struct Log_Record_Struct) + sizeof(int) + sizeof(int) + (log_context_count * 
-								    sizeof(struct Log_Context_Struct));
-	message_buffer = (char*)malloc(message_buffer_length*sizeof(char));
 	if(message_buffer == NULL)
 	{
-		Log_Error_Number = 9;
-		sprintf(Log_Error_String,"Log_UDP_Send:Failed to allocate message buffer(%d).",
-			message_buffer_length);
+		Log_Error_Number = 23;
+		sprintf(Log_Error_String,"Log_UDP_Encode:message_buffer was NULL.");
+		return FALSE;
+	}
+	if(encoded_length == NULL)
+	{
+		Log_Error_Number = 24;
+		sprintf(Log_Error_String,"Log_UDP_Encode:encoded_length was NULL.");
 		return FALSE;
 	}
 	/* copy structure into buffer
@@ -193,102 +767,448 @@ int Log_UDP_Send(int socket_id,struct Log_Record_Struct log_record,
 	/* integers should be in network byte order */
 	message_buffer_position = 0;
 	/* magic word - used to differentiate between C and Java packets */
-	network_int = htonl(UDP_PACKET_MAGIC_WORD);
-	memcpy(message_buffer+message_buffer_position,&network_int,sizeof(int));
-	message_buffer_position += sizeof(int);
+	if(!Log_UDP_Encode_Int(message_buffer,message_buffer_length,&message_buffer_position,
+			       LOG_UDP_PACKET_MAGIC_WORD))
+		return FALSE;
 	/* Timestamp */
-	network_java_long = hton64bitl(log_record.Timestamp);
-	memcpy(message_buffer+message_buffer_position,&network_java_long,sizeof(int64_t));
-	message_buffer_position += sizeof(int64_t);
+	if(!Log_UDP_Encode_Int64(message_buffer,message_buffer_length,&message_buffer_position,log_record->Timestamp))
+		return FALSE;
 	/* System */
-	strcpy(message_buffer+message_buffer_position,log_record.System);
-	message_buffer_position += strlen(log_record.System);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,log_record->System))
+		return FALSE;
 	/* Sub_System */
-	strcpy(message_buffer+message_buffer_position,log_record.Sub_System);
-	message_buffer_position += strlen(log_record.Sub_System);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,log_record->Sub_System))
+		return FALSE;
 	/* Source_File */
-	strcpy(message_buffer+message_buffer_position,log_record.Source_File);
-	message_buffer_position += strlen(log_record.Source_File);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,
+				  log_record->Source_File))
+		return FALSE;
 	/* Source_Instance */
-	strcpy(message_buffer+message_buffer_position,log_record.Source_Instance);
-	message_buffer_position += strlen(log_record.Source_Instance);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,
+				  log_record->Source_Instance))
+		return FALSE;
 	/* Function */
-	strcpy(message_buffer+message_buffer_position,log_record.Function);
-	message_buffer_position += strlen(log_record.Function);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,log_record->Function))
+		return FALSE;
 	/* Severity */
-	network_int = htonl(log_record.Severity);
-	memcpy(message_buffer+message_buffer_position,&network_int,sizeof(int));
-	message_buffer_position += sizeof(int);
+	if(!Log_UDP_Encode_Int(message_buffer,message_buffer_length,&message_buffer_position,log_record->Severity))
+		return FALSE;
 	/* Verbosity */
-	network_int = htonl(log_record.Verbosity);
-	memcpy(message_buffer+message_buffer_position,&network_int,sizeof(int));
-	message_buffer_position += sizeof(int);
+	if(!Log_UDP_Encode_Int(message_buffer,message_buffer_length,&message_buffer_position,log_record->Verbosity))
+		return FALSE;
 	/* Category */
-	strcpy(message_buffer+message_buffer_position,log_record.Category);
-	message_buffer_position += strlen(log_record.Category);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,log_record->Category))
+		return FALSE;
 	/* Message */
 #if DEBUG > 1
-	fprintf(stdout,"Log_UDP_Send():message='%s'.\n",log_record.Message);
+	fprintf(stdout,"Log_UDP_Encode():message='%s'.\n",log_record->Message);
 #endif
-	strcpy(message_buffer+message_buffer_position,log_record.Message);
-	message_buffer_position += strlen(log_record.Message);
-	message_buffer[message_buffer_position++] = '\0';
+	if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,log_record->Message))
+		return FALSE;
 	/* Context_Count */
-	network_int = htonl(log_context_count);
-	memcpy(message_buffer+message_buffer_position,&network_int,sizeof(int));
-	message_buffer_position += sizeof(int);
+	if(!Log_UDP_Encode_Int(message_buffer,message_buffer_length,&message_buffer_position,log_context_count))
+		return FALSE;
 	/* add context list */
 	for(i = 0; i < log_context_count; i++)
 	{
 		/* Keyword */
-		strcpy(message_buffer+message_buffer_position,log_context_list[i].Keyword);
-		message_buffer_position += strlen(log_context_list[i].Keyword);
-		message_buffer[message_buffer_position++] = '\0';
+		if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,
+					  log_context_list[i].Keyword))
+			return FALSE;
 		/* Value */
-		strcpy(message_buffer+message_buffer_position,log_context_list[i].Value);
-		message_buffer_position += strlen(log_context_list[i].Value);
-		message_buffer[message_buffer_position++] = '\0';
+		if(!Log_UDP_Encode_String(message_buffer,message_buffer_length,&message_buffer_position,
+					  log_context_list[i].Value))
+			return FALSE;
 	}
 #if DEBUG > 1
-	fprintf(stdout,"Log_UDP_Send():message length:allocated=%d,actual=%d.\n",
+	fprintf(stdout,"Log_UDP_Encode():message length:buffer=%d,actual=%d.\n",
 		message_buffer_length,message_buffer_position);
 #endif
-	if(message_buffer_position > message_buffer_length)
+	(*encoded_length) = message_buffer_position;
+	return TRUE;
+}
+
+/**
+ * Encode the log record and it's contexts as a list of iovecs, suitable for passing to sendmsg/writev.
+ * The integer fields are written in network byte order into the caller supplied header, and
+ * the string fields (including their NULL terminators) are referenced in place, so the log record, 
+ * contexts and header must not be modified or freed until the iovecs have been used. 
+ * The iovecs describe the same bytes Log_UDP_Encode produces.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @param header The address of a Log_UDP_Iovec_Header_Struct to hold the encoded integer fields.
+ * @param iovec_list A list of iovecs to fill in.
+ * @param iovec_length The number of iovecs in iovec_list. A list of 
+ *        LOG_UDP_IOVEC_LENGTH(log_context_count) iovecs is always big enough.
+ * @param iovec_count The address of an integer, on success filled in with the number of iovecs used.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_PACKET_MAGIC_WORD
+ * @see #LOG_UDP_IOVEC_LENGTH
+ * @see #Log_UDP_Iovec_Header_Struct
+ * @see #hton64bitl
+ */
+int Log_UDP_Encode_Iovec(const struct Log_Record_Struct *log_record,int log_context_count,
+			 const struct Log_Context_Struct *log_context_list,
+			 struct Log_UDP_Iovec_Header_Struct *header,struct iovec *iovec_list,int iovec_length,
+			 int *iovec_count)
+{
+	int64_t network_java_long;
+	int network_int,index,i;
+
+	if(log_record == NULL)
 	{
-		Log_Error_Number = 10;
-		sprintf(Log_Error_String,"Log_UDP_Send:Message Buffer overun(position %d > length %d).",
-			message_buffer_position,message_buffer_length);
+		Log_Error_Number = 22;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Iovec:log_record was NULL.");
 		return FALSE;
 	}
-	/* send buffer */
-	/* can use message_buffer_length as length (allocated), or message_buffer_position (actual end position).
-	** message_buffer_position should be better, as message_buffer_length could include struct padding bytes */
-	if(!UDP_Raw_Send(socket_id,message_buffer,message_buffer_position))
+	if(log_context_count < 0)
+	{
+		Log_Error_Number = 7;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Iovec:Log context count should be positive/zero(%d).",
+			log_context_count);
+		return FALSE;
+	}
+	if((log_context_count > 0)&&(log_context_list == NULL))
 	{
-		if(message_buffer != NULL)
-			free(message_buffer);
+		Log_Error_Number = 8;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Iovec:Log context list was NULL when log context count was %d.",
+			log_context_count);
 		return FALSE;
 	}
-	/* free buffer */
-	if(message_buffer != NULL)
-		free(message_buffer);
-#if DEBUG > 1
-	fprintf(stdout,"Log_UDP_Send():finished.\n");
+	if((header == NULL)||(iovec_list == NULL)||(iovec_count == NULL))
+	{
+		Log_Error_Number = 30;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Iovec:header, iovec_list or iovec_count was NULL.");
+		return FALSE;
+	}
+	if(iovec_length < LOG_UDP_IOVEC_LENGTH(log_context_count))
+	{
+		Log_Error_Number = 31;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Iovec:iovec_length %d too small for %d contexts.",
+			iovec_length,log_context_count);
+		return FALSE;
+	}
+	/* magic word and Timestamp */
+	network_int = htonl(LOG_UDP_PACKET_MAGIC_WORD);
+	memcpy(header->Prefix,&network_int,sizeof(int));
+	network_java_long = hton64bitl(log_record->Timestamp);
+	memcpy(header->Prefix+sizeof(int),&network_java_long,sizeof(int64_t));
+	/* Severity and Verbosity */
+	network_int = htonl(log_record->Severity);
+	memcpy(header->Severity_Verbosity,&network_int,sizeof(int));
+	network_int = htonl(log_record->Verbosity);
+	memcpy(header->Severity_Verbosity+sizeof(int),&network_int,sizeof(int));
+	/* Context_Count */
+	network_int = htonl(log_context_count);
+	memcpy(header->Context_Count,&network_int,sizeof(int));
+	index = 0;
+	iovec_list[index].iov_base = header->Prefix;
+	iovec_list[index++].iov_len = sizeof(header->Prefix);
+	/* strings include their NULL terminator */
+	iovec_list[index].iov_base = (void *)log_record->System;
+	iovec_list[index++].iov_len = strlen(log_record->System)+1;
+	iovec_list[index].iov_base = (void *)log_record->Sub_System;
+	iovec_list[index++].iov_len = strlen(log_record->Sub_System)+1;
+	iovec_list[index].iov_base = (void *)log_record->Source_File;
+	iovec_list[index++].iov_len = strlen(log_record->Source_File)+1;
+	iovec_list[index].iov_base = (void *)log_record->Source_Instance;
+	iovec_list[index++].iov_len = strlen(log_record->Source_Instance)+1;
+	iovec_list[index].iov_base = (void *)log_record->Function;
+	iovec_list[index++].iov_len = strlen(log_record->Function)+1;
+	iovec_list[index].iov_base = header->Severity_Verbosity;
+	iovec_list[index++].iov_len = sizeof(header->Severity_Verbosity);
+	iovec_list[index].iov_base = (void *)log_record->Category;
+	iovec_list[index++].iov_len = strlen(log_record->Category)+1;
+	iovec_list[index].iov_base = (void *)log_record->Message;
+	iovec_list[index++].iov_len = strlen(log_record->Message)+1;
+	iovec_list[index].iov_base = header->Context_Count;
+	iovec_list[index++].iov_len = sizeof(header->Context_Count);
+	for(i = 0; i < log_context_count; i++)
+	{
+		iovec_list[index].iov_base = (void *)log_context_list[i].Keyword;
+		iovec_list[index++].iov_len = strlen(log_context_list[i].Keyword)+1;
+		iovec_list[index].iov_base = (void *)log_context_list[i].Value;
+		iovec_list[index++].iov_len = strlen(log_context_list[i].Value)+1;
+	}
+	(*iovec_count) = index;
+	return TRUE;
+}
+
+/**
+ * Send a packet previously encoded by Log_UDP_Encode (into a caller supplied buffer) over the socket.
+ * @param socket_id The previously opened socket to send the message over.
+ * @param message_buffer The buffer containing the encoded packet.
+ * @param message_buffer_length The number of bytes in the encoded packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Encode
+ * @see #UDP_Raw_Send
+ */
+int Log_UDP_Send_Encoded(int socket_id,char *message_buffer,size_t message_buffer_length)
+{
+	return UDP_Raw_Send(socket_id,message_buffer,message_buffer_length,NULL);
+}
+
+/**
+ * Send a packet previously encoded into a caller supplied buffer over the socket, as Log_UDP_Send_Encoded,
+ * and say whether it was dropped because the send buffer was full.
+ * @param socket_id The previously opened socket to send the message over.
+ * @param message_buffer The buffer containing the encoded packet.
+ * @param message_buffer_length The number of bytes in the encoded packet.
+ * @param dropped The address of an integer, set to TRUE if the packet was dropped and FALSE if it was not.
+ * @return The routine returns TRUE on success (including a drop) and FALSE on failure.
+ * @see #Log_UDP_Send_Encoded
+ * @see #UDP_Raw_Send
+ */
+int Log_UDP_Send_Encoded_Status(int socket_id,char *message_buffer,size_t message_buffer_length,int *dropped)
+{
+	return UDP_Raw_Send(socket_id,message_buffer,message_buffer_length,dropped);
+}
+
+/**
+ * Send one encoded packet to each of a list of destinations, over an unconnected socket. The packet is not
+ * copied: under Linux the same buffer is passed to the kernel once per destination with one sendmmsg call,
+ * on other systems one sendto call per destination is used. A packet that is fragmented (see
+ * Log_UDP_Fragment_Set) is sent to each destination in turn. As the socket is not connected, the path MTU is not
+ * known, so LOG_UDP_FRAGMENT_DEFAULT_LENGTH is used when fragmenting to the path MTU.
+ * @param socket_id An unconnected datagram socket, of the same address family as the destinations.
+ * @param message_buffer The buffer containing the encoded packet.
+ * @param message_buffer_length The number of bytes in the encoded packet.
+ * @param address_list The list of destination addresses.
+ * @param address_length_list The length of each address in address_list.
+ * @param address_count The number of destinations.
+ * @param sent_list A list of address_count integers, each set to TRUE if the packet was sent to that
+ *        destination and FALSE if it was not. Can be NULL.
+ * @param dropped_list A list of address_count integers, each set to TRUE if the packet was dropped for that
+ *        destination because the send buffer was full, and FALSE if it was not. Can be NULL.
+ * @return The routine returns TRUE if the packet was sent to (or dropped for) every destination, and FALSE if
+ *         sending to at least one failed (Log_Error_Number and Log_Error_String describe the last failure).
+ * @see #UDP_DESTINATION_BATCH_LENGTH
+ */
+int Log_UDP_Send_Encoded_List(int socket_id,char *message_buffer,size_t message_buffer_length,
+			      struct sockaddr_storage *address_list,socklen_t *address_length_list,int address_count,
+			      int *sent_list,int *dropped_list)
+{
+	struct iovec iovec;
+#ifdef __linux
+	struct mmsghdr message_header_list[UDP_DESTINATION_BATCH_LENGTH];
+	int batch_start,batch_count,message_index;
+#endif
+	size_t datagram_length;
+	int i,retval,send_errno,dropped,all_sent;
+
+	if((message_buffer == NULL)||(address_list == NULL)||(address_length_list == NULL))
+	{
+		Log_Error_Number = 35;
+		sprintf(Log_Error_String,"Log_UDP_Send_Encoded_List:NULL argument.");
+		return FALSE;
+	}
+	for(i = 0; i < address_count; i++)
+	{
+		if(sent_list != NULL)
+			sent_list[i] = FALSE;
+		if(dropped_list != NULL)
+			dropped_list[i] = FALSE;
+	}
+	all_sent = TRUE;
+	/* fragmented packets are sent to each destination in turn */
+	if(UDP_Fragment_Length_Get(socket_id,message_buffer_length,&datagram_length))
+	{
+		for(i = 0; i < address_count; i++)
+		{
+			if(UDP_Fragment_Send(socket_id,&(address_list[i]),address_length_list[i],message_buffer,
+					     message_buffer_length,datagram_length,&dropped))
+			{
+				if(sent_list != NULL)
+					sent_list[i] = !dropped;
+				if(dropped_list != NULL)
+					dropped_list[i] = dropped;
+			}
+			else
+				all_sent = FALSE;
+		}
+		return all_sent;
+	}
+	iovec.iov_base = message_buffer;
+	iovec.iov_len = message_buffer_length;
+#ifdef __linux
+	for(batch_start = 0; batch_start < address_count; batch_start += UDP_DESTINATION_BATCH_LENGTH)
+	{
+		batch_count = address_count-batch_start;
+		if(batch_count > UDP_DESTINATION_BATCH_LENGTH)
+			batch_count = UDP_DESTINATION_BATCH_LENGTH;
+		for(i = 0; i < batch_count; i++)
+		{
+			memset(&(message_header_list[i]),0,sizeof(struct mmsghdr));
+			message_header_list[i].msg_hdr.msg_name = &(address_list[batch_start+i]);
+			message_header_list[i].msg_hdr.msg_namelen = address_length_list[batch_start+i];
+			message_header_list[i].msg_hdr.msg_iov = &iovec;
+			message_header_list[i].msg_hdr.msg_iovlen = 1;
+		}
+		message_index = 0;
+		while(message_index < batch_count)
+		{
+			retval = sendmmsg(socket_id,message_header_list+message_index,batch_count-message_index,0);
+			if(retval < 0)
+			{
+				/* the first remaining destination failed, carry on with the rest */
+				send_errno = errno;
+				message_index++;
+				if(UDP_Send_Drop(send_errno))
+				{
+					if(dropped_list != NULL)
+						dropped_list[batch_start+message_index-1] = TRUE;
+					continue;
+				}
+				Log_Error_Number = 36;
+				sprintf(Log_Error_String,"Log_UDP_Send_Encoded_List:sendmmsg failed for destination %d: "
+					"%d (%s).",batch_start+message_index-1,send_errno,strerror(send_errno));
+				all_sent = FALSE;
+				continue;
+			}
+			for(i = message_index; i < message_index+retval; i++)
+			{
+				if(message_header_list[i].msg_len != message_buffer_length)
+				{
+					Log_Error_Number = 37;
+					sprintf(Log_Error_String,"Log_UDP_Send_Encoded_List:sendmmsg sent %d vs %d "
+						"for destination %d.",message_header_list[i].msg_len,message_buffer_length,
+						batch_start+i);
+					all_sent = FALSE;
+				}
+				else
+				{
+					UDP_Send_Count(1,message_buffer_length);
+					if(sent_list != NULL)
+						sent_list[batch_start+i] = TRUE;
+				}
+			}
+			message_index += retval;
+		}
+	}
+#else
+	for(i = 0; i < address_count; i++)
+	{
+		retval = sendto(socket_id,message_buffer,message_buffer_length,0,
+				(struct sockaddr *)&(address_list[i]),address_length_list[i]);
+		if(retval != message_buffer_length)
+		{
+			send_errno = errno;
+			if((retval < 0)&&UDP_Send_Drop(send_errno))
+			{
+				if(dropped_list != NULL)
+					dropped_list[i] = TRUE;
+				continue;
+			}
+			Log_Error_Number = 36;
+			sprintf(Log_Error_String,"Log_UDP_Send_Encoded_List:sendto failed for destination %d: "
+				"%d (%s).",i,send_errno,strerror(send_errno));
+			all_sent = FALSE;
+		}
+		else
+		{
+			UDP_Send_Count(1,message_buffer_length);
+			if(sent_list != NULL)
+				sent_list[i] = TRUE;
+		}
+	}
 #endif
+	return all_sent;
+}
+
+/**
+ * Encode an integer into the message buffer in network byte order.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, 
+ *        updated to the position after the encoded integer.
+ * @param value The integer to encode.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ */
+int Log_UDP_Encode_Int(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+		       int value)
+{
+	int network_int;
+
+	if(((*message_buffer_position)+sizeof(int)) > message_buffer_length)
+	{
+		Log_Error_Number = 10;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Int:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),sizeof(int),message_buffer_length);
+		return FALSE;
+	}
+	network_int = htonl(value);
+	memcpy(message_buffer+(*message_buffer_position),&network_int,sizeof(int));
+	(*message_buffer_position) += sizeof(int);
 	return TRUE;
 }
 
 /**
- * Close a previously opened UDP socket.
+ * Encode a 64 bit integer (Java long) into the message buffer in network byte order.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, 
+ *        updated to the position after the encoded integer.
+ * @param value The 64 bit integer to encode.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #hton64bitl
+ */
+int Log_UDP_Encode_Int64(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+			 int64_t value)
+{
+	int64_t network_java_long;
+
+	if(((*message_buffer_position)+sizeof(int64_t)) > message_buffer_length)
+	{
+		Log_Error_Number = 10;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Int64:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),sizeof(int64_t),message_buffer_length);
+		return FALSE;
+	}
+	network_java_long = hton64bitl(value);
+	memcpy(message_buffer+(*message_buffer_position),&network_java_long,sizeof(int64_t));
+	(*message_buffer_position) += sizeof(int64_t);
+	return TRUE;
+}
+
+/**
+ * Encode a string, including it's NULL terminator, into the message buffer.
+ * The string is scanned once (strlen) and copied once (memcpy).
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, 
+ *        updated to the position after the encoded string's terminator.
+ * @param string The NULL terminated string to encode.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ */
+int Log_UDP_Encode_String(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+			  const char *string)
+{
+	size_t string_length;
+
+	/* include NULL terminator */
+	string_length = strlen(string)+1;
+	if(((*message_buffer_position)+string_length) > message_buffer_length)
+	{
+		Log_Error_Number = 10;
+		sprintf(Log_Error_String,"Log_UDP_Encode_String:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),string_length,message_buffer_length);
+		return FALSE;
+	}
+	memcpy(message_buffer+(*message_buffer_position),string,string_length);
+	(*message_buffer_position) += string_length;
+	return TRUE;
+}
+
+/**
+ * Close a previously opened UDP socket. Any rate limiter or coalescer summaries waiting to be sent over the
+ * socket are sent first, and no more are sent over it afterwards.
  * @param socket_id The socket descriptor.
  * @return The routine returns TRUE on success, and FALSE on failure. 
  *          If the routine failed, a message is printed to stderr.
+ * @see #UDP_Summary_Send
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Release
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Release
  */
 int Log_UDP_Close(int socket_id)
 {
@@ -297,6 +1217,9 @@ int Log_UDP_Close(int socket_id)
 #if DEBUG > 1
 	fprintf(stdout,"Log_UDP_Close(%d):started.\n",socket_id);
 #endif
+	/* a failed summary doesn't stop the socket closing */
+	Log_UDP_Coalesce_Release(UDP_Summary_Send,(void *)(intptr_t)socket_id);
+	Log_UDP_Rate_Limit_Release(UDP_Summary_Send,(void *)(intptr_t)socket_id);
 	retval = shutdown(socket_id,SHUT_RDWR);
 	if(retval < 0)
 	{
@@ -312,6 +1235,288 @@ int Log_UDP_Close(int socket_id)
 	return TRUE;
 }
 
+/**
+ * Set the process-wide filter. Log records with a severity lower than severity, or a verbosity higher
+ * (more verbose) than verbosity, are not sent by Log_UDP_Send_Record and the logger handle routines.
+ * Callers can test the filter with Log_UDP_Is_Enabled before creating a log record.
+ * This can be called at any time; the thresholds are plain integers, so other threads see the change 
+ * on their next log call.
+ * @param severity The lowest severity to send, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity The highest verbosity to send, a valid member of LOG_VERBOSITY.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Filter_Severity
+ * @see #Log_UDP_Filter_Verbosity
+ * @see #Log_UDP_Is_Enabled
+ */
+int Log_UDP_Filter_Set(int severity,int verbosity)
+{
+	if(!LOG_UDP_IS_SEVERITY(severity))
+	{
+		Log_Error_Number = 32;
+		sprintf(Log_Error_String,"Log_UDP_Filter_Set:severity is not a legal value(%d).",severity);
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_VERBOSITY(verbosity))
+	{
+		Log_Error_Number = 33;
+		sprintf(Log_Error_String,"Log_UDP_Filter_Set:verbosity is not a legal value(%d).",verbosity);
+		return FALSE;
+	}
+	Log_UDP_Filter_Severity = severity;
+	Log_UDP_Filter_Verbosity = verbosity;
+	return TRUE;
+}
+
+/**
+ * Set the multicast options given to sockets that send to a multicast group, by Log_UDP_Open and
+ * the logger handle's extra destinations. Sockets that are already open keep the options they were given.
+ * @param ttl The multicast time to live (hop limit), from 0 to 255. 0 keeps packets on the sending machine,
+ *        1 (the default) on the local subnet.
+ * @param loopback Whether packets are looped back to receivers on the sending machine (TRUE, the default),
+ *        or not (FALSE). Turn this off when nothing on the sending machine is listening.
+ * @param interface_address The numeric IPv4 address of the local interface to send multicast packets from,
+ *        or NULL to let the routing table choose (the default).
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Multicast_TTL
+ * @see #Multicast_Loopback
+ * @see #Multicast_Interface
+ */
+int Log_UDP_Multicast_Set(int ttl,int loopback,char *interface_address)
+{
+	struct in_addr interface_inaddr;
+
+	if((ttl < 0)||(ttl > 255))
+	{
+		Log_Error_Number = 38;
+		sprintf(Log_Error_String,"Log_UDP_Multicast_Set:Illegal time to live (%d).",ttl);
+		return FALSE;
+	}
+	if((loopback != TRUE)&&(loopback != FALSE))
+	{
+		Log_Error_Number = 39;
+		sprintf(Log_Error_String,"Log_UDP_Multicast_Set:Illegal loopback (%d).",loopback);
+		return FALSE;
+	}
+	interface_inaddr.s_addr = htonl(INADDR_ANY);
+	if(interface_address != NULL)
+	{
+		if(inet_aton(interface_address,&interface_inaddr) == 0)
+		{
+			Log_Error_Number = 40;
+			sprintf(Log_Error_String,"Log_UDP_Multicast_Set:Illegal interface address (%.64s).",
+				interface_address);
+			return FALSE;
+		}
+	}
+	Multicast_TTL = ttl;
+	Multicast_Loopback = loopback;
+	Multicast_Interface = interface_inaddr;
+	return TRUE;
+}
+
+/**
+ * If address is an IPv4 or IPv6 multicast group, give the socket the multicast options set with
+ * Log_UDP_Multicast_Set. The interface is only set for IPv4 groups; IPv6 groups use the routing table.
+ * Other addresses leave the socket unchanged.
+ * @param socket_id The socket that will send to address.
+ * @param address The address the socket will send to.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Multicast_TTL
+ * @see #Multicast_Loopback
+ * @see #Multicast_Interface
+ */
+int Log_UDP_Multicast_Configure(int socket_id,struct sockaddr_storage *address)
+{
+	struct sockaddr_in *address_in = NULL;
+	struct sockaddr_in6 *address_in6 = NULL;
+	unsigned char ttl,loopback;
+	unsigned int loopback6;
+	int socket_errno,hops;
+
+	if(address == NULL)
+	{
+		Log_Error_Number = 41;
+		sprintf(Log_Error_String,"Log_UDP_Multicast_Configure:address was NULL.");
+		return FALSE;
+	}
+	if(address->ss_family == AF_INET6)
+	{
+		address_in6 = (struct sockaddr_in6 *)address;
+		if(!IN6_IS_ADDR_MULTICAST(&(address_in6->sin6_addr)))
+			return TRUE;
+		hops = Multicast_TTL;
+		loopback6 = (unsigned int)Multicast_Loopback;
+		if((setsockopt(socket_id,IPPROTO_IPV6,IPV6_MULTICAST_HOPS,&hops,sizeof(hops)) < 0)||
+		   (setsockopt(socket_id,IPPROTO_IPV6,IPV6_MULTICAST_LOOP,&loopback6,sizeof(loopback6)) < 0))
+		{
+			socket_errno = errno;
+			Log_Error_Number = 42;
+			sprintf(Log_Error_String,"Log_UDP_Multicast_Configure:Failed to set IPv6 hop limit or loopback "
+				"(%d:%s).",socket_errno,strerror(socket_errno));
+			return FALSE;
+		}
+		return TRUE;
+	}
+	if(address->ss_family != AF_INET)
+		return TRUE;
+	address_in = (struct sockaddr_in *)address;
+	if(!IN_MULTICAST(ntohl(address_in->sin_addr.s_addr)))
+		return TRUE;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Multicast_Configure(%d):ttl %d, loopback %d.\n",socket_id,Multicast_TTL,
+		Multicast_Loopback);
+#endif
+	ttl = (unsigned char)Multicast_TTL;
+	loopback = (unsigned char)Multicast_Loopback;
+	if((setsockopt(socket_id,IPPROTO_IP,IP_MULTICAST_TTL,&ttl,sizeof(ttl)) < 0)||
+	   (setsockopt(socket_id,IPPROTO_IP,IP_MULTICAST_LOOP,&loopback,sizeof(loopback)) < 0))
+	{
+		socket_errno = errno;
+		Log_Error_Number = 42;
+		sprintf(Log_Error_String,"Log_UDP_Multicast_Configure:Failed to set time to live or loopback (%d:%s).",
+			socket_errno,strerror(socket_errno));
+		return FALSE;
+	}
+	if(Multicast_Interface.s_addr != htonl(INADDR_ANY))
+	{
+		if(setsockopt(socket_id,IPPROTO_IP,IP_MULTICAST_IF,&Multicast_Interface,
+			      sizeof(Multicast_Interface)) < 0)
+		{
+			socket_errno = errno;
+			Log_Error_Number = 43;
+			sprintf(Log_Error_String,"Log_UDP_Multicast_Configure:Failed to set interface (%d:%s).",
+				socket_errno,strerror(socket_errno));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Set the socket options given to sockets opened by Log_UDP_Open, and the logger handle's fan out
+ * sockets. Sockets that are already open keep the options they were given.
+ * A non-blocking socket never blocks the logging thread when it's send buffer is full: the packet is
+ * dropped instead, and counted in the send statistics. Packets dropped because the kernel is out of
+ * buffers (ENOBUFS) are counted the same way, whether or not the socket is non-blocking.
+ * @param non_blocking Whether sockets are non-blocking (TRUE), or block when the send buffer is full
+ *        (FALSE, the default).
+ * @param send_buffer_length The send buffer length (SO_SNDBUF) in bytes, or 0 to use the system default.
+ *        Linux doubles the value given, and limits it to net.core.wmem_max.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Socket_Non_Blocking
+ * @see #Socket_Send_Buffer_Length
+ * @see #Log_UDP_Send_Stats_Get
+ */
+int Log_UDP_Socket_Options_Set(int non_blocking,int send_buffer_length)
+{
+	if((non_blocking != TRUE)&&(non_blocking != FALSE))
+	{
+		Log_Error_Number = 44;
+		sprintf(Log_Error_String,"Log_UDP_Socket_Options_Set:Illegal non_blocking (%d).",non_blocking);
+		return FALSE;
+	}
+	if(send_buffer_length < 0)
+	{
+		Log_Error_Number = 45;
+		sprintf(Log_Error_String,"Log_UDP_Socket_Options_Set:Illegal send buffer length (%d).",
+			send_buffer_length);
+		return FALSE;
+	}
+	Socket_Non_Blocking = non_blocking;
+	Socket_Send_Buffer_Length = send_buffer_length;
+	return TRUE;
+}
+
+/**
+ * Give a socket the options set with Log_UDP_Socket_Options_Set.
+ * @param socket_id The socket.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Socket_Non_Blocking
+ * @see #Socket_Send_Buffer_Length
+ */
+int Log_UDP_Socket_Configure(int socket_id)
+{
+	int socket_errno,flags;
+
+	if(Socket_Send_Buffer_Length > 0)
+	{
+		if(setsockopt(socket_id,SOL_SOCKET,SO_SNDBUF,&Socket_Send_Buffer_Length,
+			      sizeof(Socket_Send_Buffer_Length)) < 0)
+		{
+			socket_errno = errno;
+			Log_Error_Number = 46;
+			sprintf(Log_Error_String,"Log_UDP_Socket_Configure:Failed to set send buffer length %d (%d:%s).",
+				Socket_Send_Buffer_Length,socket_errno,strerror(socket_errno));
+			return FALSE;
+		}
+	}
+	if(Socket_Non_Blocking)
+	{
+		flags = fcntl(socket_id,F_GETFL,0);
+		if((flags < 0)||(fcntl(socket_id,F_SETFL,flags|O_NONBLOCK) < 0))
+		{
+			socket_errno = errno;
+			Log_Error_Number = 47;
+			sprintf(Log_Error_String,"Log_UDP_Socket_Configure:Failed to make socket non-blocking (%d:%s).",
+				socket_errno,strerror(socket_errno));
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Get the process-wide send counters: the number of packets sent, dropped because a send buffer was full,
+ * and failed. The counters are never reset, so take the difference of two calls to get rates.
+ * @param stats The address of a structure to fill in with the counters.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Send_Stats
+ */
+int Log_UDP_Send_Stats_Get(struct Log_UDP_Send_Stats_Struct *stats)
+{
+	if(stats == NULL)
+	{
+		Log_Error_Number = 48;
+		sprintf(Log_Error_String,"Log_UDP_Send_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	stats->Packet_Count = __sync_fetch_and_add(&(Send_Stats.Packet_Count),0);
+	stats->Byte_Count = __sync_fetch_and_add(&(Send_Stats.Byte_Count),0);
+	stats->Would_Block_Drop_Count = __sync_fetch_and_add(&(Send_Stats.Would_Block_Drop_Count),0);
+	stats->No_Buffer_Drop_Count = __sync_fetch_and_add(&(Send_Stats.No_Buffer_Drop_Count),0);
+	stats->Error_Count = __sync_fetch_and_add(&(Send_Stats.Error_Count),0);
+	return TRUE;
+}
+
+/**
+ * Set whether packets too long to send in one datagram are split into fragments (see log_udp_fragment.c).
+ * This applies to every send routine. A receiver must reassemble the fragments, so this is off by default.
+ * Each fragment is counted as a packet in the send statistics. If any fragment is dropped because the
+ * send buffer is full, the rest are not sent, as the packet can't be reassembled.
+ * @param datagram_length The longest datagram sent, in bytes, between LOG_UDP_FRAGMENT_LENGTH_MIN and
+ *        LOG_UDP_FRAGMENT_LENGTH_MAX. Use LOG_UDP_FRAGMENT_PATH_MTU to fragment packets longer than the path
+ *        MTU of the socket they are sent over (under Linux, got with IP_MTU or IPV6_MTU; if the socket
+ *        is not connected, or elsewhere, LOG_UDP_FRAGMENT_DEFAULT_LENGTH is used), or 0 to turn
+ *        fragmentation off.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Fragment_Length
+ * @see #UDP_Fragment_Length_Get
+ * @see #UDP_Fragment_Send
+ * @see log_udp_fragment.html#LOG_UDP_FRAGMENT_PATH_MTU
+ */
+int Log_UDP_Fragment_Set(int datagram_length)
+{
+	if((datagram_length != 0)&&(datagram_length != LOG_UDP_FRAGMENT_PATH_MTU)&&
+	   ((datagram_length < LOG_UDP_FRAGMENT_LENGTH_MIN)||(datagram_length > LOG_UDP_FRAGMENT_LENGTH_MAX)))
+	{
+		Log_Error_Number = 49;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Set:Illegal datagram length %d.",datagram_length);
+		return FALSE;
+	}
+	Fragment_Length = datagram_length;
+	return TRUE;
+}
+
 /* ---------------------------------------------------------------
 **  Internal functions 
 ** --------------------------------------------------------------- */
@@ -321,11 +1526,19 @@ int Log_UDP_Close(int socket_id)
  * @param socket_id A previously opened and connected socket to send the buffer over.
  * @param message_buf A pointer to an area of memory containing the message to send.
  * @param message_buff_len The size of the message to send, in bytes.
+ * @param dropped The address of an integer, set to TRUE if the packet was dropped because the send buffer
+ *        was full, and FALSE otherwise. Can be NULL.
  * @return The routine returns TRUE on success, and FALSE on failure. 
- *         If the routine failed, a message is printed to stderr.
+ *         If the routine failed, a message is printed to stderr. A packet dropped because the send buffer
+ *         was full is counted, and is not a failure.
+ * @see #UDP_Send_Count
+ * @see #UDP_Send_Drop
+ * @see #UDP_Fragment_Length_Get
+ * @see #UDP_Fragment_Send
  */
-static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len)
+static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len,int *dropped)
 {
+	size_t datagram_length;
 	int retval,send_errno;
 
 #if DEBUG > 1
@@ -337,10 +1550,20 @@ static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len
 		sprintf(Log_Error_String,"UDP_Raw_Send:message_buff was NULL.");
 		return FALSE;
 	}
+	if(UDP_Fragment_Length_Get(socket_id,message_buff_len,&datagram_length))
+		return UDP_Fragment_Send(socket_id,NULL,0,message_buff,message_buff_len,datagram_length,dropped);
+	if(dropped != NULL)
+		(*dropped) = FALSE;
 	retval = send(socket_id,message_buff,message_buff_len,0);
 	if(retval < 0)
 	{
 		send_errno = errno;
+		if(UDP_Send_Drop(send_errno))
+		{
+			if(dropped != NULL)
+				(*dropped) = TRUE;
+			return TRUE;
+		}
        		Log_Error_Number = 12;
 		sprintf(Log_Error_String,"UDP_Raw_Send:Send failed %d (%s).",send_errno,strerror(send_errno));
 		return FALSE;
@@ -351,12 +1574,229 @@ static int UDP_Raw_Send(int socket_id,void *message_buff,size_t message_buff_len
 		sprintf(Log_Error_String,"UDP_Raw_Send:Send returned %d vs %d.",retval,message_buff_len);
 		return FALSE;
 	}
+	UDP_Send_Count(1,message_buff_len);
 #if DEBUG > 1
 	fprintf(stdout,"UDP_Raw_Send(%d):finished.\n",socket_id);
 #endif
 	return TRUE;
 }
 
+/**
+ * Count packets that were sent.
+ * @param packet_count The number of packets sent.
+ * @param byte_count The number of bytes sent.
+ * @see #Send_Stats
+ */
+static void UDP_Send_Count(int packet_count,size_t byte_count)
+{
+	__sync_fetch_and_add(&(Send_Stats.Packet_Count),packet_count);
+	__sync_fetch_and_add(&(Send_Stats.Byte_Count),byte_count);
+}
+
+/**
+ * Count a packet that failed to send, and decide whether the failure is a drop or an error.
+ * EAGAIN/EWOULDBLOCK (a non-blocking socket's send buffer is full) and ENOBUFS (the kernel is out of buffers)
+ * are drops: the packet is lost but the socket is fine, so the caller should carry on.
+ * @param send_errno The errno the send call failed with.
+ * @return The routine returns TRUE if the packet was dropped, and FALSE if the send failed.
+ * @see #Send_Stats
+ */
+static int UDP_Send_Drop(int send_errno)
+{
+	if((send_errno == EAGAIN)||(send_errno == EWOULDBLOCK))
+	{
+		__sync_fetch_and_add(&(Send_Stats.Would_Block_Drop_Count),1);
+		return TRUE;
+	}
+	if(send_errno == ENOBUFS)
+	{
+		__sync_fetch_and_add(&(Send_Stats.No_Buffer_Drop_Count),1);
+		return TRUE;
+	}
+	__sync_fetch_and_add(&(Send_Stats.Error_Count),1);
+	return FALSE;
+}
+
+/**
+ * Decide whether a packet is split into fragments, and how long the fragment datagrams are.
+ * When fragmenting to the path MTU, packets no longer than LOG_UDP_FRAGMENT_LENGTH_SAFE are sent without
+ * asking the kernel for the MTU. Unix domain sockets have no MTU, and only fragment packets longer than
+ * LOG_UDP_FRAGMENT_LENGTH_MAX, so any receiver can relay them over UDP.
+ * @param socket_id The socket the packet is sent over.
+ * @param message_buff_len The length of the packet in bytes.
+ * @param datagram_length The address of a size_t, filled in with the longest fragment datagram if the packet
+ *        is fragmented.
+ * @return The routine returns TRUE if the packet should be fragmented, and FALSE if it is sent as it is.
+ * @see #Fragment_Length
+ * @see #UDP_IPV4_HEADER_LENGTH
+ * @see #UDP_IPV6_HEADER_LENGTH
+ */
+static int UDP_Fragment_Length_Get(int socket_id,size_t message_buff_len,size_t *datagram_length)
+{
+#ifdef __linux
+	struct sockaddr_storage local_address;
+	socklen_t mtu_length,local_address_length;
+	int mtu;
+#endif
+
+	if(Fragment_Length == 0)
+		return FALSE;
+	if(Fragment_Length > 0)
+	{
+		(*datagram_length) = Fragment_Length;
+		return (message_buff_len > (size_t)Fragment_Length);
+	}
+	if(message_buff_len <= LOG_UDP_FRAGMENT_LENGTH_SAFE)
+		return FALSE;
+	(*datagram_length) = LOG_UDP_FRAGMENT_DEFAULT_LENGTH;
+#ifdef __linux
+	mtu_length = sizeof(mtu);
+	if(getsockopt(socket_id,IPPROTO_IP,IP_MTU,&mtu,&mtu_length) == 0)
+		(*datagram_length) = mtu-UDP_IPV4_HEADER_LENGTH;
+	else
+	{
+		mtu_length = sizeof(mtu);
+		if(getsockopt(socket_id,IPPROTO_IPV6,IPV6_MTU,&mtu,&mtu_length) == 0)
+			(*datagram_length) = mtu-UDP_IPV6_HEADER_LENGTH;
+		else
+		{
+			/* a Unix domain socket has no MTU, so only packets too long for UDP are fragmented */
+			local_address_length = sizeof(local_address);
+			if((getsockname(socket_id,(struct sockaddr *)&local_address,&local_address_length) == 0)&&
+			   (local_address.ss_family == AF_UNIX))
+				(*datagram_length) = LOG_UDP_FRAGMENT_LENGTH_MAX;
+		}
+	}
+#endif
+	if((*datagram_length) < LOG_UDP_FRAGMENT_LENGTH_SAFE)
+		(*datagram_length) = LOG_UDP_FRAGMENT_LENGTH_SAFE;
+	if((*datagram_length) > LOG_UDP_FRAGMENT_LENGTH_MAX)
+		(*datagram_length) = LOG_UDP_FRAGMENT_LENGTH_MAX;
+	return (message_buff_len > (*datagram_length));
+}
+
+/**
+ * Send a packet as fragment datagrams. Each fragment is sent with a two entry iovec (the header, and the
+ * fragment's part of the packet), so the packet is not copied. Under Linux the fragments are passed to the
+ * kernel UDP_BATCH_LENGTH at a time with sendmmsg, on other systems one sendmsg call per fragment is used.
+ * @param socket_id The socket to send over.
+ * @param address The destination address, or NULL if the socket is connected.
+ * @param address_length The length of address.
+ * @param message_buff The encoded packet.
+ * @param message_buff_len The length of the packet in bytes.
+ * @param datagram_length The longest fragment datagram, including the header.
+ * @param dropped The address of an integer, set to TRUE if a fragment was dropped because the send buffer
+ *        was full, and FALSE otherwise. Can be NULL.
+ * @return The routine returns TRUE on success (including a drop) and FALSE on failure.
+ * @see #UDP_BATCH_LENGTH
+ * @see #UDP_Send_Count
+ * @see #UDP_Send_Drop
+ * @see log_udp_fragment.html#Log_UDP_Fragment_Count_Get
+ * @see log_udp_fragment.html#Log_UDP_Fragment_Header_Encode
+ */
+static int UDP_Fragment_Send(int socket_id,struct sockaddr_storage *address,socklen_t address_length,
+			     char *message_buff,size_t message_buff_len,size_t datagram_length,int *dropped)
+{
+	char header_list[UDP_BATCH_LENGTH][LOG_UDP_FRAGMENT_HEADER_LENGTH];
+	struct iovec iovec_list[UDP_BATCH_LENGTH][2];
+#ifdef __linux
+	struct mmsghdr message_header_list[UDP_BATCH_LENGTH];
+	int message_index;
+#else
+	struct msghdr message_header;
+#endif
+	size_t payload_length,offset;
+	unsigned int message_id;
+	int fragment_count,batch_start,batch_count,retval,send_errno,i;
+
+	if(dropped != NULL)
+		(*dropped) = FALSE;
+	if(!Log_UDP_Fragment_Count_Get(message_buff_len,datagram_length,&fragment_count))
+		return FALSE;
+	payload_length = datagram_length-LOG_UDP_FRAGMENT_HEADER_LENGTH;
+	message_id = Log_UDP_Fragment_Message_Id_Get();
+#if DEBUG > 1
+	fprintf(stdout,"UDP_Fragment_Send(socket=%d,length=%d):Sending message %u in %d fragments.\n",socket_id,
+		message_buff_len,message_id,fragment_count);
+#endif
+	for(batch_start = 0; batch_start < fragment_count; batch_start += UDP_BATCH_LENGTH)
+	{
+		batch_count = fragment_count-batch_start;
+		if(batch_count > UDP_BATCH_LENGTH)
+			batch_count = UDP_BATCH_LENGTH;
+		for(i = 0; i < batch_count; i++)
+		{
+			offset = ((size_t)(batch_start+i))*payload_length;
+			Log_UDP_Fragment_Header_Encode(header_list[i],message_id,batch_start+i,fragment_count,
+						       message_buff_len);
+			iovec_list[i][0].iov_base = header_list[i];
+			iovec_list[i][0].iov_len = LOG_UDP_FRAGMENT_HEADER_LENGTH;
+			iovec_list[i][1].iov_base = message_buff+offset;
+			iovec_list[i][1].iov_len = message_buff_len-offset;
+			if(iovec_list[i][1].iov_len > payload_length)
+				iovec_list[i][1].iov_len = payload_length;
+#ifdef __linux
+			memset(&(message_header_list[i]),0,sizeof(struct mmsghdr));
+			message_header_list[i].msg_hdr.msg_name = address;
+			message_header_list[i].msg_hdr.msg_namelen = address_length;
+			message_header_list[i].msg_hdr.msg_iov = iovec_list[i];
+			message_header_list[i].msg_hdr.msg_iovlen = 2;
+#endif
+		}
+#ifdef __linux
+		message_index = 0;
+		while(message_index < batch_count)
+		{
+			retval = sendmmsg(socket_id,message_header_list+message_index,batch_count-message_index,0);
+			if(retval < 0)
+			{
+				/* the packet can't be reassembled without this fragment, so don't send the rest */
+				send_errno = errno;
+				if(UDP_Send_Drop(send_errno))
+				{
+					if(dropped != NULL)
+						(*dropped) = TRUE;
+					return TRUE;
+				}
+				Log_Error_Number = 50;
+				sprintf(Log_Error_String,"UDP_Fragment_Send:sendmmsg failed for fragment %d of %d: %d (%s).",
+					batch_start+message_index,fragment_count,send_errno,strerror(send_errno));
+				return FALSE;
+			}
+			for(i = message_index; i < message_index+retval; i++)
+				UDP_Send_Count(1,message_header_list[i].msg_len);
+			message_index += retval;
+		}
+#else
+		for(i = 0; i < batch_count; i++)
+		{
+			memset(&message_header,0,sizeof(struct msghdr));
+			message_header.msg_name = address;
+			message_header.msg_namelen = address_length;
+			message_header.msg_iov = iovec_list[i];
+			message_header.msg_iovlen = 2;
+			retval = sendmsg(socket_id,&message_header,0);
+			if(retval < 0)
+			{
+				send_errno = errno;
+				if(UDP_Send_Drop(send_errno))
+				{
+					if(dropped != NULL)
+						(*dropped) = TRUE;
+					return TRUE;
+				}
+				Log_Error_Number = 50;
+				sprintf(Log_Error_String,"UDP_Fragment_Send:sendmsg failed for fragment %d of %d: %d (%s).",
+					batch_start+i,fragment_count,send_errno,strerror(send_errno));
+				return FALSE;
+			}
+			UDP_Send_Count(1,retval);
+		}
+#endif
+	}
+	return TRUE;
+}
+
 /**
  * Get some data from the specified socket. This routine blocks until a message arrives, 
  * if the socket is <b>not</b> set to nonblocking.
@@ -421,97 +1861,111 @@ static int64_t hton64bitl(int64_t n)
 }
 
 /**
- * Internal routine to get a host address from it's name. This is traditionally handled by a call
- * to gethostbyname. Unfortunately that routine is not re-entrant because the pointer it returns
- * is to a block of reusable memory in glibc, so a second call to gethostbyname from another thread
- * in the process can lead to the pointers returned from the first call being freed leading to SIGSEGV.
- * This routine wraps gethostbyname_r, the re-entrant version of that routine.
- * @param name The hostname to translate. This should be allocated, zero-terminated and non-null.
- * @param inaddr The address of a struct in_addr, filled by the first entry returned by gethostbyname_r. 
- *        NULL can be returned on failure.
- * @return The routine returns TRUE on success and FALSE on failure.
+ * Create the thread specific data key used to find each thread's send buffer. Called once only
+ * via pthread_once.
+ * @see #Send_Buffer_Key
+ * @see #Send_Buffer_Destroy
+ */
+static void Send_Buffer_Key_Create(void)
+{
+	pthread_key_create(&Send_Buffer_Key,Send_Buffer_Destroy);
+}
+
+/**
+ * Free a thread's send buffer, called when the thread exits.
+ * @param send_buffer A pointer to the thread's Send_Buffer_Struct.
+ * @see #Send_Buffer_Struct
+ */
+static void Send_Buffer_Destroy(void *send_buffer)
+{
+	struct Send_Buffer_Struct *buffer = (struct Send_Buffer_Struct *)send_buffer;
+
+	if(buffer == NULL)
+		return;
+	if(buffer->Buffer != NULL)
+		free(buffer->Buffer);
+	free(buffer);
+}
+
+/**
+ * Get the calling thread's send buffer, making sure it is at least message_buffer_length bytes long.
+ * The buffer is only (re-)allocated the first time a thread calls this routine, or when a longer buffer
+ * than any previous one is requested.
+ * @param message_buffer_length The length of buffer required in bytes.
+ * @return A pointer to the buffer, or NULL if an error occured (Log_Error_Number and Log_Error_String are set).
+ * @see #Send_Buffer_Key
+ * @see #Send_Buffer_Key_Once
+ * @see #Send_Buffer_Key_Create
+ * @see #Send_Buffer_Struct
  */
-static int Get_Host_By_Name(const char *name,struct in_addr *inaddr)
+static char *Send_Buffer_Get(size_t message_buffer_length)
 {
-	struct hostent hostbuf,*hp = NULL;
-	size_t hstbuflen;
-	char *tmphstbuf = NULL;
-	int retval;
-	int herr;
+	struct Send_Buffer_Struct *buffer = NULL;
+	char *new_buffer = NULL;
 
-	Log_Error_Number = 0;
-	if(name == NULL)
+	pthread_once(&Send_Buffer_Key_Once,Send_Buffer_Key_Create);
+	buffer = (struct Send_Buffer_Struct *)pthread_getspecific(Send_Buffer_Key);
+	if(buffer == NULL)
 	{
-		Log_Error_Number = 3;
-		sprintf(Log_Error_String,"Get_Host_By_Name:name was NULL.");
-		return FALSE;
+		buffer = (struct Send_Buffer_Struct *)malloc(sizeof(struct Send_Buffer_Struct));
+		if(buffer == NULL)
+		{
+			Log_Error_Number = 9;
+			sprintf(Log_Error_String,"Send_Buffer_Get:Failed to allocate send buffer structure.");
+			return NULL;
+		}
+		buffer->Buffer = NULL;
+		buffer->Length = 0;
+		pthread_setspecific(Send_Buffer_Key,buffer);
 	}
-	if(inaddr == NULL)
+	if(buffer->Length < message_buffer_length)
 	{
-		Log_Error_Number = 4;
-		sprintf(Log_Error_String,"Get_Host_By_Name:inaddr was NULL.");
-		return FALSE;
+		new_buffer = (char*)realloc(buffer->Buffer,message_buffer_length*sizeof(char));
+		if(new_buffer == NULL)
+		{
+			Log_Error_Number = 9;
+			sprintf(Log_Error_String,"Send_Buffer_Get:Failed to allocate message buffer(%d).",
+				message_buffer_length);
+			return NULL;
+		}
+		buffer->Buffer = new_buffer;
+		buffer->Length = message_buffer_length;
 	}
-#if DEBUG > 5
-	fprintf(stdout,"Get_Host_By_Name(%s) Started.",name);
-#endif /* DEBUG */
-	hstbuflen = 1024;
-	/* Allocate buffer, remember to free it to avoid memory leakage.  */
-	tmphstbuf = malloc(hstbuflen);
-	if(tmphstbuf == NULL)
+	return buffer->Buffer;
+}
+
+/**
+ * Summary send routine passed to the rate limiter and coalescer by the routines sending over a socket.
+ * The summary is encoded into a buffer on the stack, as the calling thread's send buffer may hold a batch
+ * being encoded, and sent over the socket with Log_UDP_Send_Encoded.
+ * @param summary_arg The socket descriptor, cast to a pointer.
+ * @param log_record The address of the summary record.
+ * @param log_context_count The number of context records in log_context_list, at most UDP_SUMMARY_CONTEXT_COUNT.
+ * @param log_context_list The summary record's contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #UDP_SUMMARY_CONTEXT_COUNT
+ * @see #Log_UDP_Encode
+ * @see #Log_UDP_Send_Encoded
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Allow
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Allow
+ */
+static int UDP_Summary_Send(void *summary_arg,const struct Log_Record_Struct *log_record,
+			    int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	char message_buffer[LOG_UDP_BUFFER_LENGTH(UDP_SUMMARY_CONTEXT_COUNT)];
+	size_t message_buffer_position;
+
+	if(log_context_count > UDP_SUMMARY_CONTEXT_COUNT)
 	{
-		Log_Error_Number = 18;
-		sprintf(Log_Error_String,"Get_Host_By_Name:memory allocation of tmphstbuf failed(%d).",hstbuflen);
+		Log_Error_Number = 52;
+		sprintf(Log_Error_String,"UDP_Summary_Send:Too many summary contexts(%d > %d).",log_context_count,
+			UDP_SUMMARY_CONTEXT_COUNT);
 		return FALSE;
-
 	}
-	while((retval = gethostbyname_r(name,&hostbuf,tmphstbuf,hstbuflen,&hp,&herr)) == ERANGE)
-	{
-		/* Enlarge the buffer.  */
-		hstbuflen *= 2;
-		tmphstbuf = realloc(tmphstbuf, hstbuflen);
-		/* check realloc succeeds */
-		if(tmphstbuf == NULL)
-		{
-			Log_Error_Number = 19;
-			sprintf(Log_Error_String,"Get_Host_By_Name:memory reallocation of tmphstbuf failed(%d).",
-				hstbuflen);
-			return FALSE;
-		}
-#if DEBUG > 5
-	fprintf(stdout,"Get_Host_By_Name:gethostbyname_r returned ERANGE:Increasing buffer size to %d.",hstbuflen);
-#endif /* DEBUG */
-	}/* while */
-#if DEBUG > 5
-	fprintf(stdout,"Get_Host_By_Name:gethostbyname_r loop exited with retval %d and hp %p.",retval,hp);
-#endif /* DEBUG */
-	if(retval != 0)
-	{
-		if(tmphstbuf != NULL)
-			free(tmphstbuf);
-		Log_Error_Number = 20;
-		sprintf(Log_Error_String,"Get_Host_By_Name:gethostbyname_r failed to find host %s (%d).",name,herr);
-		return FALSE;
-	}
-	if(hp == NULL)
-	{
-		if(tmphstbuf != NULL)
-			free(tmphstbuf);
-		Log_Error_Number = 21;
-		sprintf(Log_Error_String,
-			"Get_Host_By_Name:gethostbyname_r returned NULL return pointer for hostname %s (%d).",
-			name,herr);
-		return FALSE;
-	}
-	/* copy result */
-	(*inaddr) = *(struct in_addr *)(hp->h_addr_list[0]);
-	/* free buffer*/
-	if(tmphstbuf != NULL)
-		free(tmphstbuf);
-#if DEBUG > 5
-	fprintf(stdout,"Get_Host_By_Name(%s) Finished.",name);
-#endif /* DEBUG */
-	return TRUE;
+	if(!Log_UDP_Encode(log_record,log_context_count,log_context_list,message_buffer,sizeof(message_buffer),
+			   &message_buffer_position))
+		return FALSE;
+	return Log_UDP_Send_Encoded((int)(intptr_t)summary_arg,message_buffer,message_buffer_position);
 }
 
 /*
@@ -0,0 +1,791 @@
+/* log_udp_async.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Asynchronous sending of log records. Callers queue log records onto a bounded lock-free
+ * multi-producer queue, and a dedicated sender thread takes them off the queue and sends them using
+ * Log_UDP_Send_Record. This means logging never blocks the calling thread on a send (unless the
+ * LOG_UDP_ASYNC_OVERFLOW_BLOCK overflow policy is selected and the queue is full).
+ * The queue is an array of slots, each with a sequence number used to hand the slot between the queueing
+ * threads and the sender thread (see Dmitry Vyukov's bounded MPMC queue).
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1c threads and
+ * POSIX.4/IEEE1003.1b-1993 clock_gettime prototypes.
+ */
+#define _POSIX_C_SOURCE 199506L
+#include <errno.h>   /* Error number definitions */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_async.h"
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                   (1000000000)
+/**
+ * The maximum length of time the sender thread sleeps (in milliseconds) before re-checking the queue,
+ * in case a wake up signal was missed.
+ */
+#define SENDER_WAIT_MS                  (100)
+/**
+ * The maximum length of time a blocked Log_UDP_Async_Send or Log_UDP_Flush sleeps (in milliseconds) before
+ * re-checking the queue, in case a wake up signal was missed.
+ */
+#define PROGRESS_WAIT_MS                (10)
+
+/* structures */
+/**
+ * A slot in the queue of records waiting to be sent.
+ * <dl>
+ * <dt>Sequence</dt> <dd>The slot's sequence number. This is equal to the queue position when the slot is free to
+ *     be filled, and one more than the queue position when the slot is filled and ready to be sent.</dd>
+ * <dt>Valid</dt> <dd>Whether the slot was filled successfully (copying the contexts can fail).</dd>
+ * <dt>Log_Record</dt> <dd>A copy of the log record to send.</dd>
+ * <dt>Log_Context_Count</dt> <dd>The number of contexts in Log_Context_List.</dd>
+ * <dt>Log_Context_Allocated_Count</dt> <dd>The number of contexts allocated in Log_Context_List.
+ *     The list is only reallocated when a record with more contexts than this is queued in this slot.</dd>
+ * <dt>Log_Context_List</dt> <dd>A copy of the log record's contexts.</dd>
+ * </dl>
+ */
+struct Async_Slot_Struct
+{
+	volatile unsigned long Sequence;
+	int Valid;
+	struct Log_Record_Struct Log_Record;
+	int Log_Context_Count;
+	int Log_Context_Allocated_Count;
+	struct Log_Context_Struct *Log_Context_List;
+};
+
+/**
+ * Data for one asynchronous sender.
+ * <dl>
+ * <dt>Socket_Id</dt> <dd>The previously opened socket the sender thread sends records over.</dd>
+ * <dt>Overflow</dt> <dd>What to do when the queue is full, a member of LOG_UDP_ASYNC_OVERFLOW.</dd>
+ * <dt>Block_Timeout_Ms</dt> <dd>How long to wait for room in the queue with LOG_UDP_ASYNC_OVERFLOW_BLOCK.</dd>
+ * <dt>Queue_Mask</dt> <dd>The number of slots in the queue minus one (the number of slots is a power of 2).</dd>
+ * <dt>Slot_List</dt> <dd>The queue's slots.</dd>
+ * <dt>Enqueue_Position</dt> <dd>The next queue position to fill.</dd>
+ * <dt>Dequeue_Position</dt> <dd>The next queue position to send.</dd>
+ * <dt>Queued_Count</dt> <dd>The number of records queued.</dd>
+ * <dt>Sent_Count</dt> <dd>The number of records sent.</dd>
+ * <dt>Failed_Count</dt> <dd>The number of records the sender thread failed to send.</dd>
+ * <dt>Dropped_Count</dt> <dd>The number of records dropped because the queue was full.</dd>
+ * <dt>Completed_Count</dt> <dd>The number of queue positions finished with (sent, failed or dropped).</dd>
+ * <dt>Error_Number</dt> <dd>The error number of the last record the sender thread failed to send, or 0.</dd>
+ * <dt>Error_String</dt> <dd>The error string of the last record the sender thread failed to send.</dd>
+ * <dt>Sender_Waiting</dt> <dd>Set when the sender thread is waiting on Sender_Condition for a record.</dd>
+ * <dt>Waiter_Count</dt> <dd>The number of threads waiting on Progress_Condition.</dd>
+ * <dt>Quit</dt> <dd>Set to make the sender thread exit once the queue is empty.</dd>
+ * <dt>Sender_Thread</dt> <dd>The sender thread.</dd>
+ * <dt>Mutex</dt> <dd>Mutex used with Sender_Condition and Progress_Condition, and to protect Error_Number
+ *     and Error_String. It is not used to queue or send records.</dd>
+ * <dt>Sender_Condition</dt> <dd>Signalled to wake the sender thread when a record is queued.</dd>
+ * <dt>Progress_Condition</dt> <dd>Broadcast by the sender thread when a queue position is finished with.</dd>
+ * </dl>
+ * @see #Async_Slot_Struct
+ * @see log_udp_async.html#LOG_UDP_ASYNC_OVERFLOW
+ */
+struct Log_UDP_Async_Struct
+{
+	int Socket_Id;
+	int Overflow;
+	int Block_Timeout_Ms;
+	unsigned long Queue_Mask;
+	struct Async_Slot_Struct *Slot_List;
+	volatile unsigned long Enqueue_Position;
+	volatile unsigned long Dequeue_Position;
+	volatile unsigned long Queued_Count;
+	volatile unsigned long Sent_Count;
+	volatile unsigned long Failed_Count;
+	volatile unsigned long Dropped_Count;
+	volatile unsigned long Completed_Count;
+	int Error_Number;
+	char Error_String[LOG_GENERAL_ERROR_LENGTH];
+	volatile int Sender_Waiting;
+	volatile int Waiter_Count;
+	volatile int Quit;
+	pthread_t Sender_Thread;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Sender_Condition;
+	pthread_cond_t Progress_Condition;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static void *Async_Sender_Thread(void *user_arg);
+static int Async_Enqueue_Claim(Log_UDP_Async_T async,struct Async_Slot_Struct **slot,unsigned long *position);
+static void Async_Enqueue_Release(struct Async_Slot_Struct *slot,unsigned long position);
+static int Async_Dequeue_Claim(Log_UDP_Async_T async,struct Async_Slot_Struct **slot,unsigned long *position);
+static void Async_Dequeue_Release(Log_UDP_Async_T async,struct Async_Slot_Struct *slot,unsigned long position);
+static int Async_Is_Empty(Log_UDP_Async_T async);
+static int Async_Slot_Fill(struct Async_Slot_Struct *slot,const struct Log_Record_Struct *log_record,
+			   int log_context_count,const struct Log_Context_Struct *log_context_list);
+static unsigned long Async_Load(volatile unsigned long *value);
+static void Async_Store(volatile unsigned long *value,unsigned long new_value);
+static void Async_Time_Add(struct timespec *abs_time,int milliseconds);
+static int Async_Time_Passed(struct timespec *abs_time);
+static void Async_Progress_Wait(Log_UDP_Async_T async,int timeout_ms,struct timespec *deadline);
+static void Async_Error_Save(Log_UDP_Async_T async);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Create an asynchronous sender, and start it's sender thread.
+ * @param socket_id A previously opened socket (see Log_UDP_Open) the sender thread sends records over.
+ *        The socket is not closed by Log_UDP_Async_Close.
+ * @param queue_length The maximum number of records that can be waiting to be sent. This is rounded up to
+ *        a power of two.
+ * @param overflow What Log_UDP_Async_Send does when the queue is full, a member of LOG_UDP_ASYNC_OVERFLOW.
+ * @param block_timeout_ms With LOG_UDP_ASYNC_OVERFLOW_BLOCK, how long Log_UDP_Async_Send waits for room
+ *        in the queue, in milliseconds. A negative number waits forever.
+ * @param async The address of a Log_UDP_Async_T to fill in with the created sender.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Async_Struct
+ * @see #Async_Sender_Thread
+ * @see log_udp_async.html#LOG_UDP_ASYNC_OVERFLOW
+ */
+int Log_UDP_Async_Open(int socket_id,int queue_length,int overflow,int block_timeout_ms,Log_UDP_Async_T *async)
+{
+	Log_UDP_Async_T new_async = NULL;
+	unsigned long slot_count,i;
+	int retval;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Async_Open(socket=%d,queue_length=%d):started.\n",socket_id,queue_length);
+#endif
+	if(queue_length < 1)
+	{
+		Log_Error_Number = 200;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:queue_length should be positive(%d).",queue_length);
+		return FALSE;
+	}
+	if(!LOG_UDP_ASYNC_IS_OVERFLOW(overflow))
+	{
+		Log_Error_Number = 201;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:overflow is not a legal value(%d).",overflow);
+		return FALSE;
+	}
+	if(async == NULL)
+	{
+		Log_Error_Number = 202;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:async was NULL.");
+		return FALSE;
+	}
+	new_async = (Log_UDP_Async_T)calloc(1,sizeof(struct Log_UDP_Async_Struct));
+	if(new_async == NULL)
+	{
+		Log_Error_Number = 203;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:Failed to allocate async structure.");
+		return FALSE;
+	}
+	/* round queue length up to a power of two, so positions can be masked into slot indexes */
+	slot_count = 1;
+	while(slot_count < (unsigned long)queue_length)
+		slot_count <<= 1;
+	new_async->Slot_List = (struct Async_Slot_Struct *)calloc(slot_count,sizeof(struct Async_Slot_Struct));
+	if(new_async->Slot_List == NULL)
+	{
+		free(new_async);
+		Log_Error_Number = 204;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:Failed to allocate %lu queue slots.",slot_count);
+		return FALSE;
+	}
+	for(i = 0; i < slot_count; i++)
+		new_async->Slot_List[i].Sequence = i;
+	new_async->Queue_Mask = slot_count-1;
+	new_async->Socket_Id = socket_id;
+	new_async->Overflow = overflow;
+	new_async->Block_Timeout_Ms = block_timeout_ms;
+	pthread_mutex_init(&(new_async->Mutex),NULL);
+	pthread_cond_init(&(new_async->Sender_Condition),NULL);
+	pthread_cond_init(&(new_async->Progress_Condition),NULL);
+	retval = pthread_create(&(new_async->Sender_Thread),NULL,Async_Sender_Thread,(void *)new_async);
+	if(retval != 0)
+	{
+		pthread_cond_destroy(&(new_async->Progress_Condition));
+		pthread_cond_destroy(&(new_async->Sender_Condition));
+		pthread_mutex_destroy(&(new_async->Mutex));
+		free(new_async->Slot_List);
+		free(new_async);
+		Log_Error_Number = 205;
+		sprintf(Log_Error_String,"Log_UDP_Async_Open:Failed to create sender thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	(*async) = new_async;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Async_Open:finished with %lu slots.\n",slot_count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Queue a log record to be sent by the sender thread. The record and it's contexts are copied, so the caller
+ * can re-use them as soon as this routine returns. Once the queue slots have been used a few times no
+ * memory is allocated.
+ * @param async The asynchronous sender, created by Log_UDP_Async_Open.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE if the record was queued, and FALSE if it failed or was dropped
+ *         because the queue was full.
+ * @see #Async_Enqueue_Claim
+ * @see #Async_Enqueue_Release
+ * @see #Async_Dequeue_Claim
+ * @see #Async_Dequeue_Release
+ * @see #Async_Slot_Fill
+ * @see #Async_Progress_Wait
+ * @see log_udp_async.html#LOG_UDP_ASYNC_OVERFLOW
+ */
+int Log_UDP_Async_Send(Log_UDP_Async_T async,const struct Log_Record_Struct *log_record,
+		       int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	struct Async_Slot_Struct *slot = NULL;
+	struct Async_Slot_Struct *dropped_slot = NULL;
+	struct timespec deadline;
+	unsigned long position,dropped_position;
+	int valid;
+
+	if(async == NULL)
+	{
+		Log_Error_Number = 206;
+		sprintf(Log_Error_String,"Log_UDP_Async_Send:async was NULL.");
+		return FALSE;
+	}
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 207;
+		sprintf(Log_Error_String,"Log_UDP_Async_Send:log_record was NULL.");
+		return FALSE;
+	}
+	if((log_context_count < 0)||((log_context_count > 0)&&(log_context_list == NULL)))
+	{
+		Log_Error_Number = 208;
+		sprintf(Log_Error_String,"Log_UDP_Async_Send:Illegal log context list (count %d).",log_context_count);
+		return FALSE;
+	}
+	if(async->Overflow == LOG_UDP_ASYNC_OVERFLOW_BLOCK)
+	{
+		clock_gettime(CLOCK_REALTIME,&deadline);
+		Async_Time_Add(&deadline,async->Block_Timeout_Ms);
+	}
+	while(!Async_Enqueue_Claim(async,&slot,&position))
+	{
+		/* the queue is full */
+		if(async->Overflow == LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST)
+		{
+			/* take the oldest record off the queue and throw it away */
+			if(Async_Dequeue_Claim(async,&dropped_slot,&dropped_position))
+			{
+				__sync_fetch_and_add(&(async->Dropped_Count),1);
+				Async_Dequeue_Release(async,dropped_slot,dropped_position);
+			}
+		}
+		else if((async->Overflow == LOG_UDP_ASYNC_OVERFLOW_BLOCK)&&
+			((async->Block_Timeout_Ms < 0)||(!Async_Time_Passed(&deadline))))
+		{
+			Async_Progress_Wait(async,async->Block_Timeout_Ms,&deadline);
+		}
+		else
+		{
+			__sync_fetch_and_add(&(async->Dropped_Count),1);
+			Log_Error_Number = 209;
+			sprintf(Log_Error_String,"Log_UDP_Async_Send:Queue full, record dropped.");
+			return FALSE;
+		}
+	}
+	valid = Async_Slot_Fill(slot,log_record,log_context_count,log_context_list);
+	slot->Valid = valid;
+	Async_Enqueue_Release(slot,position);
+	__sync_fetch_and_add(&(async->Queued_Count),1);
+	/* wake the sender thread, if it is waiting for a record */
+	__sync_synchronize();
+	if(async->Sender_Waiting)
+	{
+		pthread_mutex_lock(&(async->Mutex));
+		pthread_cond_signal(&(async->Sender_Condition));
+		pthread_mutex_unlock(&(async->Mutex));
+	}
+	return valid;
+}
+
+/**
+ * Wait until every record queued before this routine was called has been sent (or has failed/been dropped).
+ * @param async The asynchronous sender, created by Log_UDP_Async_Open.
+ * @param timeout_ms How long to wait in milliseconds. A negative number waits forever.
+ * @return The routine returns TRUE if the queue was flushed, and FALSE on failure or timeout.
+ * @see #Async_Progress_Wait
+ */
+int Log_UDP_Flush(Log_UDP_Async_T async,int timeout_ms)
+{
+	struct timespec deadline;
+	unsigned long target_position;
+
+	if(async == NULL)
+	{
+		Log_Error_Number = 210;
+		sprintf(Log_Error_String,"Log_UDP_Flush:async was NULL.");
+		return FALSE;
+	}
+	target_position = Async_Load(&(async->Enqueue_Position));
+	clock_gettime(CLOCK_REALTIME,&deadline);
+	Async_Time_Add(&deadline,timeout_ms);
+	while(Async_Load(&(async->Completed_Count)) < target_position)
+	{
+		if((timeout_ms >= 0)&&Async_Time_Passed(&deadline))
+		{
+			Log_Error_Number = 211;
+			sprintf(Log_Error_String,"Log_UDP_Flush:Timed out after %d ms with %lu records still queued.",
+				timeout_ms,target_position-Async_Load(&(async->Completed_Count)));
+			return FALSE;
+		}
+		Async_Progress_Wait(async,timeout_ms,&deadline);
+	}
+	return TRUE;
+}
+
+/**
+ * Get the asynchronous sender's counters. Any of the count addresses can be NULL.
+ * @param async The asynchronous sender, created by Log_UDP_Async_Open.
+ * @param queued_count The address of an unsigned long to fill with the number of records queued.
+ * @param sent_count The address of an unsigned long to fill with the number of records sent.
+ * @param failed_count The address of an unsigned long to fill with the number of records that failed to send.
+ * @param dropped_count The address of an unsigned long to fill with the number of records dropped
+ *        because the queue was full.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Async_Statistics_Get(Log_UDP_Async_T async,unsigned long *queued_count,
+				 unsigned long *sent_count,unsigned long *failed_count,
+				 unsigned long *dropped_count)
+{
+	if(async == NULL)
+	{
+		Log_Error_Number = 212;
+		sprintf(Log_Error_String,"Log_UDP_Async_Statistics_Get:async was NULL.");
+		return FALSE;
+	}
+	if(queued_count != NULL)
+		(*queued_count) = Async_Load(&(async->Queued_Count));
+	if(sent_count != NULL)
+		(*sent_count) = Async_Load(&(async->Sent_Count));
+	if(failed_count != NULL)
+		(*failed_count) = Async_Load(&(async->Failed_Count));
+	if(dropped_count != NULL)
+		(*dropped_count) = Async_Load(&(async->Dropped_Count));
+	return TRUE;
+}
+
+/**
+ * Get the error the sender thread reported for the last record it failed to send. The sender thread has
+ * it's own copy of Log_Error_Number and Log_Error_String, so it's errors are kept here for the caller.
+ * @param async The asynchronous sender, created by Log_UDP_Async_Open.
+ * @param error_number The address of an integer to fill with the error number. This is 0 if no record
+ *        has failed to send. Can be NULL.
+ * @param error_string An allocated string at least LOG_GENERAL_ERROR_LENGTH long, to fill with the
+ *        error string. Can be NULL.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Async_Error_Save
+ * @see log_general.html#LOG_GENERAL_ERROR_LENGTH
+ */
+int Log_UDP_Async_Error_Get(Log_UDP_Async_T async,int *error_number,char *error_string)
+{
+	if(async == NULL)
+	{
+		Log_Error_Number = 216;
+		sprintf(Log_Error_String,"Log_UDP_Async_Error_Get:async was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(async->Mutex));
+	if(error_number != NULL)
+		(*error_number) = async->Error_Number;
+	if(error_string != NULL)
+		strcpy(error_string,async->Error_String);
+	pthread_mutex_unlock(&(async->Mutex));
+	return TRUE;
+}
+
+/**
+ * Stop the sender thread, once it has sent all the queued records, and free the asynchronous sender.
+ * No other thread should be calling Log_UDP_Async_Send with this sender whilst this routine is running.
+ * The socket is not closed.
+ * @param async The asynchronous sender, created by Log_UDP_Async_Open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Async_Close(Log_UDP_Async_T async)
+{
+	unsigned long i;
+	int retval;
+
+	if(async == NULL)
+	{
+		Log_Error_Number = 213;
+		sprintf(Log_Error_String,"Log_UDP_Async_Close:async was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(async->Mutex));
+	async->Quit = TRUE;
+	pthread_cond_signal(&(async->Sender_Condition));
+	pthread_mutex_unlock(&(async->Mutex));
+	retval = pthread_join(async->Sender_Thread,NULL);
+	if(retval != 0)
+	{
+		Log_Error_Number = 214;
+		sprintf(Log_Error_String,"Log_UDP_Async_Close:Failed to join sender thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	for(i = 0; i <= async->Queue_Mask; i++)
+	{
+		if(async->Slot_List[i].Log_Context_List != NULL)
+			free(async->Slot_List[i].Log_Context_List);
+	}
+	free(async->Slot_List);
+	pthread_cond_destroy(&(async->Progress_Condition));
+	pthread_cond_destroy(&(async->Sender_Condition));
+	pthread_mutex_destroy(&(async->Mutex));
+	free(async);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * The sender thread. Takes records off the queue and sends them with Log_UDP_Send_Record, until
+ * Quit is set and the queue is empty. The error from a failed send is kept with Async_Error_Save.
+ * @param user_arg The Log_UDP_Async_T the thread is sending for.
+ * @return The routine returns NULL.
+ * @see log_udp.html#Log_UDP_Send_Record
+ * @see #SENDER_WAIT_MS
+ * @see #Async_Error_Save
+ */
+static void *Async_Sender_Thread(void *user_arg)
+{
+	Log_UDP_Async_T async = (Log_UDP_Async_T)user_arg;
+	struct Async_Slot_Struct *slot = NULL;
+	struct timespec wait_time;
+	unsigned long position;
+
+#if DEBUG > 1
+	fprintf(stdout,"Async_Sender_Thread:started.\n");
+#endif
+	while(TRUE)
+	{
+		if(Async_Dequeue_Claim(async,&slot,&position))
+		{
+			if(slot->Valid && Log_UDP_Send_Record(async->Socket_Id,&(slot->Log_Record),slot->Log_Context_Count,
+							      slot->Log_Context_List))
+			{
+				__sync_fetch_and_add(&(async->Sent_Count),1);
+			}
+			else
+			{
+				__sync_fetch_and_add(&(async->Failed_Count),1);
+				if(!slot->Valid)
+				{
+					Log_Error_Number = 217;
+					sprintf(Log_Error_String,"Async_Sender_Thread:Queued record was not copied.");
+				}
+				Async_Error_Save(async);
+#if DEBUG > 1
+				Log_General_Error();
+#endif
+			}
+			Async_Dequeue_Release(async,slot,position);
+			continue;
+		}
+		if(async->Quit)
+			break;
+		/* queue is empty, wait for a record to be queued */
+		pthread_mutex_lock(&(async->Mutex));
+		async->Sender_Waiting = TRUE;
+		__sync_synchronize();
+		if(Async_Is_Empty(async)&&(async->Quit == FALSE))
+		{
+			clock_gettime(CLOCK_REALTIME,&wait_time);
+			Async_Time_Add(&wait_time,SENDER_WAIT_MS);
+			pthread_cond_timedwait(&(async->Sender_Condition),&(async->Mutex),&wait_time);
+		}
+		async->Sender_Waiting = FALSE;
+		pthread_mutex_unlock(&(async->Mutex));
+	}
+#if DEBUG > 1
+	fprintf(stdout,"Async_Sender_Thread:finished.\n");
+#endif
+	return NULL;
+}
+
+/**
+ * Try to claim the slot at the end of the queue to fill in.
+ * @param async The asynchronous sender.
+ * @param slot The address of a pointer, set to the claimed slot.
+ * @param position The address of an unsigned long, set to the claimed queue position.
+ * @return The routine returns TRUE if a slot was claimed, and FALSE if the queue is full.
+ */
+static int Async_Enqueue_Claim(Log_UDP_Async_T async,struct Async_Slot_Struct **slot,unsigned long *position)
+{
+	struct Async_Slot_Struct *current_slot = NULL;
+	unsigned long current_position;
+	long difference;
+
+	current_position = Async_Load(&(async->Enqueue_Position));
+	while(TRUE)
+	{
+		current_slot = &(async->Slot_List[current_position&async->Queue_Mask]);
+		difference = (long)(Async_Load(&(current_slot->Sequence))-current_position);
+		if(difference == 0)
+		{
+			if(__sync_bool_compare_and_swap(&(async->Enqueue_Position),current_position,current_position+1))
+			{
+				(*slot) = current_slot;
+				(*position) = current_position;
+				return TRUE;
+			}
+		}
+		else if(difference < 0)
+			return FALSE;
+		current_position = Async_Load(&(async->Enqueue_Position));
+	}
+}
+
+/**
+ * Mark a claimed and filled in slot as ready to send.
+ * @param slot The slot.
+ * @param position The slot's queue position.
+ */
+static void Async_Enqueue_Release(struct Async_Slot_Struct *slot,unsigned long position)
+{
+	Async_Store(&(slot->Sequence),position+1);
+}
+
+/**
+ * Try to claim the slot at the front of the queue, to send (or drop).
+ * @param async The asynchronous sender.
+ * @param slot The address of a pointer, set to the claimed slot.
+ * @param position The address of an unsigned long, set to the claimed queue position.
+ * @return The routine returns TRUE if a slot was claimed, and FALSE if the queue is empty.
+ */
+static int Async_Dequeue_Claim(Log_UDP_Async_T async,struct Async_Slot_Struct **slot,unsigned long *position)
+{
+	struct Async_Slot_Struct *current_slot = NULL;
+	unsigned long current_position;
+	long difference;
+
+	current_position = Async_Load(&(async->Dequeue_Position));
+	while(TRUE)
+	{
+		current_slot = &(async->Slot_List[current_position&async->Queue_Mask]);
+		difference = (long)(Async_Load(&(current_slot->Sequence))-(current_position+1));
+		if(difference == 0)
+		{
+			if(__sync_bool_compare_and_swap(&(async->Dequeue_Position),current_position,current_position+1))
+			{
+				(*slot) = current_slot;
+				(*position) = current_position;
+				return TRUE;
+			}
+		}
+		else if(difference < 0)
+			return FALSE;
+		current_position = Async_Load(&(async->Dequeue_Position));
+	}
+}
+
+/**
+ * Mark a claimed slot as free to be filled again, and wake any threads waiting for progress.
+ * @param async The asynchronous sender.
+ * @param slot The slot.
+ * @param position The slot's queue position.
+ */
+static void Async_Dequeue_Release(Log_UDP_Async_T async,struct Async_Slot_Struct *slot,unsigned long position)
+{
+	Async_Store(&(slot->Sequence),position+async->Queue_Mask+1);
+	__sync_fetch_and_add(&(async->Completed_Count),1);
+	if(async->Waiter_Count > 0)
+	{
+		pthread_mutex_lock(&(async->Mutex));
+		pthread_cond_broadcast(&(async->Progress_Condition));
+		pthread_mutex_unlock(&(async->Mutex));
+	}
+}
+
+/**
+ * Return whether the queue is empty (the slot at the front of the queue is not ready to send).
+ * @param async The asynchronous sender.
+ * @return TRUE if the queue is empty, FALSE if it is not.
+ */
+static int Async_Is_Empty(Log_UDP_Async_T async)
+{
+	unsigned long position;
+
+	position = Async_Load(&(async->Dequeue_Position));
+	return (Async_Load(&(async->Slot_List[position&async->Queue_Mask].Sequence)) != (position+1));
+}
+
+/**
+ * Copy a log record and it's contexts into a claimed slot. The slot's context list is only reallocated
+ * if it is too small.
+ * @param slot The slot.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Async_Slot_Fill(struct Async_Slot_Struct *slot,const struct Log_Record_Struct *log_record,
+			   int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	struct Log_Context_Struct *new_list = NULL;
+
+	slot->Log_Record = (*log_record);
+	slot->Log_Context_Count = 0;
+	if(log_context_count > slot->Log_Context_Allocated_Count)
+	{
+		new_list = (struct Log_Context_Struct *)realloc(slot->Log_Context_List,
+						log_context_count*sizeof(struct Log_Context_Struct));
+		if(new_list == NULL)
+		{
+			Log_Error_Number = 215;
+			sprintf(Log_Error_String,"Async_Slot_Fill:Failed to reallocate context list(%d).",
+				log_context_count);
+			return FALSE;
+		}
+		slot->Log_Context_List = new_list;
+		slot->Log_Context_Allocated_Count = log_context_count;
+	}
+	if(log_context_count > 0)
+		memcpy(slot->Log_Context_List,log_context_list,log_context_count*sizeof(struct Log_Context_Struct));
+	slot->Log_Context_Count = log_context_count;
+	return TRUE;
+}
+
+/**
+ * Read a value shared between threads, with a memory barrier after the read.
+ * @param value The address of the value.
+ * @return The value.
+ */
+static unsigned long Async_Load(volatile unsigned long *value)
+{
+	unsigned long current_value;
+
+	current_value = (*value);
+	__sync_synchronize();
+	return current_value;
+}
+
+/**
+ * Write a value shared between threads, with a memory barrier before the write.
+ * @param value The address of the value.
+ * @param new_value The value to write.
+ */
+static void Async_Store(volatile unsigned long *value,unsigned long new_value)
+{
+	__sync_synchronize();
+	(*value) = new_value;
+}
+
+/**
+ * Add a number of milliseconds to an absolute time.
+ * @param abs_time The address of the time to modify.
+ * @param milliseconds The number of milliseconds to add. Negative numbers are treated as zero.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ * @see #ONE_SECOND_NS
+ */
+static void Async_Time_Add(struct timespec *abs_time,int milliseconds)
+{
+	if(milliseconds < 0)
+		return;
+	abs_time->tv_sec += milliseconds/ONE_SECOND_MS;
+	abs_time->tv_nsec += (milliseconds%ONE_SECOND_MS)*ONE_MILLISECOND_NS;
+	if(abs_time->tv_nsec >= ONE_SECOND_NS)
+	{
+		abs_time->tv_sec++;
+		abs_time->tv_nsec -= ONE_SECOND_NS;
+	}
+}
+
+/**
+ * Return whether the (CLOCK_REALTIME) absolute time has passed.
+ * @param abs_time The address of the time to test.
+ * @return TRUE if the time has passed, FALSE if it has not.
+ */
+static int Async_Time_Passed(struct timespec *abs_time)
+{
+	struct timespec current_time;
+
+	clock_gettime(CLOCK_REALTIME,&current_time);
+	if(current_time.tv_sec != abs_time->tv_sec)
+		return (current_time.tv_sec > abs_time->tv_sec);
+	return (current_time.tv_nsec >= abs_time->tv_nsec);
+}
+
+/**
+ * Wait for the sender thread to finish with a queue position, or for PROGRESS_WAIT_MS, or the deadline,
+ * whichever is sooner.
+ * @param async The asynchronous sender.
+ * @param timeout_ms The timeout the deadline was created from, negative if there is no deadline.
+ * @param deadline The (CLOCK_REALTIME) absolute time not to wait beyond.
+ * @see #PROGRESS_WAIT_MS
+ */
+static void Async_Progress_Wait(Log_UDP_Async_T async,int timeout_ms,struct timespec *deadline)
+{
+	struct timespec wait_time;
+
+	clock_gettime(CLOCK_REALTIME,&wait_time);
+	Async_Time_Add(&wait_time,PROGRESS_WAIT_MS);
+	if((timeout_ms >= 0)&&((deadline->tv_sec < wait_time.tv_sec)||
+			       ((deadline->tv_sec == wait_time.tv_sec)&&(deadline->tv_nsec < wait_time.tv_nsec))))
+	{
+		wait_time = (*deadline);
+	}
+	__sync_fetch_and_add(&(async->Waiter_Count),1);
+	pthread_mutex_lock(&(async->Mutex));
+	pthread_cond_timedwait(&(async->Progress_Condition),&(async->Mutex),&wait_time);
+	pthread_mutex_unlock(&(async->Mutex));
+	__sync_fetch_and_sub(&(async->Waiter_Count),1);
+}
+
+/**
+ * Copy the sender thread's error into the asynchronous sender, where Log_UDP_Async_Error_Get can read it.
+ * This must only be called by the sender thread, as it reads that thread's Log_Error_Number and
+ * Log_Error_String.
+ * @param async The asynchronous sender.
+ * @see #Log_UDP_Async_Error_Get
+ */
+static void Async_Error_Save(Log_UDP_Async_T async)
+{
+	pthread_mutex_lock(&(async->Mutex));
+	async->Error_Number = Log_Error_Number;
+	strncpy(async->Error_String,Log_Error_String,LOG_GENERAL_ERROR_LENGTH-1);
+	async->Error_String[LOG_GENERAL_ERROR_LENGTH-1] = '\0';
+	pthread_mutex_unlock(&(async->Mutex));
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,476 @@
+/* log_udp_coalesce.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Duplicate message coalescing, like syslog's "last message repeated N times". A fingerprint (hash) of each
+ * log message's System, Sub_System, Source_File, Source_Instance, Function, Severity, Verbosity, Category,
+ * Message and contexts is looked up in a small direct mapped table of recent fingerprints. The first copy
+ * of a message is sent; further copies arriving within the coalescing window are counted but not sent.
+ * When the window has passed (and another copy arrives, the table slot is needed for a different message, or
+ * Log_UDP_Coalesce_Flush is called) one summary record is sent, with the repeat count and the
+ * timestamps of the first and last repeats. The summary is sent by the summary send routine of whatever sent
+ * the message (a socket or a logger handle), so it goes the same way as the message it summarises.
+ * Coalescing is off until Log_UDP_Coalesce_Set is called.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1c threads,
+ * POSIX.4/IEEE1003.1b-1993 clock_gettime and gmtime_r prototypes.
+ */
+#define _POSIX_C_SOURCE 199506L
+#include <errno.h>   /* Error number definitions */
+#include <pthread.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+#include "log_udp_coalesce.h"
+
+/* hash defines */
+/**
+ * The number of entries in the fingerprint table. This must be a power of 2.
+ */
+#define COALESCE_TABLE_LENGTH           (64)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+/**
+ * The number of contexts in a summary record.
+ */
+#define SUMMARY_CONTEXT_COUNT           (3)
+/**
+ * The length of a formatted timestamp string.
+ */
+#define TIMESTAMP_STRING_LENGTH         (32)
+
+/* structures */
+/**
+ * An entry in the fingerprint table.
+ * <dl>
+ * <dt>In_Use</dt> <dd>Whether this entry holds a fingerprint.</dd>
+ * <dt>Fingerprint</dt> <dd>The fingerprint (hash) of the message.</dd>
+ * <dt>Summary_Send</dt> <dd>The summary send routine of whatever sent the message. NULL if the summary
+ *     is dropped.</dd>
+ * <dt>Summary_Arg</dt> <dd>The argument passed to Summary_Send.</dd>
+ * <dt>First_Ms</dt> <dd>The monotonic time in milliseconds the window started (the message was sent).</dd>
+ * <dt>Repeat_Count</dt> <dd>The number of copies of the message not sent since the window started.</dd>
+ * <dt>First_Timestamp</dt> <dd>The timestamp of the first copy not sent.</dd>
+ * <dt>Last_Timestamp</dt> <dd>The timestamp of the last copy not sent.</dd>
+ * <dt>Log_Record</dt> <dd>A copy of the message (without contexts), filled in on the first repeat,
+ *     used to send the summary.</dd>
+ * </dl>
+ */
+struct Coalesce_Entry_Struct
+{
+	int In_Use;
+	uint64_t Fingerprint;
+	Log_UDP_Summary_Send_T Summary_Send;
+	void *Summary_Arg;
+	int64_t First_Ms;
+	unsigned long Repeat_Count;
+	int64_t First_Timestamp;
+	int64_t Last_Timestamp;
+	struct Log_Record_Struct Log_Record;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The coalescing window in milliseconds. Coalescing is off when this is zero.
+ */
+static int Coalesce_Window_Ms = 0;
+/**
+ * The total number of messages not sent because they were repeats.
+ */
+static unsigned long Coalesce_Total = 0;
+/**
+ * The fingerprint table.
+ * @see #COALESCE_TABLE_LENGTH
+ */
+static struct Coalesce_Entry_Struct Coalesce_Table[COALESCE_TABLE_LENGTH];
+/**
+ * Mutex protecting the fingerprint table. Summaries are sent with the mutex locked, so a summary
+ * send routine is never called after Log_UDP_Coalesce_Release has returned for it.
+ */
+static pthread_mutex_t Coalesce_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* internal function declarations */
+static uint64_t Coalesce_Hash_String(uint64_t hash,const char *string,size_t field_length);
+static uint64_t Coalesce_Hash_Int(uint64_t hash,int value);
+static void Coalesce_Copy_String(char *field,const char *string,size_t field_length);
+static int Coalesce_Summary_Send(struct Coalesce_Entry_Struct *summary);
+static void Coalesce_Timestamp_To_String(int64_t timestamp,char *time_string);
+static int64_t Coalesce_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Configure duplicate message coalescing. Any pending summaries are discarded.
+ * @param window_ms The coalescing window in milliseconds. Copies of a message logged within this time of it
+ *        being sent are counted rather than sent. Zero turns coalescing off.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Coalesce_Window_Ms
+ */
+int Log_UDP_Coalesce_Set(int window_ms)
+{
+	if(window_ms < 0)
+	{
+		Log_Error_Number = 500;
+		sprintf(Log_Error_String,"Log_UDP_Coalesce_Set:window_ms was negative(%d).",window_ms);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Coalesce_Mutex);
+	Coalesce_Window_Ms = window_ms;
+	memset(Coalesce_Table,0,sizeof(Coalesce_Table));
+	pthread_mutex_unlock(&Coalesce_Mutex);
+	return TRUE;
+}
+
+/**
+ * Determine whether a log message should be sent, or is a repeat of a recently sent message.
+ * If the table slot for the message holds an earlier message with repeats whose summary has not been sent,
+ * the summary is sent with that message's summary send routine first. This is called by the send routines in
+ * log_udp.c and log_udp_handle.c, and returns straight away when coalescing is off.
+ * Only the fingerprint is stored for messages that are not repeated, the message fields are copied when the
+ * first repeat arrives. A message is only a repeat if it is sent with the same summary_send and summary_arg.
+ * The summary is sent with Coalesce_Mutex locked, so summary_send must not call this routine, and this routine
+ * must not be called with a lock summary_send takes held.
+ * @param summary_send The routine used to send summaries through whatever the message will be sent with.
+ *        Can be NULL, in which case summaries are dropped.
+ * @param summary_arg The argument passed to summary_send.
+ * @param system The System. Can be NULL.
+ * @param sub_system The Sub_System. Can be NULL.
+ * @param source_file The Source_File. Can be NULL.
+ * @param source_instance The Source_Instance. Can be NULL.
+ * @param function The Function. Can be NULL.
+ * @param severity The severity.
+ * @param verbosity The verbosity.
+ * @param category The Category. Can be NULL.
+ * @param message The Message. Can be NULL.
+ * @param timestamp The message's timestamp, milliseconds since 1970.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list The message's contexts.
+ * @return The routine returns TRUE if the message should be sent, and FALSE if it is a repeat.
+ * @see #Coalesce_Hash_String
+ * @see #Coalesce_Hash_Int
+ * @see #Coalesce_Summary_Send
+ */
+int Log_UDP_Coalesce_Allow(Log_UDP_Summary_Send_T summary_send,void *summary_arg,const char *system,
+			   const char *sub_system,const char *source_file,const char *source_instance,
+			   const char *function,int severity,int verbosity,const char *category,const char *message,
+			   int64_t timestamp,int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	struct Coalesce_Entry_Struct *entry = NULL;
+	struct Coalesce_Entry_Struct summary;
+	uint64_t fingerprint;
+	int64_t now_ms;
+	int allow,i;
+
+	/* unlocked read, settings changes are picked up on the next call */
+	if(Coalesce_Window_Ms <= 0)
+		return TRUE;
+	/* FNV-1a offset basis */
+	fingerprint = 14695981039346656037ULL;
+	fingerprint = Coalesce_Hash_String(fingerprint,system,LOG_RECORD_SYSTEM_LENGTH);
+	fingerprint = Coalesce_Hash_String(fingerprint,sub_system,LOG_RECORD_SUB_SYSTEM_LENGTH);
+	fingerprint = Coalesce_Hash_String(fingerprint,source_file,LOG_RECORD_SOURCE_FILE_LENGTH);
+	fingerprint = Coalesce_Hash_String(fingerprint,source_instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH);
+	fingerprint = Coalesce_Hash_String(fingerprint,function,LOG_RECORD_FUNCTION_LENGTH);
+	fingerprint = Coalesce_Hash_Int(fingerprint,severity);
+	fingerprint = Coalesce_Hash_Int(fingerprint,verbosity);
+	fingerprint = Coalesce_Hash_String(fingerprint,category,LOG_RECORD_CATEGORY_LENGTH);
+	fingerprint = Coalesce_Hash_String(fingerprint,message,LOG_RECORD_MESSAGE_LENGTH);
+	fingerprint = Coalesce_Hash_Int(fingerprint,log_context_count);
+	for(i = 0; (log_context_list != NULL) && (i < log_context_count); i++)
+	{
+		fingerprint = Coalesce_Hash_String(fingerprint,log_context_list[i].Keyword,LOG_CONTEXT_KEYWORD_LENGTH);
+		fingerprint = Coalesce_Hash_String(fingerprint,log_context_list[i].Value,LOG_CONTEXT_VALUE_LENGTH);
+	}
+	now_ms = Coalesce_Monotonic_Ms();
+	allow = TRUE;
+	pthread_mutex_lock(&Coalesce_Mutex);
+	entry = &(Coalesce_Table[fingerprint&(COALESCE_TABLE_LENGTH-1)]);
+	if(entry->In_Use && (entry->Fingerprint == fingerprint) && (entry->Summary_Send == summary_send) &&
+	   (entry->Summary_Arg == summary_arg) &&
+	   ((now_ms-entry->First_Ms) < Coalesce_Window_Ms))
+	{
+		/* a repeat within the window */
+		if(entry->Repeat_Count == 0)
+		{
+			entry->First_Timestamp = timestamp;
+			entry->Log_Record.Timestamp = timestamp;
+			Coalesce_Copy_String(entry->Log_Record.System,system,LOG_RECORD_SYSTEM_LENGTH);
+			Coalesce_Copy_String(entry->Log_Record.Sub_System,sub_system,LOG_RECORD_SUB_SYSTEM_LENGTH);
+			Coalesce_Copy_String(entry->Log_Record.Source_File,source_file,LOG_RECORD_SOURCE_FILE_LENGTH);
+			Coalesce_Copy_String(entry->Log_Record.Source_Instance,source_instance,
+					     LOG_RECORD_SOURCE_INSTANCE_LENGTH);
+			Coalesce_Copy_String(entry->Log_Record.Function,function,LOG_RECORD_FUNCTION_LENGTH);
+			entry->Log_Record.Severity = severity;
+			entry->Log_Record.Verbosity = verbosity;
+			Coalesce_Copy_String(entry->Log_Record.Category,category,LOG_RECORD_CATEGORY_LENGTH);
+			Coalesce_Copy_String(entry->Log_Record.Message,message,LOG_RECORD_MESSAGE_LENGTH);
+		}
+		entry->Repeat_Count++;
+		entry->Last_Timestamp = timestamp;
+		Coalesce_Total++;
+		allow = FALSE;
+	}
+	else
+	{
+		/* a new message, or the window has passed: send the summary for the slot's previous message */
+		if(entry->In_Use && (entry->Repeat_Count > 0))
+		{
+			summary = (*entry);
+			Coalesce_Summary_Send(&summary);
+		}
+		entry->In_Use = TRUE;
+		entry->Fingerprint = fingerprint;
+		entry->Summary_Send = summary_send;
+		entry->Summary_Arg = summary_arg;
+		entry->First_Ms = now_ms;
+		entry->Repeat_Count = 0;
+	}
+	pthread_mutex_unlock(&Coalesce_Mutex);
+	return allow;
+}
+
+/**
+ * Send a summary record for every message with repeats that have not been reported, whether or not
+ * its window has passed. Summaries are otherwise only sent when another message needs the table slot,
+ * so call this before closing the socket (or periodically) to report the end of a run of repeats.
+ * @return The routine returns TRUE on success and FALSE if sending a summary failed.
+ * @see #Coalesce_Summary_Send
+ */
+int Log_UDP_Coalesce_Flush(void)
+{
+	struct Coalesce_Entry_Struct summary;
+	int i,retval;
+
+	retval = TRUE;
+	pthread_mutex_lock(&Coalesce_Mutex);
+	for(i = 0; i < COALESCE_TABLE_LENGTH; i++)
+	{
+		if(Coalesce_Table[i].In_Use && (Coalesce_Table[i].Repeat_Count > 0))
+		{
+			summary = Coalesce_Table[i];
+			/* the next copy starts a new window */
+			Coalesce_Table[i].In_Use = FALSE;
+			Coalesce_Table[i].Repeat_Count = 0;
+			if(!Coalesce_Summary_Send(&summary))
+				retval = FALSE;
+		}
+	}
+	pthread_mutex_unlock(&Coalesce_Mutex);
+	return retval;
+}
+
+/**
+ * Stop sending summaries with a summary send routine, before whatever it sends through is closed.
+ * Summaries of messages sent with summary_send and summary_arg are sent now, whether or not their window
+ * has passed, and their table slots are freed. Called by Log_UDP_Close and Log_UDP_Handle_Close.
+ * @param summary_send The summary send routine passed to Log_UDP_Coalesce_Allow.
+ * @param summary_arg The argument passed to Log_UDP_Coalesce_Allow with summary_send.
+ * @return The routine returns TRUE on success and FALSE if sending a summary failed.
+ * @see #Coalesce_Summary_Send
+ */
+int Log_UDP_Coalesce_Release(Log_UDP_Summary_Send_T summary_send,void *summary_arg)
+{
+	struct Coalesce_Entry_Struct summary;
+	int i,retval;
+
+	retval = TRUE;
+	pthread_mutex_lock(&Coalesce_Mutex);
+	for(i = 0; i < COALESCE_TABLE_LENGTH; i++)
+	{
+		if((!Coalesce_Table[i].In_Use)||(Coalesce_Table[i].Summary_Send != summary_send)||
+		   (Coalesce_Table[i].Summary_Arg != summary_arg))
+			continue;
+		if(Coalesce_Table[i].Repeat_Count > 0)
+		{
+			summary = Coalesce_Table[i];
+			if(!Coalesce_Summary_Send(&summary))
+				retval = FALSE;
+		}
+		Coalesce_Table[i].In_Use = FALSE;
+		Coalesce_Table[i].Repeat_Count = 0;
+	}
+	pthread_mutex_unlock(&Coalesce_Mutex);
+	return retval;
+}
+
+/**
+ * Get the total number of messages not sent because they were repeats, since the program started.
+ * @param coalesced_count The address of an unsigned long to fill in with the count.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Coalesce_Total
+ */
+int Log_UDP_Coalesce_Count_Get(unsigned long *coalesced_count)
+{
+	if(coalesced_count == NULL)
+	{
+		Log_Error_Number = 501;
+		sprintf(Log_Error_String,"Log_UDP_Coalesce_Count_Get:coalesced_count was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Coalesce_Mutex);
+	(*coalesced_count) = Coalesce_Total;
+	pthread_mutex_unlock(&Coalesce_Mutex);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Add a string, up to the length it is truncated to in a log record, to an FNV-1a hash.
+ * A NULL string hashes as an empty string. A separator is hashed after the string, so adjacent
+ * fields can't run into each other.
+ * @param hash The hash so far.
+ * @param string The string. Can be NULL.
+ * @param field_length The length of the log record field the string goes in.
+ * @return The new hash.
+ */
+static uint64_t Coalesce_Hash_String(uint64_t hash,const char *string,size_t field_length)
+{
+	size_t i;
+
+	for(i = 0; (string != NULL) && (i < (field_length-1)) && (string[i] != '\0'); i++)
+	{
+		hash ^= (unsigned char)(string[i]);
+		hash *= 1099511628211ULL;
+	}
+	hash ^= 0xff;
+	hash *= 1099511628211ULL;
+	return hash;
+}
+
+/**
+ * Add an integer to an FNV-1a hash.
+ * @param hash The hash so far.
+ * @param value The integer.
+ * @return The new hash.
+ */
+static uint64_t Coalesce_Hash_Int(uint64_t hash,int value)
+{
+	size_t i;
+
+	for(i = 0; i < sizeof(int); i++)
+	{
+		hash ^= (unsigned char)(value >> (i*8));
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/**
+ * Copy a string into a log record field, truncating it and NULL terminating it.
+ * @param field The log record field.
+ * @param string The string. Can be NULL, in which case the field is set to an empty string.
+ * @param field_length The length of the log record field.
+ */
+static void Coalesce_Copy_String(char *field,const char *string,size_t field_length)
+{
+	const char *end_ch = NULL;
+	size_t string_length;
+
+	if(string == NULL)
+		string_length = 0;
+	else
+	{
+		end_ch = memchr(string,'\0',field_length-1);
+		if(end_ch != NULL)
+			string_length = end_ch-string;
+		else
+			string_length = field_length-1;
+	}
+	if(string_length > 0)
+		memcpy(field,string,string_length);
+	field[string_length] = '\0';
+}
+
+/**
+ * Send a summary record for a repeated message. The summary has the repeated message's System through
+ * Category, the message "Last message repeated N times between <first> and <last>.", and the contexts
+ * Repeat_Count, First_Timestamp and Last_Timestamp (milliseconds since 1970).
+ * The record is sent with the summary's send routine, so it is not itself filtered, coalesced or rate limited.
+ * Coalesce_Mutex should be locked.
+ * @param summary A copy of the fingerprint table entry.
+ * @return The routine returns TRUE on success (or if the summary has no send routine) and FALSE on failure.
+ * @see #SUMMARY_CONTEXT_COUNT
+ * @see #Coalesce_Timestamp_To_String
+ */
+static int Coalesce_Summary_Send(struct Coalesce_Entry_Struct *summary)
+{
+	struct Log_Context_Struct log_context_list[SUMMARY_CONTEXT_COUNT];
+	char first_string[TIMESTAMP_STRING_LENGTH];
+	char last_string[TIMESTAMP_STRING_LENGTH];
+
+	if(summary->Summary_Send == NULL)
+		return TRUE;
+	Coalesce_Timestamp_To_String(summary->First_Timestamp,first_string);
+	Coalesce_Timestamp_To_String(summary->Last_Timestamp,last_string);
+	summary->Log_Record.Timestamp = summary->Last_Timestamp;
+	sprintf(summary->Log_Record.Message,"Last message repeated %lu times between %s and %s.",
+		summary->Repeat_Count,first_string,last_string);
+	strcpy(log_context_list[0].Keyword,"Repeat_Count");
+	sprintf(log_context_list[0].Value,"%lu",summary->Repeat_Count);
+	strcpy(log_context_list[1].Keyword,"First_Timestamp");
+	sprintf(log_context_list[1].Value,"%lld",(long long)summary->First_Timestamp);
+	strcpy(log_context_list[2].Keyword,"Last_Timestamp");
+	sprintf(log_context_list[2].Value,"%lld",(long long)summary->Last_Timestamp);
+	return summary->Summary_Send(summary->Summary_Arg,&(summary->Log_Record),SUMMARY_CONTEXT_COUNT,
+				     log_context_list);
+}
+
+/**
+ * Format a timestamp as a UTC date and time string, with milliseconds.
+ * @param timestamp The timestamp, milliseconds since 1970.
+ * @param time_string A string of at least TIMESTAMP_STRING_LENGTH characters to fill in.
+ * @see #TIMESTAMP_STRING_LENGTH
+ */
+static void Coalesce_Timestamp_To_String(int64_t timestamp,char *time_string)
+{
+	struct tm time_tm;
+	time_t time_secs;
+	size_t length;
+
+	time_secs = (time_t)(timestamp/ONE_SECOND_MS);
+	gmtime_r(&time_secs,&time_tm);
+	length = strftime(time_string,TIMESTAMP_STRING_LENGTH,"%Y-%m-%dT%H:%M:%S",&time_tm);
+	sprintf(time_string+length,".%03d",(int)(timestamp%ONE_SECOND_MS));
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Coalesce_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
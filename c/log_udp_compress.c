@@ -0,0 +1,384 @@
+/* log_udp_compress.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * A small, fast LZ77 compressor used for large version 2 packets (see LOG_UDP_V2_FLAG_COMPRESSED).
+ * It is self-contained, so no compression library is needed by senders or receivers. The compressed data
+ * is a list of sequences, each:
+ * <ul>
+ * <li>A token byte: the number of literal bytes in the top 4 bits, and the match length minus 4 in the
+ *     bottom 4 bits. A value of 15 means more length bytes follow.</li>
+ * <li>If the literal count was 15, more bytes are added to it, each 0..255, until one is less than 255.</li>
+ * <li>The literal bytes.</li>
+ * <li>The match offset (how far back in the uncompressed data the match starts, 1..65535), two bytes in
+ *     network byte order.</li>
+ * <li>If the match length was 15, more bytes are added to it as for the literal count.</li>
+ * </ul>
+ * The last sequence has only literals, and ends the data. Matches are found with a 4096 entry hash table
+ * of 4 byte prefixes, so the compressor does no searching and needs no state between packets.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>   /* Error number definitions */
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_compress.h"
+
+/* hash defines */
+/**
+ * The number of bits in a hash table index.
+ */
+#define COMPRESS_HASH_BITS              (12)
+/**
+ * The number of entries in the hash table.
+ */
+#define COMPRESS_HASH_LENGTH            (1<<COMPRESS_HASH_BITS)
+/**
+ * The shortest match encoded.
+ */
+#define COMPRESS_MIN_MATCH              (4)
+/**
+ * The furthest back a match can start.
+ */
+#define COMPRESS_MAX_OFFSET             (65535)
+/**
+ * The number of bytes at the end of the input that are always sent as literals, so a 4 byte prefix can
+ * always be read.
+ */
+#define COMPRESS_LAST_LITERALS          (5)
+/**
+ * The value of a 4 bit length that means more length bytes follow.
+ */
+#define COMPRESS_LENGTH_MORE            (15)
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static unsigned int Compress_Hash(const unsigned char *input);
+static int Compress_Sequence(const unsigned char *literal,size_t literal_length,size_t match_offset,
+			     size_t match_length,unsigned char *output_buffer,size_t output_buffer_length,
+			     size_t *output_position);
+static int Compress_Length(size_t length,unsigned char *output_buffer,size_t output_buffer_length,
+			   size_t *output_position);
+static int Decompress_Length(const unsigned char *input_buffer,size_t input_length,size_t *input_position,
+			     size_t *length);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Compress some data.
+ * @param input_buffer The data to compress.
+ * @param input_length The number of bytes in input_buffer.
+ * @param output_buffer The buffer to compress into. LOG_UDP_COMPRESS_BOUND(input_length) bytes is always enough.
+ * @param output_buffer_length The length of output_buffer in bytes.
+ * @param output_length The address of a size_t, on success filled in with the length of the compressed data.
+ * @return The routine returns TRUE on success and FALSE on failure (the output buffer was too small).
+ * @see #LOG_UDP_COMPRESS_BOUND
+ * @see #Compress_Hash
+ * @see #Compress_Sequence
+ */
+int Log_UDP_Compress(const char *input_buffer,size_t input_length,char *output_buffer,
+		     size_t output_buffer_length,size_t *output_length)
+{
+	const unsigned char *input = (const unsigned char *)input_buffer;
+	uint32_t hash_list[COMPRESS_HASH_LENGTH];
+	size_t input_position,anchor_position,match_position,match_length,output_position,hash_limit;
+	unsigned int hash;
+
+	if((input_buffer == NULL)||(output_buffer == NULL)||(output_length == NULL))
+	{
+		Log_Error_Number = 900;
+		sprintf(Log_Error_String,"Log_UDP_Compress:NULL argument.");
+		return FALSE;
+	}
+	/* hash entries are positions plus one, zero is empty */
+	memset(hash_list,0,sizeof(hash_list));
+	output_position = 0;
+	input_position = 0;
+	anchor_position = 0;
+	if(input_length > COMPRESS_LAST_LITERALS)
+		hash_limit = input_length-COMPRESS_LAST_LITERALS;
+	else
+		hash_limit = 0;
+	while(input_position < hash_limit)
+	{
+		hash = Compress_Hash(input+input_position);
+		match_position = hash_list[hash];
+		hash_list[hash] = (uint32_t)(input_position+1);
+		if((match_position == 0)||((input_position-(match_position-1)) > COMPRESS_MAX_OFFSET)||
+		   (memcmp(input+match_position-1,input+input_position,COMPRESS_MIN_MATCH) != 0))
+		{
+			/* skip faster through data that isn't matching */
+			input_position += 1+((input_position-anchor_position)>>6);
+			continue;
+		}
+		match_position--;
+		match_length = COMPRESS_MIN_MATCH;
+		while(((input_position+match_length) < hash_limit)&&
+		      (input[match_position+match_length] == input[input_position+match_length]))
+			match_length++;
+		if(!Compress_Sequence(input+anchor_position,input_position-anchor_position,
+				      input_position-match_position,match_length,(unsigned char *)output_buffer,
+				      output_buffer_length,&output_position))
+			return FALSE;
+		input_position += match_length;
+		anchor_position = input_position;
+	}
+	/* the last literals */
+	if(!Compress_Sequence(input+anchor_position,input_length-anchor_position,0,0,(unsigned char *)output_buffer,
+			      output_buffer_length,&output_position))
+		return FALSE;
+	(*output_length) = output_position;
+	return TRUE;
+}
+
+/**
+ * Decompress some data compressed with Log_UDP_Compress.
+ * @param input_buffer The compressed data.
+ * @param input_length The number of bytes in input_buffer.
+ * @param output_buffer The buffer to decompress into.
+ * @param output_buffer_length The length of output_buffer in bytes.
+ * @param output_length The address of a size_t, on success filled in with the length of the decompressed data.
+ * @return The routine returns TRUE on success and FALSE if the data was malformed or too long for
+ *         the output buffer.
+ * @see #Decompress_Length
+ */
+int Log_UDP_Decompress(const char *input_buffer,size_t input_length,char *output_buffer,
+		       size_t output_buffer_length,size_t *output_length)
+{
+	const unsigned char *input = (const unsigned char *)input_buffer;
+	unsigned char *output = (unsigned char *)output_buffer;
+	size_t input_position,output_position,literal_length,match_length,match_offset,i;
+	int token;
+
+	if((input_buffer == NULL)||(output_buffer == NULL)||(output_length == NULL))
+	{
+		Log_Error_Number = 901;
+		sprintf(Log_Error_String,"Log_UDP_Decompress:NULL argument.");
+		return FALSE;
+	}
+	input_position = 0;
+	output_position = 0;
+	while(TRUE)
+	{
+		if(input_position >= input_length)
+		{
+			Log_Error_Number = 902;
+			sprintf(Log_Error_String,"Log_UDP_Decompress:Data ended before the last sequence.");
+			return FALSE;
+		}
+		token = input[input_position++];
+		literal_length = (token>>4)&0xf;
+		if(literal_length == COMPRESS_LENGTH_MORE)
+		{
+			if(!Decompress_Length(input,input_length,&input_position,&literal_length))
+				return FALSE;
+		}
+		if((literal_length > (input_length-input_position))||
+		   (literal_length > (output_buffer_length-output_position)))
+		{
+			Log_Error_Number = 903;
+			sprintf(Log_Error_String,"Log_UDP_Decompress:Literal length %d overruns input or output.",
+				literal_length);
+			return FALSE;
+		}
+		memcpy(output+output_position,input+input_position,literal_length);
+		input_position += literal_length;
+		output_position += literal_length;
+		/* the last sequence has no match */
+		if(input_position == input_length)
+			break;
+		if((input_position+2) > input_length)
+		{
+			Log_Error_Number = 902;
+			sprintf(Log_Error_String,"Log_UDP_Decompress:Data ended before a match offset.");
+			return FALSE;
+		}
+		match_offset = (((size_t)input[input_position])<<8)|input[input_position+1];
+		input_position += 2;
+		match_length = token&0xf;
+		if(match_length == COMPRESS_LENGTH_MORE)
+		{
+			if(!Decompress_Length(input,input_length,&input_position,&match_length))
+				return FALSE;
+		}
+		match_length += COMPRESS_MIN_MATCH;
+		if((match_offset == 0)||(match_offset > output_position)||
+		   (match_length > (output_buffer_length-output_position)))
+		{
+			Log_Error_Number = 904;
+			sprintf(Log_Error_String,"Log_UDP_Decompress:Illegal match (offset %d, length %d) at %d.",
+				match_offset,match_length,output_position);
+			return FALSE;
+		}
+		/* the match can overlap the bytes being written, so copy forwards a byte at a time */
+		for(i = 0; i < match_length; i++)
+		{
+			output[output_position] = output[output_position-match_offset];
+			output_position++;
+		}
+	}
+	(*output_length) = output_position;
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Hash the 4 bytes at input into a hash table index.
+ * @param input The bytes to hash.
+ * @return The hash table index, 0..COMPRESS_HASH_LENGTH-1.
+ * @see #COMPRESS_HASH_BITS
+ */
+static unsigned int Compress_Hash(const unsigned char *input)
+{
+	uint32_t value;
+
+	value = ((uint32_t)input[0])|(((uint32_t)input[1])<<8)|(((uint32_t)input[2])<<16)|
+		(((uint32_t)input[3])<<24);
+	return (unsigned int)((value*2654435761U)>>(32-COMPRESS_HASH_BITS));
+}
+
+/**
+ * Write one sequence: the token, literals and (if match_length is not zero) the match.
+ * @param literal The literal bytes.
+ * @param literal_length The number of literal bytes.
+ * @param match_offset How far back the match starts.
+ * @param match_length The length of the match, zero for the last sequence, otherwise at least
+ *        COMPRESS_MIN_MATCH.
+ * @param output_buffer The buffer to write to.
+ * @param output_buffer_length The length of output_buffer in bytes.
+ * @param output_position The address of the position in output_buffer to write to, updated.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Compress_Length
+ */
+static int Compress_Sequence(const unsigned char *literal,size_t literal_length,size_t match_offset,
+			     size_t match_length,unsigned char *output_buffer,size_t output_buffer_length,
+			     size_t *output_position)
+{
+	size_t match_code;
+	int token;
+
+	if(match_length > 0)
+		match_code = match_length-COMPRESS_MIN_MATCH;
+	else
+		match_code = 0;
+	token = 0;
+	if(literal_length >= COMPRESS_LENGTH_MORE)
+		token |= COMPRESS_LENGTH_MORE<<4;
+	else
+		token |= literal_length<<4;
+	if(match_code >= COMPRESS_LENGTH_MORE)
+		token |= COMPRESS_LENGTH_MORE;
+	else
+		token |= match_code;
+	if((*output_position) >= output_buffer_length)
+	{
+		Log_Error_Number = 905;
+		sprintf(Log_Error_String,"Compress_Sequence:Output buffer overrun(length %d).",output_buffer_length);
+		return FALSE;
+	}
+	output_buffer[(*output_position)++] = (unsigned char)token;
+	if(literal_length >= COMPRESS_LENGTH_MORE)
+	{
+		if(!Compress_Length(literal_length-COMPRESS_LENGTH_MORE,output_buffer,output_buffer_length,
+				    output_position))
+			return FALSE;
+	}
+	if(literal_length > (output_buffer_length-(*output_position)))
+	{
+		Log_Error_Number = 905;
+		sprintf(Log_Error_String,"Compress_Sequence:Output buffer overrun(length %d).",output_buffer_length);
+		return FALSE;
+	}
+	memcpy(output_buffer+(*output_position),literal,literal_length);
+	(*output_position) += literal_length;
+	if(match_length == 0)
+		return TRUE;
+	if(((*output_position)+2) > output_buffer_length)
+	{
+		Log_Error_Number = 905;
+		sprintf(Log_Error_String,"Compress_Sequence:Output buffer overrun(length %d).",output_buffer_length);
+		return FALSE;
+	}
+	output_buffer[(*output_position)++] = (unsigned char)((match_offset>>8)&0xff);
+	output_buffer[(*output_position)++] = (unsigned char)(match_offset&0xff);
+	if(match_code >= COMPRESS_LENGTH_MORE)
+	{
+		if(!Compress_Length(match_code-COMPRESS_LENGTH_MORE,output_buffer,output_buffer_length,output_position))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Write the rest of a length that didn't fit in it's token: bytes of 255 until the remainder, which is
+ * less than 255.
+ * @param length The rest of the length.
+ * @param output_buffer The buffer to write to.
+ * @param output_buffer_length The length of output_buffer in bytes.
+ * @param output_position The address of the position in output_buffer to write to, updated.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ */
+static int Compress_Length(size_t length,unsigned char *output_buffer,size_t output_buffer_length,
+			   size_t *output_position)
+{
+	if(((*output_position)+(length/255)+1) > output_buffer_length)
+	{
+		Log_Error_Number = 906;
+		sprintf(Log_Error_String,"Compress_Length:Output buffer overrun(length %d).",output_buffer_length);
+		return FALSE;
+	}
+	while(length >= 255)
+	{
+		output_buffer[(*output_position)++] = 255;
+		length -= 255;
+	}
+	output_buffer[(*output_position)++] = (unsigned char)length;
+	return TRUE;
+}
+
+/**
+ * Read the rest of a length that didn't fit in it's token, and add it to the length.
+ * @param input_buffer The compressed data.
+ * @param input_length The number of bytes in input_buffer.
+ * @param input_position The address of the position to read from, updated.
+ * @param length The address of the length, updated.
+ * @return The routine returns TRUE on success and FALSE if the data ended first.
+ */
+static int Decompress_Length(const unsigned char *input_buffer,size_t input_length,size_t *input_position,
+			     size_t *length)
+{
+	int length_byte;
+
+	do
+	{
+		if((*input_position) >= input_length)
+		{
+			Log_Error_Number = 907;
+			sprintf(Log_Error_String,"Decompress_Length:Data ended in a length.");
+			return FALSE;
+		}
+		length_byte = input_buffer[(*input_position)++];
+		(*length) += length_byte;
+	}
+	while(length_byte == 255);
+	return TRUE;
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,376 @@
+/* log_udp_container.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Multi-record container datagrams. Short log records (a syslog line is around 100 bytes) cost far more in
+ * per-datagram overhead (system calls on the sender, headers on the network, wakeups on the receiver) than
+ * in bytes. A container packs several encoded packets, in either wire format, into one datagram up to a
+ * configured length (by default LOG_UDP_CONTAINER_DEFAULT_LENGTH, which is never IP fragmented):
+ * <ul>
+ * <li>The magic word LOG_UDP_PACKET_MAGIC_WORD_CONTAINER, two bytes in network byte order.</li>
+ * <li>The number of records, two bytes in network byte order.</li>
+ * <li>For each record, it's length as a varint, followed by the encoded packet.</li>
+ * </ul>
+ * The records are unpacked in order with Log_UDP_Container_Unpack_Start and Log_UDP_Container_Unpack_Next,
+ * and each one decoded as if it had arrived on it's own, so dictionary and template definitions in
+ * earlier records apply to later ones.
+ * A container is not thread safe: the sender's handle mutex protects it.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>   /* Error number definitions */
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_container.h"
+#include "log_udp_wire.h"
+
+/* structures */
+/**
+ * A container datagram being filled.
+ * <dl>
+ * <dt>Buffer</dt> <dd>The datagram, the header is filled in when it is sent.</dd>
+ * <dt>Datagram_Length</dt> <dd>The allocated length of Buffer, the longest datagram sent.</dd>
+ * <dt>Buffer_Position</dt> <dd>The number of bytes of Buffer used, including the header.</dd>
+ * <dt>Record_Count</dt> <dd>The number of records in the container.</dd>
+ * </dl>
+ */
+struct Log_UDP_Container_Struct
+{
+	char *Buffer;
+	size_t Datagram_Length;
+	size_t Buffer_Position;
+	int Record_Count;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static void Container_Clear(Log_UDP_Container_T container);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Create an empty container.
+ * @param datagram_length The longest datagram to send, in bytes, between LOG_UDP_CONTAINER_HEADER_LENGTH+2
+ *        and LOG_UDP_CONTAINER_LENGTH_MAX.
+ * @param container The address of a container to fill in.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_CONTAINER_DEFAULT_LENGTH
+ * @see #Log_UDP_Container_Destroy
+ */
+int Log_UDP_Container_Create(size_t datagram_length,Log_UDP_Container_T *container)
+{
+	Log_UDP_Container_T new_container = NULL;
+
+	if(container == NULL)
+	{
+		Log_Error_Number = 1000;
+		sprintf(Log_Error_String,"Log_UDP_Container_Create:container was NULL.");
+		return FALSE;
+	}
+	if((datagram_length < (LOG_UDP_CONTAINER_HEADER_LENGTH+2))||(datagram_length > LOG_UDP_CONTAINER_LENGTH_MAX))
+	{
+		Log_Error_Number = 1001;
+		sprintf(Log_Error_String,"Log_UDP_Container_Create:Illegal datagram length %d.",datagram_length);
+		return FALSE;
+	}
+	new_container = (Log_UDP_Container_T)malloc(sizeof(struct Log_UDP_Container_Struct));
+	if(new_container == NULL)
+	{
+		Log_Error_Number = 1002;
+		sprintf(Log_Error_String,"Log_UDP_Container_Create:Failed to allocate container.");
+		return FALSE;
+	}
+	new_container->Buffer = (char *)malloc(datagram_length*sizeof(char));
+	if(new_container->Buffer == NULL)
+	{
+		free(new_container);
+		Log_Error_Number = 1003;
+		sprintf(Log_Error_String,"Log_UDP_Container_Create:Failed to allocate buffer(%d).",datagram_length);
+		return FALSE;
+	}
+	new_container->Datagram_Length = datagram_length;
+	Container_Clear(new_container);
+	(*container) = new_container;
+	return TRUE;
+}
+
+/**
+ * Add an encoded packet to a container, if there is room for it. If there is not, the caller should send
+ * the container and add the packet again. A packet that doesn't fit in an empty container should be sent
+ * on it's own.
+ * @param container The container.
+ * @param message_buffer The encoded packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param added The address of an integer, set to TRUE if the packet was added, and FALSE if the container
+ *        did not have room for it.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Send
+ */
+int Log_UDP_Container_Add(Log_UDP_Container_T container,const char *message_buffer,
+			  size_t message_buffer_length,int *added)
+{
+	size_t length_length,value;
+
+	if((container == NULL)||(message_buffer == NULL)||(added == NULL))
+	{
+		Log_Error_Number = 1004;
+		sprintf(Log_Error_String,"Log_UDP_Container_Add:NULL argument.");
+		return FALSE;
+	}
+	(*added) = FALSE;
+	/* the number of bytes in the record's varint length */
+	length_length = 1;
+	for(value = message_buffer_length; value > 0x7f; value >>= 7)
+		length_length++;
+	if((container->Record_Count >= LOG_UDP_CONTAINER_RECORD_COUNT_MAX)||
+	   ((container->Buffer_Position+length_length+message_buffer_length) > container->Datagram_Length))
+		return TRUE;
+	if(!Log_UDP_Encode_Varint(container->Buffer,container->Datagram_Length,&(container->Buffer_Position),
+				  (uint64_t)message_buffer_length))
+		return FALSE;
+	memcpy(container->Buffer+container->Buffer_Position,message_buffer,message_buffer_length);
+	container->Buffer_Position += message_buffer_length;
+	container->Record_Count++;
+	(*added) = TRUE;
+	return TRUE;
+}
+
+/**
+ * Get the number of records in a container.
+ * @param container The container.
+ * @param record_count The address of an integer, filled in with the number of records.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Container_Record_Count_Get(Log_UDP_Container_T container,int *record_count)
+{
+	if((container == NULL)||(record_count == NULL))
+	{
+		Log_Error_Number = 1005;
+		sprintf(Log_Error_String,"Log_UDP_Container_Record_Count_Get:NULL argument.");
+		return FALSE;
+	}
+	(*record_count) = container->Record_Count;
+	return TRUE;
+}
+
+/**
+ * Fill in a container's header, ready for it to be sent. Use this rather than Log_UDP_Container_Send
+ * to send the datagram some other way, then call Log_UDP_Container_Clear.
+ * @param container The container, holding at least one record.
+ * @param message_buffer The address of a pointer, set to the datagram.
+ * @param message_buffer_length The address of a size_t, filled in with the length of the datagram.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Clear
+ */
+int Log_UDP_Container_Finish(Log_UDP_Container_T container,char **message_buffer,size_t *message_buffer_length)
+{
+	if((container == NULL)||(message_buffer == NULL)||(message_buffer_length == NULL))
+	{
+		Log_Error_Number = 1012;
+		sprintf(Log_Error_String,"Log_UDP_Container_Finish:NULL argument.");
+		return FALSE;
+	}
+	if(container->Record_Count == 0)
+	{
+		Log_Error_Number = 1013;
+		sprintf(Log_Error_String,"Log_UDP_Container_Finish:Container is empty.");
+		return FALSE;
+	}
+	container->Buffer[0] = (char)((LOG_UDP_PACKET_MAGIC_WORD_CONTAINER>>8)&0xff);
+	container->Buffer[1] = (char)(LOG_UDP_PACKET_MAGIC_WORD_CONTAINER&0xff);
+	container->Buffer[2] = (char)((container->Record_Count>>8)&0xff);
+	container->Buffer[3] = (char)(container->Record_Count&0xff);
+	(*message_buffer) = container->Buffer;
+	(*message_buffer_length) = container->Buffer_Position;
+	return TRUE;
+}
+
+/**
+ * Empty a container, discarding any records in it.
+ * @param container The container.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Finish
+ */
+int Log_UDP_Container_Clear(Log_UDP_Container_T container)
+{
+	if(container == NULL)
+	{
+		Log_Error_Number = 1014;
+		sprintf(Log_Error_String,"Log_UDP_Container_Clear:container was NULL.");
+		return FALSE;
+	}
+	Container_Clear(container);
+	return TRUE;
+}
+
+/**
+ * Send a container's records as one datagram, and empty it. An empty container is not sent.
+ * The container is emptied even if the send fails, as a failed send of a single packet loses it.
+ * @param container The container.
+ * @param socket_id The connected socket to send over.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Finish
+ * @see log_udp.html#Log_UDP_Send_Encoded
+ */
+int Log_UDP_Container_Send(Log_UDP_Container_T container,int socket_id)
+{
+	char *message_buffer = NULL;
+	size_t message_buffer_length;
+	int retval;
+
+	if(container == NULL)
+	{
+		Log_Error_Number = 1006;
+		sprintf(Log_Error_String,"Log_UDP_Container_Send:container was NULL.");
+		return FALSE;
+	}
+	if(container->Record_Count == 0)
+		return TRUE;
+	if(!Log_UDP_Container_Finish(container,&message_buffer,&message_buffer_length))
+		return FALSE;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Container_Send:Sending %d records in %d bytes.\n",container->Record_Count,
+		message_buffer_length);
+#endif
+	retval = Log_UDP_Send_Encoded(socket_id,message_buffer,message_buffer_length);
+	Container_Clear(container);
+	return retval;
+}
+
+/**
+ * Free a container. Any records in it are not sent.
+ * @param container The container.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Create
+ */
+int Log_UDP_Container_Destroy(Log_UDP_Container_T container)
+{
+	if(container == NULL)
+	{
+		Log_Error_Number = 1007;
+		sprintf(Log_Error_String,"Log_UDP_Container_Destroy:container was NULL.");
+		return FALSE;
+	}
+	free(container->Buffer);
+	free(container);
+	return TRUE;
+}
+
+/**
+ * Determine whether a received datagram is a container.
+ * @param message_buffer The received datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @return The routine returns TRUE if the datagram starts with LOG_UDP_PACKET_MAGIC_WORD_CONTAINER,
+ *         and FALSE otherwise.
+ */
+int Log_UDP_Container_Is_Container(const char *message_buffer,size_t message_buffer_length)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+
+	if((message_buffer == NULL)||(message_buffer_length < LOG_UDP_CONTAINER_HEADER_LENGTH))
+		return FALSE;
+	return (buffer[0] == ((LOG_UDP_PACKET_MAGIC_WORD_CONTAINER>>8)&0xff))&&
+		(buffer[1] == (LOG_UDP_PACKET_MAGIC_WORD_CONTAINER&0xff));
+}
+
+/**
+ * Start unpacking a received container.
+ * @param message_buffer The received datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @param record_count The address of an integer, filled in with the number of records in the container.
+ * @param message_buffer_position The address of a size_t, set to the position of the first record.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Container_Unpack_Next
+ */
+int Log_UDP_Container_Unpack_Start(const char *message_buffer,size_t message_buffer_length,
+				   int *record_count,size_t *message_buffer_position)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+
+	if((record_count == NULL)||(message_buffer_position == NULL))
+	{
+		Log_Error_Number = 1008;
+		sprintf(Log_Error_String,"Log_UDP_Container_Unpack_Start:NULL argument.");
+		return FALSE;
+	}
+	if(!Log_UDP_Container_Is_Container(message_buffer,message_buffer_length))
+	{
+		Log_Error_Number = 1009;
+		sprintf(Log_Error_String,"Log_UDP_Container_Unpack_Start:Not a container(length %d).",
+			message_buffer_length);
+		return FALSE;
+	}
+	(*record_count) = (buffer[2]<<8)|buffer[3];
+	(*message_buffer_position) = LOG_UDP_CONTAINER_HEADER_LENGTH;
+	return TRUE;
+}
+
+/**
+ * Get the next record from a received container. Call once for each of the records
+ * Log_UDP_Container_Unpack_Start returned.
+ * @param message_buffer The received datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @param message_buffer_position The address of the position in the datagram, updated to the next record.
+ * @param packet The address of a pointer, set to the record's encoded packet within message_buffer.
+ * @param packet_length The address of a size_t, filled in with the length of the record's packet.
+ * @return The routine returns TRUE on success and FALSE on failure (the container is truncated or corrupt).
+ * @see #Log_UDP_Container_Unpack_Start
+ * @see log_udp_wire.html#Log_UDP_Decode_Template
+ */
+int Log_UDP_Container_Unpack_Next(const char *message_buffer,size_t message_buffer_length,
+				  size_t *message_buffer_position,const char **packet,size_t *packet_length)
+{
+	uint64_t length;
+
+	if((message_buffer == NULL)||(message_buffer_position == NULL)||(packet == NULL)||(packet_length == NULL))
+	{
+		Log_Error_Number = 1010;
+		sprintf(Log_Error_String,"Log_UDP_Container_Unpack_Next:NULL argument.");
+		return FALSE;
+	}
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&length))
+		return FALSE;
+	if(length > (message_buffer_length-(*message_buffer_position)))
+	{
+		Log_Error_Number = 1011;
+		sprintf(Log_Error_String,"Log_UDP_Container_Unpack_Next:Record length %llu overruns container"
+			"(position %d, length %d).",(unsigned long long)length,(*message_buffer_position),
+			message_buffer_length);
+		return FALSE;
+	}
+	(*packet) = message_buffer+(*message_buffer_position);
+	(*packet_length) = (size_t)length;
+	(*message_buffer_position) += (size_t)length;
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Empty a container, leaving room for the header.
+ * @param container The container.
+ * @see #LOG_UDP_CONTAINER_HEADER_LENGTH
+ */
+static void Container_Clear(Log_UDP_Container_T container)
+{
+	container->Buffer_Position = LOG_UDP_CONTAINER_HEADER_LENGTH;
+	container->Record_Count = 0;
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,658 @@
+/* log_udp_dictionary.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * String interning for version 2 packets. System, Sub_System, Source_File, Source_Instance, Function, Category
+ * and context Keywords repeat in nearly every packet a process sends. When a handle sends with
+ * LOG_UDP_V2_FLAG_DICTIONARY set, each of these fields is sent as a varint code:
+ * <ul>
+ * <li>0: a literal string follows (varint length and characters), used when the dictionary is full.</li>
+ * <li>(id &lt;&lt; 1)|1: the string with identifier id is defined, the string follows (varint length and
+ *     characters). The receiver remembers it.</li>
+ * <li>(id &lt;&lt; 1): a reference to the string previously defined with identifier id.</li>
+ * </ul>
+ * The Message and context Values are sent the same way, but as they are often unique they are only given
+ * an identifier the second time they are seen (a small table of recently seen hashes is kept), so one-off
+ * strings don't fill the dictionary.
+ * Each packet carries the sender's dictionary generation. The sender refreshes the dictionary periodically,
+ * forgetting every string and starting a new generation, so a receiver that restarts or misses a definition
+ * recovers within one refresh interval. Identifiers are never reused within a generation, so a receiver
+ * that clears it's dictionary whenever the generation changes never expands a reference to the wrong string.
+ * A dictionary is not thread safe: the sender's handle mutex protects it.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993
+ * clock_gettime prototypes.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>   /* Error number definitions */
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_wire.h"
+
+/* hash defines */
+/**
+ * The number of slots in the string to identifier index. This must be a power of 2, and more than
+ * LOG_UDP_DICTIONARY_ENTRY_COUNT so a probe always finds an empty slot.
+ */
+#define DICTIONARY_INDEX_LENGTH         (256)
+/**
+ * The number of slots in the table of recently seen value hashes. This must be a power of 2.
+ */
+#define DICTIONARY_SEEN_LENGTH          (256)
+/**
+ * The number of generations before the generation number wraps. It is sent as one byte.
+ */
+#define DICTIONARY_GENERATION_COUNT     (256)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+
+/* structures */
+/**
+ * One string in a dictionary.
+ * <dl>
+ * <dt>String</dt> <dd>The string.</dd>
+ * <dt>Hash</dt> <dd>The hash of the string (sender only).</dd>
+ * <dt>Is_Defined</dt> <dd>For the sender, whether the string's definition has been sent this generation.
+ *     For the receiver, whether the string's definition has been received this generation.</dd>
+ * </dl>
+ * @see #LOG_UDP_DICTIONARY_STRING_LENGTH
+ */
+struct Dictionary_Entry_Struct
+{
+	char String[LOG_UDP_DICTIONARY_STRING_LENGTH];
+	unsigned int Hash;
+	int Is_Defined;
+};
+
+/**
+ * A string dictionary, for one sender or one receiver.
+ * <dl>
+ * <dt>Entry_List</dt> <dd>The strings, entry id-1 holds the string with identifier id.</dd>
+ * <dt>Entry_Count</dt> <dd>The number of identifiers allocated this generation.</dd>
+ * <dt>Index_List</dt> <dd>An open-addressed hash index from string to identifier (zero is an empty slot).
+ *     Sender only.</dd>
+ * <dt>Seen_List</dt> <dd>The hashes of recently seen values that don't have an identifier, indexed by hash.
+ *     Sender only.</dd>
+ * <dt>Pending_List</dt> <dd>The identifiers defined in the packet being encoded.</dd>
+ * <dt>Pending_Count</dt> <dd>The number of identifiers in Pending_List.</dd>
+ * <dt>Generation</dt> <dd>The current generation, 0..DICTIONARY_GENERATION_COUNT-1.</dd>
+ * <dt>Refresh_Interval_Ms</dt> <dd>The time between refreshes in milliseconds.</dd>
+ * <dt>Refresh_Time_Ms</dt> <dd>The monotonic time in milliseconds of the last refresh.</dd>
+ * </dl>
+ * @see #LOG_UDP_DICTIONARY_ENTRY_COUNT
+ * @see #DICTIONARY_INDEX_LENGTH
+ * @see #DICTIONARY_SEEN_LENGTH
+ */
+struct Log_UDP_Dictionary_Struct
+{
+	struct Dictionary_Entry_Struct Entry_List[LOG_UDP_DICTIONARY_ENTRY_COUNT];
+	int Entry_Count;
+	unsigned char Index_List[DICTIONARY_INDEX_LENGTH];
+	unsigned int Seen_List[DICTIONARY_SEEN_LENGTH];
+	unsigned char Pending_List[LOG_UDP_DICTIONARY_ENTRY_COUNT];
+	int Pending_Count;
+	int Generation;
+	int Refresh_Interval_Ms;
+	int64_t Refresh_Time_Ms;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static void Dictionary_Clear(Log_UDP_Dictionary_T dictionary);
+static int Dictionary_Encode(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			     size_t *message_buffer_position,const char *string,size_t field_length,int is_value);
+static unsigned int Dictionary_Hash(const char *string,size_t string_length);
+static int Dictionary_Encode_Literal(char *message_buffer,size_t message_buffer_length,
+				     size_t *message_buffer_position,uint64_t code,const char *string,
+				     size_t string_length);
+static int Dictionary_Decode_Literal(const char *message_buffer,size_t message_buffer_length,
+				     size_t *message_buffer_position,char *field,size_t field_length);
+static int64_t Dictionary_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Create an empty dictionary, refreshed every LOG_UDP_DICTIONARY_DEFAULT_REFRESH_MS milliseconds.
+ * @param dictionary The address of a dictionary to fill in.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Dictionary_Destroy
+ * @see #LOG_UDP_DICTIONARY_DEFAULT_REFRESH_MS
+ */
+int Log_UDP_Dictionary_Create(Log_UDP_Dictionary_T *dictionary)
+{
+	Log_UDP_Dictionary_T new_dictionary = NULL;
+
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 700;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Create:dictionary was NULL.");
+		return FALSE;
+	}
+	new_dictionary = (Log_UDP_Dictionary_T)malloc(sizeof(struct Log_UDP_Dictionary_Struct));
+	if(new_dictionary == NULL)
+	{
+		Log_Error_Number = 701;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Create:Failed to allocate dictionary.");
+		return FALSE;
+	}
+	Dictionary_Clear(new_dictionary);
+	new_dictionary->Generation = 0;
+	new_dictionary->Refresh_Interval_Ms = LOG_UDP_DICTIONARY_DEFAULT_REFRESH_MS;
+	new_dictionary->Refresh_Time_Ms = Dictionary_Monotonic_Ms();
+	(*dictionary) = new_dictionary;
+	return TRUE;
+}
+
+/**
+ * Set how often a sender's dictionary is refreshed. A refresh forgets every string, so each is
+ * defined again the next time it is sent. A shorter interval lets a restarted receiver recover
+ * sooner, at the cost of more definitions on the wire.
+ * @param dictionary The dictionary.
+ * @param refresh_interval_ms The time between refreshes in milliseconds, greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Dictionary_Refresh_Set(Log_UDP_Dictionary_T dictionary,int refresh_interval_ms)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 702;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Refresh_Set:dictionary was NULL.");
+		return FALSE;
+	}
+	if(refresh_interval_ms <= 0)
+	{
+		Log_Error_Number = 703;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Refresh_Set:Illegal refresh interval %d.",
+			refresh_interval_ms);
+		return FALSE;
+	}
+	dictionary->Refresh_Interval_Ms = refresh_interval_ms;
+	return TRUE;
+}
+
+/**
+ * Refresh a sender's dictionary now, rather than when the refresh interval has passed. Every string is
+ * forgotten and a new generation started, so the next packet defines each string it uses. A handle does this
+ * when packets that may have carried definitions were written to it's journal rather than sent.
+ * Call this between packets, not whilst one is being encoded.
+ * @param dictionary The dictionary.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Dictionary_Clear
+ * @see #DICTIONARY_GENERATION_COUNT
+ */
+int Log_UDP_Dictionary_Refresh(Log_UDP_Dictionary_T dictionary)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 714;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Refresh:dictionary was NULL.");
+		return FALSE;
+	}
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Dictionary_Refresh:Refreshing dictionary (%d strings).\n",dictionary->Entry_Count);
+#endif
+	Dictionary_Clear(dictionary);
+	dictionary->Generation = (dictionary->Generation+1)%DICTIONARY_GENERATION_COUNT;
+	dictionary->Refresh_Time_Ms = Dictionary_Monotonic_Ms();
+	return TRUE;
+}
+
+/**
+ * Start encoding a packet with a sender's dictionary. If the refresh interval has passed, the dictionary
+ * is cleared and a new generation started.
+ * @param dictionary The dictionary.
+ * @param generation The address of an integer, filled in with the generation to send in the packet header.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Dictionary_Refresh
+ * @see #Log_UDP_Dictionary_Packet_End
+ */
+int Log_UDP_Dictionary_Packet_Start(Log_UDP_Dictionary_T dictionary,int *generation)
+{
+	int64_t now_ms;
+
+	if((dictionary == NULL)||(generation == NULL))
+	{
+		Log_Error_Number = 704;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Packet_Start:NULL argument.");
+		return FALSE;
+	}
+	now_ms = Dictionary_Monotonic_Ms();
+	if((now_ms-dictionary->Refresh_Time_Ms) >= dictionary->Refresh_Interval_Ms)
+		Log_UDP_Dictionary_Refresh(dictionary);
+	dictionary->Pending_Count = 0;
+	(*generation) = dictionary->Generation;
+	return TRUE;
+}
+
+/**
+ * Encode a name field (System, Sub_System, Source_File, Source_Instance, Function, Category or a context
+ * Keyword) through a sender's dictionary. The first time a string is sent this generation it is defined,
+ * after that only a reference is sent. If the dictionary is full the string is sent as a literal.
+ * @param dictionary The dictionary.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the field.
+ * @param string The string to encode, or NULL (sent as an empty string).
+ * @param field_length The length of the log record field, the string is truncated to (field_length-1)
+ *        characters.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Log_UDP_Dictionary_Packet_Start
+ * @see #Dictionary_Encode
+ */
+int Log_UDP_Dictionary_Encode_String(Log_UDP_Dictionary_T dictionary,char *message_buffer,
+				     size_t message_buffer_length,size_t *message_buffer_position,
+				     const char *string,size_t field_length)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 705;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Encode_String:dictionary was NULL.");
+		return FALSE;
+	}
+	return Dictionary_Encode(dictionary,message_buffer,message_buffer_length,message_buffer_position,string,
+				 field_length,FALSE);
+}
+
+/**
+ * Encode a value field (the Message or a context Value) through a sender's dictionary. Values are often
+ * unique, so a value is sent as a literal the first time it is seen, and only defined (and then referenced)
+ * if it is seen again. Values too long for the dictionary are always sent as literals.
+ * @param dictionary The dictionary.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the field.
+ * @param string The string to encode, or NULL (sent as an empty string).
+ * @param field_length The length of the log record field, the string is truncated to (field_length-1)
+ *        characters.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Log_UDP_Dictionary_Packet_Start
+ * @see #Dictionary_Encode
+ */
+int Log_UDP_Dictionary_Encode_Value(Log_UDP_Dictionary_T dictionary,char *message_buffer,
+				    size_t message_buffer_length,size_t *message_buffer_position,
+				    const char *string,size_t field_length)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 713;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Encode_Value:dictionary was NULL.");
+		return FALSE;
+	}
+	return Dictionary_Encode(dictionary,message_buffer,message_buffer_length,message_buffer_position,string,
+				 field_length,TRUE);
+}
+
+/**
+ * Finish encoding a packet with a sender's dictionary. If the packet was not sent (an encoding or
+ * send error, or the record was dropped after encoding started), the definitions it contained are
+ * forgotten, so the strings are defined again in the next packet that uses them.
+ * @param dictionary The dictionary.
+ * @param sent Whether the packet was sent, TRUE or FALSE.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Dictionary_Packet_Start
+ */
+int Log_UDP_Dictionary_Packet_End(Log_UDP_Dictionary_T dictionary,int sent)
+{
+	int i;
+
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 706;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Packet_End:dictionary was NULL.");
+		return FALSE;
+	}
+	if(!sent)
+	{
+		for(i = 0; i < dictionary->Pending_Count; i++)
+			dictionary->Entry_List[dictionary->Pending_List[i]-1].Is_Defined = FALSE;
+	}
+	dictionary->Pending_Count = 0;
+	return TRUE;
+}
+
+/**
+ * Check the generation in a received packet against a receiver's dictionary. If the sender has started
+ * a new generation the receiver's dictionary is cleared.
+ * @param dictionary The receiver's dictionary for the packet's sender.
+ * @param generation The generation from the packet header.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Dictionary_Generation_Check(Log_UDP_Dictionary_T dictionary,int generation)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 707;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Generation_Check:dictionary was NULL.");
+		return FALSE;
+	}
+	if(generation != dictionary->Generation)
+	{
+#if DEBUG > 1
+		fprintf(stdout,"Log_UDP_Dictionary_Generation_Check:Generation changed from %d to %d.\n",
+			dictionary->Generation,generation);
+#endif
+		Dictionary_Clear(dictionary);
+		dictionary->Generation = generation;
+	}
+	return TRUE;
+}
+
+/**
+ * Decode a string field sent through a dictionary. Definitions are remembered in the receiver's dictionary.
+ * A reference to a string this receiver never saw defined (the definition was lost, or the receiver started
+ * after it was sent) is decoded as "&lt;id N&gt;", so the rest of the record is not lost.
+ * @param dictionary The receiver's dictionary for the packet's sender.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to read from,
+ *        updated to the position after the field.
+ * @param field The log record field to fill in.
+ * @param field_length The length of the field, longer strings are truncated.
+ * @param is_known The address of an integer, set to FALSE if the field was a reference to an unknown string
+ *        and left alone otherwise.
+ * @return The routine returns TRUE on success and FALSE if the field was malformed.
+ * @see #Dictionary_Decode_Literal
+ */
+int Log_UDP_Dictionary_Decode_String(Log_UDP_Dictionary_T dictionary,const char *message_buffer,
+				     size_t message_buffer_length,size_t *message_buffer_position,
+				     char *field,size_t field_length,int *is_known)
+{
+	struct Dictionary_Entry_Struct *entry = NULL;
+	uint64_t code,id;
+
+	if((dictionary == NULL)||(is_known == NULL))
+	{
+		Log_Error_Number = 708;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Decode_String:NULL argument.");
+		return FALSE;
+	}
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&code))
+		return FALSE;
+	if(code == 0)
+	{
+		return Dictionary_Decode_Literal(message_buffer,message_buffer_length,message_buffer_position,
+						 field,field_length);
+	}
+	id = code >> 1;
+	if((id < 1)||(id > LOG_UDP_DICTIONARY_ENTRY_COUNT))
+	{
+		Log_Error_Number = 709;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Decode_String:Illegal dictionary id %llu.",
+			(unsigned long long)id);
+		return FALSE;
+	}
+	entry = &(dictionary->Entry_List[id-1]);
+	if(code&1)
+	{
+		if(!Dictionary_Decode_Literal(message_buffer,message_buffer_length,message_buffer_position,
+					      entry->String,LOG_UDP_DICTIONARY_STRING_LENGTH))
+			return FALSE;
+		entry->Is_Defined = TRUE;
+	}
+	if(entry->Is_Defined)
+	{
+		strncpy(field,entry->String,field_length-1);
+		field[field_length-1] = '\0';
+	}
+	else
+	{
+		snprintf(field,field_length,"<id %d>",(int)id);
+		(*is_known) = FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Free a dictionary.
+ * @param dictionary The dictionary, created with Log_UDP_Dictionary_Create.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Dictionary_Create
+ */
+int Log_UDP_Dictionary_Destroy(Log_UDP_Dictionary_T dictionary)
+{
+	if(dictionary == NULL)
+	{
+		Log_Error_Number = 710;
+		sprintf(Log_Error_String,"Log_UDP_Dictionary_Destroy:dictionary was NULL.");
+		return FALSE;
+	}
+	free(dictionary);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Forget every string in a dictionary. The generation is not changed.
+ * @param dictionary The dictionary.
+ */
+static void Dictionary_Clear(Log_UDP_Dictionary_T dictionary)
+{
+	int i;
+
+	for(i = 0; i < LOG_UDP_DICTIONARY_ENTRY_COUNT; i++)
+	{
+		dictionary->Entry_List[i].String[0] = '\0';
+		dictionary->Entry_List[i].Is_Defined = FALSE;
+	}
+	dictionary->Entry_Count = 0;
+	memset(dictionary->Index_List,0,sizeof(dictionary->Index_List));
+	memset(dictionary->Seen_List,0,sizeof(dictionary->Seen_List));
+	dictionary->Pending_Count = 0;
+}
+
+/**
+ * Encode a string through a sender's dictionary, as a definition, reference or literal.
+ * @param dictionary The dictionary.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the field.
+ * @param string The string to encode, or NULL (sent as an empty string).
+ * @param field_length The length of the log record field, the string is truncated to (field_length-1)
+ *        characters.
+ * @param is_value TRUE if the string is a value, which is only given an identifier the second time it is seen,
+ *        FALSE if it is a name.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Dictionary_Hash
+ * @see #Dictionary_Encode_Literal
+ * @see #DICTIONARY_SEEN_LENGTH
+ */
+static int Dictionary_Encode(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			     size_t *message_buffer_position,const char *string,size_t field_length,int is_value)
+{
+	struct Dictionary_Entry_Struct *entry = NULL;
+	const char *end_ch = NULL;
+	size_t string_length;
+	unsigned int hash,slot;
+	int id;
+
+	if(string == NULL)
+		string = "";
+	end_ch = memchr(string,'\0',field_length-1);
+	if(end_ch != NULL)
+		string_length = end_ch-string;
+	else
+		string_length = field_length-1;
+	if(string_length >= LOG_UDP_DICTIONARY_STRING_LENGTH)
+	{
+		return Dictionary_Encode_Literal(message_buffer,message_buffer_length,message_buffer_position,0,
+						 string,string_length);
+	}
+	hash = Dictionary_Hash(string,string_length);
+	/* find the string, or the empty slot to index it at */
+	slot = hash&(DICTIONARY_INDEX_LENGTH-1);
+	while((id = dictionary->Index_List[slot]) != 0)
+	{
+		entry = &(dictionary->Entry_List[id-1]);
+		if((entry->Hash == hash)&&(strncmp(entry->String,string,string_length) == 0)&&
+		   (entry->String[string_length] == '\0'))
+			break;
+		slot = (slot+1)&(DICTIONARY_INDEX_LENGTH-1);
+	}
+	if(id == 0)
+	{
+		/* a value is only worth an identifier once it has repeated */
+		if(is_value && (dictionary->Seen_List[hash&(DICTIONARY_SEEN_LENGTH-1)] != hash))
+		{
+			dictionary->Seen_List[hash&(DICTIONARY_SEEN_LENGTH-1)] = hash;
+			return Dictionary_Encode_Literal(message_buffer,message_buffer_length,message_buffer_position,
+							 0,string,string_length);
+		}
+		if(dictionary->Entry_Count >= LOG_UDP_DICTIONARY_ENTRY_COUNT)
+		{
+			return Dictionary_Encode_Literal(message_buffer,message_buffer_length,message_buffer_position,
+							 0,string,string_length);
+		}
+		id = ++(dictionary->Entry_Count);
+		entry = &(dictionary->Entry_List[id-1]);
+		memcpy(entry->String,string,string_length);
+		entry->String[string_length] = '\0';
+		entry->Hash = hash;
+		entry->Is_Defined = FALSE;
+		dictionary->Index_List[slot] = (unsigned char)id;
+	}
+	if(entry->Is_Defined)
+	{
+		return Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+					     ((uint64_t)id) << 1);
+	}
+	if(!Dictionary_Encode_Literal(message_buffer,message_buffer_length,message_buffer_position,
+				      (((uint64_t)id) << 1)|1,string,string_length))
+		return FALSE;
+	/* later fields in this packet can refer to it, Log_UDP_Dictionary_Packet_End undoes this if it isn't sent */
+	entry->Is_Defined = TRUE;
+	dictionary->Pending_List[dictionary->Pending_Count++] = (unsigned char)id;
+	return TRUE;
+}
+
+/**
+ * Hash a string with the 32 bit FNV-1a algorithm.
+ * @param string The string.
+ * @param string_length The number of characters to hash.
+ * @return The hash.
+ */
+static unsigned int Dictionary_Hash(const char *string,size_t string_length)
+{
+	unsigned int hash;
+	size_t i;
+
+	hash = 2166136261U;
+	for(i = 0; i < string_length; i++)
+	{
+		hash ^= (unsigned char)string[i];
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/**
+ * Encode a code varint, followed by a string as a varint length and the characters.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param code The code, 0 for a literal or (id &lt;&lt; 1)|1 for a definition.
+ * @param string The string.
+ * @param string_length The number of characters in the string.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see log_udp_wire.html#Log_UDP_Encode_Varint
+ */
+static int Dictionary_Encode_Literal(char *message_buffer,size_t message_buffer_length,
+				     size_t *message_buffer_position,uint64_t code,const char *string,
+				     size_t string_length)
+{
+	if(!Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,code))
+		return FALSE;
+	if(!Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+				  (uint64_t)string_length))
+		return FALSE;
+	if(((*message_buffer_position)+string_length) > message_buffer_length)
+	{
+		Log_Error_Number = 711;
+		sprintf(Log_Error_String,"Dictionary_Encode_Literal:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),string_length,message_buffer_length);
+		return FALSE;
+	}
+	if(string_length > 0)
+		memcpy(message_buffer+(*message_buffer_position),string,string_length);
+	(*message_buffer_position) += string_length;
+	return TRUE;
+}
+
+/**
+ * Decode a varint length prefixed string, truncating it to fit the field.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the string.
+ * @param field The field to fill in.
+ * @param field_length The length of the field.
+ * @return The routine returns TRUE on success and FALSE if the string ran off the end of the buffer.
+ */
+static int Dictionary_Decode_Literal(const char *message_buffer,size_t message_buffer_length,
+				     size_t *message_buffer_position,char *field,size_t field_length)
+{
+	uint64_t string_length;
+	size_t copy_length;
+
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&string_length))
+		return FALSE;
+	if(string_length > (message_buffer_length-(*message_buffer_position)))
+	{
+		Log_Error_Number = 712;
+		sprintf(Log_Error_String,"Dictionary_Decode_Literal:String length %llu at position %d overruns length %d.",
+			(unsigned long long)string_length,(*message_buffer_position),message_buffer_length);
+		return FALSE;
+	}
+	copy_length = (size_t)string_length;
+	if(copy_length > (field_length-1))
+		copy_length = field_length-1;
+	memcpy(field,message_buffer+(*message_buffer_position),copy_length);
+	field[copy_length] = '\0';
+	(*message_buffer_position) += (size_t)string_length;
+	return TRUE;
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Dictionary_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
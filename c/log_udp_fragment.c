@@ -0,0 +1,593 @@
+/* log_udp_fragment.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Fragmentation and reassembly of oversized packets. A log record with a long context list can encode to a
+ * packet longer than the path MTU, which the IP layer fragments: losing any one IP fragment loses the
+ * whole record, and packets longer than the largest UDP payload can't be sent at all. When fragmentation
+ * is turned on (see Log_UDP_Fragment_Set), such packets are split into numbered fragment datagrams, each
+ * no longer than the configured length:
+ * <ul>
+ * <li>The magic word LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT, two bytes in network byte order.</li>
+ * <li>The message identifier, four bytes in network byte order, the same in every fragment of a message.</li>
+ * <li>The fragment index, two bytes in network byte order, starting at zero.</li>
+ * <li>The number of fragments, two bytes in network byte order.</li>
+ * <li>The length of the whole message, four bytes in network byte order.</li>
+ * <li>The fragment's part of the message. Every fragment but the last carries the same number of bytes.</li>
+ * </ul>
+ * A receiver passes fragment datagrams to a reassembler (one per sender, as message identifiers are only
+ * unique per sender), which returns the original packet once all it's fragments have arrived. The packet is
+ * then handled as if it had arrived in one datagram (it may be a container). The reassembler's memory is
+ * bounded: partly received messages are discarded after a timeout, or (oldest first) to make room.
+ * A reassembler is not thread safe.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993
+ * clock_gettime prototypes, and POSIX.1c pthread_once.
+ */
+#define _POSIX_C_SOURCE 199506L
+#include <errno.h>   /* Error number definitions */
+#include <pthread.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_fragment.h"
+
+/* hash defines */
+/**
+ * The number of partly received messages a reassembler holds at once.
+ */
+#define REASSEMBLY_MESSAGE_COUNT      (64)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                 (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS            (1000000)
+
+/* structures */
+/**
+ * A partly received message.
+ * <dl>
+ * <dt>In_Use</dt> <dd>Whether this entry holds a message (TRUE), or is free (FALSE).</dd>
+ * <dt>Message_Id</dt> <dd>The message identifier from the fragment headers.</dd>
+ * <dt>Fragment_Count</dt> <dd>The number of fragments the message was split into.</dd>
+ * <dt>Received_Count</dt> <dd>The number of different fragments received so far.</dd>
+ * <dt>Message_Length</dt> <dd>The length of the whole message, in bytes.</dd>
+ * <dt>Buffer</dt> <dd>An allocated buffer of Message_Length bytes the fragments are copied into.</dd>
+ * <dt>Received_Bitmap</dt> <dd>An allocated bitmap, with a bit set for each fragment received.</dd>
+ * <dt>Memory_Length</dt> <dd>The length of Buffer and Received_Bitmap, in bytes.</dd>
+ * <dt>Start_Ms</dt> <dd>The monotonic time the first fragment arrived, in milliseconds.</dd>
+ * </dl>
+ */
+struct Reassembly_Message_Struct
+{
+	int In_Use;
+	unsigned int Message_Id;
+	int Fragment_Count;
+	int Received_Count;
+	size_t Message_Length;
+	char *Buffer;
+	unsigned char *Received_Bitmap;
+	size_t Memory_Length;
+	int64_t Start_Ms;
+};
+
+/**
+ * A reassembler.
+ * <dl>
+ * <dt>Message_List</dt> <dd>The partly received messages.</dd>
+ * <dt>Memory_Budget</dt> <dd>The most memory partly received messages can use, in bytes.</dd>
+ * <dt>Timeout_Ms</dt> <dd>How long to wait for the rest of a message's fragments, in milliseconds.</dd>
+ * <dt>Complete_Buffer</dt> <dd>The last message reassembled, freed on the next call to
+ *     Log_UDP_Reassembly_Add.</dd>
+ * <dt>Stats</dt> <dd>The reassembly counters.</dd>
+ * </dl>
+ * @see #REASSEMBLY_MESSAGE_COUNT
+ */
+struct Log_UDP_Reassembly_Struct
+{
+	struct Reassembly_Message_Struct Message_List[REASSEMBLY_MESSAGE_COUNT];
+	size_t Memory_Budget;
+	int Timeout_Ms;
+	char *Complete_Buffer;
+	struct Log_UDP_Reassembly_Stats_Struct Stats;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The next message identifier to give out. Seeded from the process id and time, so a restarted sender
+ * is unlikely to reuse identifiers a receiver still holds fragments for.
+ * @see #Log_UDP_Fragment_Message_Id_Get
+ */
+static unsigned int Fragment_Message_Id = 0;
+/**
+ * Used to make sure Fragment_Message_Id is only seeded once.
+ * @see #Fragment_Message_Id_Seed
+ */
+static pthread_once_t Fragment_Message_Id_Once = PTHREAD_ONCE_INIT;
+
+/* internal function declarations */
+static void Fragment_Message_Id_Seed(void);
+static void Reassembly_Message_Free(Log_UDP_Reassembly_T reassembly,struct Reassembly_Message_Struct *message);
+static struct Reassembly_Message_Struct *Reassembly_Message_Get(Log_UDP_Reassembly_T reassembly,
+								unsigned int message_id,int fragment_count,
+								size_t message_length);
+static int64_t Reassembly_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Work out how many fragments a message is split into.
+ * @param message_length The length of the message in bytes.
+ * @param datagram_length The longest fragment datagram, including the header, in bytes.
+ * @param fragment_count The address of an integer, filled in with the number of fragments.
+ * @return The routine returns TRUE on success and FALSE on failure (the message needs more than
+ *         LOG_UDP_FRAGMENT_COUNT_MAX fragments).
+ * @see #LOG_UDP_FRAGMENT_HEADER_LENGTH
+ * @see #LOG_UDP_FRAGMENT_COUNT_MAX
+ */
+int Log_UDP_Fragment_Count_Get(size_t message_length,size_t datagram_length,int *fragment_count)
+{
+	size_t payload_length,count;
+
+	if(fragment_count == NULL)
+	{
+		Log_Error_Number = 1200;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Count_Get:fragment_count was NULL.");
+		return FALSE;
+	}
+	if(datagram_length < LOG_UDP_FRAGMENT_LENGTH_MIN)
+	{
+		Log_Error_Number = 1201;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Count_Get:Illegal datagram length %d.",datagram_length);
+		return FALSE;
+	}
+	payload_length = datagram_length-LOG_UDP_FRAGMENT_HEADER_LENGTH;
+	count = (message_length+payload_length-1)/payload_length;
+	if((message_length == 0)||(message_length > 0xffffffffUL)||(count > LOG_UDP_FRAGMENT_COUNT_MAX))
+	{
+		Log_Error_Number = 1202;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Count_Get:Message length %lu can't be sent in "
+			"datagrams of %d bytes.",(unsigned long)message_length,datagram_length);
+		return FALSE;
+	}
+	(*fragment_count) = (int)count;
+	return TRUE;
+}
+
+/**
+ * Get a new message identifier, to put in the header of each fragment of a message. Thread safe.
+ * @return The message identifier.
+ * @see #Fragment_Message_Id
+ */
+unsigned int Log_UDP_Fragment_Message_Id_Get(void)
+{
+	pthread_once(&Fragment_Message_Id_Once,Fragment_Message_Id_Seed);
+	return __sync_fetch_and_add(&Fragment_Message_Id,1);
+}
+
+/**
+ * Encode a fragment datagram's header.
+ * @param header_buffer A buffer of at least LOG_UDP_FRAGMENT_HEADER_LENGTH bytes to encode into.
+ * @param message_id The message identifier, from Log_UDP_Fragment_Message_Id_Get.
+ * @param fragment_index The index of this fragment, from zero to fragment_count-1.
+ * @param fragment_count The number of fragments, from Log_UDP_Fragment_Count_Get.
+ * @param message_length The length of the whole message in bytes.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT
+ * @see #LOG_UDP_FRAGMENT_HEADER_LENGTH
+ */
+int Log_UDP_Fragment_Header_Encode(char *header_buffer,unsigned int message_id,int fragment_index,
+				   int fragment_count,size_t message_length)
+{
+	if(header_buffer == NULL)
+	{
+		Log_Error_Number = 1203;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Header_Encode:header_buffer was NULL.");
+		return FALSE;
+	}
+	if((fragment_count < 1)||(fragment_count > LOG_UDP_FRAGMENT_COUNT_MAX)||(fragment_index < 0)||
+	   (fragment_index >= fragment_count))
+	{
+		Log_Error_Number = 1204;
+		sprintf(Log_Error_String,"Log_UDP_Fragment_Header_Encode:Illegal fragment %d of %d.",fragment_index,
+			fragment_count);
+		return FALSE;
+	}
+	header_buffer[0] = (char)((LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT>>8)&0xff);
+	header_buffer[1] = (char)(LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT&0xff);
+	header_buffer[2] = (char)((message_id>>24)&0xff);
+	header_buffer[3] = (char)((message_id>>16)&0xff);
+	header_buffer[4] = (char)((message_id>>8)&0xff);
+	header_buffer[5] = (char)(message_id&0xff);
+	header_buffer[6] = (char)((fragment_index>>8)&0xff);
+	header_buffer[7] = (char)(fragment_index&0xff);
+	header_buffer[8] = (char)((fragment_count>>8)&0xff);
+	header_buffer[9] = (char)(fragment_count&0xff);
+	header_buffer[10] = (char)((message_length>>24)&0xff);
+	header_buffer[11] = (char)((message_length>>16)&0xff);
+	header_buffer[12] = (char)((message_length>>8)&0xff);
+	header_buffer[13] = (char)(message_length&0xff);
+	return TRUE;
+}
+
+/**
+ * Determine whether a received datagram is a fragment.
+ * @param message_buffer The received datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @return The routine returns TRUE if the datagram starts with LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT,
+ *         and FALSE otherwise.
+ */
+int Log_UDP_Fragment_Is_Fragment(const char *message_buffer,size_t message_buffer_length)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+
+	if((message_buffer == NULL)||(message_buffer_length < LOG_UDP_FRAGMENT_HEADER_LENGTH))
+		return FALSE;
+	return (buffer[0] == ((LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT>>8)&0xff))&&
+		(buffer[1] == (LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT&0xff));
+}
+
+/**
+ * Create a reassembler, for the fragments from one sender.
+ * @param memory_length The most memory partly received messages can use, in bytes. Messages longer than
+ *        this are discarded.
+ * @param timeout_ms How long to wait for the rest of a message's fragments, in milliseconds.
+ * @param reassembly The address of a reassembler to fill in.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_REASSEMBLY_DEFAULT_MEMORY
+ * @see #LOG_UDP_REASSEMBLY_DEFAULT_TIMEOUT_MS
+ * @see #Log_UDP_Reassembly_Destroy
+ */
+int Log_UDP_Reassembly_Create(size_t memory_length,int timeout_ms,Log_UDP_Reassembly_T *reassembly)
+{
+	Log_UDP_Reassembly_T new_reassembly = NULL;
+
+	if(reassembly == NULL)
+	{
+		Log_Error_Number = 1205;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Create:reassembly was NULL.");
+		return FALSE;
+	}
+	if((memory_length == 0)||(timeout_ms <= 0))
+	{
+		Log_Error_Number = 1206;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Create:Illegal memory length %lu or timeout %d.",
+			(unsigned long)memory_length,timeout_ms);
+		return FALSE;
+	}
+	new_reassembly = (Log_UDP_Reassembly_T)malloc(sizeof(struct Log_UDP_Reassembly_Struct));
+	if(new_reassembly == NULL)
+	{
+		Log_Error_Number = 1207;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Create:Failed to allocate reassembly.");
+		return FALSE;
+	}
+	memset(new_reassembly,0,sizeof(struct Log_UDP_Reassembly_Struct));
+	new_reassembly->Memory_Budget = memory_length;
+	new_reassembly->Timeout_Ms = timeout_ms;
+	new_reassembly->Complete_Buffer = NULL;
+	(*reassembly) = new_reassembly;
+	return TRUE;
+}
+
+/**
+ * Add a received fragment datagram to a reassembler. Partly received messages that have timed out are
+ * discarded first. If this fragment completes it's message, the message is returned.
+ * A message split into one fragment is returned straight away, pointing into message_buffer.
+ * @param reassembly The reassembler.
+ * @param message_buffer The received fragment datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @param complete The address of an integer, set to TRUE if a message was completed, and FALSE otherwise.
+ * @param message The address of a pointer, set to the completed message. It is owned by the reassembler,
+ *        and is valid until the next call to Log_UDP_Reassembly_Add or Log_UDP_Reassembly_Destroy.
+ * @param message_length The address of a size_t, filled in with the length of the completed message.
+ * @return The routine returns TRUE on success (including a fragment that is discarded, which is counted),
+ *         and FALSE on failure (the datagram is not a valid fragment).
+ * @see #Log_UDP_Fragment_Is_Fragment
+ * @see #Log_UDP_Reassembly_Expire
+ * @see #Reassembly_Message_Get
+ */
+int Log_UDP_Reassembly_Add(Log_UDP_Reassembly_T reassembly,const char *message_buffer,
+			   size_t message_buffer_length,int *complete,const char **message,
+			   size_t *message_length)
+{
+	struct Reassembly_Message_Struct *partial_message = NULL;
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+	unsigned int message_id;
+	size_t total_length,payload_length,offset;
+	int fragment_index,fragment_count;
+
+	if((reassembly == NULL)||(complete == NULL)||(message == NULL)||(message_length == NULL))
+	{
+		Log_Error_Number = 1208;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Add:NULL argument.");
+		return FALSE;
+	}
+	(*complete) = FALSE;
+	if(reassembly->Complete_Buffer != NULL)
+	{
+		free(reassembly->Complete_Buffer);
+		reassembly->Complete_Buffer = NULL;
+	}
+	if(!Log_UDP_Fragment_Is_Fragment(message_buffer,message_buffer_length))
+	{
+		Log_Error_Number = 1209;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Add:Not a fragment(length %d).",message_buffer_length);
+		return FALSE;
+	}
+	message_id = (((unsigned int)buffer[2])<<24)|(buffer[3]<<16)|(buffer[4]<<8)|buffer[5];
+	fragment_index = (buffer[6]<<8)|buffer[7];
+	fragment_count = (buffer[8]<<8)|buffer[9];
+	total_length = (((size_t)buffer[10])<<24)|(buffer[11]<<16)|(buffer[12]<<8)|buffer[13];
+	payload_length = message_buffer_length-LOG_UDP_FRAGMENT_HEADER_LENGTH;
+	/* every fragment but the last carries the same number of bytes, and the last ends the message */
+	if((fragment_count == 0)||(fragment_index >= fragment_count)||(payload_length == 0)||
+	   (payload_length > total_length)||
+	   ((fragment_index < (fragment_count-1))&&((((size_t)fragment_count-1)*payload_length) >= total_length))||
+	   ((fragment_index == (fragment_count-1))&&
+	    ((total_length-payload_length) < (((size_t)fragment_index)*payload_length))))
+	{
+		Log_Error_Number = 1210;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Add:Illegal fragment %d of %d (%lu of %lu bytes).",
+			fragment_index,fragment_count,(unsigned long)payload_length,(unsigned long)total_length);
+		return FALSE;
+	}
+	if(fragment_index < (fragment_count-1))
+		offset = ((size_t)fragment_index)*payload_length;
+	else
+		offset = total_length-payload_length;
+	if(fragment_count == 1)
+	{
+		reassembly->Stats.Complete_Count++;
+		(*complete) = TRUE;
+		(*message) = message_buffer+LOG_UDP_FRAGMENT_HEADER_LENGTH;
+		(*message_length) = payload_length;
+		return TRUE;
+	}
+	Log_UDP_Reassembly_Expire(reassembly);
+	partial_message = Reassembly_Message_Get(reassembly,message_id,fragment_count,total_length);
+	if(partial_message == NULL)
+		return TRUE;
+	if(partial_message->Received_Bitmap[fragment_index/8] & (1<<(fragment_index%8)))
+	{
+		reassembly->Stats.Duplicate_Count++;
+		return TRUE;
+	}
+	memcpy(partial_message->Buffer+offset,message_buffer+LOG_UDP_FRAGMENT_HEADER_LENGTH,payload_length);
+	partial_message->Received_Bitmap[fragment_index/8] |= (1<<(fragment_index%8));
+	partial_message->Received_Count++;
+	if(partial_message->Received_Count < partial_message->Fragment_Count)
+		return TRUE;
+	/* hand the buffer over, so the message isn't copied again */
+	reassembly->Complete_Buffer = partial_message->Buffer;
+	partial_message->Buffer = NULL;
+	(*complete) = TRUE;
+	(*message) = reassembly->Complete_Buffer;
+	(*message_length) = partial_message->Message_Length;
+	Reassembly_Message_Free(reassembly,partial_message);
+	reassembly->Stats.Complete_Count++;
+	return TRUE;
+}
+
+/**
+ * Discard partly received messages whose first fragment arrived longer ago than the reassembler's timeout.
+ * Log_UDP_Reassembly_Add calls this, a receiver should also call it when no fragments have arrived for a while
+ * to free the memory.
+ * @param reassembly The reassembler.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Reassembly_Message_Free
+ */
+int Log_UDP_Reassembly_Expire(Log_UDP_Reassembly_T reassembly)
+{
+	int64_t now_ms;
+	int i;
+
+	if(reassembly == NULL)
+	{
+		Log_Error_Number = 1211;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Expire:reassembly was NULL.");
+		return FALSE;
+	}
+	if(reassembly->Stats.Memory_Length == 0)
+		return TRUE;
+	now_ms = Reassembly_Monotonic_Ms();
+	for(i = 0; i < REASSEMBLY_MESSAGE_COUNT; i++)
+	{
+		if(reassembly->Message_List[i].In_Use &&
+		   ((now_ms-reassembly->Message_List[i].Start_Ms) > reassembly->Timeout_Ms))
+		{
+			Reassembly_Message_Free(reassembly,&(reassembly->Message_List[i]));
+			reassembly->Stats.Timeout_Count++;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Get a reassembler's counters.
+ * @param reassembly The reassembler.
+ * @param stats The address of a structure to fill in with the counters.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Reassembly_Stats_Get(Log_UDP_Reassembly_T reassembly,struct Log_UDP_Reassembly_Stats_Struct *stats)
+{
+	if((reassembly == NULL)||(stats == NULL))
+	{
+		Log_Error_Number = 1212;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Stats_Get:NULL argument.");
+		return FALSE;
+	}
+	(*stats) = reassembly->Stats;
+	return TRUE;
+}
+
+/**
+ * Free a reassembler, and any partly received messages it holds.
+ * @param reassembly The reassembler.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Reassembly_Create
+ */
+int Log_UDP_Reassembly_Destroy(Log_UDP_Reassembly_T reassembly)
+{
+	int i;
+
+	if(reassembly == NULL)
+	{
+		Log_Error_Number = 1213;
+		sprintf(Log_Error_String,"Log_UDP_Reassembly_Destroy:reassembly was NULL.");
+		return FALSE;
+	}
+	for(i = 0; i < REASSEMBLY_MESSAGE_COUNT; i++)
+	{
+		if(reassembly->Message_List[i].In_Use)
+			Reassembly_Message_Free(reassembly,&(reassembly->Message_List[i]));
+	}
+	if(reassembly->Complete_Buffer != NULL)
+		free(reassembly->Complete_Buffer);
+	free(reassembly);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Seed the message identifier from the process id and the time.
+ * @see #Fragment_Message_Id
+ */
+static void Fragment_Message_Id_Seed(void)
+{
+	Fragment_Message_Id = (((unsigned int)getpid())<<16)^((unsigned int)time(NULL));
+}
+
+/**
+ * Free a partly received message's memory, and mark it's entry free.
+ * @param reassembly The reassembler.
+ * @param message The message's entry.
+ */
+static void Reassembly_Message_Free(Log_UDP_Reassembly_T reassembly,struct Reassembly_Message_Struct *message)
+{
+	if(message->Buffer != NULL)
+		free(message->Buffer);
+	if(message->Received_Bitmap != NULL)
+		free(message->Received_Bitmap);
+	reassembly->Stats.Memory_Length -= message->Memory_Length;
+	memset(message,0,sizeof(struct Reassembly_Message_Struct));
+}
+
+/**
+ * Find a partly received message, or start a new one. Starting a message discards the oldest messages
+ * until there is a free entry and enough memory for it. A message with the same identifier but a different
+ * fragment count or length is from an earlier sender that reused the identifier, and is discarded.
+ * @param reassembly The reassembler.
+ * @param message_id The message identifier.
+ * @param fragment_count The number of fragments in the message.
+ * @param message_length The length of the message in bytes.
+ * @return The message's entry, or NULL if the message is discarded (it is longer than the reassembler's
+ *         memory, or memory could not be allocated).
+ * @see #Reassembly_Message_Free
+ */
+static struct Reassembly_Message_Struct *Reassembly_Message_Get(Log_UDP_Reassembly_T reassembly,
+								unsigned int message_id,int fragment_count,
+								size_t message_length)
+{
+	struct Reassembly_Message_Struct *message = NULL;
+	struct Reassembly_Message_Struct *oldest_message = NULL;
+	size_t memory_length;
+	int i;
+
+	for(i = 0; i < REASSEMBLY_MESSAGE_COUNT; i++)
+	{
+		if(reassembly->Message_List[i].In_Use && (reassembly->Message_List[i].Message_Id == message_id))
+		{
+			if((reassembly->Message_List[i].Fragment_Count == fragment_count)&&
+			   (reassembly->Message_List[i].Message_Length == message_length))
+				return &(reassembly->Message_List[i]);
+			Reassembly_Message_Free(reassembly,&(reassembly->Message_List[i]));
+			reassembly->Stats.Evicted_Count++;
+		}
+	}
+	memory_length = message_length+((fragment_count+7)/8);
+	if(memory_length > reassembly->Memory_Budget)
+	{
+		reassembly->Stats.Oversize_Count++;
+		return NULL;
+	}
+	while(TRUE)
+	{
+		message = NULL;
+		oldest_message = NULL;
+		for(i = 0; i < REASSEMBLY_MESSAGE_COUNT; i++)
+		{
+			if(!reassembly->Message_List[i].In_Use)
+			{
+				if(message == NULL)
+					message = &(reassembly->Message_List[i]);
+			}
+			else if((oldest_message == NULL)||(reassembly->Message_List[i].Start_Ms < oldest_message->Start_Ms))
+				oldest_message = &(reassembly->Message_List[i]);
+		}
+		if((message != NULL)&&((reassembly->Stats.Memory_Length+memory_length) <= reassembly->Memory_Budget))
+			break;
+		Reassembly_Message_Free(reassembly,oldest_message);
+		reassembly->Stats.Evicted_Count++;
+	}
+	message->Buffer = (char *)malloc(message_length*sizeof(char));
+	message->Received_Bitmap = (unsigned char *)calloc((fragment_count+7)/8,sizeof(unsigned char));
+	if((message->Buffer == NULL)||(message->Received_Bitmap == NULL))
+	{
+		if(message->Buffer != NULL)
+			free(message->Buffer);
+		if(message->Received_Bitmap != NULL)
+			free(message->Received_Bitmap);
+		memset(message,0,sizeof(struct Reassembly_Message_Struct));
+		reassembly->Stats.Oversize_Count++;
+		return NULL;
+	}
+	message->In_Use = TRUE;
+	message->Message_Id = message_id;
+	message->Fragment_Count = fragment_count;
+	message->Received_Count = 0;
+	message->Message_Length = message_length;
+	message->Memory_Length = memory_length;
+	message->Start_Ms = Reassembly_Monotonic_Ms();
+	reassembly->Stats.Memory_Length += memory_length;
+	return message;
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Reassembly_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
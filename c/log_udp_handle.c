@@ -0,0 +1,2294 @@
+/* log_udp_handle.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Persistent logger handles. Most processes log with constant System, Sub_System, Source_File and
+ * Source_Instance values. A handle holds the connected socket, the resolved remote address, and those
+ * constant fields already encoded into a byte prefix, so each log message only encodes the timestamp,
+ * Function, Severity, Verbosity, Category, Message and contexts. The packets are identical to
+ * those sent by Log_UDP_Send_Record.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1c threads prototypes,
+ * and the POSIX.1-2001 gethostname prototype.
+ */
+#define _POSIX_C_SOURCE 200112L
+#include <errno.h>   /* Error number definitions */
+#include <pthread.h>
+#include <stdarg.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+#include "log_udp_handle.h"
+#include "log_udp_coalesce.h"
+#include "log_udp_rate.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_template.h"
+#include "log_udp_compress.h"
+#include "log_udp_container.h"
+#include "log_udp_journal.h"
+#include "log_udp_resolve.h"
+#include "log_udp_ring.h"
+#include "log_udp_stream.h"
+#include "log_udp_wire.h"
+
+/* hash defines */
+/**
+ * The maximum length of the pre-encoded prefix, the System, Sub_System, Source_File and Source_Instance
+ * strings including their NULL terminators.
+ */
+#define HANDLE_PREFIX_LENGTH          (LOG_RECORD_SYSTEM_LENGTH+LOG_RECORD_SUB_SYSTEM_LENGTH+ \
+				       LOG_RECORD_SOURCE_FILE_LENGTH+LOG_RECORD_SOURCE_INSTANCE_LENGTH)
+/**
+ * The maximum length of the pre-encoded version 2 prefix. Each of the four strings has a varint length
+ * of at most 2 bytes in place of it's NULL terminator.
+ */
+#define HANDLE_PREFIX_V2_LENGTH       (HANDLE_PREFIX_LENGTH+4)
+/**
+ * The default compression threshold, in bytes. Shorter packets are not worth compressing.
+ */
+#define HANDLE_DEFAULT_COMPRESSION_THRESHOLD (256)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                 (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS            (1000000)
+/**
+ * The number of microseconds in one second.
+ */
+#define ONE_SECOND_US                 (1000000)
+/**
+ * The number of nanoseconds in one microsecond.
+ */
+#define ONE_MICROSECOND_NS            (1000)
+/**
+ * The length of the buffer the host name is read into, for the stream tag.
+ */
+#define HANDLE_HOSTNAME_LENGTH        (256)
+
+/* structures */
+/**
+ * Data for one logger handle.
+ * <dl>
+ * <dt>Socket_Id</dt> <dd>The connected socket, opened by Log_UDP_Open, or -1 if the handle writes to a ring
+ *     or stream.</dd>
+ * <dt>Ring</dt> <dd>If not NULL, the shared memory ring packets are written to instead of being sent.</dd>
+ * <dt>Stream</dt> <dd>If not NULL, the stream packets are written to instead of being sent as datagrams.</dd>
+ * <dt>Journal</dt> <dd>If not NULL, packets that can't be sent because the destination is unreachable are
+ *     written to this journal, and replayed later.</dd>
+ * <dt>Journal_Refresh</dt> <dd>TRUE from when a packet is written to the journal until one is sent, whilst
+ *     the dictionary and templates are refreshed before each packet.</dd>
+ * <dt>Destination_Address_List</dt> <dd>The resolved addresses packets are sent to. The first is the
+ *     address the socket is connected to, the rest were added with Log_UDP_Handle_Destination_Add.</dd>
+ * <dt>Destination_Address_Length_List</dt> <dd>The length of each address in Destination_Address_List.</dd>
+ * <dt>Destination_Hostname_List</dt> <dd>The hostname of each destination, used to pick up re-resolved
+ *     addresses. Empty if the hostname was too long to be cached.</dd>
+ * <dt>Destination_Port_List</dt> <dd>The port number of each destination.</dd>
+ * <dt>Resolve_Generation</dt> <dd>The value of Log_UDP_Resolve_Generation when the destination addresses were
+ *     last checked against the resolver cache.</dd>
+ * <dt>Destination_Stats_List</dt> <dd>The number of packets sent to each destination.</dd>
+ * <dt>Destination_Count</dt> <dd>The number of destinations, at least one.</dd>
+ * <dt>Fan_Out_Socket_Id</dt> <dd>An unconnected socket, used to send to every destination when there is more
+ *     than one, or -1.</dd>
+ * <dt>Prefix</dt> <dd>The System, Sub_System, Source_File and Source_Instance, encoded as they appear
+ *     in a packet (NULL terminated strings one after another).</dd>
+ * <dt>Prefix_Length</dt> <dd>The number of bytes used in Prefix.</dd>
+ * <dt>Prefix_V2</dt> <dd>The System, Sub_System, Source_File and Source_Instance, encoded as they appear
+ *     in a version 2 packet (varint length prefixed strings one after another).</dd>
+ * <dt>Prefix_V2_Length</dt> <dd>The number of bytes used in Prefix_V2.</dd>
+ * <dt>Format</dt> <dd>The wire format packets are encoded in, a member of LOG_UDP_WIRE_FORMAT.</dd>
+ * <dt>Flags</dt> <dd>The version 2 packet flags to send (LOG_UDP_V2_FLAG_*).</dd>
+ * <dt>Dictionary</dt> <dd>The string dictionary used when LOG_UDP_V2_FLAG_DICTIONARY is set, created the first
+ *     time it is. Protected by Mutex.</dd>
+ * <dt>Template_Table</dt> <dd>The message templates registered with the handle, created when the first is.
+ *     Protected by Mutex.</dd>
+ * <dt>Buffer</dt> <dd>The buffer packets are encoded into. Only reallocated when a longer packet is sent.</dd>
+ * <dt>Buffer_Length</dt> <dd>The allocated length of Buffer in bytes.</dd>
+ * <dt>Compression_Threshold</dt> <dd>When LOG_UDP_V2_FLAG_COMPRESSED is set, packets at least this long
+ *     (in bytes) are compressed.</dd>
+ * <dt>Compress_Buffer</dt> <dd>The buffer packets are compressed into. Only reallocated when a longer packet
+ *     is compressed.</dd>
+ * <dt>Compress_Buffer_Length</dt> <dd>The allocated length of Compress_Buffer in bytes.</dd>
+ * <dt>Container</dt> <dd>If not NULL, packets are packed into this container rather than sent one by one.</dd>
+ * <dt>Container_Flush_Interval_Ms</dt> <dd>A container is sent once it's first record is this old
+ *     (in milliseconds), checked whenever a packet is sent.</dd>
+ * <dt>Container_Start_Ms</dt> <dd>The monotonic time in milliseconds the first record was added to
+ *     the container.</dd>
+ * <dt>Sequence_Host_Id</dt> <dd>A hash of this host's name, sent in the stream tag of packets sent with
+ *     LOG_UDP_V2_FLAG_SEQUENCE.</dd>
+ * <dt>Sequence_Pid</dt> <dd>This process's id, sent in the stream tag.</dd>
+ * <dt>Sequence_Start_Us</dt> <dd>The time the handle was opened, in microseconds since 1970, sent in the
+ *     stream tag. This makes each handle's stream distinct.</dd>
+ * <dt>Sequence_Number</dt> <dd>The sequence number of the next packet sent with LOG_UDP_V2_FLAG_SEQUENCE.</dd>
+ * <dt>Filter_Severity</dt> <dd>Messages with a lower severity are not sent by this handle.</dd>
+ * <dt>Filter_Verbosity</dt> <dd>Messages with a higher (more verbose) verbosity are not sent by this handle.</dd>
+ * <dt>Mutex</dt> <dd>Used to stop more than one thread using Buffer at once.</dd>
+ * </dl>
+ * @see #HANDLE_PREFIX_LENGTH
+ * @see #HANDLE_PREFIX_V2_LENGTH
+ * @see #HANDLE_DEFAULT_COMPRESSION_THRESHOLD
+ * @see log_udp_wire.html#LOG_UDP_WIRE_FORMAT
+ */
+struct Log_UDP_Handle_Struct
+{
+	int Socket_Id;
+	Log_UDP_Ring_T Ring;
+	Log_UDP_Stream_T Stream;
+	Log_UDP_Journal_T Journal;
+	int Journal_Refresh;
+	struct sockaddr_storage Destination_Address_List[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	socklen_t Destination_Address_Length_List[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	char Destination_Hostname_List[LOG_UDP_HANDLE_DESTINATION_COUNT][LOG_UDP_RESOLVE_HOSTNAME_LENGTH];
+	int Destination_Port_List[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	int Resolve_Generation;
+	struct Log_UDP_Handle_Destination_Stats_Struct Destination_Stats_List[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	int Destination_Count;
+	int Fan_Out_Socket_Id;
+	char Prefix[HANDLE_PREFIX_LENGTH];
+	size_t Prefix_Length;
+	char Prefix_V2[HANDLE_PREFIX_V2_LENGTH];
+	size_t Prefix_V2_Length;
+	int Format;
+	int Flags;
+	Log_UDP_Dictionary_T Dictionary;
+	Log_UDP_Template_Table_T Template_Table;
+	char *Buffer;
+	size_t Buffer_Length;
+	int Compression_Threshold;
+	char *Compress_Buffer;
+	size_t Compress_Buffer_Length;
+	Log_UDP_Container_T Container;
+	int Container_Flush_Interval_Ms;
+	int64_t Container_Start_Ms;
+	uint64_t Sequence_Host_Id;
+	uint64_t Sequence_Pid;
+	uint64_t Sequence_Start_Us;
+	uint64_t Sequence_Number;
+	int Filter_Severity;
+	int Filter_Verbosity;
+	pthread_mutex_t Mutex;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static int Handle_Encode_String(char *message_buffer,size_t message_buffer_length,
+				size_t *message_buffer_position,const char *string,size_t field_length);
+static int Handle_Coalesce_Allow(Log_UDP_Handle_T handle,const char *function,int severity,int verbosity,
+				 const char *category,const char *message,int64_t timestamp,int log_context_count,
+				 const struct Log_Context_Struct *log_context_list);
+static int Handle_Rate_Limit_Allow(Log_UDP_Handle_T handle,const char *category,int severity);
+static int Handle_Timestamp_Get(int format,int flags,int64_t *timestamp,int64_t *wire_timestamp);
+static int Handle_Encode_Header(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+				size_t message_buffer_length,size_t *message_buffer_position,int64_t wire_timestamp,
+				const char *function,int severity,int verbosity,const char *category);
+static int Handle_Encode_Field(int format,char *message_buffer,size_t message_buffer_length,
+			       size_t *message_buffer_position,const char *string,size_t field_length);
+static int Handle_Encode_Name(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+			      size_t message_buffer_length,size_t *message_buffer_position,const char *string,
+			      size_t field_length);
+static int Handle_Encode_Value(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+			       size_t message_buffer_length,size_t *message_buffer_position,const char *string,
+			       size_t field_length);
+static int Handle_Encode_Count(int format,char *message_buffer,size_t message_buffer_length,
+			       size_t *message_buffer_position,int count);
+static void Handle_Journal_Refresh(Log_UDP_Handle_T handle);
+static char *Handle_Buffer_Get(Log_UDP_Handle_T handle,size_t message_buffer_length);
+static int Handle_Record_Send(void *summary_arg,const struct Log_Record_Struct *log_record,
+			      int log_context_count,const struct Log_Context_Struct *log_context_list);
+static int Handle_Transmit(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length);
+static int Handle_Container_Add(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length);
+static int Handle_Container_Send(Log_UDP_Handle_T handle);
+static int Handle_Datagram_Send(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length);
+static void Handle_Destination_Hostname_Set(Log_UDP_Handle_T handle,int index,char *hostname,int port_number);
+static void Handle_Destination_Refresh(Log_UDP_Handle_T handle);
+static int64_t Handle_Monotonic_Ms(void);
+static uint64_t Handle_Host_Id(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Open a logger handle. A UDP socket is opened and connected to hostname/port_number, and the constant
+ * fields of the log records are pre-encoded. Strings longer than the corresponding log record fields are
+ * truncated, as in Log_Create_Record. A hostname starting with LOG_UDP_RING_PREFIX ("shm:log_relay") opens
+ * a shared memory ring instead: the handle's packets are written to the ring without a system call, and a
+ * local relay forwards them. A hostname starting with LOG_UDP_STREAM_PREFIX ("tcp:loghost") sends the
+ * handle's packets over a stream connection instead, for records that must not be lost: the connection is
+ * made (and remade) in the background, and packets are buffered until they can be written. Ring and stream
+ * handles have only the one destination.
+ * @param hostname The hostname the socket will talk to, either numeric or via /etc/hosts,
+ *        LOG_UDP_RING_PREFIX followed by a ring name, or LOG_UDP_STREAM_PREFIX followed by a hostname.
+ * @param port_number The port number to send to in host (normal) byte order.
+ * @param system The System, a string of length LOG_RECORD_SYSTEM_LENGTH. Can be NULL.
+ * @param sub_system The Sub_System, a string of length LOG_RECORD_SUB_SYSTEM_LENGTH. Can be NULL.
+ * @param source_file The source filename, a string of length LOG_RECORD_SOURCE_FILE_LENGTH. Can be NULL.
+ * @param source_instance The instance of the source filename, a string of length
+ *        LOG_RECORD_SOURCE_INSTANCE_LENGTH. Can be NULL.
+ * @param handle The address of a Log_UDP_Handle_T to fill in with the opened handle.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Encode_String
+ * @see log_udp.html#Log_UDP_Open
+ * @see log_udp_ring.html#Log_UDP_Ring_Open
+ * @see log_udp_stream.html#Log_UDP_Stream_Open
+ */
+int Log_UDP_Handle_Open(char *hostname,int port_number,char *system,char *sub_system,char *source_file,
+			char *source_instance,Log_UDP_Handle_T *handle)
+{
+	Log_UDP_Handle_T new_handle = NULL;
+	struct timespec now_time;
+	int socket_errno;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Handle_Open(%s,%d):started.\n",hostname,port_number);
+#endif
+	if(handle == NULL)
+	{
+		Log_Error_Number = 300;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Open:handle was NULL.");
+		return FALSE;
+	}
+	/* the hostname is tested for the ring and stream prefixes before anything else looks at it */
+	if(hostname == NULL)
+	{
+		Log_Error_Number = 332;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Open:hostname was NULL.");
+		return FALSE;
+	}
+	new_handle = (Log_UDP_Handle_T)calloc(1,sizeof(struct Log_UDP_Handle_Struct));
+	if(new_handle == NULL)
+	{
+		Log_Error_Number = 301;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Open:Failed to allocate handle.");
+		return FALSE;
+	}
+	/* pre-encode constant fields */
+	new_handle->Prefix_Length = 0;
+	if((!Handle_Encode_String(new_handle->Prefix,HANDLE_PREFIX_LENGTH,&(new_handle->Prefix_Length),system,
+				  LOG_RECORD_SYSTEM_LENGTH))||
+	   (!Handle_Encode_String(new_handle->Prefix,HANDLE_PREFIX_LENGTH,&(new_handle->Prefix_Length),sub_system,
+				  LOG_RECORD_SUB_SYSTEM_LENGTH))||
+	   (!Handle_Encode_String(new_handle->Prefix,HANDLE_PREFIX_LENGTH,&(new_handle->Prefix_Length),source_file,
+				  LOG_RECORD_SOURCE_FILE_LENGTH))||
+	   (!Handle_Encode_String(new_handle->Prefix,HANDLE_PREFIX_LENGTH,&(new_handle->Prefix_Length),
+				  source_instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH)))
+	{
+		free(new_handle);
+		return FALSE;
+	}
+	new_handle->Prefix_V2_Length = 0;
+	if((!Log_UDP_Encode_Varint_String(new_handle->Prefix_V2,HANDLE_PREFIX_V2_LENGTH,
+					  &(new_handle->Prefix_V2_Length),system,LOG_RECORD_SYSTEM_LENGTH))||
+	   (!Log_UDP_Encode_Varint_String(new_handle->Prefix_V2,HANDLE_PREFIX_V2_LENGTH,
+					  &(new_handle->Prefix_V2_Length),sub_system,LOG_RECORD_SUB_SYSTEM_LENGTH))||
+	   (!Log_UDP_Encode_Varint_String(new_handle->Prefix_V2,HANDLE_PREFIX_V2_LENGTH,
+					  &(new_handle->Prefix_V2_Length),source_file,LOG_RECORD_SOURCE_FILE_LENGTH))||
+	   (!Log_UDP_Encode_Varint_String(new_handle->Prefix_V2,HANDLE_PREFIX_V2_LENGTH,
+					  &(new_handle->Prefix_V2_Length),source_instance,
+					  LOG_RECORD_SOURCE_INSTANCE_LENGTH)))
+	{
+		free(new_handle);
+		return FALSE;
+	}
+	new_handle->Format = LOG_UDP_WIRE_FORMAT_V1;
+	new_handle->Flags = 0;
+	new_handle->Dictionary = NULL;
+	new_handle->Template_Table = NULL;
+	new_handle->Compression_Threshold = HANDLE_DEFAULT_COMPRESSION_THRESHOLD;
+	new_handle->Compress_Buffer = NULL;
+	new_handle->Compress_Buffer_Length = 0;
+	new_handle->Container = NULL;
+	new_handle->Container_Flush_Interval_Ms = 0;
+	new_handle->Container_Start_Ms = 0;
+	clock_gettime(CLOCK_REALTIME,&now_time);
+	new_handle->Sequence_Host_Id = Handle_Host_Id();
+	new_handle->Sequence_Pid = (uint64_t)getpid();
+	new_handle->Sequence_Start_Us = (((uint64_t)now_time.tv_sec)*ONE_SECOND_US)+(now_time.tv_nsec/ONE_MICROSECOND_NS);
+	new_handle->Sequence_Number = 0;
+	new_handle->Resolve_Generation = Log_UDP_Resolve_Generation;
+	new_handle->Ring = NULL;
+	new_handle->Stream = NULL;
+	new_handle->Journal = NULL;
+	new_handle->Journal_Refresh = FALSE;
+	if(strncmp(hostname,LOG_UDP_RING_PREFIX,strlen(LOG_UDP_RING_PREFIX)) == 0)
+	{
+		/* the ring is not a resolvable destination, so is never refreshed */
+		if(!Log_UDP_Ring_Open(hostname+strlen(LOG_UDP_RING_PREFIX),0,&(new_handle->Ring)))
+		{
+			free(new_handle);
+			return FALSE;
+		}
+		new_handle->Socket_Id = -1;
+		new_handle->Destination_Hostname_List[0][0] = '\0';
+		new_handle->Destination_Port_List[0] = port_number;
+		new_handle->Destination_Address_Length_List[0] = 0;
+	}
+	else if(strncmp(hostname,LOG_UDP_STREAM_PREFIX,strlen(LOG_UDP_STREAM_PREFIX)) == 0)
+	{
+		/* the stream resolves it's hostname each time it connects */
+		if(!Log_UDP_Stream_Open(hostname+strlen(LOG_UDP_STREAM_PREFIX),port_number,0,0,
+					&(new_handle->Stream)))
+		{
+			free(new_handle);
+			return FALSE;
+		}
+		new_handle->Socket_Id = -1;
+		new_handle->Destination_Hostname_List[0][0] = '\0';
+		new_handle->Destination_Port_List[0] = port_number;
+		new_handle->Destination_Address_Length_List[0] = 0;
+	}
+	else
+	{
+		if(!Log_UDP_Open(hostname,port_number,&(new_handle->Socket_Id)))
+		{
+			free(new_handle);
+			return FALSE;
+		}
+		/* remember the resolved address, as the first destination */
+		Handle_Destination_Hostname_Set(new_handle,0,hostname,port_number);
+		new_handle->Destination_Address_Length_List[0] = sizeof(struct sockaddr_storage);
+		if(getpeername(new_handle->Socket_Id,(struct sockaddr *)&(new_handle->Destination_Address_List[0]),
+			       &(new_handle->Destination_Address_Length_List[0])) < 0)
+		{
+			socket_errno = errno;
+			Log_UDP_Close(new_handle->Socket_Id);
+			close(new_handle->Socket_Id);
+			free(new_handle);
+			Log_Error_Number = 302;
+			sprintf(Log_Error_String,"Log_UDP_Handle_Open:getpeername failed (%d:%s).",socket_errno,
+				strerror(socket_errno));
+			return FALSE;
+		}
+	}
+	memset(new_handle->Destination_Stats_List,0,sizeof(new_handle->Destination_Stats_List));
+	new_handle->Destination_Count = 1;
+	new_handle->Fan_Out_Socket_Id = -1;
+	/* by default the handle only applies the process-wide filter */
+	new_handle->Filter_Severity = LOG_SEVERITY_INFO;
+	new_handle->Filter_Verbosity = LOG_VERBOSITY_VERY_VERBOSE;
+	pthread_mutex_init(&(new_handle->Mutex),NULL);
+	(*handle) = new_handle;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Handle_Open:finished with prefix length %d.\n",new_handle->Prefix_Length);
+#endif
+	return TRUE;
+}
+
+/**
+ * Send a log message using a logger handle. The timestamp is set to the current time, and the
+ * System, Sub_System, Source_File and Source_Instance are those the handle was opened with.
+ * Strings longer than the corresponding log record fields are truncated, as in Log_Create_Record.
+ * Messages that don't pass the handle's filter or the process-wide filter return TRUE without
+ * reading the clock or encoding anything. Repeated messages (see Log_UDP_Coalesce_Set) and messages 
+ * suppressed by the rate limiter return TRUE without being encoded.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param function The function calling the log, a string of length LOG_RECORD_FUNCTION_LENGTH. Can be NULL.
+ * @param severity Whether the log is INFO or ERROR, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity At what level is the log message (TERSE/high level or VERBOSE/low level),
+ *         a valid member of LOG_VERBOSITY.
+ * @param category What sort of information is the message. A string of length LOG_RECORD_CATEGORY_LENGTH.
+ *        Can be NULL.
+ * @param message The actual message. A string of length LOG_RECORD_MESSAGE_LENGTH.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Buffer_Get
+ * @see #Handle_Encode_Header
+ * @see #Handle_Encode_String
+ * @see #Handle_Transmit
+ * @see #Log_UDP_Handle_Is_Enabled
+ * @see log_create.html#Log_Create_Timestamp_Get
+ */
+int Log_UDP_Handle_Send(Log_UDP_Handle_T handle,char *function,int severity,int verbosity,char *category,
+			char *message,int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	char *message_buffer = NULL;
+	size_t message_buffer_length,message_buffer_position;
+	int64_t timestamp,wire_timestamp;
+	int wire_format,wire_flags,i,retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send:handle was NULL.");
+		return FALSE;
+	}
+	/* filtered out messages are not an error */
+	if(!Log_UDP_Handle_Is_Enabled(handle,severity,verbosity))
+		return TRUE;
+	if(message == NULL)
+	{
+		Log_Error_Number = 304;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send:message was NULL.");
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_SEVERITY(severity))
+	{
+		Log_Error_Number = 305;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send:severity is not a legal value(%d).",severity);
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_VERBOSITY(verbosity))
+	{
+		Log_Error_Number = 306;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send:verbosity is not a legal value(%d).",verbosity);
+		return FALSE;
+	}
+	if((log_context_count < 0)||((log_context_count > 0)&&(log_context_list == NULL)))
+	{
+		Log_Error_Number = 307;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send:Illegal log context list (count %d).",log_context_count);
+		return FALSE;
+	}
+	/* read the format once, so the timestamp and encoding agree. The Message is text, not a template */
+	wire_format = handle->Format;
+	wire_flags = handle->Flags&(~LOG_UDP_V2_FLAG_TEMPLATE);
+	if(!Handle_Timestamp_Get(wire_format,wire_flags,&timestamp,&wire_timestamp))
+		return FALSE;
+	/* repeated and rate limited messages are not an error */
+	if(!Handle_Coalesce_Allow(handle,function,severity,verbosity,category,message,timestamp,log_context_count,
+				  log_context_list))
+		return TRUE;
+	if(!Handle_Rate_Limit_Allow(handle,category,severity))
+		return TRUE;
+	if(wire_format == LOG_UDP_WIRE_FORMAT_V2)
+		message_buffer_length = LOG_UDP_V2_BUFFER_LENGTH(log_context_count);
+	else
+		message_buffer_length = LOG_UDP_BUFFER_LENGTH(log_context_count);
+	pthread_mutex_lock(&(handle->Mutex));
+	Handle_Journal_Refresh(handle);
+	message_buffer = Handle_Buffer_Get(handle,message_buffer_length);
+	if(message_buffer == NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		return FALSE;
+	}
+	message_buffer_position = 0;
+	retval = Handle_Encode_Header(handle,wire_format,wire_flags,message_buffer,message_buffer_length,
+				      &message_buffer_position,wire_timestamp,function,severity,verbosity,category);
+	retval = retval && Handle_Encode_Value(handle,wire_format,wire_flags,message_buffer,message_buffer_length,
+					       &message_buffer_position,message,LOG_RECORD_MESSAGE_LENGTH);
+	retval = retval && Handle_Encode_Count(wire_format,message_buffer,message_buffer_length,
+					       &message_buffer_position,log_context_count);
+	for(i = 0; retval && (i < log_context_count); i++)
+	{
+		retval = Handle_Encode_Name(handle,wire_format,wire_flags,message_buffer,message_buffer_length,
+					    &message_buffer_position,log_context_list[i].Keyword,
+					    LOG_CONTEXT_KEYWORD_LENGTH);
+		retval = retval && Handle_Encode_Value(handle,wire_format,wire_flags,message_buffer,
+						       message_buffer_length,&message_buffer_position,
+						       log_context_list[i].Value,LOG_CONTEXT_VALUE_LENGTH);
+	}
+	if(retval)
+		retval = Handle_Transmit(handle,message_buffer,message_buffer_position);
+	if(wire_flags&LOG_UDP_V2_FLAG_DICTIONARY)
+		Log_UDP_Dictionary_Packet_End(handle->Dictionary,retval);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Send a printf-style formatted log message using a logger handle. The message is formatted once, into a
+ * buffer on the stack, and copied straight into the handle's packet buffer rather than into a log record
+ * first. The message is truncated to LOG_RECORD_MESSAGE_LENGTH-1 characters. The Function is sent as an
+ * empty string, and no contexts are sent. When the message doesn't pass the handle's filter or the
+ * process-wide filter the routine returns TRUE without formatting anything. Repeated messages and messages
+ * suppressed by the rate limiter return TRUE without being encoded, as in Log_UDP_Handle_Send.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity Whether the log is INFO or ERROR, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity At what level is the log message, a valid member of LOG_VERBOSITY.
+ * @param category What sort of information is the message. A string of length LOG_RECORD_CATEGORY_LENGTH.
+ *        Can be NULL.
+ * @param format A printf-style format string.
+ * @param ... The arguments for format.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Vsendf
+ */
+int Log_UDP_Sendf(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,const char *format,...)
+{
+	va_list argument_list;
+	int retval;
+
+	va_start(argument_list,format);
+	retval = Log_UDP_Vsendf(handle,severity,verbosity,category,format,argument_list);
+	va_end(argument_list);
+	return retval;
+}
+
+/**
+ * Send a vprintf-style formatted log message using a logger handle. See Log_UDP_Sendf.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity Whether the log is INFO or ERROR, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity At what level is the log message, a valid member of LOG_VERBOSITY.
+ * @param category What sort of information is the message. A string of length LOG_RECORD_CATEGORY_LENGTH.
+ *        Can be NULL.
+ * @param format A printf-style format string.
+ * @param argument_list The arguments for format.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Sendf
+ * @see #Log_UDP_Handle_Is_Enabled
+ * @see #Handle_Coalesce_Allow
+ * @see #Handle_Rate_Limit_Allow
+ * @see #Handle_Buffer_Get
+ * @see #Handle_Encode_Header
+ * @see #Handle_Encode_Field
+ * @see #Handle_Transmit
+ */
+int Log_UDP_Vsendf(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,const char *format,
+		   va_list argument_list)
+{
+	char message[LOG_RECORD_MESSAGE_LENGTH];
+	char *message_buffer = NULL;
+	size_t message_buffer_length,message_buffer_position;
+	int64_t timestamp,wire_timestamp;
+	int wire_format,wire_flags,retval,format_length;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Vsendf:handle was NULL.");
+		return FALSE;
+	}
+	/* filtered out messages are not formatted */
+	if(!Log_UDP_Handle_Is_Enabled(handle,severity,verbosity))
+		return TRUE;
+	if(format == NULL)
+	{
+		Log_Error_Number = 304;
+		sprintf(Log_Error_String,"Log_UDP_Vsendf:format was NULL.");
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_SEVERITY(severity))
+	{
+		Log_Error_Number = 305;
+		sprintf(Log_Error_String,"Log_UDP_Vsendf:severity is not a legal value(%d).",severity);
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_VERBOSITY(verbosity))
+	{
+		Log_Error_Number = 306;
+		sprintf(Log_Error_String,"Log_UDP_Vsendf:verbosity is not a legal value(%d).",verbosity);
+		return FALSE;
+	}
+	format_length = vsnprintf(message,LOG_RECORD_MESSAGE_LENGTH,format,argument_list);
+	if(format_length < 0)
+	{
+		Log_Error_Number = 312;
+		sprintf(Log_Error_String,"Log_UDP_Vsendf:Failed to format message '%s'.",format);
+		return FALSE;
+	}
+	wire_format = handle->Format;
+	wire_flags = handle->Flags&(~LOG_UDP_V2_FLAG_TEMPLATE);
+	if(!Handle_Timestamp_Get(wire_format,wire_flags,&timestamp,&wire_timestamp))
+		return FALSE;
+	/* repeated and rate limited messages are not an error, and are checked in the same order as
+	** Log_UDP_Handle_Send so repeats don't use up rate limiter tokens */
+	if(!Handle_Coalesce_Allow(handle,"",severity,verbosity,category,message,timestamp,0,NULL))
+		return TRUE;
+	if(!Handle_Rate_Limit_Allow(handle,category,severity))
+		return TRUE;
+	if(wire_format == LOG_UDP_WIRE_FORMAT_V2)
+		message_buffer_length = LOG_UDP_V2_BUFFER_LENGTH(0);
+	else
+		message_buffer_length = LOG_UDP_BUFFER_LENGTH(0);
+	pthread_mutex_lock(&(handle->Mutex));
+	Handle_Journal_Refresh(handle);
+	message_buffer = Handle_Buffer_Get(handle,message_buffer_length);
+	if(message_buffer == NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		return FALSE;
+	}
+	message_buffer_position = 0;
+	retval = Handle_Encode_Header(handle,wire_format,wire_flags,message_buffer,message_buffer_length,
+				      &message_buffer_position,wire_timestamp,"",severity,verbosity,category);
+	/* a formatted message is unlikely to repeat, so it is always sent as a dictionary literal */
+	if(retval && (wire_flags&LOG_UDP_V2_FLAG_DICTIONARY))
+		message_buffer[message_buffer_position++] = 0;
+	retval = retval && Handle_Encode_Field(wire_format,message_buffer,message_buffer_length,
+					       &message_buffer_position,message,LOG_RECORD_MESSAGE_LENGTH);
+	retval = retval && Handle_Encode_Count(wire_format,message_buffer,message_buffer_length,
+					       &message_buffer_position,0);
+	retval = retval && Handle_Transmit(handle,message_buffer,message_buffer_position);
+	if(wire_flags&LOG_UDP_V2_FLAG_DICTIONARY)
+		Log_UDP_Dictionary_Packet_End(handle->Dictionary,retval);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Send an already created log record over the handle's socket. The record's own System, Sub_System,
+ * Source_File and Source_Instance are sent, not those the handle was opened with.
+ * Records that don't pass the handle's filter or the process-wide filter, are repeats, or are suppressed
+ * by the rate limiter, are not sent.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Record_Send
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Allow
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Allow
+ */
+int Log_UDP_Handle_Send_Record(Log_UDP_Handle_T handle,const struct Log_Record_Struct *log_record,
+			       int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send_Record:handle was NULL.");
+		return FALSE;
+	}
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 311;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send_Record:log_record was NULL.");
+		return FALSE;
+	}
+	/* filtered out records are not an error */
+	if(!Log_UDP_Handle_Is_Enabled(handle,log_record->Severity,log_record->Verbosity))
+		return TRUE;
+	/* validate before coalescing, so an illegal record is never counted as a repeat */
+	if((log_context_count < 0)||((log_context_count > 0)&&(log_context_list == NULL)))
+	{
+		Log_Error_Number = 307;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Send_Record:Illegal log context list (count %d).",
+			log_context_count);
+		return FALSE;
+	}
+	/* repeated and rate limited records are not an error */
+	if(!Log_UDP_Coalesce_Allow(Handle_Record_Send,handle,log_record->System,log_record->Sub_System,
+				   log_record->Source_File,log_record->Source_Instance,log_record->Function,
+				   log_record->Severity,log_record->Verbosity,log_record->Category,log_record->Message,
+				   log_record->Timestamp,log_context_count,log_context_list))
+		return TRUE;
+	if(!Log_UDP_Rate_Limit_Allow(Handle_Record_Send,handle,log_record->System,log_record->Sub_System,
+				     log_record->Category,log_record->Severity))
+		return TRUE;
+	return Handle_Record_Send(handle,log_record,log_context_count,log_context_list);
+}
+
+/**
+ * Set a logger handle's filter. Messages with a severity lower than severity, or a verbosity higher
+ * (more verbose) than verbosity, are not sent by the handle. The process-wide filter set by
+ * Log_UDP_Filter_Set is applied as well.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity The lowest severity to send, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity The highest verbosity to send, a valid member of LOG_VERBOSITY.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Is_Enabled
+ * @see log_udp.html#Log_UDP_Filter_Set
+ */
+int Log_UDP_Handle_Filter_Set(Log_UDP_Handle_T handle,int severity,int verbosity)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Filter_Set:handle was NULL.");
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_SEVERITY(severity))
+	{
+		Log_Error_Number = 305;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Filter_Set:severity is not a legal value(%d).",severity);
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_VERBOSITY(verbosity))
+	{
+		Log_Error_Number = 306;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Filter_Set:verbosity is not a legal value(%d).",verbosity);
+		return FALSE;
+	}
+	handle->Filter_Severity = severity;
+	handle->Filter_Verbosity = verbosity;
+	return TRUE;
+}
+
+/**
+ * Set the wire format a logger handle encodes it's packets in. Handles are opened sending version 1
+ * packets, which every receiver understands. Version 2 packets are smaller, and can carry a microsecond
+ * timestamp.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param format The wire format, a valid member of LOG_UDP_WIRE_FORMAT.
+ * @param flags The version 2 packet flags, a combination of LOG_UDP_V2_FLAG_*. Should be zero for version 1.
+ *        If LOG_UDP_V2_FLAG_MICROSECONDS is set, messages sent with Log_UDP_Handle_Send and Log_UDP_Sendf
+ *        are timestamped in microseconds. If LOG_UDP_V2_FLAG_DICTIONARY is set, the name fields are sent
+ *        through a string dictionary, which the receiver must decode with Log_UDP_Decode_Dictionary.
+ *        If LOG_UDP_V2_FLAG_TEMPLATE is set, messages sent with Log_UDP_Handle_Template_Send are sent as
+ *        a template identifier and arguments, which the receiver must decode with Log_UDP_Decode_Template.
+ *        If LOG_UDP_V2_FLAG_COMPRESSED is set, packets at least as long as the compression threshold are
+ *        compressed, when that makes them shorter. If LOG_UDP_V2_FLAG_SEQUENCE is set, each packet carries the
+ *        handle's stream tag and a sequence number, so receivers can count lost and reordered packets.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see log_udp_wire.html#LOG_UDP_WIRE_FORMAT
+ * @see log_udp_wire.html#LOG_UDP_V2_FLAG_ALL
+ * @see #Log_UDP_Handle_Compression_Threshold_Set
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Create
+ */
+int Log_UDP_Handle_Format_Set(Log_UDP_Handle_T handle,int format,int flags)
+{
+	Log_UDP_Dictionary_T dictionary = NULL;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Format_Set:handle was NULL.");
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_WIRE_FORMAT(format))
+	{
+		Log_Error_Number = 313;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Format_Set:format is not a legal value(%d).",format);
+		return FALSE;
+	}
+	if(((flags & (~LOG_UDP_V2_FLAG_ALL)) != 0)||((format == LOG_UDP_WIRE_FORMAT_V1)&&(flags != 0)))
+	{
+		Log_Error_Number = 314;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Format_Set:flags are not legal for format %d(%#x).",
+			format,flags);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if((flags&LOG_UDP_V2_FLAG_DICTIONARY)&&(handle->Dictionary == NULL))
+	{
+		if(!Log_UDP_Dictionary_Create(&dictionary))
+		{
+			pthread_mutex_unlock(&(handle->Mutex));
+			return FALSE;
+		}
+		handle->Dictionary = dictionary;
+	}
+	handle->Format = format;
+	handle->Flags = flags;
+	pthread_mutex_unlock(&(handle->Mutex));
+	return TRUE;
+}
+
+/**
+ * Set how often a logger handle's string dictionary is refreshed (every string defined again), so a receiver
+ * that restarts or misses a definition recovers. The handle must be sending with LOG_UDP_V2_FLAG_DICTIONARY.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param refresh_interval_ms The time between refreshes in milliseconds, greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Format_Set
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Refresh_Set
+ */
+int Log_UDP_Handle_Dictionary_Refresh_Set(Log_UDP_Handle_T handle,int refresh_interval_ms)
+{
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Dictionary_Refresh_Set:handle was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Dictionary == NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 315;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Dictionary_Refresh_Set:Handle has no dictionary.");
+		return FALSE;
+	}
+	retval = Log_UDP_Dictionary_Refresh_Set(handle->Dictionary,refresh_interval_ms);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Register a message template with a logger handle. Messages are then sent with Log_UDP_Handle_Template_Send,
+ * passing the template identifier and the format's arguments. Registering the same format again returns the
+ * same identifier. Templates can be registered whatever the handle's wire format is.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param format A printf-style format, see log_udp_template.c for the conversions supported.
+ * @param template_id The address of an integer, filled in with the template's identifier.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Template_Send
+ * @see log_udp_template.html#Log_UDP_Template_Register
+ */
+int Log_UDP_Handle_Template_Register(Log_UDP_Handle_T handle,const char *format,int *template_id)
+{
+	Log_UDP_Template_Table_T template_table = NULL;
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Register:handle was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Template_Table == NULL)
+	{
+		if(!Log_UDP_Template_Table_Create(&template_table))
+		{
+			pthread_mutex_unlock(&(handle->Mutex));
+			return FALSE;
+		}
+		handle->Template_Table = template_table;
+	}
+	retval = Log_UDP_Template_Register(handle->Template_Table,format,template_id);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Send a log message built from a registered template using a logger handle. If the handle is sending
+ * version 2 packets with LOG_UDP_V2_FLAG_TEMPLATE set, the arguments are encoded in binary after the template
+ * identifier, and nothing is formatted. Otherwise the message is formatted as Log_UDP_Sendf does.
+ * The Function is sent as an empty string, and no contexts are sent. Filtered and rate limited messages
+ * return TRUE without encoding anything. Templated messages are not coalesced.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity Whether the log is INFO or ERROR, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity At what level is the log message, a valid member of LOG_VERBOSITY.
+ * @param category What sort of information is the message. A string of length LOG_RECORD_CATEGORY_LENGTH.
+ *        Can be NULL.
+ * @param template_id The template's identifier, returned by Log_UDP_Handle_Template_Register.
+ * @param ... The arguments for the template's format.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Template_Vsend
+ */
+int Log_UDP_Handle_Template_Send(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,
+				 int template_id,...)
+{
+	va_list argument_list;
+	int retval;
+
+	va_start(argument_list,template_id);
+	retval = Log_UDP_Handle_Template_Vsend(handle,severity,verbosity,category,template_id,argument_list);
+	va_end(argument_list);
+	return retval;
+}
+
+/**
+ * Send a log message built from a registered template using a logger handle, with the arguments in a va_list.
+ * See Log_UDP_Handle_Template_Send.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity Whether the log is INFO or ERROR, a valid member of the LOG_SEVERITY enum.
+ * @param verbosity At what level is the log message, a valid member of LOG_VERBOSITY.
+ * @param category What sort of information is the message. A string of length LOG_RECORD_CATEGORY_LENGTH.
+ *        Can be NULL.
+ * @param template_id The template's identifier, returned by Log_UDP_Handle_Template_Register.
+ * @param argument_list The arguments for the template's format.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Template_Send
+ * @see #Log_UDP_Vsendf
+ * @see #Handle_Encode_Header
+ * @see #Handle_Transmit
+ * @see log_udp_template.html#Log_UDP_Template_Encode
+ */
+int Log_UDP_Handle_Template_Vsend(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,
+				  int template_id,va_list argument_list)
+{
+	const char *format = NULL;
+	char *message_buffer = NULL;
+	size_t message_buffer_length,message_buffer_position;
+	int64_t timestamp,wire_timestamp;
+	int wire_format,wire_flags,retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Vsend:handle was NULL.");
+		return FALSE;
+	}
+	if(!Log_UDP_Handle_Is_Enabled(handle,severity,verbosity))
+		return TRUE;
+	/* templates are never removed, so the format stays valid once the mutex is released */
+	pthread_mutex_lock(&(handle->Mutex));
+	if((handle->Template_Table == NULL)||
+	   (!Log_UDP_Template_Format_Get(handle->Template_Table,template_id,&format)))
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 316;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Vsend:Template %d is not registered.",template_id);
+		return FALSE;
+	}
+	wire_format = handle->Format;
+	wire_flags = handle->Flags;
+	pthread_mutex_unlock(&(handle->Mutex));
+	if((wire_format != LOG_UDP_WIRE_FORMAT_V2)||((wire_flags&LOG_UDP_V2_FLAG_TEMPLATE) == 0))
+		return Log_UDP_Vsendf(handle,severity,verbosity,category,format,argument_list);
+	if(!LOG_UDP_IS_SEVERITY(severity))
+	{
+		Log_Error_Number = 305;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Vsend:severity is not a legal value(%d).",severity);
+		return FALSE;
+	}
+	if(!LOG_UDP_IS_VERBOSITY(verbosity))
+	{
+		Log_Error_Number = 306;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Vsend:verbosity is not a legal value(%d).",
+			verbosity);
+		return FALSE;
+	}
+	/* rate limited messages are not encoded */
+	if(!Handle_Rate_Limit_Allow(handle,category,severity))
+		return TRUE;
+	if(!Handle_Timestamp_Get(wire_format,wire_flags,&timestamp,&wire_timestamp))
+		return FALSE;
+	message_buffer_length = LOG_UDP_V2_BUFFER_LENGTH(0)+LOG_UDP_TEMPLATE_ENCODED_LENGTH;
+	pthread_mutex_lock(&(handle->Mutex));
+	Handle_Journal_Refresh(handle);
+	message_buffer = Handle_Buffer_Get(handle,message_buffer_length);
+	if(message_buffer == NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		return FALSE;
+	}
+	message_buffer_position = 0;
+	retval = Handle_Encode_Header(handle,wire_format,wire_flags,message_buffer,message_buffer_length,
+				      &message_buffer_position,wire_timestamp,"",severity,verbosity,category);
+	retval = retval && Log_UDP_Template_Encode(handle->Template_Table,template_id,message_buffer,
+						   message_buffer_length,&message_buffer_position,argument_list);
+	retval = retval && Handle_Encode_Count(wire_format,message_buffer,message_buffer_length,
+					       &message_buffer_position,0);
+	retval = retval && Handle_Transmit(handle,message_buffer,message_buffer_position);
+	if(wire_flags&LOG_UDP_V2_FLAG_DICTIONARY)
+		Log_UDP_Dictionary_Packet_End(handle->Dictionary,retval);
+	Log_UDP_Template_Packet_End(handle->Template_Table,retval);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Set how often a logger handle's templates are defined again, so a receiver that restarts or misses a
+ * definition recovers. At least one template must have been registered.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param refresh_interval_ms The time between refreshes in milliseconds, greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Template_Register
+ * @see log_udp_template.html#Log_UDP_Template_Refresh_Set
+ */
+int Log_UDP_Handle_Template_Refresh_Set(Log_UDP_Handle_T handle,int refresh_interval_ms)
+{
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Refresh_Set:handle was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Template_Table == NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 316;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Template_Refresh_Set:No templates are registered.");
+		return FALSE;
+	}
+	retval = Log_UDP_Template_Refresh_Set(handle->Template_Table,refresh_interval_ms);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Set the length at which a logger handle starts compressing it's packets. Only used when the handle is
+ * sending version 2 packets with LOG_UDP_V2_FLAG_COMPRESSED set. Handles are opened with a threshold of
+ * HANDLE_DEFAULT_COMPRESSION_THRESHOLD bytes.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param threshold Packets at least this many bytes long are compressed. Zero compresses every packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Format_Set
+ * @see #HANDLE_DEFAULT_COMPRESSION_THRESHOLD
+ */
+int Log_UDP_Handle_Compression_Threshold_Set(Log_UDP_Handle_T handle,int threshold)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Compression_Threshold_Set:handle was NULL.");
+		return FALSE;
+	}
+	if(threshold < 0)
+	{
+		Log_Error_Number = 317;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Compression_Threshold_Set:Illegal threshold %d.",threshold);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	handle->Compression_Threshold = threshold;
+	pthread_mutex_unlock(&(handle->Mutex));
+	return TRUE;
+}
+
+/**
+ * Pack a logger handle's packets into multi-record container datagrams, rather than sending each one on
+ * it's own. A container is sent when the next packet doesn't fit, when a packet is sent and the
+ * container's first record is older than flush_interval_ms, and by Log_UDP_Handle_Flush and
+ * Log_UDP_Handle_Close. A quiet process should call Log_UDP_Handle_Flush periodically so it's last few
+ * records are not held back. Packets too long for a container are sent on their own.
+ * The receiver must unpack containers with Log_UDP_Container_Unpack_Next.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param datagram_length The longest container datagram in bytes (LOG_UDP_CONTAINER_DEFAULT_LENGTH avoids
+ *        IP fragmentation), or zero to send packets one by one again (any records held are sent first).
+ * @param flush_interval_ms The longest time in milliseconds a record is held in the container before
+ *        being sent (when the next packet is sent), greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Flush
+ * @see log_udp_container.html#Log_UDP_Container_Create
+ * @see log_udp_container.html#LOG_UDP_CONTAINER_DEFAULT_LENGTH
+ */
+int Log_UDP_Handle_Container_Set(Log_UDP_Handle_T handle,size_t datagram_length,int flush_interval_ms)
+{
+	Log_UDP_Container_T container = NULL;
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Container_Set:handle was NULL.");
+		return FALSE;
+	}
+	if(flush_interval_ms < 1)
+	{
+		Log_Error_Number = 319;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Container_Set:Illegal flush interval %d ms.",
+			flush_interval_ms);
+		return FALSE;
+	}
+	if((datagram_length > 0)&&(!Log_UDP_Container_Create(datagram_length,&container)))
+		return FALSE;
+	pthread_mutex_lock(&(handle->Mutex));
+	retval = TRUE;
+	if(handle->Container != NULL)
+	{
+		retval = Handle_Container_Send(handle);
+		Log_UDP_Container_Destroy(handle->Container);
+	}
+	handle->Container = container;
+	handle->Container_Flush_Interval_Ms = flush_interval_ms;
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Send any records a logger handle is holding in it's container. A stream handle also waits (for up to
+ * LOG_UDP_STREAM_FLUSH_TIMEOUT_MS) for it's buffered packets to be acknowledged by the receiver, and a
+ * handle with a journal writes it's buffered packets to the journal file.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @return The routine returns TRUE on success and FALSE on failure. A handle not using containers
+ *         has nothing to send, and returns TRUE.
+ * @see #Log_UDP_Handle_Container_Set
+ * @see #Handle_Container_Send
+ * @see log_udp_stream.html#Log_UDP_Stream_Flush
+ * @see log_udp_journal.html#Log_UDP_Journal_Flush
+ */
+int Log_UDP_Handle_Flush(Log_UDP_Handle_T handle)
+{
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Flush:handle was NULL.");
+		return FALSE;
+	}
+	retval = TRUE;
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Container != NULL)
+		retval = Handle_Container_Send(handle);
+	if(retval && (handle->Journal != NULL))
+		retval = Log_UDP_Journal_Flush(handle->Journal);
+	pthread_mutex_unlock(&(handle->Mutex));
+	/* wait for the stream outside the mutex, so other threads can keep logging */
+	if(retval && (handle->Stream != NULL))
+		retval = Log_UDP_Stream_Flush(handle->Stream,LOG_UDP_STREAM_FLUSH_TIMEOUT_MS);
+	return retval;
+}
+
+/**
+ * Give a logger handle a spill to disk journal. From then on, a packet that fails to send because the
+ * collector is unreachable (a connected UDP socket reports ECONNREFUSED once the collector's host has
+ * returned an ICMP port unreachable, or EHOSTUNREACH/ENETUNREACH) is written to the journal instead, as is
+ * every packet after it until the journal has been replayed to the collector, so the packets stay in order.
+ * Packets that fail to send for other reasons are counted as errors, not journaled. The journal's replay
+ * thread replays the packets exactly as they were encoded, with their original timestamps. Packets left in
+ * the journal file by a previous process are replayed too. A collector host that is down without anything
+ * returning an ICMP error can't be detected, and packets sent to it are still lost. From when a packet is
+ * journaled until one is sent, the handle's dictionary and templates are refreshed before each packet, so
+ * the replayed packets and the first live packet define the strings and templates they use (the packet that
+ * found the collector unreachable was encoded before that was known). Only handles sending over a UDP
+ * socket to one destination can have a journal, and destinations can't be added once it has one.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param filename The journal filename. Only one process can use a journal file at once.
+ * @param replay_rate The number of packets per second to replay, zero uses
+ *        LOG_UDP_JOURNAL_DEFAULT_REPLAY_RATE.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Destination_Stats_Struct
+ * @see log_udp_journal.html#Log_UDP_Journal_Open
+ */
+int Log_UDP_Handle_Journal_Set(Log_UDP_Handle_T handle,const char *filename,int replay_rate)
+{
+	Log_UDP_Journal_T journal = NULL;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Journal_Set:handle was NULL.");
+		return FALSE;
+	}
+	if((handle->Ring != NULL)||(handle->Stream != NULL))
+	{
+		Log_Error_Number = 328;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Journal_Set:Only a datagram handle can have a journal.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Journal != NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 329;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Journal_Set:The handle already has a journal.");
+		return FALSE;
+	}
+	if(handle->Destination_Count != 1)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 330;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Journal_Set:A handle with %d destinations can't have a "
+			"journal.",handle->Destination_Count);
+		return FALSE;
+	}
+	/* the journal replays over it's own socket, connected to the handle's destination */
+	if(handle->Destination_Hostname_List[0][0] == '\0')
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 331;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Journal_Set:The handle's hostname is too long.");
+		return FALSE;
+	}
+	if(!Log_UDP_Journal_Open(filename,handle->Destination_Hostname_List[0],handle->Destination_Port_List[0],
+				 replay_rate,&journal))
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		return FALSE;
+	}
+	handle->Journal = journal;
+	pthread_mutex_unlock(&(handle->Mutex));
+	return TRUE;
+}
+
+/**
+ * Add a destination to a logger handle. Every packet the handle sends is then encoded once and sent to
+ * each destination: the address the handle was opened with, and those added. With more than one
+ * destination the handle sends over an unconnected socket, using one sendmmsg call per packet under Linux.
+ * A send is successful only if it reached every destination, Log_UDP_Handle_Destination_Stats_Get shows
+ * which failed. Handles writing to a ring can't have destinations added, the relay forwards the packets,
+ * and nor can handles writing to a stream, or handles with a journal.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param hostname The hostname to send to, either numeric or via /etc/hosts.
+ * @param port_number The port number to send to.
+ * @param destination_index The address of an integer, filled in with the index of the new destination
+ *        (the handle's original destination is index 0). Can be NULL.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_HANDLE_DESTINATION_COUNT
+ * @see #Log_UDP_Handle_Destination_Stats_Get
+ * @see log_udp.html#Log_UDP_Resolve
+ * @see log_udp.html#Log_UDP_Multicast_Configure
+ * @see log_udp.html#Log_UDP_Send_Encoded_List
+ */
+int Log_UDP_Handle_Destination_Add(Log_UDP_Handle_T handle,char *hostname,int port_number,
+				   int *destination_index)
+{
+	struct sockaddr_storage address;
+	socklen_t address_length;
+	int index,socket_errno;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:handle was NULL.");
+		return FALSE;
+	}
+	if(handle->Ring != NULL)
+	{
+		Log_Error_Number = 325;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:A ring handle can't have more destinations.");
+		return FALSE;
+	}
+	if(handle->Stream != NULL)
+	{
+		Log_Error_Number = 326;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:A stream handle can't have more destinations.");
+		return FALSE;
+	}
+	/* resolve before taking the mutex, a DNS lookup can take a while */
+	if(!Log_UDP_Resolve(hostname,port_number,&address,&address_length))
+		return FALSE;
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Journal != NULL)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 327;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:A handle with a journal can't have more "
+			"destinations.");
+		return FALSE;
+	}
+	if(handle->Destination_Count >= LOG_UDP_HANDLE_DESTINATION_COUNT)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 320;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:Too many destinations(%d).",
+			handle->Destination_Count);
+		return FALSE;
+	}
+	if(((struct sockaddr *)&address)->sa_family !=
+	   ((struct sockaddr *)&(handle->Destination_Address_List[0]))->sa_family)
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 321;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:%s:%d is not in the same address family "
+			"as the handle's first destination.",hostname,port_number);
+		return FALSE;
+	}
+	if(handle->Fan_Out_Socket_Id < 0)
+	{
+		handle->Fan_Out_Socket_Id = socket(((struct sockaddr *)&address)->sa_family,SOCK_DGRAM,0);
+		if(handle->Fan_Out_Socket_Id < 0)
+		{
+			socket_errno = errno;
+			pthread_mutex_unlock(&(handle->Mutex));
+			Log_Error_Number = 322;
+			sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Add:Failed to create socket (%d:%s).",
+				socket_errno,strerror(socket_errno));
+			return FALSE;
+		}
+		if(!Log_UDP_Socket_Configure(handle->Fan_Out_Socket_Id))
+		{
+			close(handle->Fan_Out_Socket_Id);
+			handle->Fan_Out_Socket_Id = -1;
+			pthread_mutex_unlock(&(handle->Mutex));
+			return FALSE;
+		}
+		/* the first destination may be a multicast group, it is now sent to over this socket */
+		if(!Log_UDP_Multicast_Configure(handle->Fan_Out_Socket_Id,&(handle->Destination_Address_List[0])))
+		{
+			close(handle->Fan_Out_Socket_Id);
+			handle->Fan_Out_Socket_Id = -1;
+			pthread_mutex_unlock(&(handle->Mutex));
+			return FALSE;
+		}
+	}
+	if(!Log_UDP_Multicast_Configure(handle->Fan_Out_Socket_Id,&address))
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		return FALSE;
+	}
+	index = handle->Destination_Count;
+	handle->Destination_Address_List[index] = address;
+	handle->Destination_Address_Length_List[index] = address_length;
+	Handle_Destination_Hostname_Set(handle,index,hostname,port_number);
+	memset(&(handle->Destination_Stats_List[index]),0,sizeof(struct Log_UDP_Handle_Destination_Stats_Struct));
+	handle->Destination_Count++;
+	pthread_mutex_unlock(&(handle->Mutex));
+	if(destination_index != NULL)
+		(*destination_index) = index;
+	return TRUE;
+}
+
+/**
+ * Get the number of destinations a logger handle sends to.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param destination_count The address of an integer, filled in with the number of destinations.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Destination_Add
+ */
+int Log_UDP_Handle_Destination_Count_Get(Log_UDP_Handle_T handle,int *destination_count)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Count_Get:handle was NULL.");
+		return FALSE;
+	}
+	if(destination_count == NULL)
+	{
+		Log_Error_Number = 323;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Count_Get:destination_count was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	(*destination_count) = handle->Destination_Count;
+	pthread_mutex_unlock(&(handle->Mutex));
+	return TRUE;
+}
+
+/**
+ * Get the number of packets a logger handle has sent to one of it's destinations.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param destination_index The index of the destination, 0 is the address the handle was opened with.
+ * @param stats The address of a structure to fill in.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Handle_Destination_Add
+ * @see #Log_UDP_Handle_Destination_Stats_Struct
+ */
+int Log_UDP_Handle_Destination_Stats_Get(Log_UDP_Handle_T handle,int destination_index,
+					 struct Log_UDP_Handle_Destination_Stats_Struct *stats)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Stats_Get:handle was NULL.");
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Log_Error_Number = 323;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(handle->Mutex));
+	if((destination_index < 0)||(destination_index >= handle->Destination_Count))
+	{
+		pthread_mutex_unlock(&(handle->Mutex));
+		Log_Error_Number = 324;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Destination_Stats_Get:Illegal destination index %d.",
+			destination_index);
+		return FALSE;
+	}
+	(*stats) = handle->Destination_Stats_List[destination_index];
+	pthread_mutex_unlock(&(handle->Mutex));
+	return TRUE;
+}
+
+/**
+ * Determine whether a message with the specified severity and verbosity would be sent by the handle,
+ * i.e. it passes both the handle's filter and the process-wide filter. Test this before building an
+ * expensive message.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param severity The severity of the message.
+ * @param verbosity The verbosity of the message.
+ * @return The routine returns TRUE if the message would be sent, and FALSE if it would be filtered out
+ *         (or the handle is NULL).
+ * @see #Log_UDP_Handle_Filter_Set
+ * @see log_udp.html#Log_UDP_Is_Enabled
+ */
+int Log_UDP_Handle_Is_Enabled(Log_UDP_Handle_T handle,int severity,int verbosity)
+{
+	if(handle == NULL)
+		return FALSE;
+	return (severity >= handle->Filter_Severity)&&(verbosity <= handle->Filter_Verbosity)&&
+		Log_UDP_Is_Enabled(severity,verbosity);
+}
+
+/**
+ * Get the socket a logger handle sends over.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @param socket_id The address of an integer to fill in with the socket, or -1 if the handle writes to a
+ *        ring or stream.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Handle_Socket_Get(Log_UDP_Handle_T handle,int *socket_id)
+{
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Socket_Get:handle was NULL.");
+		return FALSE;
+	}
+	if(socket_id == NULL)
+	{
+		Log_Error_Number = 308;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Socket_Get:socket_id was NULL.");
+		return FALSE;
+	}
+	(*socket_id) = handle->Socket_Id;
+	return TRUE;
+}
+
+/**
+ * Close a logger handle, sending any rate limiter and coalescer summaries for messages sent with it and
+ * any records held in it's container, closing it's socket (unmapping it's
+ * ring, or flushing and closing it's stream) and freeing the handle. A journal is closed with the packets
+ * not yet replayed left in it's file, to be replayed when it is next opened.
+ * @param handle The logger handle, opened with Log_UDP_Handle_Open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Record_Send
+ * @see log_udp.html#Log_UDP_Close
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Release
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Release
+ * @see log_udp_journal.html#Log_UDP_Journal_Close
+ */
+int Log_UDP_Handle_Close(Log_UDP_Handle_T handle)
+{
+	int retval;
+
+	if(handle == NULL)
+	{
+		Log_Error_Number = 303;
+		sprintf(Log_Error_String,"Log_UDP_Handle_Close:handle was NULL.");
+		return FALSE;
+	}
+	/* summaries go into the container, and no summary is sent through the handle once these return */
+	Log_UDP_Coalesce_Release(Handle_Record_Send,handle);
+	Log_UDP_Rate_Limit_Release(Handle_Record_Send,handle);
+	/* another thread may still be appending to the container */
+	pthread_mutex_lock(&(handle->Mutex));
+	if(handle->Container != NULL)
+	{
+		Handle_Container_Send(handle);
+		Log_UDP_Container_Destroy(handle->Container);
+		handle->Container = NULL;
+	}
+	pthread_mutex_unlock(&(handle->Mutex));
+	if(handle->Ring != NULL)
+		retval = Log_UDP_Ring_Close(handle->Ring);
+	else if(handle->Stream != NULL)
+		retval = Log_UDP_Stream_Close(handle->Stream);
+	else
+	{
+		retval = Log_UDP_Close(handle->Socket_Id);
+		close(handle->Socket_Id);
+	}
+	if((handle->Journal != NULL)&&(!Log_UDP_Journal_Close(handle->Journal)))
+		retval = FALSE;
+	if(handle->Fan_Out_Socket_Id >= 0)
+		close(handle->Fan_Out_Socket_Id);
+	pthread_mutex_destroy(&(handle->Mutex));
+	if(handle->Buffer != NULL)
+		free(handle->Buffer);
+	if(handle->Compress_Buffer != NULL)
+		free(handle->Compress_Buffer);
+	if(handle->Dictionary != NULL)
+		Log_UDP_Dictionary_Destroy(handle->Dictionary);
+	if(handle->Template_Table != NULL)
+		Log_UDP_Template_Table_Destroy(handle->Template_Table);
+	free(handle);
+	return retval;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Encode a string, truncated to fit into a log record field of field_length bytes, with a NULL terminator,
+ * into the message buffer. A NULL string is encoded as an empty string.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the encoded string's terminator.
+ * @param string The string to encode, or NULL.
+ * @param field_length The length of the log record field, the string is truncated to (field_length-1)
+ *        characters.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ */
+static int Handle_Encode_String(char *message_buffer,size_t message_buffer_length,
+				size_t *message_buffer_position,const char *string,size_t field_length)
+{
+	const char *end_ch = NULL;
+	size_t string_length;
+
+	if(string == NULL)
+		string_length = 0;
+	else
+	{
+		end_ch = memchr(string,'\0',field_length-1);
+		if(end_ch != NULL)
+			string_length = end_ch-string;
+		else
+			string_length = field_length-1;
+	}
+	if(((*message_buffer_position)+string_length+1) > message_buffer_length)
+	{
+		Log_Error_Number = 309;
+		sprintf(Log_Error_String,"Handle_Encode_String:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),string_length+1,message_buffer_length);
+		return FALSE;
+	}
+	if(string_length > 0)
+		memcpy(message_buffer+(*message_buffer_position),string,string_length);
+	message_buffer[(*message_buffer_position)+string_length] = '\0';
+	(*message_buffer_position) += string_length+1;
+	return TRUE;
+}
+
+/**
+ * Check a message sent with the handle's System, Sub_System, Source_File and Source_Instance for repeats.
+ * These are the four strings in the handle's pre-encoded prefix. Summaries are sent with Handle_Record_Send,
+ * so they go to the handle's ring, stream or destinations like it's other packets, and the handle's mutex
+ * must not be locked.
+ * @param handle The logger handle.
+ * @param function The message's Function. Can be NULL.
+ * @param severity The message's severity.
+ * @param verbosity The message's verbosity.
+ * @param category The message's Category. Can be NULL.
+ * @param message The message.
+ * @param timestamp The message's timestamp.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list The message's contexts.
+ * @return The routine returns TRUE if the message should be sent, and FALSE if it is a repeat.
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Allow
+ */
+static int Handle_Coalesce_Allow(Log_UDP_Handle_T handle,const char *function,int severity,int verbosity,
+				 const char *category,const char *message,int64_t timestamp,int log_context_count,
+				 const struct Log_Context_Struct *log_context_list)
+{
+	const char *sub_system = NULL;
+	const char *source_file = NULL;
+	const char *source_instance = NULL;
+
+	sub_system = handle->Prefix+strlen(handle->Prefix)+1;
+	source_file = sub_system+strlen(sub_system)+1;
+	source_instance = source_file+strlen(source_file)+1;
+	return Log_UDP_Coalesce_Allow(Handle_Record_Send,handle,handle->Prefix,sub_system,source_file,
+				      source_instance,function,severity,verbosity,category,message,timestamp,
+				      log_context_count,log_context_list);
+}
+
+/**
+ * Check a message sent with the handle's System and Sub_System against the rate limiter.
+ * The System and Sub_System are the first two strings in the handle's pre-encoded prefix. Summaries are sent
+ * with Handle_Record_Send, so they go to the handle's ring, stream or destinations like it's other packets,
+ * and the handle's mutex must not be locked.
+ * @param handle The logger handle.
+ * @param category The message's Category. Can be NULL.
+ * @param severity The message's severity.
+ * @return The routine returns TRUE if the message should be sent, and FALSE if it should be suppressed.
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Allow
+ */
+static int Handle_Rate_Limit_Allow(Log_UDP_Handle_T handle,const char *category,int severity)
+{
+	const char *sub_system = NULL;
+
+	sub_system = handle->Prefix+strlen(handle->Prefix)+1;
+	return Log_UDP_Rate_Limit_Allow(Handle_Record_Send,handle,handle->Prefix,sub_system,category,severity);
+}
+
+/**
+ * Get the timestamp for a message sent over a handle. The timestamp used for coalescing is always in
+ * milliseconds, the timestamp put on the wire is in microseconds if the handle sends version 2 packets
+ * with LOG_UDP_V2_FLAG_MICROSECONDS set.
+ * @param format The handle's wire format.
+ * @param flags The handle's version 2 packet flags.
+ * @param timestamp The address of an integer to fill in with the timestamp, in milliseconds since the epoch.
+ * @param wire_timestamp The address of an integer to fill in with the timestamp to encode.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see log_create.html#Log_Create_Timestamp_Get
+ * @see log_create.html#Log_Create_Timestamp_Us_Get
+ */
+static int Handle_Timestamp_Get(int format,int flags,int64_t *timestamp,int64_t *wire_timestamp)
+{
+	if((format == LOG_UDP_WIRE_FORMAT_V2)&&(flags & LOG_UDP_V2_FLAG_MICROSECONDS))
+	{
+		if(!Log_Create_Timestamp_Us_Get(wire_timestamp))
+			return FALSE;
+		(*timestamp) = (*wire_timestamp)/1000;
+	}
+	else
+	{
+		if(!Log_Create_Timestamp_Get(timestamp))
+			return FALSE;
+		(*wire_timestamp) = (*timestamp);
+	}
+	return TRUE;
+}
+
+/**
+ * Encode the start of a packet, everything before the Message: the magic word, timestamp, the handle's
+ * pre-encoded prefix, Function, Severity, Verbosity and Category. Version 2 packets also have a flags byte,
+ * and Severity and Verbosity are packed into one byte before the prefix. If the handle's dictionary is used,
+ * the dictionary generation follows the flags, and the prefix is sent through the dictionary rather than
+ * copied. If LOG_UDP_V2_FLAG_SEQUENCE is set, the stream tag and the next sequence number come next; the
+ * number is only used up when Handle_Transmit sends the packet. The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param format The wire format to encode in.
+ * @param flags The version 2 packet flags.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the Category.
+ * @param wire_timestamp The timestamp, in milliseconds since the epoch (or microseconds if
+ *        LOG_UDP_V2_FLAG_MICROSECONDS is set in a version 2 packet's flags).
+ * @param function The function calling the log. Can be NULL.
+ * @param severity The severity of the log message.
+ * @param verbosity The verbosity of the log message.
+ * @param category What sort of information is the message. Can be NULL.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Handle_Encode_Field
+ * @see log_udp.html#LOG_UDP_PACKET_MAGIC_WORD
+ * @see log_udp_wire.html#LOG_UDP_PACKET_MAGIC_WORD_V2
+ */
+static int Handle_Encode_Header(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+				size_t message_buffer_length,size_t *message_buffer_position,int64_t wire_timestamp,
+				const char *function,int severity,int verbosity,const char *category)
+{
+	const char *sub_system = NULL;
+	const char *source_file = NULL;
+	const char *source_instance = NULL;
+	char *prefix = NULL;
+	size_t prefix_length;
+	int retval,generation;
+
+	if(format == LOG_UDP_WIRE_FORMAT_V2)
+	{
+		/* magic word, flags, dictionary generation, Timestamp, Severity and Verbosity */
+		if(((*message_buffer_position)+5) > message_buffer_length)
+		{
+			Log_Error_Number = 309;
+			sprintf(Log_Error_String,"Handle_Encode_Header:Message Buffer overun(position %d + 5 > length %d).",
+				(*message_buffer_position),message_buffer_length);
+			return FALSE;
+		}
+		message_buffer[(*message_buffer_position)++] = (char)((LOG_UDP_PACKET_MAGIC_WORD_V2>>8)&0xff);
+		message_buffer[(*message_buffer_position)++] = (char)(LOG_UDP_PACKET_MAGIC_WORD_V2&0xff);
+		/* compression happens in Handle_Transmit, once the packet is complete */
+		message_buffer[(*message_buffer_position)++] = (char)(flags&(~LOG_UDP_V2_FLAG_COMPRESSED));
+		if(flags&LOG_UDP_V2_FLAG_DICTIONARY)
+		{
+			if(!Log_UDP_Dictionary_Packet_Start(handle->Dictionary,&generation))
+				return FALSE;
+			message_buffer[(*message_buffer_position)++] = (char)generation;
+		}
+		retval = TRUE;
+		if(flags&LOG_UDP_V2_FLAG_SEQUENCE)
+		{
+			retval = Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+						       handle->Sequence_Host_Id);
+			retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,
+								 message_buffer_position,handle->Sequence_Pid);
+			retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,
+								 message_buffer_position,handle->Sequence_Start_Us);
+			retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,
+								 message_buffer_position,handle->Sequence_Number);
+		}
+		retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+							 (uint64_t)wire_timestamp);
+		if(retval && ((*message_buffer_position) >= message_buffer_length))
+		{
+			Log_Error_Number = 309;
+			sprintf(Log_Error_String,"Handle_Encode_Header:Message Buffer overun(position %d >= length %d).",
+				(*message_buffer_position),message_buffer_length);
+			retval = FALSE;
+		}
+		if(retval)
+			message_buffer[(*message_buffer_position)++] = (char)(((severity&0xf)<<4)|(verbosity&0xf));
+		prefix = handle->Prefix_V2;
+		prefix_length = handle->Prefix_V2_Length;
+	}
+	else
+	{
+		/* magic word and Timestamp */
+		retval = Log_UDP_Encode_Int(message_buffer,message_buffer_length,message_buffer_position,
+					    LOG_UDP_PACKET_MAGIC_WORD);
+		retval = retval && Log_UDP_Encode_Int64(message_buffer,message_buffer_length,message_buffer_position,
+							wire_timestamp);
+		prefix = handle->Prefix;
+		prefix_length = handle->Prefix_Length;
+	}
+	/* System, Sub_System, Source_File, Source_Instance */
+	if((format == LOG_UDP_WIRE_FORMAT_V2)&&(flags&LOG_UDP_V2_FLAG_DICTIONARY))
+	{
+		sub_system = handle->Prefix+strlen(handle->Prefix)+1;
+		source_file = sub_system+strlen(sub_system)+1;
+		source_instance = source_file+strlen(source_file)+1;
+		retval = retval && Log_UDP_Dictionary_Encode_String(handle->Dictionary,message_buffer,
+								     message_buffer_length,message_buffer_position,
+								     handle->Prefix,LOG_RECORD_SYSTEM_LENGTH);
+		retval = retval && Log_UDP_Dictionary_Encode_String(handle->Dictionary,message_buffer,
+								     message_buffer_length,message_buffer_position,
+								     sub_system,LOG_RECORD_SUB_SYSTEM_LENGTH);
+		retval = retval && Log_UDP_Dictionary_Encode_String(handle->Dictionary,message_buffer,
+								     message_buffer_length,message_buffer_position,
+								     source_file,LOG_RECORD_SOURCE_FILE_LENGTH);
+		retval = retval && Log_UDP_Dictionary_Encode_String(handle->Dictionary,message_buffer,
+								     message_buffer_length,message_buffer_position,
+								     source_instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH);
+		/* nothing more to copy */
+		prefix_length = 0;
+	}
+	if(retval && (((*message_buffer_position)+prefix_length) > message_buffer_length))
+	{
+		Log_Error_Number = 309;
+		sprintf(Log_Error_String,"Handle_Encode_Header:Message Buffer overun(position %d + %d > length %d).",
+			(*message_buffer_position),prefix_length,message_buffer_length);
+		retval = FALSE;
+	}
+	if(retval)
+	{
+		memcpy(message_buffer+(*message_buffer_position),prefix,prefix_length);
+		(*message_buffer_position) += prefix_length;
+	}
+	retval = retval && Handle_Encode_Name(handle,format,flags,message_buffer,message_buffer_length,
+					      message_buffer_position,function,LOG_RECORD_FUNCTION_LENGTH);
+	if(format != LOG_UDP_WIRE_FORMAT_V2)
+	{
+		retval = retval && Log_UDP_Encode_Int(message_buffer,message_buffer_length,message_buffer_position,
+						      severity);
+		retval = retval && Log_UDP_Encode_Int(message_buffer,message_buffer_length,message_buffer_position,
+						      verbosity);
+	}
+	retval = retval && Handle_Encode_Name(handle,format,flags,message_buffer,message_buffer_length,
+					      message_buffer_position,category,LOG_RECORD_CATEGORY_LENGTH);
+	return retval;
+}
+
+/**
+ * Encode a string field in the specified wire format: NULL terminated for version 1,
+ * varint length prefixed for version 2. The string is truncated to fit into a log record field of
+ * field_length bytes. A NULL string is encoded as an empty string.
+ * @param format The wire format to encode in.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param string The string to encode.
+ * @param field_length The length of the log record field the string is sent as.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Handle_Encode_String
+ * @see log_udp_wire.html#Log_UDP_Encode_Varint_String
+ */
+static int Handle_Encode_Field(int format,char *message_buffer,size_t message_buffer_length,
+			       size_t *message_buffer_position,const char *string,size_t field_length)
+{
+	if(format == LOG_UDP_WIRE_FORMAT_V2)
+	{
+		return Log_UDP_Encode_Varint_String(message_buffer,message_buffer_length,message_buffer_position,
+						    string,field_length);
+	}
+	return Handle_Encode_String(message_buffer,message_buffer_length,message_buffer_position,string,
+				    field_length);
+}
+
+/**
+ * Encode a name field (System, Sub_System, Source_File, Source_Instance, Function, Category or a context Keyword)
+ * in the specified wire format, through the handle's dictionary if LOG_UDP_V2_FLAG_DICTIONARY is set.
+ * The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param format The wire format to encode in.
+ * @param flags The version 2 packet flags.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param string The string to encode.
+ * @param field_length The length of the log record field the string is sent as.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Handle_Encode_Field
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Encode_String
+ */
+static int Handle_Encode_Name(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+			      size_t message_buffer_length,size_t *message_buffer_position,const char *string,
+			      size_t field_length)
+{
+	if((format == LOG_UDP_WIRE_FORMAT_V2)&&(flags&LOG_UDP_V2_FLAG_DICTIONARY))
+	{
+		return Log_UDP_Dictionary_Encode_String(handle->Dictionary,message_buffer,message_buffer_length,
+							message_buffer_position,string,field_length);
+	}
+	return Handle_Encode_Field(format,message_buffer,message_buffer_length,message_buffer_position,string,
+				   field_length);
+}
+
+/**
+ * Encode a value field (the Message or a context Value) in the specified wire format, through the handle's
+ * dictionary if LOG_UDP_V2_FLAG_DICTIONARY is set. The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param format The wire format to encode in.
+ * @param flags The version 2 packet flags.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param string The string to encode.
+ * @param field_length The length of the log record field the string is sent as.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Handle_Encode_Field
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Encode_Value
+ */
+static int Handle_Encode_Value(Log_UDP_Handle_T handle,int format,int flags,char *message_buffer,
+			       size_t message_buffer_length,size_t *message_buffer_position,const char *string,
+			       size_t field_length)
+{
+	if((format == LOG_UDP_WIRE_FORMAT_V2)&&(flags&LOG_UDP_V2_FLAG_DICTIONARY))
+	{
+		return Log_UDP_Dictionary_Encode_Value(handle->Dictionary,message_buffer,message_buffer_length,
+						       message_buffer_position,string,field_length);
+	}
+	return Handle_Encode_Field(format,message_buffer,message_buffer_length,message_buffer_position,string,
+				   field_length);
+}
+
+/**
+ * Encode the context count in the specified wire format: a four byte integer for version 1, a varint
+ * for version 2.
+ * @param format The wire format to encode in.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param count The context count to encode.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see log_udp.html#Log_UDP_Encode_Int
+ * @see log_udp_wire.html#Log_UDP_Encode_Varint
+ */
+static int Handle_Encode_Count(int format,char *message_buffer,size_t message_buffer_length,
+			       size_t *message_buffer_position,int count)
+{
+	if(format == LOG_UDP_WIRE_FORMAT_V2)
+	{
+		return Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+					     (uint64_t)count);
+	}
+	return Log_UDP_Encode_Int(message_buffer,message_buffer_length,message_buffer_position,count);
+}
+
+/**
+ * Refresh the handle's dictionary and templates before encoding a packet, if packets have been written to
+ * the journal since one was last sent. The journal replays over it's own socket, and a decoder keeps
+ * dictionaries and templates per sender, so definitions in journaled packets never reach the decoder
+ * expanding the handle's live packets. A new generation makes the next packet define every string and
+ * template it uses, and also makes each packet journaled after the first stand on it's own when replayed.
+ * The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @see #Handle_Datagram_Send
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Refresh
+ * @see log_udp_template.html#Log_UDP_Template_Refresh
+ */
+static void Handle_Journal_Refresh(Log_UDP_Handle_T handle)
+{
+	if(!handle->Journal_Refresh)
+		return;
+	if(handle->Dictionary != NULL)
+		Log_UDP_Dictionary_Refresh(handle->Dictionary);
+	if(handle->Template_Table != NULL)
+		Log_UDP_Template_Refresh(handle->Template_Table);
+}
+
+/**
+ * Get the handle's encode buffer, making sure it is at least message_buffer_length bytes long.
+ * The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param message_buffer_length The length of buffer required in bytes.
+ * @return A pointer to the buffer, or NULL if an error occured (Log_Error_Number and Log_Error_String are set).
+ */
+static char *Handle_Buffer_Get(Log_UDP_Handle_T handle,size_t message_buffer_length)
+{
+	char *new_buffer = NULL;
+
+	if(handle->Buffer_Length < message_buffer_length)
+	{
+		new_buffer = (char*)realloc(handle->Buffer,message_buffer_length*sizeof(char));
+		if(new_buffer == NULL)
+		{
+			Log_Error_Number = 310;
+			sprintf(Log_Error_String,"Handle_Buffer_Get:Failed to allocate message buffer(%d).",
+				message_buffer_length);
+			return NULL;
+		}
+		handle->Buffer = new_buffer;
+		handle->Buffer_Length = message_buffer_length;
+	}
+	return handle->Buffer;
+}
+
+/**
+ * Encode an already created log record in the handle's wire format and transmit it, without filtering,
+ * coalescing or rate limiting it. This is the tail of Log_UDP_Handle_Send_Record, and is also the summary
+ * send routine the handle passes to the rate limiter and coalescer, so their summaries are numbered, put in
+ * the container, fanned out and journaled like the handle's other packets. It locks the handle's mutex,
+ * so it must not be called with the mutex locked.
+ * @param summary_arg The logger handle.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list The log contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Buffer_Get
+ * @see #Handle_Transmit
+ * @see log_udp.html#Log_UDP_Encode
+ * @see log_udp_wire.html#Log_UDP_Encode_V2
+ */
+static int Handle_Record_Send(void *summary_arg,const struct Log_Record_Struct *log_record,
+			      int log_context_count,const struct Log_Context_Struct *log_context_list)
+{
+	Log_UDP_Handle_T handle = (Log_UDP_Handle_T)summary_arg;
+	struct Log_UDP_Packet_Info_Struct stream_tag;
+	struct Log_UDP_Packet_Info_Struct *stream_tag_ptr = NULL;
+	char *message_buffer = NULL;
+	size_t message_buffer_length,message_buffer_position;
+	int wire_format,wire_flags,retval;
+
+	/* the record's timestamp is in milliseconds, so version 2 records are sent without the microseconds flag */
+	wire_format = handle->Format;
+	wire_flags = handle->Flags&(~LOG_UDP_V2_FLAG_MICROSECONDS);
+	if(wire_format == LOG_UDP_WIRE_FORMAT_V2)
+		message_buffer_length = LOG_UDP_V2_BUFFER_LENGTH(log_context_count);
+	else
+		message_buffer_length = LOG_UDP_BUFFER_LENGTH(log_context_count);
+	pthread_mutex_lock(&(handle->Mutex));
+	Handle_Journal_Refresh(handle);
+	message_buffer = Handle_Buffer_Get(handle,message_buffer_length);
+	retval = (message_buffer != NULL);
+	/* records are numbered in the same stream as the handle's other packets */
+	if((wire_format == LOG_UDP_WIRE_FORMAT_V2)&&(wire_flags&LOG_UDP_V2_FLAG_SEQUENCE))
+	{
+		memset(&stream_tag,0,sizeof(stream_tag));
+		stream_tag.Sequence_Host_Id = handle->Sequence_Host_Id;
+		stream_tag.Sequence_Pid = handle->Sequence_Pid;
+		stream_tag.Sequence_Start_Us = handle->Sequence_Start_Us;
+		stream_tag.Sequence_Number = handle->Sequence_Number;
+		stream_tag_ptr = &stream_tag;
+	}
+	if((wire_format == LOG_UDP_WIRE_FORMAT_V2)&&(wire_flags&LOG_UDP_V2_FLAG_DICTIONARY))
+	{
+		retval = retval && Log_UDP_Encode_V2(log_record,log_context_count,log_context_list,handle->Dictionary,
+						     stream_tag_ptr,message_buffer,message_buffer_length,
+						     &message_buffer_position);
+		retval = retval && Handle_Transmit(handle,message_buffer,message_buffer_position);
+		Log_UDP_Dictionary_Packet_End(handle->Dictionary,retval);
+		pthread_mutex_unlock(&(handle->Mutex));
+		return retval;
+	}
+	if(wire_format == LOG_UDP_WIRE_FORMAT_V2)
+	{
+		retval = retval && Log_UDP_Encode_V2(log_record,log_context_count,log_context_list,NULL,stream_tag_ptr,
+						     message_buffer,message_buffer_length,&message_buffer_position);
+	}
+	else
+	{
+		retval = retval && Log_UDP_Encode(log_record,log_context_count,log_context_list,message_buffer,
+						  message_buffer_length,&message_buffer_position);
+	}
+	if(retval)
+		retval = Handle_Transmit(handle,message_buffer,message_buffer_position);
+	pthread_mutex_unlock(&(handle->Mutex));
+	return retval;
+}
+
+/**
+ * Transmit an encoded packet using the handle. The handle's mutex should be locked.
+ * If the handle is sending version 2 packets with LOG_UDP_V2_FLAG_COMPRESSED set, and the packet is at least
+ * Compression_Threshold bytes long, the packet is compressed into Compress_Buffer, and the compressed
+ * packet is sent if it is shorter. If the handle has a container, the packet is added to it rather than sent.
+ * A packet carrying a sequence number (LOG_UDP_V2_FLAG_SEQUENCE) only uses it up if it is transmitted, so
+ * packets that are coalesced, rate limited or fail to encode or send leave no gap in the numbering.
+ * @param handle The logger handle.
+ * @param message_buffer The buffer containing the encoded packet.
+ * @param message_buffer_length The number of bytes in the encoded packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see log_udp_wire.html#Log_UDP_Compress_V2
+ * @see #Handle_Container_Add
+ * @see #Handle_Datagram_Send
+ */
+static int Handle_Transmit(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length)
+{
+	char *new_buffer = NULL;
+	size_t compress_buffer_length,compressed_length;
+	int sequenced,retval;
+
+	sequenced = (message_buffer_length > 3)&&
+		(((unsigned char)message_buffer[0]) == ((LOG_UDP_PACKET_MAGIC_WORD_V2>>8)&0xff))&&
+		(((unsigned char)message_buffer[1]) == (LOG_UDP_PACKET_MAGIC_WORD_V2&0xff))&&
+		(message_buffer[2]&LOG_UDP_V2_FLAG_SEQUENCE);
+	if((handle->Format == LOG_UDP_WIRE_FORMAT_V2)&&(handle->Flags&LOG_UDP_V2_FLAG_COMPRESSED)&&
+	   (message_buffer_length >= (size_t)(handle->Compression_Threshold))&&(message_buffer_length > 3)&&
+	   ((message_buffer[2]&LOG_UDP_V2_FLAG_COMPRESSED) == 0))
+	{
+		compress_buffer_length = 3+LOG_UDP_VARINT_LENGTH+LOG_UDP_COMPRESS_BOUND(message_buffer_length);
+		if(handle->Compress_Buffer_Length < compress_buffer_length)
+		{
+			new_buffer = (char*)realloc(handle->Compress_Buffer,compress_buffer_length*sizeof(char));
+			if(new_buffer == NULL)
+			{
+				Log_Error_Number = 318;
+				sprintf(Log_Error_String,"Handle_Transmit:Failed to allocate compress buffer(%d).",
+					compress_buffer_length);
+				return FALSE;
+			}
+			handle->Compress_Buffer = new_buffer;
+			handle->Compress_Buffer_Length = compress_buffer_length;
+		}
+		if(!Log_UDP_Compress_V2(message_buffer,message_buffer_length,handle->Compress_Buffer,
+					handle->Compress_Buffer_Length,&compressed_length))
+			return FALSE;
+		if(compressed_length < message_buffer_length)
+		{
+			message_buffer = handle->Compress_Buffer;
+			message_buffer_length = compressed_length;
+		}
+	}
+	if(handle->Container != NULL)
+		retval = Handle_Container_Add(handle,message_buffer,message_buffer_length);
+	else
+		retval = Handle_Datagram_Send(handle,message_buffer,message_buffer_length);
+	if(retval && sequenced)
+		handle->Sequence_Number++;
+	return retval;
+}
+
+/**
+ * Add an encoded packet to the handle's container. The container is sent first if it's first record is
+ * older than Container_Flush_Interval_Ms, or there isn't room for the packet. A packet too long for an
+ * empty container is sent on it's own. The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param message_buffer The buffer containing the encoded packet.
+ * @param message_buffer_length The number of bytes in the encoded packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Monotonic_Ms
+ * @see #Handle_Container_Send
+ * @see log_udp_container.html#Log_UDP_Container_Add
+ */
+static int Handle_Container_Add(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length)
+{
+	int64_t now_ms;
+	int record_count,added,retval;
+
+	retval = TRUE;
+	now_ms = Handle_Monotonic_Ms();
+	if(!Log_UDP_Container_Record_Count_Get(handle->Container,&record_count))
+		return FALSE;
+	if((record_count > 0)&&((now_ms-handle->Container_Start_Ms) >= handle->Container_Flush_Interval_Ms))
+	{
+		retval = Handle_Container_Send(handle);
+		record_count = 0;
+	}
+	if(!Log_UDP_Container_Add(handle->Container,message_buffer,message_buffer_length,&added))
+		return FALSE;
+	if((!added)&&(record_count > 0))
+	{
+		retval = Handle_Container_Send(handle) && retval;
+		record_count = 0;
+		if(!Log_UDP_Container_Add(handle->Container,message_buffer,message_buffer_length,&added))
+			return FALSE;
+	}
+	if(!added)
+		return Handle_Datagram_Send(handle,message_buffer,message_buffer_length) && retval;
+	if(record_count == 0)
+		handle->Container_Start_Ms = now_ms;
+	return retval;
+}
+
+/**
+ * Send any records in the handle's container, and empty it. The handle's mutex should be locked.
+ * @param handle The logger handle, with a container.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Handle_Datagram_Send
+ * @see log_udp_container.html#Log_UDP_Container_Finish
+ * @see log_udp_container.html#Log_UDP_Container_Clear
+ */
+static int Handle_Container_Send(Log_UDP_Handle_T handle)
+{
+	char *message_buffer = NULL;
+	size_t message_buffer_length;
+	int record_count,retval;
+
+	if(!Log_UDP_Container_Record_Count_Get(handle->Container,&record_count))
+		return FALSE;
+	if(record_count == 0)
+		return TRUE;
+	if(!Log_UDP_Container_Finish(handle->Container,&message_buffer,&message_buffer_length))
+		return FALSE;
+	retval = Handle_Datagram_Send(handle,message_buffer,message_buffer_length);
+	Log_UDP_Container_Clear(handle->Container);
+	return retval;
+}
+
+/**
+ * Send a datagram to each of the handle's destinations, updating the destination counters.
+ * A handle with a ring or stream writes the datagram to it, a handle with one destination sends over it's
+ * connected socket, otherwise the datagram is sent to every destination over the fan out socket.
+ * A handle with a journal writes the datagram to the journal if the send fails because the collector is
+ * unreachable, or whilst the journal is spilling, so the datagram is sent behind those already journaled.
+ * Journal_Refresh is set when the datagram is journaled, and cleared when one is sent.
+ * Other send failures are counted as errors. The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @param message_buffer The datagram.
+ * @param message_buffer_length The length of the datagram in bytes.
+ * @return The routine returns TRUE if the datagram was sent to (or dropped for) every destination, and FALSE
+ *         otherwise.
+ * @see #Handle_Destination_Refresh
+ * @see log_udp.html#Log_UDP_Send_Encoded_Status
+ * @see log_udp.html#Log_UDP_Send_Encoded_List
+ * @see log_udp_ring.html#Log_UDP_Ring_Write
+ * @see log_udp_stream.html#Log_UDP_Stream_Write
+ * @see log_udp_journal.html#Log_UDP_Journal_Unreachable
+ * @see log_udp_journal.html#Log_UDP_Journal_Write
+ */
+static int Handle_Datagram_Send(Log_UDP_Handle_T handle,char *message_buffer,size_t message_buffer_length)
+{
+	int sent_list[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	int dropped_list[LOG_UDP_HANDLE_DESTINATION_COUNT];
+	int i,retval,journaled,unreachable;
+
+	journaled = FALSE;
+	/* a cached hostname has been re-resolved to a new address */
+	if(handle->Resolve_Generation != Log_UDP_Resolve_Generation)
+		Handle_Destination_Refresh(handle);
+	if(handle->Ring != NULL)
+	{
+		retval = Log_UDP_Ring_Write(handle->Ring,message_buffer,message_buffer_length,&(dropped_list[0]));
+		sent_list[0] = retval && (!dropped_list[0]);
+	}
+	else if(handle->Stream != NULL)
+	{
+		retval = Log_UDP_Stream_Write(handle->Stream,message_buffer,message_buffer_length,&(dropped_list[0]));
+		sent_list[0] = retval && (!dropped_list[0]);
+	}
+	else if(handle->Destination_Count == 1)
+	{
+		if((handle->Journal != NULL)&&Log_UDP_Journal_Is_Spilling(handle->Journal))
+		{
+			retval = FALSE;
+			dropped_list[0] = FALSE;
+			unreachable = TRUE;
+		}
+		else
+		{
+			/* a short send fails without setting errno */
+			errno = 0;
+			retval = Log_UDP_Send_Encoded_Status(handle->Socket_Id,message_buffer,message_buffer_length,
+							     &(dropped_list[0]));
+			unreachable = (!retval)&&Log_UDP_Journal_Unreachable(errno);
+		}
+		sent_list[0] = retval && (!dropped_list[0]);
+		/* other failures (a packet too big, a bad socket) would fail again on replay */
+		if(unreachable&&(handle->Journal != NULL))
+		{
+			retval = Log_UDP_Journal_Write(handle->Journal,message_buffer,message_buffer_length);
+			journaled = retval;
+		}
+		/* definitions in a journaled packet have not reached the collector */
+		if(journaled)
+			handle->Journal_Refresh = TRUE;
+		else if(sent_list[0])
+			handle->Journal_Refresh = FALSE;
+	}
+	else
+	{
+		retval = Log_UDP_Send_Encoded_List(handle->Fan_Out_Socket_Id,message_buffer,message_buffer_length,
+						   handle->Destination_Address_List,
+						   handle->Destination_Address_Length_List,handle->Destination_Count,
+						   sent_list,dropped_list);
+	}
+	for(i = 0; i < handle->Destination_Count; i++)
+	{
+		if(sent_list[i])
+		{
+			handle->Destination_Stats_List[i].Packet_Count++;
+			handle->Destination_Stats_List[i].Byte_Count += message_buffer_length;
+		}
+		else if(journaled)
+			handle->Destination_Stats_List[i].Journal_Count++;
+		else if(dropped_list[i])
+			handle->Destination_Stats_List[i].Drop_Count++;
+		else
+			handle->Destination_Stats_List[i].Error_Count++;
+	}
+	return retval;
+}
+
+/**
+ * Remember the hostname and port number of a destination, so re-resolved addresses can be picked up.
+ * @param handle The logger handle.
+ * @param index The index of the destination.
+ * @param hostname The hostname. Hostnames too long to be cached are not remembered.
+ * @param port_number The port number.
+ * @see log_udp_resolve.html#LOG_UDP_RESOLVE_HOSTNAME_LENGTH
+ */
+static void Handle_Destination_Hostname_Set(Log_UDP_Handle_T handle,int index,char *hostname,int port_number)
+{
+	if(strlen(hostname) < LOG_UDP_RESOLVE_HOSTNAME_LENGTH)
+		strcpy(handle->Destination_Hostname_List[index],hostname);
+	else
+		handle->Destination_Hostname_List[index][0] = '\0';
+	handle->Destination_Port_List[index] = port_number;
+}
+
+/**
+ * Pick up the re-resolved addresses of the handle's destinations from the resolver cache. This never blocks
+ * on a lookup. The connected socket is reconnected if the first destination has moved. An address that has
+ * changed address family (IPv4 to IPv6 or back) cannot be sent to over the handle's sockets, so the last
+ * address in the old family is kept. The handle's mutex should be locked.
+ * @param handle The logger handle.
+ * @see #Log_UDP_Handle_Struct
+ * @see log_udp_resolve.html#Log_UDP_Resolve_Cache_Get
+ * @see log_udp_resolve.html#Log_UDP_Resolve_Generation
+ */
+static void Handle_Destination_Refresh(Log_UDP_Handle_T handle)
+{
+	struct sockaddr_storage address;
+	socklen_t address_length;
+	int found,i;
+
+	handle->Resolve_Generation = Log_UDP_Resolve_Generation;
+	for(i = 0; i < handle->Destination_Count; i++)
+	{
+		if(handle->Destination_Hostname_List[i][0] == '\0')
+			continue;
+		if(!Log_UDP_Resolve_Cache_Get(handle->Destination_Hostname_List[i],handle->Destination_Port_List[i],
+					      &address,&address_length,&found))
+			continue;
+		if((!found)||(address.ss_family != handle->Destination_Address_List[i].ss_family))
+			continue;
+		if((address_length == handle->Destination_Address_Length_List[i])&&
+		   (memcmp(&address,&(handle->Destination_Address_List[i]),address_length) == 0))
+			continue;
+#if DEBUG > 1
+		fprintf(stdout,"Handle_Destination_Refresh:Destination %d (%s) has a new address.\n",i,
+			handle->Destination_Hostname_List[i]);
+#endif
+		if(i == 0)
+		{
+			if(connect(handle->Socket_Id,(struct sockaddr *)&address,address_length) < 0)
+				continue;
+		}
+		handle->Destination_Address_List[i] = address;
+		handle->Destination_Address_Length_List[i] = address_length;
+	}
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ */
+static int64_t Handle_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/**
+ * Get the host identifier sent in stream tags: the 32 bit FNV-1a hash of this host's name.
+ * @return The host identifier, or 0 if the host name could not be read.
+ */
+static uint64_t Handle_Host_Id(void)
+{
+	char hostname[HANDLE_HOSTNAME_LENGTH];
+	unsigned int hash;
+	int i;
+
+	if(gethostname(hostname,HANDLE_HOSTNAME_LENGTH) < 0)
+		return 0;
+	hostname[HANDLE_HOSTNAME_LENGTH-1] = '\0';
+	hash = 2166136261U;
+	for(i = 0; hostname[i] != '\0'; i++)
+	{
+		hash ^= (unsigned char)hostname[i];
+		hash *= 16777619U;
+	}
+	return (uint64_t)hash;
+}
+
+/*
+** $Log$
+*/
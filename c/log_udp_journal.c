@@ -0,0 +1,926 @@
+/* log_udp_journal.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Spill to disk journal, for packets that can't be delivered because the collector is unreachable. Once a
+ * send to the collector has failed (a connected UDP socket reports ECONNREFUSED after the collector's host
+ * returns an ICMP port unreachable, EHOSTUNREACH or ENETUNREACH when the host or network is down), every
+ * packet is appended to the journal instead of being sent, until the journal has been replayed. This keeps
+ * the packets in order. The packets are journaled exactly as encoded, so they keep their original timestamps
+ * (and sequence numbers) when they are replayed.
+ * <p>
+ * The journal file is a header (JOURNAL_MAGIC, and the offset of the next packet to replay as eight bytes in
+ * network byte order) followed by the packets, each preceded by it's length as JOURNAL_RECORD_HEADER_LENGTH
+ * bytes in network byte order. Packets are collected in a JOURNAL_BUFFER_LENGTH memory buffer, and appended
+ * to the file with one write when the buffer is full, or when the replayer needs them.
+ * <p>
+ * A replay thread sends the journaled packets to the collector, over it's own socket, at the journal's replay
+ * rate. A connected UDP socket only learns the collector is unreachable after a packet has been sent, so
+ * after each batch the replayer checks the socket's pending error before the next, and if a packet was
+ * refused, the whole batch is replayed again after JOURNAL_RETRY_INTERVAL_MS. Packets can therefore be
+ * received twice, but are not lost. When the journal is empty, the file is truncated and packets are sent
+ * directly again. The replay offset is saved in the header every JOURNAL_SAVE_INTERVAL_MS, so a journal
+ * left by a process that stopped is replayed by the next one to open it.
+ * <p>
+ * A host that is down on a remote network usually sends no ICMP error at all, so UDP packets sent to it are
+ * lost without anything to journal; only unreachable errors the kernel reports can be detected.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1-2008 prototypes for pread
+ * and pwrite, as well as threads and clock_gettime.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>   /* Error number definitions */
+#include <fcntl.h>   /* File control definitions */
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_journal.h"
+
+/* hash defines */
+/**
+ * The string at the start of a journal file.
+ */
+#define JOURNAL_MAGIC                   "LUDPJNL1"
+/**
+ * The length of JOURNAL_MAGIC in bytes, without a terminating NULL.
+ */
+#define JOURNAL_MAGIC_LENGTH            (8)
+/**
+ * The length of the journal file header: JOURNAL_MAGIC and the replay offset.
+ */
+#define JOURNAL_HEADER_LENGTH           (JOURNAL_MAGIC_LENGTH+8)
+/**
+ * The length of the packet length in front of each journaled packet.
+ */
+#define JOURNAL_RECORD_HEADER_LENGTH    (4)
+/**
+ * The length of the memory buffer packets are collected in before being appended to the file, in bytes.
+ */
+#define JOURNAL_BUFFER_LENGTH           (256*1024)
+/**
+ * How often the replay thread sends a batch of packets, in milliseconds. Each batch is the replay rate's
+ * worth of packets for this interval.
+ */
+#define JOURNAL_TICK_MS                 (10)
+/**
+ * How long the replay thread waits before trying an unreachable collector again, in milliseconds.
+ */
+#define JOURNAL_RETRY_INTERVAL_MS       (1000)
+/**
+ * How often the replay thread appends buffered packets to the file and saves the replay offset, in
+ * milliseconds.
+ */
+#define JOURNAL_SAVE_INTERVAL_MS        (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                   (1000000000)
+
+/* structures */
+/**
+ * Data for one journal. Everything but File_Id, Socket_Id, Replay_Rate (which don't change) and
+ * Packet_Buffer (which only the replay thread uses) is protected by Mutex.
+ * <dl>
+ * <dt>File_Id</dt> <dd>The open journal file.</dd>
+ * <dt>Socket_Id</dt> <dd>The socket the replay thread sends to the collector over.</dd>
+ * <dt>Replay_Rate</dt> <dd>The number of packets replayed per second.</dd>
+ * <dt>Buffer</dt> <dd>Journaled packets not yet appended to the file.</dd>
+ * <dt>Buffer_Length</dt> <dd>The number of bytes in Buffer.</dd>
+ * <dt>File_Length</dt> <dd>The length of the journal file.</dd>
+ * <dt>Read_Offset</dt> <dd>The offset in the file of the next packet to replay.</dd>
+ * <dt>Batch_Offset</dt> <dd>The offset in the file of the first packet of the last batch replayed, which
+ *     may yet be refused. This is the replay offset saved in the header.</dd>
+ * <dt>Saved_Offset</dt> <dd>The replay offset last saved in the header.</dd>
+ * <dt>Spilling</dt> <dd>TRUE whilst packets are being journaled rather than sent.</dd>
+ * <dt>Stats</dt> <dd>The journal counters. Pending_Length and Spilling are filled in when they are read.</dd>
+ * <dt>Quit</dt> <dd>Set to make the replay thread exit.</dd>
+ * <dt>Replay_Thread</dt> <dd>The replay thread.</dd>
+ * <dt>Mutex</dt> <dd>Mutex protecting the buffer, offsets and counters.</dd>
+ * <dt>Replay_Condition</dt> <dd>Signalled to wake the replay thread.</dd>
+ * <dt>Packet_Buffer</dt> <dd>The packet being replayed.</dd>
+ * </dl>
+ */
+struct Log_UDP_Journal_Struct
+{
+	int File_Id;
+	int Socket_Id;
+	int Replay_Rate;
+	char *Buffer;
+	size_t Buffer_Length;
+	off_t File_Length;
+	off_t Read_Offset;
+	off_t Batch_Offset;
+	off_t Saved_Offset;
+	int Spilling;
+	struct Log_UDP_Journal_Stats_Struct Stats;
+	int Quit;
+	pthread_t Replay_Thread;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Replay_Condition;
+	char Packet_Buffer[LOG_UDP_JOURNAL_PACKET_LENGTH_MAX];
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static void *Journal_Replay_Thread(void *user_arg);
+static int Journal_Batch_Replay(Log_UDP_Journal_T journal,off_t *read_offset,off_t file_length,
+				unsigned long *replay_count,unsigned long *discard_count);
+static int Journal_Record_Read(Log_UDP_Journal_T journal,off_t offset,size_t *packet_length);
+static int Journal_Refused(Log_UDP_Journal_T journal);
+static int Journal_Load(Log_UDP_Journal_T journal);
+static int Journal_Buffer_Write(Log_UDP_Journal_T journal);
+static int Journal_Header_Save(Log_UDP_Journal_T journal,off_t replay_offset);
+static void Journal_Reset(Log_UDP_Journal_T journal);
+static int Journal_Lock(int file_id);
+static void Journal_Free(Log_UDP_Journal_T journal);
+static void Journal_Wait(Log_UDP_Journal_T journal,struct timespec *abs_time);
+static void Journal_Time_Add(struct timespec *abs_time,int milliseconds);
+static int Journal_Time_Passed(struct timespec *abs_time);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Open a journal, creating the file if it doesn't exist, and start it's replay thread. If the file holds
+ * packets a previous process didn't replay, they are replayed, and new packets are journaled behind them.
+ * A packet that was being appended when the previous process stopped is discarded. Only one process can
+ * have a journal file open. The lock is a POSIX record lock, which doesn't stop the same process opening it
+ * twice, so don't.
+ * @param filename The journal filename.
+ * @param hostname The collector's hostname, either numeric or via /etc/hosts, that packets are replayed to.
+ * @param port_number The collector's port number, in host (normal) byte order.
+ * @param replay_rate The number of packets to replay per second. Zero uses
+ *        LOG_UDP_JOURNAL_DEFAULT_REPLAY_RATE. This should be well above the rate packets are logged at,
+ *        or the journal never empties.
+ * @param journal The address of a Log_UDP_Journal_T to fill in with the opened journal.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Journal_Load
+ * @see #Journal_Replay_Thread
+ * @see log_udp.html#Log_UDP_Open
+ */
+int Log_UDP_Journal_Open(const char *filename,char *hostname,int port_number,int replay_rate,
+			 Log_UDP_Journal_T *journal)
+{
+	Log_UDP_Journal_T new_journal = NULL;
+	int retval,file_errno;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Journal_Open(%s):started.\n",filename);
+#endif
+	if(journal == NULL)
+	{
+		Log_Error_Number = 1500;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:journal was NULL.");
+		return FALSE;
+	}
+	if(filename == NULL)
+	{
+		Log_Error_Number = 1501;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:filename was NULL.");
+		return FALSE;
+	}
+	if(replay_rate == 0)
+		replay_rate = LOG_UDP_JOURNAL_DEFAULT_REPLAY_RATE;
+	if(replay_rate < 0)
+	{
+		Log_Error_Number = 1502;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:Illegal replay rate %d.",replay_rate);
+		return FALSE;
+	}
+	new_journal = (Log_UDP_Journal_T)calloc(1,sizeof(struct Log_UDP_Journal_Struct));
+	if(new_journal == NULL)
+	{
+		Log_Error_Number = 1503;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:Failed to allocate journal.");
+		return FALSE;
+	}
+	new_journal->File_Id = -1;
+	new_journal->Socket_Id = -1;
+	new_journal->Replay_Rate = replay_rate;
+	new_journal->Buffer = (char *)malloc(JOURNAL_BUFFER_LENGTH);
+	if(new_journal->Buffer == NULL)
+	{
+		Journal_Free(new_journal);
+		Log_Error_Number = 1504;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:Failed to allocate buffer.");
+		return FALSE;
+	}
+	new_journal->Buffer_Length = 0;
+	new_journal->File_Id = open(filename,O_RDWR|O_CREAT,0644);
+	if(new_journal->File_Id < 0)
+	{
+		file_errno = errno;
+		Journal_Free(new_journal);
+		Log_Error_Number = 1505;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:Failed to open '%s' (%d:%s).",filename,file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	if((!Journal_Lock(new_journal->File_Id))||(!Journal_Load(new_journal)))
+	{
+		Journal_Free(new_journal);
+		return FALSE;
+	}
+	if(!Log_UDP_Open(hostname,port_number,&(new_journal->Socket_Id)))
+	{
+		new_journal->Socket_Id = -1;
+		Journal_Free(new_journal);
+		return FALSE;
+	}
+	/* packets left by a previous process are replayed before new ones are sent */
+	new_journal->Spilling = (new_journal->Read_Offset < new_journal->File_Length);
+	new_journal->Quit = FALSE;
+	pthread_mutex_init(&(new_journal->Mutex),NULL);
+	pthread_cond_init(&(new_journal->Replay_Condition),NULL);
+	retval = pthread_create(&(new_journal->Replay_Thread),NULL,Journal_Replay_Thread,(void *)new_journal);
+	if(retval != 0)
+	{
+		pthread_cond_destroy(&(new_journal->Replay_Condition));
+		pthread_mutex_destroy(&(new_journal->Mutex));
+		Journal_Free(new_journal);
+		Log_Error_Number = 1506;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Open:Failed to create replay thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	(*journal) = new_journal;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Journal_Open(%s):finished with %ld bytes to replay.\n",filename,
+		(long)(new_journal->File_Length-new_journal->Read_Offset));
+#endif
+	return TRUE;
+}
+
+/**
+ * Return whether packets are being journaled rather than sent, because the collector has been found
+ * unreachable and the journal hasn't been replayed yet.
+ * @param journal The journal, opened with Log_UDP_Journal_Open.
+ * @return The routine returns TRUE if packets should be written to the journal, and FALSE if they should be
+ *         sent (or the journal is NULL).
+ */
+int Log_UDP_Journal_Is_Spilling(Log_UDP_Journal_T journal)
+{
+	int spilling;
+
+	if(journal == NULL)
+		return FALSE;
+	pthread_mutex_lock(&(journal->Mutex));
+	spilling = journal->Spilling;
+	pthread_mutex_unlock(&(journal->Mutex));
+	return spilling;
+}
+
+/**
+ * Decide whether a send failure means the collector is unreachable, rather than something being wrong
+ * with the packet or the socket. Only packets that failed to send because the collector is unreachable
+ * should be journaled.
+ * @param send_errno The errno the send failed with.
+ * @return The routine returns TRUE if the collector is unreachable, and FALSE otherwise.
+ */
+int Log_UDP_Journal_Unreachable(int send_errno)
+{
+	switch(send_errno)
+	{
+		case ECONNREFUSED:
+		case EHOSTUNREACH:
+		case ENETUNREACH:
+		case ENETDOWN:
+		case ENOENT: /* a Unix domain socket path with no relay bound to it */
+			return TRUE;
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Write a packet to the journal, to be replayed later. The packet is copied into the journal's buffer,
+ * which is appended to the file when it is full. Packets are journaled rather than sent from now on, until
+ * the journal has been replayed.
+ * @param journal The journal, opened with Log_UDP_Journal_Open.
+ * @param message_buffer The packet.
+ * @param message_buffer_length The length of the packet in bytes, at most LOG_UDP_JOURNAL_PACKET_LENGTH_MAX.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Journal_Buffer_Write
+ * @see #JOURNAL_RECORD_HEADER_LENGTH
+ */
+int Log_UDP_Journal_Write(Log_UDP_Journal_T journal,const char *message_buffer,size_t message_buffer_length)
+{
+	char *record;
+
+	if(journal == NULL)
+	{
+		Log_Error_Number = 1507;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Write:journal was NULL.");
+		return FALSE;
+	}
+	if(message_buffer == NULL)
+	{
+		Log_Error_Number = 1508;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Write:message_buffer was NULL.");
+		return FALSE;
+	}
+	if((message_buffer_length == 0)||(message_buffer_length > LOG_UDP_JOURNAL_PACKET_LENGTH_MAX))
+	{
+		Log_Error_Number = 1509;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Write:Illegal packet length %lu.",message_buffer_length);
+		return FALSE;
+	}
+	pthread_mutex_lock(&(journal->Mutex));
+	if((journal->Buffer_Length+JOURNAL_RECORD_HEADER_LENGTH+message_buffer_length) > JOURNAL_BUFFER_LENGTH)
+	{
+		if(!Journal_Buffer_Write(journal))
+		{
+			journal->Stats.Error_Count++;
+			pthread_mutex_unlock(&(journal->Mutex));
+			return FALSE;
+		}
+	}
+	record = journal->Buffer+journal->Buffer_Length;
+	record[0] = (char)((message_buffer_length>>24)&0xff);
+	record[1] = (char)((message_buffer_length>>16)&0xff);
+	record[2] = (char)((message_buffer_length>>8)&0xff);
+	record[3] = (char)(message_buffer_length&0xff);
+	memcpy(record+JOURNAL_RECORD_HEADER_LENGTH,message_buffer,message_buffer_length);
+	journal->Buffer_Length += JOURNAL_RECORD_HEADER_LENGTH+message_buffer_length;
+	journal->Stats.Write_Count++;
+	if(!journal->Spilling)
+	{
+		journal->Spilling = TRUE;
+		pthread_cond_signal(&(journal->Replay_Condition));
+	}
+	pthread_mutex_unlock(&(journal->Mutex));
+	return TRUE;
+}
+
+/**
+ * Append the packets in the journal's buffer to the file now, rather than when the buffer is full.
+ * @param journal The journal, opened with Log_UDP_Journal_Open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Journal_Buffer_Write
+ */
+int Log_UDP_Journal_Flush(Log_UDP_Journal_T journal)
+{
+	int retval;
+
+	if(journal == NULL)
+	{
+		Log_Error_Number = 1510;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Flush:journal was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(journal->Mutex));
+	retval = Journal_Buffer_Write(journal);
+	pthread_mutex_unlock(&(journal->Mutex));
+	return retval;
+}
+
+/**
+ * Get a journal's counters.
+ * @param journal The journal, opened with Log_UDP_Journal_Open.
+ * @param stats The address of a structure to fill in with the counters.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Journal_Stats_Get(Log_UDP_Journal_T journal,struct Log_UDP_Journal_Stats_Struct *stats)
+{
+	if(journal == NULL)
+	{
+		Log_Error_Number = 1511;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Stats_Get:journal was NULL.");
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Log_Error_Number = 1512;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(journal->Mutex));
+	(*stats) = journal->Stats;
+	stats->Pending_Length = (size_t)(journal->File_Length-journal->Read_Offset)+journal->Buffer_Length;
+	stats->Spilling = journal->Spilling;
+	pthread_mutex_unlock(&(journal->Mutex));
+	return TRUE;
+}
+
+/**
+ * Close a journal. The replay thread is stopped, buffered packets are appended to the file, and the replay
+ * offset is saved, so packets not yet replayed are replayed by the next process to open the journal. The
+ * last batch replayed may not have reached the collector, so it is replayed again.
+ * @param journal The journal, opened with Log_UDP_Journal_Open.
+ * @return The routine returns TRUE on success and FALSE on failure (the journal is still closed).
+ * @see #Journal_Buffer_Write
+ * @see #Journal_Header_Save
+ */
+int Log_UDP_Journal_Close(Log_UDP_Journal_T journal)
+{
+	int retval;
+
+	if(journal == NULL)
+	{
+		Log_Error_Number = 1513;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Close:journal was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(journal->Mutex));
+	journal->Quit = TRUE;
+	pthread_cond_signal(&(journal->Replay_Condition));
+	pthread_mutex_unlock(&(journal->Mutex));
+	retval = pthread_join(journal->Replay_Thread,NULL);
+	if(retval != 0)
+	{
+		Log_Error_Number = 1514;
+		sprintf(Log_Error_String,"Log_UDP_Journal_Close:Failed to join replay thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	retval = Journal_Buffer_Write(journal);
+	if(!Journal_Header_Save(journal,journal->Batch_Offset))
+		retval = FALSE;
+	pthread_cond_destroy(&(journal->Replay_Condition));
+	pthread_mutex_destroy(&(journal->Mutex));
+	Journal_Free(journal);
+	return retval;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * The replay thread. Whilst the journal is spilling, sends a batch of journaled packets every
+ * JOURNAL_TICK_MS, checking before each batch that none of the last was refused. When the collector is
+ * unreachable, the last batch is replayed again after JOURNAL_RETRY_INTERVAL_MS. When every packet has been
+ * replayed, the journal is emptied and packets are sent directly again.
+ * @param user_arg The Log_UDP_Journal_T the thread is replaying.
+ * @return The routine returns NULL.
+ * @see #Journal_Batch_Replay
+ * @see #Journal_Refused
+ * @see #Journal_Reset
+ * @see #JOURNAL_SAVE_INTERVAL_MS
+ */
+static void *Journal_Replay_Thread(void *user_arg)
+{
+	Log_UDP_Journal_T journal = (Log_UDP_Journal_T)user_arg;
+	struct timespec wait_time,save_time;
+	unsigned long replay_count,discard_count;
+	off_t read_offset,file_length;
+	int reachable;
+
+#if DEBUG > 1
+	fprintf(stdout,"Journal_Replay_Thread:started.\n");
+#endif
+	clock_gettime(CLOCK_REALTIME,&save_time);
+	Journal_Time_Add(&save_time,JOURNAL_SAVE_INTERVAL_MS);
+	pthread_mutex_lock(&(journal->Mutex));
+	while(journal->Quit == FALSE)
+	{
+		/* keep the file up to date whilst the collector is unreachable */
+		if(Journal_Time_Passed(&save_time))
+		{
+			Journal_Buffer_Write(journal);
+			if(journal->Batch_Offset != journal->Saved_Offset)
+				Journal_Header_Save(journal,journal->Batch_Offset);
+			clock_gettime(CLOCK_REALTIME,&save_time);
+			Journal_Time_Add(&save_time,JOURNAL_SAVE_INTERVAL_MS);
+		}
+		if(!journal->Spilling)
+		{
+			Journal_Wait(journal,&save_time);
+			continue;
+		}
+		/* a packet of the last batch was refused, replay the batch again once the collector is back */
+		if((journal->Read_Offset != journal->Batch_Offset)&&Journal_Refused(journal))
+		{
+			journal->Read_Offset = journal->Batch_Offset;
+			journal->Stats.Retry_Count++;
+			clock_gettime(CLOCK_REALTIME,&wait_time);
+			Journal_Time_Add(&wait_time,JOURNAL_RETRY_INTERVAL_MS);
+			Journal_Wait(journal,&wait_time);
+			continue;
+		}
+		journal->Batch_Offset = journal->Read_Offset;
+		/* make the packets journaled since the file was last appended to readable */
+		if((journal->Read_Offset == journal->File_Length)&&(journal->Buffer_Length > 0))
+		{
+			if(!Journal_Buffer_Write(journal))
+			{
+				clock_gettime(CLOCK_REALTIME,&wait_time);
+				Journal_Time_Add(&wait_time,JOURNAL_RETRY_INTERVAL_MS);
+				Journal_Wait(journal,&wait_time);
+				continue;
+			}
+		}
+		if(journal->Read_Offset == journal->File_Length)
+		{
+			/* every packet has been replayed, and none were refused */
+			Journal_Reset(journal);
+			journal->Spilling = FALSE;
+			continue;
+		}
+		/* the file below File_Length is only changed by this thread, so can be read without the mutex */
+		read_offset = journal->Read_Offset;
+		file_length = journal->File_Length;
+		pthread_mutex_unlock(&(journal->Mutex));
+		replay_count = 0;
+		discard_count = 0;
+		reachable = Journal_Batch_Replay(journal,&read_offset,file_length,&replay_count,&discard_count);
+		pthread_mutex_lock(&(journal->Mutex));
+		journal->Stats.Replay_Count += replay_count;
+		journal->Stats.Discard_Count += discard_count;
+		clock_gettime(CLOCK_REALTIME,&wait_time);
+		if(reachable)
+		{
+			journal->Read_Offset = read_offset;
+			Journal_Time_Add(&wait_time,JOURNAL_TICK_MS);
+		}
+		else
+		{
+			journal->Read_Offset = journal->Batch_Offset;
+			journal->Stats.Retry_Count++;
+			Journal_Time_Add(&wait_time,JOURNAL_RETRY_INTERVAL_MS);
+		}
+		Journal_Wait(journal,&wait_time);
+	}
+	pthread_mutex_unlock(&(journal->Mutex));
+#if DEBUG > 1
+	fprintf(stdout,"Journal_Replay_Thread:finished.\n");
+#endif
+	return NULL;
+}
+
+/**
+ * Replay one batch of packets: the replay rate's worth of packets for JOURNAL_TICK_MS, at least one.
+ * A packet the send buffer had no room for is replayed in the next batch. A packet that fails to send
+ * for any reason other than the collector being unreachable is discarded.
+ * @param journal The journal.
+ * @param read_offset The address of the offset of the next packet to replay, advanced past the packets
+ *        replayed.
+ * @param file_length The length of the file, the end of the packets that can be replayed.
+ * @param replay_count The address of a counter, incremented for each packet sent.
+ * @param discard_count The address of a counter, incremented for each packet discarded.
+ * @return The routine returns TRUE if the collector is reachable, and FALSE if it is unreachable or the file
+ *         couldn't be read.
+ * @see #Journal_Record_Read
+ * @see #Log_UDP_Journal_Unreachable
+ * @see #JOURNAL_TICK_MS
+ * @see log_udp.html#Log_UDP_Send_Encoded_Status
+ */
+static int Journal_Batch_Replay(Log_UDP_Journal_T journal,off_t *read_offset,off_t file_length,
+				unsigned long *replay_count,unsigned long *discard_count)
+{
+	size_t packet_length;
+	int batch_count,dropped,send_errno,i;
+
+	batch_count = (journal->Replay_Rate*JOURNAL_TICK_MS)/ONE_SECOND_MS;
+	if(batch_count < 1)
+		batch_count = 1;
+	for(i = 0; (i < batch_count)&&((*read_offset) < file_length); i++)
+	{
+		if(!Journal_Record_Read(journal,(*read_offset),&packet_length))
+			return FALSE;
+		if(!Log_UDP_Send_Encoded_Status(journal->Socket_Id,journal->Packet_Buffer,packet_length,&dropped))
+		{
+			send_errno = errno;
+			if(Log_UDP_Journal_Unreachable(send_errno))
+				return FALSE;
+			(*discard_count)++;
+		}
+		else if(dropped)
+			return TRUE;
+		else
+			(*replay_count)++;
+		(*read_offset) += JOURNAL_RECORD_HEADER_LENGTH+packet_length;
+	}
+	return TRUE;
+}
+
+/**
+ * Read a journaled packet from the file into the journal's Packet_Buffer.
+ * @param journal The journal.
+ * @param offset The offset in the file of the packet's length.
+ * @param packet_length The address of a size_t, filled in with the length of the packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Journal_Record_Read(Log_UDP_Journal_T journal,off_t offset,size_t *packet_length)
+{
+	unsigned char record_header[JOURNAL_RECORD_HEADER_LENGTH];
+	int i;
+
+	if(pread(journal->File_Id,record_header,JOURNAL_RECORD_HEADER_LENGTH,offset) != JOURNAL_RECORD_HEADER_LENGTH)
+		return FALSE;
+	(*packet_length) = 0;
+	for(i = 0; i < JOURNAL_RECORD_HEADER_LENGTH; i++)
+		(*packet_length) = ((*packet_length)<<8)|record_header[i];
+	if(((*packet_length) == 0)||((*packet_length) > LOG_UDP_JOURNAL_PACKET_LENGTH_MAX))
+		return FALSE;
+	if(pread(journal->File_Id,journal->Packet_Buffer,(*packet_length),offset+JOURNAL_RECORD_HEADER_LENGTH) !=
+	   (ssize_t)(*packet_length))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Check whether the collector refused a packet sent by the replay thread. The ICMP error arrives after the
+ * packet was sent, and is held on the socket until read, which this does.
+ * @param journal The journal.
+ * @return The routine returns TRUE if a packet was refused, and FALSE otherwise.
+ */
+static int Journal_Refused(Log_UDP_Journal_T journal)
+{
+	socklen_t option_length;
+	int socket_error;
+
+	socket_error = 0;
+	option_length = sizeof(socket_error);
+	if(getsockopt(journal->Socket_Id,SOL_SOCKET,SO_ERROR,&socket_error,&option_length) < 0)
+		return FALSE;
+	return (socket_error != 0);
+}
+
+/**
+ * Read the header of a newly opened journal file, or write one if the file is empty. The file is scanned
+ * from the replay offset, and truncated after the last complete packet.
+ * @param journal The journal, with File_Id open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Journal_Header_Save
+ * @see #JOURNAL_MAGIC
+ */
+static int Journal_Load(Log_UDP_Journal_T journal)
+{
+	struct stat file_stat;
+	unsigned char header[JOURNAL_HEADER_LENGTH];
+	unsigned char record_header[JOURNAL_RECORD_HEADER_LENGTH];
+	off_t replay_offset,end_offset;
+	size_t packet_length;
+	int file_errno,i;
+
+	if(fstat(journal->File_Id,&file_stat) < 0)
+	{
+		file_errno = errno;
+		Log_Error_Number = 1515;
+		sprintf(Log_Error_String,"Journal_Load:fstat failed (%d:%s).",file_errno,strerror(file_errno));
+		return FALSE;
+	}
+	if(file_stat.st_size == 0)
+	{
+		journal->File_Length = JOURNAL_HEADER_LENGTH;
+		journal->Read_Offset = JOURNAL_HEADER_LENGTH;
+		journal->Batch_Offset = JOURNAL_HEADER_LENGTH;
+		return Journal_Header_Save(journal,JOURNAL_HEADER_LENGTH);
+	}
+	/* never overwrite a file that isn't a journal */
+	if((file_stat.st_size < JOURNAL_HEADER_LENGTH)||
+	   (pread(journal->File_Id,header,JOURNAL_HEADER_LENGTH,0) != JOURNAL_HEADER_LENGTH)||
+	   (memcmp(header,JOURNAL_MAGIC,JOURNAL_MAGIC_LENGTH) != 0))
+	{
+		Log_Error_Number = 1516;
+		sprintf(Log_Error_String,"Journal_Load:The file is not a journal.");
+		return FALSE;
+	}
+	replay_offset = 0;
+	for(i = JOURNAL_MAGIC_LENGTH; i < JOURNAL_HEADER_LENGTH; i++)
+		replay_offset = (replay_offset<<8)|header[i];
+	if((replay_offset < JOURNAL_HEADER_LENGTH)||(replay_offset > file_stat.st_size))
+	{
+		Log_Error_Number = 1517;
+		sprintf(Log_Error_String,"Journal_Load:Illegal replay offset %ld in a file of %ld bytes.",
+			(long)replay_offset,(long)file_stat.st_size);
+		return FALSE;
+	}
+	/* a packet being appended when the last process stopped is incomplete */
+	end_offset = replay_offset;
+	while((end_offset+JOURNAL_RECORD_HEADER_LENGTH) <= file_stat.st_size)
+	{
+		if(pread(journal->File_Id,record_header,JOURNAL_RECORD_HEADER_LENGTH,end_offset) !=
+		   JOURNAL_RECORD_HEADER_LENGTH)
+			break;
+		packet_length = 0;
+		for(i = 0; i < JOURNAL_RECORD_HEADER_LENGTH; i++)
+			packet_length = (packet_length<<8)|record_header[i];
+		if((packet_length == 0)||(packet_length > LOG_UDP_JOURNAL_PACKET_LENGTH_MAX)||
+		   ((end_offset+JOURNAL_RECORD_HEADER_LENGTH+(off_t)packet_length) > file_stat.st_size))
+			break;
+		end_offset += JOURNAL_RECORD_HEADER_LENGTH+packet_length;
+	}
+	if((end_offset < file_stat.st_size)&&(ftruncate(journal->File_Id,end_offset) < 0))
+	{
+		file_errno = errno;
+		Log_Error_Number = 1518;
+		sprintf(Log_Error_String,"Journal_Load:Failed to truncate an incomplete packet (%d:%s).",file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	journal->File_Length = end_offset;
+	journal->Read_Offset = replay_offset;
+	journal->Batch_Offset = replay_offset;
+	journal->Saved_Offset = replay_offset;
+	return TRUE;
+}
+
+/**
+ * Append the packets in the journal's buffer to the file, with one write. The journal's mutex should be
+ * locked.
+ * @param journal The journal.
+ * @return The routine returns TRUE on success and FALSE on failure. On failure the packets are kept in the
+ *         buffer.
+ * @see #JOURNAL_BUFFER_LENGTH
+ */
+static int Journal_Buffer_Write(Log_UDP_Journal_T journal)
+{
+	size_t written_length;
+	ssize_t retval;
+	int file_errno;
+
+	written_length = 0;
+	while(written_length < journal->Buffer_Length)
+	{
+		retval = pwrite(journal->File_Id,journal->Buffer+written_length,journal->Buffer_Length-written_length,
+				journal->File_Length+written_length);
+		if(retval < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			file_errno = errno;
+			Log_Error_Number = 1519;
+			sprintf(Log_Error_String,"Journal_Buffer_Write:Failed to write %lu bytes (%d:%s).",
+				journal->Buffer_Length-written_length,file_errno,strerror(file_errno));
+			return FALSE;
+		}
+		written_length += retval;
+	}
+	journal->File_Length += journal->Buffer_Length;
+	journal->Buffer_Length = 0;
+	return TRUE;
+}
+
+/**
+ * Write the journal file header, with a replay offset.
+ * @param journal The journal.
+ * @param replay_offset The offset of the next packet to replay.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #JOURNAL_MAGIC
+ * @see #JOURNAL_HEADER_LENGTH
+ */
+static int Journal_Header_Save(Log_UDP_Journal_T journal,off_t replay_offset)
+{
+	unsigned char header[JOURNAL_HEADER_LENGTH];
+	uint64_t offset;
+	int file_errno,i;
+
+	memcpy(header,JOURNAL_MAGIC,JOURNAL_MAGIC_LENGTH);
+	offset = (uint64_t)replay_offset;
+	for(i = JOURNAL_HEADER_LENGTH-1; i >= JOURNAL_MAGIC_LENGTH; i--)
+	{
+		header[i] = (unsigned char)(offset&0xff);
+		offset >>= 8;
+	}
+	if(pwrite(journal->File_Id,header,JOURNAL_HEADER_LENGTH,0) != JOURNAL_HEADER_LENGTH)
+	{
+		file_errno = errno;
+		Log_Error_Number = 1520;
+		sprintf(Log_Error_String,"Journal_Header_Save:Failed to write header (%d:%s).",file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	journal->Saved_Offset = replay_offset;
+	return TRUE;
+}
+
+/**
+ * Empty a journal that has been completely replayed, truncating the file to it's header. The journal's
+ * mutex should be locked, and the buffer should be empty.
+ * @param journal The journal.
+ * @see #Journal_Header_Save
+ */
+static void Journal_Reset(Log_UDP_Journal_T journal)
+{
+#if DEBUG > 1
+	fprintf(stdout,"Journal_Reset:Replayed %ld bytes.\n",(long)(journal->File_Length-JOURNAL_HEADER_LENGTH));
+#endif
+	if(ftruncate(journal->File_Id,JOURNAL_HEADER_LENGTH) < 0)
+		return;
+	journal->File_Length = JOURNAL_HEADER_LENGTH;
+	journal->Read_Offset = JOURNAL_HEADER_LENGTH;
+	journal->Batch_Offset = JOURNAL_HEADER_LENGTH;
+	Journal_Header_Save(journal,JOURNAL_HEADER_LENGTH);
+}
+
+/**
+ * Lock the whole of a journal file, so no other process can open it. The lock is released when the file
+ * is closed.
+ * @param file_id The open journal file.
+ * @return The routine returns TRUE on success and FALSE on failure, including when another process has the
+ *         file locked.
+ */
+static int Journal_Lock(int file_id)
+{
+	struct flock lock;
+	int file_errno;
+
+	memset(&lock,0,sizeof(lock));
+	lock.l_type = F_WRLCK;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = 0;
+	lock.l_len = 0;
+	if(fcntl(file_id,F_SETLK,&lock) < 0)
+	{
+		file_errno = errno;
+		Log_Error_Number = 1521;
+		sprintf(Log_Error_String,"Journal_Lock:Failed to lock journal file, is another process using it "
+			"(%d:%s)?",file_errno,strerror(file_errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Free a journal, closing it's file and socket if they are open.
+ * @param journal The journal.
+ */
+static void Journal_Free(Log_UDP_Journal_T journal)
+{
+	if(journal->Socket_Id >= 0)
+	{
+		Log_UDP_Close(journal->Socket_Id);
+		close(journal->Socket_Id);
+	}
+	if(journal->File_Id >= 0)
+		close(journal->File_Id);
+	if(journal->Buffer != NULL)
+		free(journal->Buffer);
+	free(journal);
+}
+
+/**
+ * Wait on the journal's condition until an absolute time, or until signalled. The journal's mutex should
+ * be locked.
+ * @param journal The journal.
+ * @param abs_time The (CLOCK_REALTIME) time to wait until.
+ */
+static void Journal_Wait(Log_UDP_Journal_T journal,struct timespec *abs_time)
+{
+	pthread_cond_timedwait(&(journal->Replay_Condition),&(journal->Mutex),abs_time);
+}
+
+/**
+ * Add a number of milliseconds to an absolute time.
+ * @param abs_time The address of the time to modify.
+ * @param milliseconds The number of milliseconds to add.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ * @see #ONE_SECOND_NS
+ */
+static void Journal_Time_Add(struct timespec *abs_time,int milliseconds)
+{
+	abs_time->tv_sec += milliseconds/ONE_SECOND_MS;
+	abs_time->tv_nsec += (milliseconds%ONE_SECOND_MS)*ONE_MILLISECOND_NS;
+	if(abs_time->tv_nsec >= ONE_SECOND_NS)
+	{
+		abs_time->tv_sec++;
+		abs_time->tv_nsec -= ONE_SECOND_NS;
+	}
+}
+
+/**
+ * Return whether the (CLOCK_REALTIME) absolute time has passed.
+ * @param abs_time The address of the time to test.
+ * @return TRUE if the time has passed, FALSE if it has not.
+ */
+static int Journal_Time_Passed(struct timespec *abs_time)
+{
+	struct timespec current_time;
+
+	clock_gettime(CLOCK_REALTIME,&current_time);
+	if(current_time.tv_sec != abs_time->tv_sec)
+		return (current_time.tv_sec > abs_time->tv_sec);
+	return (current_time.tv_nsec >= abs_time->tv_nsec);
+}
+
+/*
+** $Log$
+*/
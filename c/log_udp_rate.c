@@ -0,0 +1,547 @@
+/* log_udp_rate.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Per-source rate limiting. Each System/Sub_System/Category has a token bucket, refilled at
+ * a configured number of records per second up to a burst size. A record is only sent if its bucket
+ * holds a token. Records that are suppressed are counted, and a summary record ("N messages suppressed")
+ * is sent with the same System/Sub_System/Category once a summary interval has passed since suppression
+ * started, so the receiver still sees that the source is active. The summary is sent by the summary send
+ * routine of whatever last logged with that key (a socket or a logger handle), so it goes the same way as the
+ * records it summarises. The buckets are kept in a small fixed size open-addressed hash table protected by
+ * a mutex. Rate limiting is off until Log_UDP_Rate_Limit_Set is called.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1c threads and
+ * POSIX.4/IEEE1003.1b-1993 clock_gettime prototypes.
+ */
+#define _POSIX_C_SOURCE 199506L
+#include <errno.h>   /* Error number definitions */
+#include <pthread.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+#include "log_udp_rate.h"
+
+/* hash defines */
+/**
+ * The number of buckets in the hash table. This must be a power of 2.
+ */
+#define RATE_TABLE_LENGTH               (256)
+/**
+ * The maximum number of hash table entries examined when looking for a key.
+ */
+#define RATE_PROBE_LENGTH               (16)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+/**
+ * The default summary interval in milliseconds.
+ */
+#define DEFAULT_SUMMARY_INTERVAL_MS     (10000)
+
+/* structures */
+/**
+ * A token bucket for one System/Sub_System/Category.
+ * <dl>
+ * <dt>In_Use</dt> <dd>Whether this entry holds a key.</dd>
+ * <dt>Hash</dt> <dd>The hash of the key.</dd>
+ * <dt>System</dt> <dd>The System part of the key.</dd>
+ * <dt>Sub_System</dt> <dd>The Sub_System part of the key.</dd>
+ * <dt>Category</dt> <dd>The Category part of the key.</dd>
+ * <dt>Summary_Send</dt> <dd>The summary send routine of whatever last sent a record with this key,
+ *     used to send summaries. NULL if summaries are dropped.</dd>
+ * <dt>Summary_Arg</dt> <dd>The argument passed to Summary_Send.</dd>
+ * <dt>Tokens</dt> <dd>The number of records that can be sent before the bucket is empty.</dd>
+ * <dt>Last_Refill_Ms</dt> <dd>The monotonic time in milliseconds the bucket was last refilled.</dd>
+ * <dt>Suppressed_Count</dt> <dd>The number of records suppressed since the last summary.</dd>
+ * <dt>Suppressed_Severity</dt> <dd>The highest severity of the suppressed records.</dd>
+ * <dt>Suppress_Start_Ms</dt> <dd>The monotonic time in milliseconds suppression started.</dd>
+ * </dl>
+ */
+struct Rate_Entry_Struct
+{
+	int In_Use;
+	unsigned int Hash;
+	char System[LOG_RECORD_SYSTEM_LENGTH];
+	char Sub_System[LOG_RECORD_SUB_SYSTEM_LENGTH];
+	char Category[LOG_RECORD_CATEGORY_LENGTH];
+	Log_UDP_Summary_Send_T Summary_Send;
+	void *Summary_Arg;
+	double Tokens;
+	int64_t Last_Refill_Ms;
+	unsigned long Suppressed_Count;
+	int Suppressed_Severity;
+	int64_t Suppress_Start_Ms;
+};
+
+/**
+ * The data needed to send one summary record, copied out of the hash table entry.
+ * <dl>
+ * <dt>Summary_Send</dt> <dd>The routine to send the summary with, or NULL to drop it.</dd>
+ * <dt>Summary_Arg</dt> <dd>The argument passed to Summary_Send.</dd>
+ * <dt>System</dt> <dd>The System of the suppressed records.</dd>
+ * <dt>Sub_System</dt> <dd>The Sub_System of the suppressed records.</dd>
+ * <dt>Category</dt> <dd>The Category of the suppressed records.</dd>
+ * <dt>Suppressed_Count</dt> <dd>The number of records suppressed.</dd>
+ * <dt>Severity</dt> <dd>The highest severity of the suppressed records.</dd>
+ * <dt>Duration_Ms</dt> <dd>The length of time (in milliseconds) the records were suppressed over.</dd>
+ * </dl>
+ */
+struct Rate_Summary_Struct
+{
+	Log_UDP_Summary_Send_T Summary_Send;
+	void *Summary_Arg;
+	char System[LOG_RECORD_SYSTEM_LENGTH];
+	char Sub_System[LOG_RECORD_SUB_SYSTEM_LENGTH];
+	char Category[LOG_RECORD_CATEGORY_LENGTH];
+	unsigned long Suppressed_Count;
+	int Severity;
+	int64_t Duration_Ms;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of records per second each bucket is refilled with. Rate limiting is off when
+ * this is zero.
+ */
+static double Rate_Records_Per_Second = 0.0;
+/**
+ * The maximum number of tokens in a bucket.
+ */
+static int Rate_Burst_Count = 0;
+/**
+ * The length of time in milliseconds after suppression starts before a summary is sent.
+ */
+static int Rate_Summary_Interval_Ms = DEFAULT_SUMMARY_INTERVAL_MS;
+/**
+ * The total number of records suppressed since the program started.
+ */
+static unsigned long Rate_Suppressed_Total = 0;
+/**
+ * The hash table of token buckets.
+ * @see #RATE_TABLE_LENGTH
+ */
+static struct Rate_Entry_Struct Rate_Table[RATE_TABLE_LENGTH];
+/**
+ * Mutex protecting the hash table and the settings. Summaries are sent with the mutex locked, so a summary
+ * send routine is never called after Log_UDP_Rate_Limit_Release has returned for it.
+ */
+static pthread_mutex_t Rate_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* internal function declarations */
+static struct Rate_Entry_Struct *Rate_Entry_Get(const char *system,const char *sub_system,const char *category);
+static unsigned int Rate_Hash(const char *system,const char *sub_system,const char *category);
+static int Rate_Key_Equal(struct Rate_Entry_Struct *entry,const char *system,const char *sub_system,
+			  const char *category);
+static void Rate_Summary_Take(struct Rate_Entry_Struct *entry,int64_t now_ms,struct Rate_Summary_Struct *summary);
+static int Rate_Summary_Send(struct Rate_Summary_Struct *summary);
+static int64_t Rate_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Configure rate limiting. Each System/Sub_System/Category can send burst_count records at once,
+ * and records_per_second records per second after that. Any existing buckets are reset.
+ * @param records_per_second The number of records per second each System/Sub_System/Category
+ *        can send. Zero turns rate limiting off.
+ * @param burst_count The maximum number of records that can be sent at once, at least 1.
+ * @param summary_interval_ms How long (in milliseconds) after records start being suppressed a summary
+ *        record is sent. Zero selects the default.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Rate_Records_Per_Second
+ * @see #Rate_Burst_Count
+ * @see #Rate_Summary_Interval_Ms
+ * @see #DEFAULT_SUMMARY_INTERVAL_MS
+ */
+int Log_UDP_Rate_Limit_Set(double records_per_second,int burst_count,int summary_interval_ms)
+{
+	if(records_per_second < 0.0)
+	{
+		Log_Error_Number = 400;
+		sprintf(Log_Error_String,"Log_UDP_Rate_Limit_Set:records_per_second was negative(%.2f).",
+			records_per_second);
+		return FALSE;
+	}
+	if((records_per_second > 0.0)&&(burst_count < 1))
+	{
+		Log_Error_Number = 401;
+		sprintf(Log_Error_String,"Log_UDP_Rate_Limit_Set:burst_count should be at least 1(%d).",burst_count);
+		return FALSE;
+	}
+	if(summary_interval_ms < 0)
+	{
+		Log_Error_Number = 402;
+		sprintf(Log_Error_String,"Log_UDP_Rate_Limit_Set:summary_interval_ms was negative(%d).",
+			summary_interval_ms);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Rate_Mutex);
+	Rate_Records_Per_Second = records_per_second;
+	Rate_Burst_Count = burst_count;
+	if(summary_interval_ms > 0)
+		Rate_Summary_Interval_Ms = summary_interval_ms;
+	else
+		Rate_Summary_Interval_Ms = DEFAULT_SUMMARY_INTERVAL_MS;
+	memset(Rate_Table,0,sizeof(Rate_Table));
+	pthread_mutex_unlock(&Rate_Mutex);
+	return TRUE;
+}
+
+/**
+ * Determine whether a record should be sent, taking a token from its System/Sub_System/Category's
+ * bucket. If records with this key have been suppressed for longer than the summary interval,
+ * a summary record is sent with summary_send first. This is called by the send routines in log_udp.c and
+ * log_udp_handle.c, and returns straight away when rate limiting is off.
+ * If the hash table is too full to hold a new key, the record is sent.
+ * The summary is sent with Rate_Mutex locked, so summary_send must not call this routine, and this routine
+ * must not be called with a lock summary_send takes held.
+ * @param summary_send The routine used to send summaries through whatever the record will be sent with.
+ *        Can be NULL, in which case summaries are dropped.
+ * @param summary_arg The argument passed to summary_send.
+ * @param system The record's System. Can be NULL.
+ * @param sub_system The record's Sub_System. Can be NULL.
+ * @param category The record's Category. Can be NULL.
+ * @param severity The record's severity.
+ * @return The routine returns TRUE if the record should be sent, and FALSE if it should be suppressed.
+ * @see #Rate_Entry_Get
+ * @see #Rate_Summary_Take
+ * @see #Rate_Summary_Send
+ */
+int Log_UDP_Rate_Limit_Allow(Log_UDP_Summary_Send_T summary_send,void *summary_arg,const char *system,
+			     const char *sub_system,const char *category,int severity)
+{
+	struct Rate_Entry_Struct *entry = NULL;
+	struct Rate_Summary_Struct summary;
+	int64_t now_ms;
+	int allow;
+
+	/* unlocked read, settings changes are picked up on the next call */
+	if(Rate_Records_Per_Second <= 0.0)
+		return TRUE;
+	now_ms = Rate_Monotonic_Ms();
+	pthread_mutex_lock(&Rate_Mutex);
+	entry = Rate_Entry_Get(system,sub_system,category);
+	if(entry == NULL)
+	{
+		pthread_mutex_unlock(&Rate_Mutex);
+		return TRUE;
+	}
+	entry->Summary_Send = summary_send;
+	entry->Summary_Arg = summary_arg;
+	/* refill bucket */
+	entry->Tokens += (((double)(now_ms-entry->Last_Refill_Ms))*Rate_Records_Per_Second)/((double)ONE_SECOND_MS);
+	if(entry->Tokens > (double)Rate_Burst_Count)
+		entry->Tokens = (double)Rate_Burst_Count;
+	entry->Last_Refill_Ms = now_ms;
+	if(entry->Tokens >= 1.0)
+	{
+		entry->Tokens -= 1.0;
+		allow = TRUE;
+	}
+	else
+	{
+		if(entry->Suppressed_Count == 0)
+		{
+			entry->Suppress_Start_Ms = now_ms;
+			entry->Suppressed_Severity = severity;
+		}
+		else if(severity > entry->Suppressed_Severity)
+			entry->Suppressed_Severity = severity;
+		entry->Suppressed_Count++;
+		Rate_Suppressed_Total++;
+		allow = FALSE;
+	}
+	if((entry->Suppressed_Count > 0)&&((now_ms-entry->Suppress_Start_Ms) >= Rate_Summary_Interval_Ms))
+	{
+		Rate_Summary_Take(entry,now_ms,&summary);
+		Rate_Summary_Send(&summary);
+	}
+	pthread_mutex_unlock(&Rate_Mutex);
+	return allow;
+}
+
+/**
+ * Send a summary record for every System/Sub_System/Category with suppressed records, whether or not
+ * the summary interval has passed. Summaries are otherwise only sent when another record with the same
+ * key is logged, so call this before closing the socket (or periodically) to report the end of a flood.
+ * @return The routine returns TRUE on success and FALSE if sending a summary failed.
+ * @see #Rate_Summary_Take
+ * @see #Rate_Summary_Send
+ */
+int Log_UDP_Rate_Limit_Flush(void)
+{
+	struct Rate_Summary_Struct summary;
+	int64_t now_ms;
+	int i,retval;
+
+	retval = TRUE;
+	now_ms = Rate_Monotonic_Ms();
+	pthread_mutex_lock(&Rate_Mutex);
+	for(i = 0; i < RATE_TABLE_LENGTH; i++)
+	{
+		if(Rate_Table[i].In_Use && (Rate_Table[i].Suppressed_Count > 0))
+		{
+			Rate_Summary_Take(&(Rate_Table[i]),now_ms,&summary);
+			if(!Rate_Summary_Send(&summary))
+				retval = FALSE;
+		}
+	}
+	pthread_mutex_unlock(&Rate_Mutex);
+	return retval;
+}
+
+/**
+ * Stop sending summaries with a summary send routine, before whatever it sends through is closed.
+ * Summaries of records last sent with summary_send and summary_arg are sent now, whether or not the summary
+ * interval has passed, and later summaries for their keys are dropped until another record with the key
+ * is sent. The buckets themselves are kept. Called by Log_UDP_Close and Log_UDP_Handle_Close.
+ * @param summary_send The summary send routine passed to Log_UDP_Rate_Limit_Allow.
+ * @param summary_arg The argument passed to Log_UDP_Rate_Limit_Allow with summary_send.
+ * @return The routine returns TRUE on success and FALSE if sending a summary failed.
+ * @see #Rate_Summary_Take
+ * @see #Rate_Summary_Send
+ */
+int Log_UDP_Rate_Limit_Release(Log_UDP_Summary_Send_T summary_send,void *summary_arg)
+{
+	struct Rate_Summary_Struct summary;
+	int64_t now_ms;
+	int i,retval;
+
+	retval = TRUE;
+	now_ms = Rate_Monotonic_Ms();
+	pthread_mutex_lock(&Rate_Mutex);
+	for(i = 0; i < RATE_TABLE_LENGTH; i++)
+	{
+		if((!Rate_Table[i].In_Use)||(Rate_Table[i].Summary_Send != summary_send)||
+		   (Rate_Table[i].Summary_Arg != summary_arg))
+			continue;
+		if(Rate_Table[i].Suppressed_Count > 0)
+		{
+			Rate_Summary_Take(&(Rate_Table[i]),now_ms,&summary);
+			if(!Rate_Summary_Send(&summary))
+				retval = FALSE;
+		}
+		Rate_Table[i].Summary_Send = NULL;
+		Rate_Table[i].Summary_Arg = NULL;
+	}
+	pthread_mutex_unlock(&Rate_Mutex);
+	return retval;
+}
+
+/**
+ * Get the total number of records suppressed by the rate limiter since the program started.
+ * @param suppressed_count The address of an unsigned long to fill in with the count.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Rate_Suppressed_Total
+ */
+int Log_UDP_Rate_Limit_Suppressed_Count_Get(unsigned long *suppressed_count)
+{
+	if(suppressed_count == NULL)
+	{
+		Log_Error_Number = 403;
+		sprintf(Log_Error_String,"Log_UDP_Rate_Limit_Suppressed_Count_Get:suppressed_count was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&Rate_Mutex);
+	(*suppressed_count) = Rate_Suppressed_Total;
+	pthread_mutex_unlock(&Rate_Mutex);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Find the hash table entry for a key, creating it with a full bucket if it is not there.
+ * If all the entries probed are in use, the least recently refilled one without suppressed records
+ * is reused. Rate_Mutex should be locked.
+ * @param system The System. Can be NULL.
+ * @param sub_system The Sub_System. Can be NULL.
+ * @param category The Category. Can be NULL.
+ * @return The entry, or NULL if there was no room for the key.
+ * @see #Rate_Table
+ * @see #RATE_PROBE_LENGTH
+ * @see #Rate_Hash
+ * @see #Rate_Key_Equal
+ */
+static struct Rate_Entry_Struct *Rate_Entry_Get(const char *system,const char *sub_system,const char *category)
+{
+	struct Rate_Entry_Struct *entry = NULL;
+	struct Rate_Entry_Struct *free_entry = NULL;
+	struct Rate_Entry_Struct *idle_entry = NULL;
+	unsigned int hash;
+	int i;
+
+	hash = Rate_Hash(system,sub_system,category);
+	for(i = 0; i < RATE_PROBE_LENGTH; i++)
+	{
+		entry = &(Rate_Table[(hash+i)&(RATE_TABLE_LENGTH-1)]);
+		if(!entry->In_Use)
+		{
+			if(free_entry == NULL)
+				free_entry = entry;
+			continue;
+		}
+		if((entry->Hash == hash)&&Rate_Key_Equal(entry,system,sub_system,category))
+			return entry;
+		if((entry->Suppressed_Count == 0)&&
+		   ((idle_entry == NULL)||(entry->Last_Refill_Ms < idle_entry->Last_Refill_Ms)))
+			idle_entry = entry;
+	}
+	if(free_entry != NULL)
+		entry = free_entry;
+	else if(idle_entry != NULL)
+		entry = idle_entry;
+	else
+		return NULL;
+	memset(entry,0,sizeof(struct Rate_Entry_Struct));
+	entry->In_Use = TRUE;
+	entry->Hash = hash;
+	if(system != NULL)
+		strncpy(entry->System,system,LOG_RECORD_SYSTEM_LENGTH-1);
+	if(sub_system != NULL)
+		strncpy(entry->Sub_System,sub_system,LOG_RECORD_SUB_SYSTEM_LENGTH-1);
+	if(category != NULL)
+		strncpy(entry->Category,category,LOG_RECORD_CATEGORY_LENGTH-1);
+	entry->Tokens = (double)Rate_Burst_Count;
+	entry->Last_Refill_Ms = Rate_Monotonic_Ms();
+	return entry;
+}
+
+/**
+ * Compute an FNV-1a hash of a System/Sub_System/Category key. Each string is hashed up to the length
+ * it is truncated to in a log record. NULL strings hash as empty strings.
+ * @param system The System. Can be NULL.
+ * @param sub_system The Sub_System. Can be NULL.
+ * @param category The Category. Can be NULL.
+ * @return The hash.
+ */
+static unsigned int Rate_Hash(const char *system,const char *sub_system,const char *category)
+{
+	const char *string_list[3];
+	size_t length_list[3];
+	unsigned int hash;
+	size_t j;
+	int i;
+
+	string_list[0] = system;
+	length_list[0] = LOG_RECORD_SYSTEM_LENGTH-1;
+	string_list[1] = sub_system;
+	length_list[1] = LOG_RECORD_SUB_SYSTEM_LENGTH-1;
+	string_list[2] = category;
+	length_list[2] = LOG_RECORD_CATEGORY_LENGTH-1;
+	hash = 2166136261U;
+	for(i = 0; i < 3; i++)
+	{
+		for(j = 0; (string_list[i] != NULL)&&(j < length_list[i])&&(string_list[i][j] != '\0'); j++)
+		{
+			hash ^= (unsigned char)(string_list[i][j]);
+			hash *= 16777619U;
+		}
+		/* separate the strings */
+		hash ^= 0xff;
+		hash *= 16777619U;
+	}
+	return hash;
+}
+
+/**
+ * Determine whether a hash table entry holds the specified key.
+ * @param entry The hash table entry.
+ * @param system The System. Can be NULL.
+ * @param sub_system The Sub_System. Can be NULL.
+ * @param category The Category. Can be NULL.
+ * @return TRUE if the entry holds the key, FALSE otherwise.
+ */
+static int Rate_Key_Equal(struct Rate_Entry_Struct *entry,const char *system,const char *sub_system,
+			  const char *category)
+{
+	if(strncmp(entry->System,(system != NULL) ? system : "",LOG_RECORD_SYSTEM_LENGTH-1) != 0)
+		return FALSE;
+	if(strncmp(entry->Sub_System,(sub_system != NULL) ? sub_system : "",LOG_RECORD_SUB_SYSTEM_LENGTH-1) != 0)
+		return FALSE;
+	if(strncmp(entry->Category,(category != NULL) ? category : "",LOG_RECORD_CATEGORY_LENGTH-1) != 0)
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Copy the data needed for a summary out of a hash table entry, and reset the entry's suppressed count.
+ * Rate_Mutex should be locked.
+ * @param entry The hash table entry.
+ * @param now_ms The current monotonic time in milliseconds.
+ * @param summary The address of a structure to fill in.
+ */
+static void Rate_Summary_Take(struct Rate_Entry_Struct *entry,int64_t now_ms,struct Rate_Summary_Struct *summary)
+{
+	summary->Summary_Send = entry->Summary_Send;
+	summary->Summary_Arg = entry->Summary_Arg;
+	strcpy(summary->System,entry->System);
+	strcpy(summary->Sub_System,entry->Sub_System);
+	strcpy(summary->Category,entry->Category);
+	summary->Suppressed_Count = entry->Suppressed_Count;
+	summary->Severity = entry->Suppressed_Severity;
+	summary->Duration_Ms = now_ms-entry->Suppress_Start_Ms;
+	entry->Suppressed_Count = 0;
+}
+
+/**
+ * Send a summary record with the summary's send routine, which sends it without filtering or rate limiting it.
+ * Rate_Mutex should be locked.
+ * @param summary The summary to send.
+ * @return The routine returns TRUE on success (or if the summary has no send routine) and FALSE on failure.
+ * @see log_create.html#Log_Create_Record
+ */
+static int Rate_Summary_Send(struct Rate_Summary_Struct *summary)
+{
+	struct Log_Record_Struct log_record;
+	char message[LOG_RECORD_MESSAGE_LENGTH];
+
+	if(summary->Summary_Send == NULL)
+		return TRUE;
+	sprintf(message,"%lu messages suppressed by the rate limit over %.1f s.",summary->Suppressed_Count,
+		((double)summary->Duration_Ms)/((double)ONE_SECOND_MS));
+	if(!Log_Create_Record(summary->System,summary->Sub_System,"log_udp_rate.c",NULL,"Log_UDP_Rate_Limit_Allow",
+			      summary->Severity,LOG_VERBOSITY_TERSE,summary->Category,message,&log_record))
+		return FALSE;
+	return summary->Summary_Send(summary->Summary_Arg,&log_record,0,NULL);
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Rate_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,569 @@
+/* log_udp_resolve.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Hostname resolution. Hostnames are resolved to an IPv4 or IPv6 address using getaddrinfo, and the result
+ * is kept in a small process-wide cache. Only the first lookup of a hostname blocks: after that the cached
+ * address is returned at once. A resolver thread, started when the first hostname is cached, re-resolves
+ * each cached hostname once its time to live has passed. If the lookup fails (the DNS server is down, for
+ * instance) the last known address is kept and the lookup is retried later. Whenever a re-resolved address
+ * changes, Log_UDP_Resolve_Generation is incremented, so logger handles know to pick up the new address.
+ * Numeric addresses are converted without touching the cache. Hostnames starting with
+ * LOG_UDP_RESOLVE_UNIX_PREFIX are converted to a Unix domain socket address, so the same packets can be
+ * sent to a relay on the same machine over an AF_UNIX datagram socket, which is reliable and cheaper
+ * than the UDP stack.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1-2001 getaddrinfo,
+ * POSIX.1c threads and POSIX.4/IEEE1003.1b-1993 clock_gettime and nanosleep prototypes.
+ */
+#define _POSIX_C_SOURCE 200112L
+#include <errno.h>   /* Error number definitions */
+#include <netdb.h>
+#include <pthread.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stddef.h>  /* offsetof */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <netinet/in.h> /* htons etc */
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_resolve.h"
+
+/* hash defines */
+/**
+ * The number of hostnames cached. When more are resolved, the least recently used is replaced.
+ */
+#define RESOLVE_CACHE_LENGTH            (32)
+/**
+ * How long (in milliseconds) the resolver thread sleeps between looking for hostnames to re-resolve.
+ */
+#define RESOLVE_WAIT_MS                 (1000)
+/**
+ * How long (in milliseconds) after a failed re-resolution it is tried again.
+ */
+#define RESOLVE_RETRY_MS                (10000)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+
+/* structures */
+/**
+ * A cached hostname and the address it resolved to.
+ * <dl>
+ * <dt>In_Use</dt> <dd>Whether this entry holds a hostname.</dd>
+ * <dt>Hostname</dt> <dd>The hostname.</dd>
+ * <dt>Address</dt> <dd>The last address the hostname resolved to, with a port number of 0.</dd>
+ * <dt>Address_Length</dt> <dd>The length of Address in bytes.</dd>
+ * <dt>Expiry_Ms</dt> <dd>The monotonic time in milliseconds after which the hostname is re-resolved.</dd>
+ * <dt>Last_Used_Ms</dt> <dd>The monotonic time in milliseconds the entry was last looked up.</dd>
+ * <dt>Failure_Count</dt> <dd>The number of re-resolutions that have failed since the last successful one.</dd>
+ * </dl>
+ * @see log_udp_resolve.h#LOG_UDP_RESOLVE_HOSTNAME_LENGTH
+ */
+struct Resolve_Entry_Struct
+{
+	int In_Use;
+	char Hostname[LOG_UDP_RESOLVE_HOSTNAME_LENGTH];
+	struct sockaddr_storage Address;
+	socklen_t Address_Length;
+	int64_t Expiry_Ms;
+	int64_t Last_Used_Ms;
+	int Failure_Count;
+};
+
+/* external variables */
+/**
+ * Incremented whenever a cached hostname is re-resolved to a different address. Users of resolved
+ * addresses compare this with the value they last saw, and call Log_UDP_Resolve_Cache_Get when it changes.
+ * Like the process-wide filter, this is a plain integer read without taking a lock.
+ * @see #Log_UDP_Resolve_Cache_Get
+ */
+int Log_UDP_Resolve_Generation = 0;
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The cached hostnames.
+ * @see #RESOLVE_CACHE_LENGTH
+ */
+static struct Resolve_Entry_Struct Resolve_Cache[RESOLVE_CACHE_LENGTH];
+/**
+ * The length of time in seconds a resolved address is used before it is re-resolved.
+ * @see log_udp_resolve.h#LOG_UDP_RESOLVE_DEFAULT_TTL
+ */
+static int Resolve_TTL = LOG_UDP_RESOLVE_DEFAULT_TTL;
+/**
+ * Whether the resolver thread has been started.
+ */
+static int Resolve_Thread_Started = FALSE;
+/**
+ * The resolver thread.
+ */
+static pthread_t Resolve_Thread_Id;
+/**
+ * Mutex protecting the cache, the settings and Log_UDP_Resolve_Generation.
+ */
+static pthread_mutex_t Resolve_Mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* internal function declarations */
+static int Resolve_Numeric(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length);
+static int Resolve_Unix(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length);
+static int Resolve_Lookup(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length);
+static struct Resolve_Entry_Struct *Resolve_Entry_Find(const char *hostname);
+static void Resolve_Entry_Insert(const char *hostname,struct sockaddr_storage *address,socklen_t address_length,
+				 int64_t now_ms);
+static void Resolve_Port_Set(struct sockaddr_storage *address,int port_number);
+static void *Resolve_Thread(void *user_arg);
+static int64_t Resolve_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Convert a hostname and port number into an IPv4, IPv6 or Unix domain socket address. Numeric addresses and
+ * Unix domain socket paths are converted directly. Other hostnames are looked up in the cache, and only
+ * resolved with getaddrinfo (which can block) the first time they are seen; they are then cached and
+ * re-resolved in the background.
+ * @param hostname The hostname, either numeric (IPv4 or IPv6), resolved via /etc/hosts or DNS, or
+ *        LOG_UDP_RESOLVE_UNIX_PREFIX followed by the path of a Unix domain socket.
+ * @param port_number The port number in host (normal) byte order, ignored for Unix domain sockets.
+ * @param address The address of a socket address structure to fill in.
+ * @param address_length The address of a socklen_t, filled in with the length of the address used.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_RESOLVE_UNIX_PREFIX
+ * @see #Resolve_Unix
+ * @see #Resolve_Numeric
+ * @see #Resolve_Entry_Find
+ * @see #Resolve_Lookup
+ * @see #Resolve_Entry_Insert
+ */
+int Log_UDP_Resolve_Address(const char *hostname,int port_number,struct sockaddr_storage *address,
+			    socklen_t *address_length)
+{
+	struct Resolve_Entry_Struct *entry = NULL;
+	int gai_retval,retval;
+
+	if((hostname == NULL)||(address == NULL)||(address_length == NULL))
+	{
+		Log_Error_Number = 1100;
+		sprintf(Log_Error_String,"Log_UDP_Resolve_Address:NULL argument.");
+		return FALSE;
+	}
+	if((port_number < 0)||(port_number > 65535))
+	{
+		Log_Error_Number = 1101;
+		sprintf(Log_Error_String,"Log_UDP_Resolve_Address:Illegal port number %d.",port_number);
+		return FALSE;
+	}
+	if(strncmp(hostname,LOG_UDP_RESOLVE_UNIX_PREFIX,strlen(LOG_UDP_RESOLVE_UNIX_PREFIX)) == 0)
+	{
+		if(!Resolve_Unix(hostname,address,address_length))
+		{
+			Log_Error_Number = 1105;
+			sprintf(Log_Error_String,"Log_UDP_Resolve_Address:Illegal Unix domain socket '%.128s'.",hostname);
+			return FALSE;
+		}
+		return TRUE;
+	}
+	if(Resolve_Numeric(hostname,address,address_length))
+	{
+		Resolve_Port_Set(address,port_number);
+		return TRUE;
+	}
+	pthread_mutex_lock(&Resolve_Mutex);
+	entry = Resolve_Entry_Find(hostname);
+	if(entry != NULL)
+	{
+		(*address) = entry->Address;
+		(*address_length) = entry->Address_Length;
+		entry->Last_Used_Ms = Resolve_Monotonic_Ms();
+		pthread_mutex_unlock(&Resolve_Mutex);
+		Resolve_Port_Set(address,port_number);
+		return TRUE;
+	}
+	pthread_mutex_unlock(&Resolve_Mutex);
+	/* not cached, resolve now */
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Resolve_Address:%s is not cached, resolving.\n",hostname);
+#endif
+	gai_retval = Resolve_Lookup(hostname,address,address_length);
+	if(gai_retval != 0)
+	{
+		Log_Error_Number = 1102;
+		sprintf(Log_Error_String,"Log_UDP_Resolve_Address:Failed to resolve %.128s (%d:%s).",hostname,
+			gai_retval,gai_strerror(gai_retval));
+		return FALSE;
+	}
+	if(strlen(hostname) < LOG_UDP_RESOLVE_HOSTNAME_LENGTH)
+	{
+		pthread_mutex_lock(&Resolve_Mutex);
+		if(Resolve_Entry_Find(hostname) == NULL)
+			Resolve_Entry_Insert(hostname,address,(*address_length),Resolve_Monotonic_Ms());
+		if(!Resolve_Thread_Started)
+		{
+			retval = pthread_create(&Resolve_Thread_Id,NULL,Resolve_Thread,(void *)Resolve_Cache);
+			if(retval == 0)
+			{
+				pthread_detach(Resolve_Thread_Id);
+				Resolve_Thread_Started = TRUE;
+			}
+			/* otherwise the address is still cached, but not re-resolved; starting the thread is
+			** retried when the next hostname is cached */
+		}
+		pthread_mutex_unlock(&Resolve_Mutex);
+	}
+	Resolve_Port_Set(address,port_number);
+	return TRUE;
+}
+
+/**
+ * Get the address a hostname resolves to, without ever blocking on a lookup. Numeric addresses and Unix domain
+ * socket paths are converted directly, other hostnames are only found if they are in the cache.
+ * @param hostname The hostname.
+ * @param port_number The port number in host (normal) byte order.
+ * @param address The address of a socket address structure, filled in if the hostname was found.
+ * @param address_length The address of a socklen_t, filled in with the length of the address if the hostname
+ *        was found.
+ * @param found The address of an integer, set to TRUE if the hostname was numeric, a Unix domain socket
+ *        or cached, and FALSE if not.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Resolve_Generation
+ */
+int Log_UDP_Resolve_Cache_Get(const char *hostname,int port_number,struct sockaddr_storage *address,
+			      socklen_t *address_length,int *found)
+{
+	struct Resolve_Entry_Struct *entry = NULL;
+
+	if((hostname == NULL)||(address == NULL)||(address_length == NULL)||(found == NULL))
+	{
+		Log_Error_Number = 1103;
+		sprintf(Log_Error_String,"Log_UDP_Resolve_Cache_Get:NULL argument.");
+		return FALSE;
+	}
+	(*found) = FALSE;
+	if(strncmp(hostname,LOG_UDP_RESOLVE_UNIX_PREFIX,strlen(LOG_UDP_RESOLVE_UNIX_PREFIX)) == 0)
+		(*found) = Resolve_Unix(hostname,address,address_length);
+	else if(Resolve_Numeric(hostname,address,address_length))
+		(*found) = TRUE;
+	else
+	{
+		pthread_mutex_lock(&Resolve_Mutex);
+		entry = Resolve_Entry_Find(hostname);
+		if(entry != NULL)
+		{
+			(*address) = entry->Address;
+			(*address_length) = entry->Address_Length;
+			entry->Last_Used_Ms = Resolve_Monotonic_Ms();
+			(*found) = TRUE;
+		}
+		pthread_mutex_unlock(&Resolve_Mutex);
+	}
+	if(*found)
+		Resolve_Port_Set(address,port_number);
+	return TRUE;
+}
+
+/**
+ * Set the length of time cached addresses are used before they are re-resolved. Cached addresses that would
+ * now live longer than ttl are re-resolved sooner.
+ * @param ttl The time to live in seconds, at least 1.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Resolve_TTL
+ */
+int Log_UDP_Resolve_TTL_Set(int ttl)
+{
+	int64_t expiry_ms;
+	int i;
+
+	if(ttl < 1)
+	{
+		Log_Error_Number = 1104;
+		sprintf(Log_Error_String,"Log_UDP_Resolve_TTL_Set:Illegal time to live %d.",ttl);
+		return FALSE;
+	}
+	pthread_mutex_lock(&Resolve_Mutex);
+	Resolve_TTL = ttl;
+	expiry_ms = Resolve_Monotonic_Ms()+(((int64_t)ttl)*ONE_SECOND_MS);
+	for(i = 0; i < RESOLVE_CACHE_LENGTH; i++)
+	{
+		if(Resolve_Cache[i].In_Use && (Resolve_Cache[i].Expiry_Ms > expiry_ms))
+			Resolve_Cache[i].Expiry_Ms = expiry_ms;
+	}
+	pthread_mutex_unlock(&Resolve_Mutex);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Convert a numeric IPv4 or IPv6 address. This never does a lookup.
+ * @param hostname The hostname.
+ * @param address The address of a socket address structure, filled in if hostname is numeric.
+ * @param address_length The address of a socklen_t, filled in if hostname is numeric.
+ * @return The routine returns TRUE if hostname was numeric, and FALSE if it was not.
+ */
+static int Resolve_Numeric(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length)
+{
+	struct addrinfo hints;
+	struct addrinfo *result = NULL;
+
+	memset(&hints,0,sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_NUMERICHOST;
+	if(getaddrinfo(hostname,NULL,&hints,&result) != 0)
+		return FALSE;
+	if((result == NULL)||(result->ai_addrlen > sizeof(struct sockaddr_storage)))
+	{
+		if(result != NULL)
+			freeaddrinfo(result);
+		return FALSE;
+	}
+	memset(address,0,sizeof(struct sockaddr_storage));
+	memcpy(address,result->ai_addr,result->ai_addrlen);
+	(*address_length) = result->ai_addrlen;
+	freeaddrinfo(result);
+	return TRUE;
+}
+
+/**
+ * Convert a hostname of the form "unix:/path" into a Unix domain socket address. This never does a lookup.
+ * @param hostname The hostname, starting with LOG_UDP_RESOLVE_UNIX_PREFIX.
+ * @param address The address of a socket address structure, filled in with the socket address.
+ * @param address_length The address of a socklen_t, filled in with the length of the address used.
+ * @return The routine returns TRUE on success, and FALSE if the path is empty or too long.
+ * @see #LOG_UDP_RESOLVE_UNIX_PREFIX
+ */
+static int Resolve_Unix(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length)
+{
+	struct sockaddr_un *address_un = NULL;
+	const char *path = NULL;
+
+	path = hostname+strlen(LOG_UDP_RESOLVE_UNIX_PREFIX);
+	address_un = (struct sockaddr_un *)address;
+	if((strlen(path) == 0)||(strlen(path) >= sizeof(address_un->sun_path)))
+		return FALSE;
+	memset(address,0,sizeof(struct sockaddr_storage));
+	address_un->sun_family = AF_UNIX;
+	strcpy(address_un->sun_path,path);
+	(*address_length) = (socklen_t)(offsetof(struct sockaddr_un,sun_path)+strlen(path)+1);
+	return TRUE;
+}
+
+/**
+ * Resolve a hostname using getaddrinfo, which may block while a DNS server is queried. The first address
+ * returned is used: getaddrinfo sorts them into the order they should be tried in, and only returns IPv6
+ * (or IPv4) addresses if this machine has an IPv6 (or IPv4) address configured.
+ * This routine does not set Log_Error_Number, as it is also called by the resolver thread.
+ * @param hostname The hostname.
+ * @param address The address of a socket address structure, filled in with the address, with a port number of 0.
+ * @param address_length The address of a socklen_t, filled in with the length of the address.
+ * @return The routine returns 0 on success, and a getaddrinfo error code (EAI_*) on failure.
+ */
+static int Resolve_Lookup(const char *hostname,struct sockaddr_storage *address,socklen_t *address_length)
+{
+	struct addrinfo hints;
+	struct addrinfo *result = NULL;
+	int retval;
+
+	memset(&hints,0,sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_DGRAM;
+	hints.ai_flags = AI_ADDRCONFIG;
+	retval = getaddrinfo(hostname,NULL,&hints,&result);
+	if(retval != 0)
+		return retval;
+	if((result == NULL)||(result->ai_addrlen > sizeof(struct sockaddr_storage)))
+	{
+		if(result != NULL)
+			freeaddrinfo(result);
+		return EAI_FAIL;
+	}
+	memset(address,0,sizeof(struct sockaddr_storage));
+	memcpy(address,result->ai_addr,result->ai_addrlen);
+	(*address_length) = result->ai_addrlen;
+	freeaddrinfo(result);
+	Resolve_Port_Set(address,0);
+	return 0;
+}
+
+/**
+ * Find a hostname in the cache. Resolve_Mutex must be locked.
+ * @param hostname The hostname.
+ * @return The cache entry, or NULL if the hostname is not cached.
+ * @see #Resolve_Cache
+ */
+static struct Resolve_Entry_Struct *Resolve_Entry_Find(const char *hostname)
+{
+	int i;
+
+	for(i = 0; i < RESOLVE_CACHE_LENGTH; i++)
+	{
+		if(Resolve_Cache[i].In_Use && (strcmp(Resolve_Cache[i].Hostname,hostname) == 0))
+			return &(Resolve_Cache[i]);
+	}
+	return NULL;
+}
+
+/**
+ * Add a hostname to the cache, replacing the least recently used entry if the cache is full.
+ * Resolve_Mutex must be locked.
+ * @param hostname The hostname, shorter than LOG_UDP_RESOLVE_HOSTNAME_LENGTH.
+ * @param address The address the hostname resolved to.
+ * @param address_length The length of address in bytes.
+ * @param now_ms The current monotonic time in milliseconds.
+ * @see #Resolve_Cache
+ * @see #Resolve_TTL
+ */
+static void Resolve_Entry_Insert(const char *hostname,struct sockaddr_storage *address,socklen_t address_length,
+				 int64_t now_ms)
+{
+	struct Resolve_Entry_Struct *entry = NULL;
+	int i;
+
+	for(i = 0; i < RESOLVE_CACHE_LENGTH; i++)
+	{
+		if(!Resolve_Cache[i].In_Use)
+		{
+			entry = &(Resolve_Cache[i]);
+			break;
+		}
+		if((entry == NULL)||(Resolve_Cache[i].Last_Used_Ms < entry->Last_Used_Ms))
+			entry = &(Resolve_Cache[i]);
+	}
+	entry->In_Use = TRUE;
+	strcpy(entry->Hostname,hostname);
+	entry->Address = (*address);
+	entry->Address_Length = address_length;
+	Resolve_Port_Set(&(entry->Address),0);
+	entry->Expiry_Ms = now_ms+(((int64_t)Resolve_TTL)*ONE_SECOND_MS);
+	entry->Last_Used_Ms = now_ms;
+	entry->Failure_Count = 0;
+}
+
+/**
+ * Set the port number of an IPv4 or IPv6 address.
+ * @param address The address.
+ * @param port_number The port number in host (normal) byte order.
+ */
+static void Resolve_Port_Set(struct sockaddr_storage *address,int port_number)
+{
+	if(address->ss_family == AF_INET)
+		((struct sockaddr_in *)address)->sin_port = htons((unsigned short)port_number);
+	else if(address->ss_family == AF_INET6)
+		((struct sockaddr_in6 *)address)->sin6_port = htons((unsigned short)port_number);
+}
+
+/**
+ * The resolver thread. Every RESOLVE_WAIT_MS milliseconds it re-resolves each cached hostname whose time
+ * to live has passed, one at a time and without holding Resolve_Mutex during the lookup, so callers are never
+ * held up. A failed lookup keeps the old address, and is retried after RESOLVE_RETRY_MS milliseconds.
+ * @param user_arg The cache, Resolve_Cache.
+ * @return Never returns.
+ * @see #Resolve_Cache
+ * @see #Resolve_Lookup
+ * @see #Log_UDP_Resolve_Generation
+ */
+static void *Resolve_Thread(void *user_arg)
+{
+	struct Resolve_Entry_Struct *cache = (struct Resolve_Entry_Struct *)user_arg;
+	struct Resolve_Entry_Struct *entry = NULL;
+	struct sockaddr_storage address;
+	struct timespec sleep_time;
+	char hostname[LOG_UDP_RESOLVE_HOSTNAME_LENGTH];
+	socklen_t address_length;
+	int64_t now_ms;
+	int gai_retval,i;
+
+	while(TRUE)
+	{
+		sleep_time.tv_sec = RESOLVE_WAIT_MS/ONE_SECOND_MS;
+		sleep_time.tv_nsec = (RESOLVE_WAIT_MS%ONE_SECOND_MS)*ONE_MILLISECOND_NS;
+		nanosleep(&sleep_time,NULL);
+		do
+		{
+			/* find the next hostname to re-resolve */
+			hostname[0] = '\0';
+			now_ms = Resolve_Monotonic_Ms();
+			pthread_mutex_lock(&Resolve_Mutex);
+			for(i = 0; i < RESOLVE_CACHE_LENGTH; i++)
+			{
+				if(cache[i].In_Use && (cache[i].Expiry_Ms <= now_ms))
+				{
+					strcpy(hostname,cache[i].Hostname);
+					/* if the lookup fails, try again later */
+					cache[i].Expiry_Ms = now_ms+RESOLVE_RETRY_MS;
+					break;
+				}
+			}
+			pthread_mutex_unlock(&Resolve_Mutex);
+			if(hostname[0] == '\0')
+				break;
+			gai_retval = Resolve_Lookup(hostname,&address,&address_length);
+#if DEBUG > 1
+			fprintf(stdout,"Resolve_Thread:Re-resolved %s:%d.\n",hostname,gai_retval);
+#endif
+			pthread_mutex_lock(&Resolve_Mutex);
+			/* the entry may have been replaced while it was being resolved */
+			entry = Resolve_Entry_Find(hostname);
+			if(entry != NULL)
+			{
+				if(gai_retval == 0)
+				{
+					if((address_length != entry->Address_Length)||
+					   (memcmp(&address,&(entry->Address),address_length) != 0))
+					{
+						entry->Address = address;
+						entry->Address_Length = address_length;
+						Log_UDP_Resolve_Generation++;
+					}
+					entry->Expiry_Ms = Resolve_Monotonic_Ms()+(((int64_t)Resolve_TTL)*ONE_SECOND_MS);
+					entry->Failure_Count = 0;
+				}
+				else
+					entry->Failure_Count++;
+			}
+			pthread_mutex_unlock(&Resolve_Mutex);
+		} while(hostname[0] != '\0');
+	}
+	return NULL;
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Resolve_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,849 @@
+/* log_udp_ring.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Shared memory ring transport for same-host producers. The highest-rate local producers can write their
+ * encoded packets into a ring in a shared memory file (normally in /dev/shm), rather than making a send
+ * system call per packet. A local relay reads the packets out of the ring and forwards them over UDP.
+ * <p>
+ * The file starts with a header holding the write position, the read position and the shared counters
+ * (each on it's own cache line), followed by a data area whose length is a power of two. Records are
+ * variable length and eight byte aligned:
+ * <ul>
+ * <li>A four byte record word: the packet length, with RING_RECORD_CLAIMED set once a writer has reserved
+ *     the record, and RING_RECORD_COMMITTED set once the packet has been copied in.</li>
+ * <li>The packet.</li>
+ * </ul>
+ * A record never wraps round the end of the data area: a writer that would wrap fills the rest of the data
+ * area with a padding record (RING_RECORD_PADDING) and writes it's record at the start.
+ * <p>
+ * Any number of processes and threads may write to a ring. A writer reserves space by advancing the write
+ * position with a compare and swap, copies it's packet in and sets the record word, so writing takes no
+ * locks and no system calls. A packet that doesn't fit in the free space is dropped and counted, a writer
+ * never waits for the reader. Only one process (the relay) may read from a ring. The reader consumes
+ * records in order, zeroing each one before advancing the read position. When the ring is empty the reader
+ * sleeps on a futex in the header, and the next writer wakes it: writers only make the wake system call
+ * when the reader is actually asleep.
+ * <p>
+ * A writer that dies between reserving a record and committing it would stop the reader for good, so a
+ * record that stays uncommitted for longer than the stall timeout is skipped. A writer that dies in the few
+ * instructions between reserving space and claiming it leaves a zero record word, with no length. The
+ * reader notes the write position when it starts waiting: by the end of the stall timeout every record
+ * reserved before then has had it's record word set by a live writer, so the abandoned space ends at the
+ * first non-zero record word after it (or at the noted write position, or the end of the data area).
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1-2001 prototypes,
+ * including clock_gettime, nanosleep and ftruncate.
+ */
+#define _POSIX_C_SOURCE 200112L
+#ifdef __linux
+/**
+ * Define GNU Source to get the syscall prototype under Linux, used to call futex.
+ */
+#define _GNU_SOURCE (1)
+#endif
+#include <errno.h>   /* Error number definitions */
+#include <fcntl.h>   /* File control definitions */
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_ring.h"
+
+/* hash defines */
+/**
+ * The magic word at the start of a ring file ("LUDR").
+ */
+#define RING_MAGIC                    (0x4C554452)
+/**
+ * The version of the ring file layout.
+ */
+#define RING_VERSION                  (1)
+/**
+ * The length of a cache line. The write position and the read position are kept on different
+ * cache lines, so writers and the reader don't slow each other down.
+ */
+#define RING_CACHE_LINE_LENGTH        (64)
+/**
+ * The length of the ring file header, the data area starts this far into the file.
+ */
+#define RING_HEADER_LENGTH            (4*RING_CACHE_LINE_LENGTH)
+/**
+ * The length of the record word at the start of each record.
+ */
+#define RING_RECORD_HEADER_LENGTH     (4)
+/**
+ * Records start on a multiple of this many bytes.
+ */
+#define RING_RECORD_ALIGNMENT         (8)
+/**
+ * Record word bit, set when the record's packet has been copied in.
+ */
+#define RING_RECORD_COMMITTED         (0x80000000U)
+/**
+ * Record word bit, set when the record fills the end of the data area and holds no packet.
+ */
+#define RING_RECORD_PADDING           (0x40000000U)
+/**
+ * Record word bit, set when a writer has reserved the record.
+ */
+#define RING_RECORD_CLAIMED           (0x20000000U)
+/**
+ * The record word bits holding the packet (or padding) length.
+ */
+#define RING_RECORD_LENGTH_MASK       (0x1FFFFFFFU)
+/**
+ * How long the reader sleeps while waiting for a writer to commit a record, in nanoseconds.
+ */
+#define RING_COMMIT_POLL_NS           (50000)
+/**
+ * How long the reader sleeps when the ring is empty on systems without futexes, in nanoseconds.
+ */
+#define RING_EMPTY_POLL_NS            (1000000)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                 (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS            (1000000)
+/**
+ * Round a length up to a multiple of RING_RECORD_ALIGNMENT.
+ */
+#define RING_ALIGN(l)                 ((((uint64_t)(l))+RING_RECORD_ALIGNMENT-1)& \
+				       (~((uint64_t)(RING_RECORD_ALIGNMENT-1))))
+
+/* structures */
+/**
+ * The header at the start of a ring file, shared between every process using the ring.
+ * <dl>
+ * <dt>Magic</dt> <dd>RING_MAGIC, written last when the ring is created.</dd>
+ * <dt>Version</dt> <dd>RING_VERSION.</dd>
+ * <dt>Data_Length</dt> <dd>The length of the data area in bytes, a power of two.</dd>
+ * <dt>Write_Position</dt> <dd>The number of bytes of records reserved by writers since the ring was created.</dd>
+ * <dt>Write_Count</dt> <dd>The number of packets written.</dd>
+ * <dt>Drop_Count</dt> <dd>The number of packets dropped because the ring was full.</dd>
+ * <dt>Wake_Count</dt> <dd>The number of times a writer woke the reader.</dd>
+ * <dt>Read_Position</dt> <dd>The number of bytes of records consumed by the reader since the ring was
+ *     created. The data area between Read_Position and Write_Position holds records.</dd>
+ * <dt>Reader_Waiting</dt> <dd>The futex word, set to 1 when the reader is about to sleep on an empty ring.</dd>
+ * <dt>Read_Count</dt> <dd>The number of packets read.</dd>
+ * <dt>Abandoned_Count</dt> <dd>The number of records skipped because their writer never committed them.</dd>
+ * </dl>
+ * @see #RING_MAGIC
+ * @see #RING_VERSION
+ * @see #RING_CACHE_LINE_LENGTH
+ */
+struct Ring_Header_Struct
+{
+	unsigned int Magic;
+	unsigned int Version;
+	uint64_t Data_Length;
+	volatile uint64_t Write_Position __attribute__((aligned(RING_CACHE_LINE_LENGTH)));
+	volatile uint64_t Write_Count;
+	volatile uint64_t Drop_Count;
+	volatile uint64_t Wake_Count;
+	volatile uint64_t Read_Position __attribute__((aligned(RING_CACHE_LINE_LENGTH)));
+	volatile int Reader_Waiting;
+	volatile uint64_t Read_Count;
+	volatile uint64_t Abandoned_Count;
+};
+
+/**
+ * A ring, as mapped by one process.
+ * <dl>
+ * <dt>Memory</dt> <dd>The mapped ring file.</dd>
+ * <dt>Memory_Length</dt> <dd>The length of the mapping in bytes.</dd>
+ * <dt>Header</dt> <dd>The ring header, at the start of Memory.</dd>
+ * <dt>Data</dt> <dd>The data area, RING_HEADER_LENGTH bytes into Memory.</dd>
+ * <dt>Data_Length</dt> <dd>The length of the data area in bytes, a power of two.</dd>
+ * <dt>Record_Length_Max</dt> <dd>The longest packet that can be written to the ring.</dd>
+ * <dt>Held_Length</dt> <dd>The length of the record last returned by Log_UDP_Ring_Read, consumed on
+ *     the next call.</dd>
+ * <dt>Stall_Timeout_Ms</dt> <dd>How long the reader waits for a reserved record to be committed.</dd>
+ * <dt>Stall_Start_Ms</dt> <dd>The monotonic time the reader started waiting for the record at the read
+ *     position to be committed, or zero.</dd>
+ * <dt>Stall_Write_Position</dt> <dd>The write position when the reader started waiting. Only records
+ *     reserved before this are skipped as abandoned.</dd>
+ * </dl>
+ */
+struct Log_UDP_Ring_Struct
+{
+	char *Memory;
+	size_t Memory_Length;
+	struct Ring_Header_Struct *Header;
+	char *Data;
+	uint64_t Data_Length;
+	size_t Record_Length_Max;
+	uint64_t Held_Length;
+	int Stall_Timeout_Ms;
+	int64_t Stall_Start_Ms;
+	uint64_t Stall_Write_Position;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static int Ring_Path_Get(const char *name,char *path);
+static int Ring_Lock(int file_id,int lock_type);
+static void Ring_Consume(Log_UDP_Ring_T ring,uint64_t read_position,uint64_t length);
+static uint64_t Ring_Abandoned_Length(Log_UDP_Ring_T ring,uint64_t read_position);
+static void Ring_Reader_Wait(Log_UDP_Ring_T ring,int64_t end_ms);
+static void Ring_Reader_Wake(Log_UDP_Ring_T ring);
+static void Ring_Sleep_Ns(long sleep_ns);
+static int64_t Ring_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Open a ring, creating the ring file if it doesn't exist. Writers and the reader all open the ring this
+ * way, so either can be started first, and a restarted relay carries on from where the last one stopped.
+ * The ring file is locked while it is created, so two processes opening a new ring at once agree on it's
+ * size.
+ * @param name The ring name. Names starting with '/' are used as the ring file's path, other names are
+ *        created in LOG_UDP_RING_DIRECTORY.
+ * @param data_length The length of the data area to create, rounded up to a power of two, between
+ *        LOG_UDP_RING_DATA_LENGTH_MIN and LOG_UDP_RING_DATA_LENGTH_MAX. Zero uses
+ *        LOG_UDP_RING_DEFAULT_DATA_LENGTH. Ignored if the ring already exists.
+ * @param ring The address of a Log_UDP_Ring_T to fill in with the opened ring.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Ring_Path_Get
+ * @see #Ring_Lock
+ * @see #RING_HEADER_LENGTH
+ * @see #LOG_UDP_RING_DEFAULT_DATA_LENGTH
+ */
+int Log_UDP_Ring_Open(const char *name,size_t data_length,Log_UDP_Ring_T *ring)
+{
+	Log_UDP_Ring_T new_ring = NULL;
+	struct Ring_Header_Struct *header = NULL;
+	struct stat file_stat;
+	char path[LOG_UDP_RING_PATH_LENGTH];
+	uint64_t ring_data_length;
+	int file_id,file_errno,created;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Ring_Open(%s,%lu):started.\n",name,data_length);
+#endif
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1300;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:ring was NULL.");
+		return FALSE;
+	}
+	if(data_length == 0)
+		data_length = LOG_UDP_RING_DEFAULT_DATA_LENGTH;
+	if((data_length < LOG_UDP_RING_DATA_LENGTH_MIN)||(data_length > LOG_UDP_RING_DATA_LENGTH_MAX))
+	{
+		Log_Error_Number = 1301;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:Illegal data length %lu.",data_length);
+		return FALSE;
+	}
+	for(ring_data_length = LOG_UDP_RING_DATA_LENGTH_MIN; ring_data_length < data_length;
+	    ring_data_length *= 2)
+		;
+	if(!Ring_Path_Get(name,path))
+		return FALSE;
+	file_id = open(path,O_RDWR|O_CREAT,0666);
+	if(file_id < 0)
+	{
+		file_errno = errno;
+		Log_Error_Number = 1302;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:Failed to open %s (%d:%s).",path,file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	if(!Ring_Lock(file_id,F_WRLCK))
+	{
+		close(file_id);
+		return FALSE;
+	}
+	if(fstat(file_id,&file_stat) < 0)
+	{
+		file_errno = errno;
+		close(file_id);
+		Log_Error_Number = 1303;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:Failed to stat %s (%d:%s).",path,file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	/* a new ring file, size it. The data area is zero filled, so every record word reads as free */
+	created = (file_stat.st_size == 0);
+	if(created)
+	{
+		if(ftruncate(file_id,RING_HEADER_LENGTH+ring_data_length) < 0)
+		{
+			file_errno = errno;
+			close(file_id);
+			Log_Error_Number = 1304;
+			sprintf(Log_Error_String,"Log_UDP_Ring_Open:Failed to size %s to %lu bytes (%d:%s).",path,
+				(unsigned long)(RING_HEADER_LENGTH+ring_data_length),file_errno,strerror(file_errno));
+			return FALSE;
+		}
+		file_stat.st_size = RING_HEADER_LENGTH+ring_data_length;
+	}
+	else if(file_stat.st_size < RING_HEADER_LENGTH+LOG_UDP_RING_DATA_LENGTH_MIN)
+	{
+		close(file_id);
+		Log_Error_Number = 1305;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:%s is too short (%ld bytes) to be a ring.",path,
+			(long)file_stat.st_size);
+		return FALSE;
+	}
+	new_ring = (Log_UDP_Ring_T)calloc(1,sizeof(struct Log_UDP_Ring_Struct));
+	if(new_ring == NULL)
+	{
+		close(file_id);
+		Log_Error_Number = 1306;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:Failed to allocate ring.");
+		return FALSE;
+	}
+	new_ring->Memory_Length = file_stat.st_size;
+	new_ring->Memory = mmap(NULL,new_ring->Memory_Length,PROT_READ|PROT_WRITE,MAP_SHARED,file_id,0);
+	if(new_ring->Memory == MAP_FAILED)
+	{
+		file_errno = errno;
+		close(file_id);
+		free(new_ring);
+		Log_Error_Number = 1307;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:Failed to map %s (%d:%s).",path,file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	header = (struct Ring_Header_Struct *)(new_ring->Memory);
+	if(created)
+	{
+		header->Version = RING_VERSION;
+		header->Data_Length = new_ring->Memory_Length-RING_HEADER_LENGTH;
+		__sync_synchronize();
+		header->Magic = RING_MAGIC;
+	}
+	Ring_Lock(file_id,F_UNLCK);
+	close(file_id);
+	/* check the ring is one we understand */
+	if((header->Magic != RING_MAGIC)||(header->Version != RING_VERSION)||
+	   (header->Data_Length != new_ring->Memory_Length-RING_HEADER_LENGTH)||
+	   ((header->Data_Length&(header->Data_Length-1)) != 0))
+	{
+		munmap(new_ring->Memory,new_ring->Memory_Length);
+		free(new_ring);
+		Log_Error_Number = 1308;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Open:%s is not a version %d ring.",path,RING_VERSION);
+		return FALSE;
+	}
+	new_ring->Header = header;
+	new_ring->Data = new_ring->Memory+RING_HEADER_LENGTH;
+	new_ring->Data_Length = header->Data_Length;
+	/* a quarter of the data area, so one long packet can't fill the ring */
+	new_ring->Record_Length_Max = new_ring->Data_Length/4;
+	new_ring->Held_Length = 0;
+	new_ring->Stall_Timeout_Ms = LOG_UDP_RING_DEFAULT_STALL_TIMEOUT_MS;
+	new_ring->Stall_Start_Ms = 0;
+	new_ring->Stall_Write_Position = 0;
+	(*ring) = new_ring;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Ring_Open(%s):finished with data length %lu.\n",path,
+		(unsigned long)new_ring->Data_Length);
+#endif
+	return TRUE;
+}
+
+/**
+ * Write a packet to a ring. The packet is copied into the ring without taking a lock or making a system
+ * call, unless the reader is asleep waiting for a packet, when it is woken. If the ring doesn't have
+ * room for the packet it is dropped: the routine returns TRUE with dropped set, and the ring's drop
+ * counter is incremented. Any number of threads and processes may write to a ring at once.
+ * @param ring The ring, opened with Log_UDP_Ring_Open.
+ * @param message_buffer The packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dropped The address of an integer, set to TRUE if the packet was dropped because the ring was full
+ *        and FALSE if it was written. Can be NULL.
+ * @return The routine returns TRUE if the packet was written or dropped, and FALSE if it could never
+ *         be written (it is longer than a quarter of the ring).
+ * @see #Ring_Reader_Wake
+ * @see #RING_ALIGN
+ */
+int Log_UDP_Ring_Write(Log_UDP_Ring_T ring,const char *message_buffer,size_t message_buffer_length,
+		       int *dropped)
+{
+	struct Ring_Header_Struct *header = NULL;
+	uint64_t write_position,read_position,offset,contiguous_length,record_length,reserve_length;
+	volatile unsigned int *record_word = NULL;
+
+	if(dropped != NULL)
+		(*dropped) = FALSE;
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1309;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Write:ring was NULL.");
+		return FALSE;
+	}
+	if(message_buffer == NULL)
+	{
+		Log_Error_Number = 1310;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Write:message_buffer was NULL.");
+		return FALSE;
+	}
+	if(message_buffer_length > ring->Record_Length_Max)
+	{
+		Log_Error_Number = 1311;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Write:Packet of %lu bytes is longer than %lu.",
+			message_buffer_length,ring->Record_Length_Max);
+		return FALSE;
+	}
+	header = ring->Header;
+	record_length = RING_ALIGN(RING_RECORD_HEADER_LENGTH+message_buffer_length);
+	/* reserve space, padding out the end of the data area if the record would wrap */
+	do
+	{
+		write_position = header->Write_Position;
+		read_position = header->Read_Position;
+		offset = write_position&(ring->Data_Length-1);
+		contiguous_length = ring->Data_Length-offset;
+		if(record_length <= contiguous_length)
+			reserve_length = record_length;
+		else
+			reserve_length = contiguous_length+record_length;
+		if((write_position+reserve_length-read_position) > ring->Data_Length)
+		{
+			__sync_fetch_and_add(&(header->Drop_Count),1);
+			if(dropped != NULL)
+				(*dropped) = TRUE;
+			return TRUE;
+		}
+	} while(__sync_val_compare_and_swap(&(header->Write_Position),write_position,
+					    write_position+reserve_length) != write_position);
+	if(reserve_length != record_length)
+	{
+		record_word = (volatile unsigned int *)(ring->Data+offset);
+		(*record_word) = RING_RECORD_COMMITTED|RING_RECORD_PADDING|((unsigned int)contiguous_length);
+		offset = 0;
+	}
+	record_word = (volatile unsigned int *)(ring->Data+offset);
+	(*record_word) = RING_RECORD_CLAIMED|((unsigned int)message_buffer_length);
+	memcpy(ring->Data+offset+RING_RECORD_HEADER_LENGTH,message_buffer,message_buffer_length);
+	/* the packet must be visible before the record word says it is committed */
+	__sync_synchronize();
+	(*record_word) = RING_RECORD_COMMITTED|((unsigned int)message_buffer_length);
+	/* also a full barrier, so the commit is visible before Reader_Waiting is read */
+	__sync_fetch_and_add(&(header->Write_Count),1);
+	if(header->Reader_Waiting)
+		Ring_Reader_Wake(ring);
+	return TRUE;
+}
+
+/**
+ * Read the next packet from a ring. The packet is returned in place, and stays valid until the next call
+ * to Log_UDP_Ring_Read or Log_UDP_Ring_Close, when it's space is handed back to the writers. Only one
+ * thread of one process may read a ring. A record whose writer has reserved it but not committed it
+ * within the stall timeout is skipped and counted as abandoned.
+ * @param ring The ring, opened with Log_UDP_Ring_Open.
+ * @param timeout_ms How long to wait for a packet if the ring is empty, in milliseconds. Zero returns at
+ *        once.
+ * @param message The address of a pointer, set to the packet if one was read.
+ * @param message_length The address of a size_t, set to the length of the packet if one was read.
+ * @param found The address of an integer, set to TRUE if a packet was read and FALSE if the timeout expired.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Ring_Consume
+ * @see #Ring_Reader_Wait
+ * @see #Log_UDP_Ring_Stall_Timeout_Set
+ */
+int Log_UDP_Ring_Read(Log_UDP_Ring_T ring,int timeout_ms,const char **message,size_t *message_length,
+		      int *found)
+{
+	struct Ring_Header_Struct *header = NULL;
+	uint64_t read_position,offset;
+	unsigned int record_word;
+	int64_t end_ms,now_ms;
+
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1312;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Read:ring was NULL.");
+		return FALSE;
+	}
+	if((message == NULL)||(message_length == NULL)||(found == NULL))
+	{
+		Log_Error_Number = 1313;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Read:message, message_length or found was NULL.");
+		return FALSE;
+	}
+	(*found) = FALSE;
+	header = ring->Header;
+	/* hand the last packet read back to the writers */
+	if(ring->Held_Length > 0)
+	{
+		Ring_Consume(ring,header->Read_Position,ring->Held_Length);
+		ring->Held_Length = 0;
+	}
+	end_ms = Ring_Monotonic_Ms()+timeout_ms;
+	while(TRUE)
+	{
+		read_position = header->Read_Position;
+		if(read_position == header->Write_Position)
+		{
+			if(Ring_Monotonic_Ms() >= end_ms)
+				return TRUE;
+			Ring_Reader_Wait(ring,end_ms);
+			continue;
+		}
+		offset = read_position&(ring->Data_Length-1);
+		record_word = *((volatile unsigned int *)(ring->Data+offset));
+		if(record_word&RING_RECORD_COMMITTED)
+		{
+			ring->Stall_Start_Ms = 0;
+			if(record_word&RING_RECORD_PADDING)
+			{
+				Ring_Consume(ring,read_position,record_word&RING_RECORD_LENGTH_MASK);
+				continue;
+			}
+			/* the packet must not be read before the record word */
+			__sync_synchronize();
+			(*message) = ring->Data+offset+RING_RECORD_HEADER_LENGTH;
+			(*message_length) = record_word&RING_RECORD_LENGTH_MASK;
+			ring->Held_Length = RING_ALIGN(RING_RECORD_HEADER_LENGTH+(*message_length));
+			__sync_fetch_and_add(&(header->Read_Count),1);
+			(*found) = TRUE;
+			return TRUE;
+		}
+		/* a writer has reserved the record, but not committed it (or even claimed it) yet */
+		now_ms = Ring_Monotonic_Ms();
+		if(ring->Stall_Start_Ms == 0)
+		{
+			ring->Stall_Start_Ms = now_ms;
+			ring->Stall_Write_Position = header->Write_Position;
+		}
+		else if((now_ms-ring->Stall_Start_Ms) >= ring->Stall_Timeout_Ms)
+		{
+#if DEBUG > 1
+			fprintf(stdout,"Log_UDP_Ring_Read:Skipping record at %llu abandoned by it's writer.\n",
+				(unsigned long long)read_position);
+#endif
+			ring->Stall_Start_Ms = 0;
+			__sync_fetch_and_add(&(header->Abandoned_Count),1);
+			if(record_word&RING_RECORD_CLAIMED)
+			{
+				Ring_Consume(ring,read_position,
+					     RING_ALIGN(RING_RECORD_HEADER_LENGTH+(record_word&RING_RECORD_LENGTH_MASK)));
+			}
+			else
+				Ring_Consume(ring,read_position,Ring_Abandoned_Length(ring,read_position));
+			continue;
+		}
+		if(now_ms >= end_ms)
+			return TRUE;
+		Ring_Sleep_Ns(RING_COMMIT_POLL_NS);
+	}
+}
+
+/**
+ * Set how long the reader waits for a writer to commit a record it has reserved, before deciding the writer
+ * has died and skipping the record.
+ * @param ring The ring, opened with Log_UDP_Ring_Open.
+ * @param timeout_ms The stall timeout in milliseconds, greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_RING_DEFAULT_STALL_TIMEOUT_MS
+ */
+int Log_UDP_Ring_Stall_Timeout_Set(Log_UDP_Ring_T ring,int timeout_ms)
+{
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1314;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Stall_Timeout_Set:ring was NULL.");
+		return FALSE;
+	}
+	if(timeout_ms < 1)
+	{
+		Log_Error_Number = 1315;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Stall_Timeout_Set:Illegal timeout %d.",timeout_ms);
+		return FALSE;
+	}
+	ring->Stall_Timeout_Ms = timeout_ms;
+	return TRUE;
+}
+
+/**
+ * Get a ring's counters. The counters are shared, so they cover every process using the ring.
+ * @param ring The ring, opened with Log_UDP_Ring_Open.
+ * @param stats The address of a structure to fill in with the counters.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Ring_Stats_Get(Log_UDP_Ring_T ring,struct Log_UDP_Ring_Stats_Struct *stats)
+{
+	struct Ring_Header_Struct *header = NULL;
+
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1316;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Stats_Get:ring was NULL.");
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Log_Error_Number = 1317;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	header = ring->Header;
+	stats->Write_Count = (unsigned long)header->Write_Count;
+	stats->Drop_Count = (unsigned long)header->Drop_Count;
+	stats->Read_Count = (unsigned long)header->Read_Count;
+	stats->Abandoned_Count = (unsigned long)header->Abandoned_Count;
+	stats->Wake_Count = (unsigned long)header->Wake_Count;
+	stats->Used_Length = (size_t)(header->Write_Position-header->Read_Position);
+	stats->Data_Length = (size_t)ring->Data_Length;
+	return TRUE;
+}
+
+/**
+ * Close a ring, unmapping it. A packet held by the reader is handed back to the writers first. The ring
+ * file is left in place, so packets still in it are read when the ring is next opened.
+ * @param ring The ring, opened with Log_UDP_Ring_Open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Ring_Consume
+ * @see #Log_UDP_Ring_Unlink
+ */
+int Log_UDP_Ring_Close(Log_UDP_Ring_T ring)
+{
+	if(ring == NULL)
+	{
+		Log_Error_Number = 1318;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Close:ring was NULL.");
+		return FALSE;
+	}
+	if(ring->Held_Length > 0)
+		Ring_Consume(ring,ring->Header->Read_Position,ring->Held_Length);
+	munmap(ring->Memory,ring->Memory_Length);
+	free(ring);
+	return TRUE;
+}
+
+/**
+ * Remove a ring file. Processes that have the ring open carry on using it, but processes opening the ring
+ * afterwards get a new one.
+ * @param name The ring name, as passed to Log_UDP_Ring_Open.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Ring_Path_Get
+ */
+int Log_UDP_Ring_Unlink(const char *name)
+{
+	char path[LOG_UDP_RING_PATH_LENGTH];
+	int file_errno;
+
+	if(!Ring_Path_Get(name,path))
+		return FALSE;
+	if(unlink(path) < 0)
+	{
+		file_errno = errno;
+		Log_Error_Number = 1319;
+		sprintf(Log_Error_String,"Log_UDP_Ring_Unlink:Failed to remove %s (%d:%s).",path,file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Get the path of a ring file from the ring name.
+ * @param name The ring name. Names starting with '/' are used as the path, other names are prefixed
+ *        with LOG_UDP_RING_DIRECTORY.
+ * @param path A buffer of LOG_UDP_RING_PATH_LENGTH characters, filled in with the path.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_RING_DIRECTORY
+ */
+static int Ring_Path_Get(const char *name,char *path)
+{
+	if((name == NULL)||(name[0] == '\0'))
+	{
+		Log_Error_Number = 1320;
+		sprintf(Log_Error_String,"Ring_Path_Get:name was NULL or empty.");
+		return FALSE;
+	}
+	if((strlen(LOG_UDP_RING_DIRECTORY)+strlen(name)) >= LOG_UDP_RING_PATH_LENGTH)
+	{
+		Log_Error_Number = 1321;
+		sprintf(Log_Error_String,"Ring_Path_Get:name '%.80s' is too long.",name);
+		return FALSE;
+	}
+	if(name[0] == '/')
+		strcpy(path,name);
+	else
+		sprintf(path,"%s%s",LOG_UDP_RING_DIRECTORY,name);
+	return TRUE;
+}
+
+/**
+ * Lock or unlock the whole of a ring file, waiting for the lock.
+ * @param file_id The open ring file.
+ * @param lock_type F_WRLCK to lock the file, F_UNLCK to unlock it.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Ring_Lock(int file_id,int lock_type)
+{
+	struct flock lock;
+	int file_errno;
+
+	memset(&lock,0,sizeof(lock));
+	lock.l_type = lock_type;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = 0;
+	lock.l_len = 0;
+	while(fcntl(file_id,F_SETLKW,&lock) < 0)
+	{
+		if(errno == EINTR)
+			continue;
+		file_errno = errno;
+		Log_Error_Number = 1322;
+		sprintf(Log_Error_String,"Ring_Lock:Failed to lock ring file (%d:%s).",file_errno,
+			strerror(file_errno));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Consume records at the read position, zeroing them so their record words read as free when the space
+ * is reused, then advancing the read position.
+ * @param ring The ring.
+ * @param read_position The read position.
+ * @param length The length of the records to consume, in bytes. The records never wrap round the end of
+ *        the data area.
+ */
+static void Ring_Consume(Log_UDP_Ring_T ring,uint64_t read_position,uint64_t length)
+{
+	memset(ring->Data+(read_position&(ring->Data_Length-1)),0,length);
+	/* the zeroed records must be visible before writers can reserve them */
+	__sync_synchronize();
+	ring->Header->Read_Position = read_position+length;
+}
+
+/**
+ * Find the length of space abandoned by a writer that died before setting it's record word. Consumed space
+ * is zeroed, so the abandoned space is zero up to the next record word. Every record reserved before
+ * Stall_Write_Position has had the stall timeout to set it's record word, so the first non-zero record
+ * word before then starts the next record. The abandoned space may also end at Stall_Write_Position, or
+ * (if the writer was going to pad out the data area) at the end of the data area.
+ * @param ring The ring.
+ * @param read_position The read position, where the zero record word is.
+ * @return The length of the abandoned space in bytes, a multiple of RING_RECORD_ALIGNMENT.
+ * @see #Log_UDP_Ring_Struct
+ */
+static uint64_t Ring_Abandoned_Length(Log_UDP_Ring_T ring,uint64_t read_position)
+{
+	uint64_t offset,end_offset,position;
+
+	offset = read_position&(ring->Data_Length-1);
+	end_offset = ring->Data_Length;
+	if((ring->Stall_Write_Position-read_position) < (end_offset-offset))
+		end_offset = offset+(ring->Stall_Write_Position-read_position);
+	for(position = offset+RING_RECORD_ALIGNMENT; position < end_offset; position += RING_RECORD_ALIGNMENT)
+	{
+		if(*((volatile unsigned int *)(ring->Data+position)) != 0)
+			break;
+	}
+	return position-offset;
+}
+
+/**
+ * Sleep until a writer wakes the reader, or end_ms. The reader sets the futex word, then checks the ring
+ * is still empty, so a writer that commits a record in between either sees the word set and wakes the
+ * reader, or the reader sees the record. Systems without futexes poll.
+ * @param ring The ring.
+ * @param end_ms The monotonic time in milliseconds to wait until.
+ * @see #Ring_Reader_Wake
+ */
+static void Ring_Reader_Wait(Log_UDP_Ring_T ring,int64_t end_ms)
+{
+	struct Ring_Header_Struct *header = ring->Header;
+#ifdef __linux
+	struct timespec timeout;
+	int64_t wait_ms;
+
+	wait_ms = end_ms-Ring_Monotonic_Ms();
+	if(wait_ms <= 0)
+		return;
+	/* also a full barrier, so the flag is visible before the positions are read */
+	__sync_val_compare_and_swap(&(header->Reader_Waiting),0,1);
+	if(header->Read_Position == header->Write_Position)
+	{
+		timeout.tv_sec = wait_ms/ONE_SECOND_MS;
+		timeout.tv_nsec = (wait_ms%ONE_SECOND_MS)*ONE_MILLISECOND_NS;
+		syscall(SYS_futex,&(header->Reader_Waiting),FUTEX_WAIT,1,&timeout,NULL,0);
+	}
+	header->Reader_Waiting = 0;
+#else
+	if(header->Read_Position == header->Write_Position)
+		Ring_Sleep_Ns(RING_EMPTY_POLL_NS);
+#endif
+}
+
+/**
+ * Wake the reader if it is asleep on the futex. Only the writer that clears the futex word makes the
+ * wake system call.
+ * @param ring The ring.
+ * @see #Ring_Reader_Wait
+ */
+static void Ring_Reader_Wake(Log_UDP_Ring_T ring)
+{
+#ifdef __linux
+	struct Ring_Header_Struct *header = ring->Header;
+
+	if(__sync_bool_compare_and_swap(&(header->Reader_Waiting),1,0))
+	{
+		syscall(SYS_futex,&(header->Reader_Waiting),FUTEX_WAKE,1,NULL,NULL,0);
+		__sync_fetch_and_add(&(header->Wake_Count),1);
+	}
+#endif
+}
+
+/**
+ * Sleep for a number of nanoseconds.
+ * @param sleep_ns The time to sleep, less than one second.
+ */
+static void Ring_Sleep_Ns(long sleep_ns)
+{
+	struct timespec sleep_time;
+
+	sleep_time.tv_sec = 0;
+	sleep_time.tv_nsec = sleep_ns;
+	nanosleep(&sleep_time,NULL);
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ */
+static int64_t Ring_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,889 @@
+/* log_udp_stream.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Stream transport, for log records that must not be dropped (error records, audit trails). The same
+ * encoded packets the UDP routines send are written over a stream (TCP) connection, each in a frame:
+ * <ul>
+ * <li>The packet length, LOG_UDP_STREAM_FRAME_HEADER_LENGTH bytes in network byte order.</li>
+ * <li>The packet.</li>
+ * </ul>
+ * The receiver acknowledges the frames it has received by sending back the number received over the
+ * connection so far, LOG_UDP_STREAM_ACK_LENGTH bytes in network byte order (modulo 2^32).
+ * <p>
+ * Log_UDP_Stream_Write only copies the frame into a circular buffer, it never makes a system call or
+ * waits for the connection. A writer thread writes the buffered frames with one sendmsg call (a writev,
+ * that doesn't raise SIGPIPE) per batch: it waits for the flush interval after the first frame of a batch
+ * is buffered, or until a quarter of the buffer (at most STREAM_FLUSH_LENGTH bytes) is buffered, whichever
+ * is sooner. The writer thread also makes the connection, in the background, and reconnects with an
+ * increasing delay when it is lost. Frames are buffered while the stream is disconnected, and only dropped
+ * (and counted) when the buffer is full.
+ * <p>
+ * A frame is only removed from the buffer once the receiver has acknowledged it. When a connection is lost,
+ * every frame not yet acknowledged is written again, from the start of the oldest, over the next connection.
+ * Frames the kernel had accepted but the receiver never read are not lost, and the receiver (which discards
+ * a partial frame when a connection closes) never sees a frame split across connections. A frame the
+ * receiver read but hadn't acknowledged when the connection was lost is received twice.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.1-2008 prototypes,
+ * including MSG_NOSIGNAL, threads and clock_gettime.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>   /* Error number definitions */
+#include <fcntl.h>   /* File control definitions */
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h> /* TCP_NODELAY */
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h> /* struct iovec */
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_resolve.h"
+#include "log_udp_stream.h"
+
+/* hash defines */
+/**
+ * The most bytes buffered before the writer thread writes them without waiting for the flush interval.
+ */
+#define STREAM_FLUSH_LENGTH             (64*1024)
+/**
+ * How long the writer thread waits for a connection to be made, in milliseconds.
+ */
+#define STREAM_CONNECT_TIMEOUT_MS       (1000)
+/**
+ * How long a write to the connection can block, in milliseconds, so a stalled receiver doesn't stop
+ * the writer thread noticing the stream is being closed.
+ */
+#define STREAM_SEND_TIMEOUT_MS          (1000)
+/**
+ * How long the writer thread waits for an acknowledgement when every buffered frame has been written, in
+ * milliseconds. Frames buffered meanwhile wait at most this long to be written.
+ */
+#define STREAM_ACK_WAIT_MS              (1)
+/**
+ * The delay before the first reconnection attempt, in milliseconds. The delay doubles after each
+ * failed attempt.
+ */
+#define STREAM_RECONNECT_DELAY_MIN_MS   (100)
+/**
+ * The longest delay between reconnection attempts, in milliseconds.
+ */
+#define STREAM_RECONNECT_DELAY_MAX_MS   (5000)
+/**
+ * The maximum length of time the writer thread sleeps (in milliseconds) when nothing is buffered,
+ * before re-checking, in case a wake up signal was missed.
+ */
+#define STREAM_IDLE_WAIT_MS             (100)
+/**
+ * The maximum length of time Log_UDP_Stream_Flush sleeps (in milliseconds) before re-checking,
+ * in case a wake up signal was missed.
+ */
+#define PROGRESS_WAIT_MS                (10)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+/**
+ * The number of microseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_US              (1000)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                   (1000000000)
+
+/* structures */
+/**
+ * Data for one stream. Everything but Hostname, Port_Number, Buffer_Length, Flush_Length and
+ * Flush_Interval_Ms (which don't change), and Ack_Count, Ack_Buffer and Ack_Length (which only the writer
+ * thread uses) is protected by Mutex. The bytes of Buffer between Tail and Head are only read by the writer
+ * thread, which can do so without the mutex, as Log_UDP_Stream_Write only writes outside them.
+ * <dl>
+ * <dt>Hostname</dt> <dd>The hostname to connect to.</dd>
+ * <dt>Port_Number</dt> <dd>The port number to connect to.</dd>
+ * <dt>Socket_Id</dt> <dd>The connected socket, or -1 when the stream is disconnected.</dd>
+ * <dt>Buffer</dt> <dd>The circular buffer of frames waiting to be written.</dd>
+ * <dt>Buffer_Length</dt> <dd>The length of Buffer in bytes.</dd>
+ * <dt>Head</dt> <dd>The offset in Buffer the next frame is copied to.</dd>
+ * <dt>Tail</dt> <dd>The offset in Buffer of the oldest frame not acknowledged by the receiver.</dd>
+ * <dt>Used_Length</dt> <dd>The number of bytes of Buffer holding frames.</dd>
+ * <dt>Sent_Offset</dt> <dd>The number of bytes from Tail written over the current connection, but not
+ *     acknowledged.</dd>
+ * <dt>Ack_Count</dt> <dd>The last frame count the receiver acknowledged over the current connection.</dd>
+ * <dt>Ack_Buffer</dt> <dd>The bytes of an acknowledgement received so far.</dd>
+ * <dt>Ack_Length</dt> <dd>The number of bytes in Ack_Buffer.</dd>
+ * <dt>Flush_Length</dt> <dd>The number of buffered bytes that are written without waiting for the flush
+ *     interval.</dd>
+ * <dt>Flush_Interval_Ms</dt> <dd>How long the first frame of a batch waits for others, in milliseconds.</dd>
+ * <dt>Reconnect_Delay_Ms</dt> <dd>The delay before the next reconnection attempt, in milliseconds.</dd>
+ * <dt>Flusher_Count</dt> <dd>The number of threads in Log_UDP_Stream_Flush. The writer thread writes at
+ *     once, without waiting for the flush interval, when this is non-zero.</dd>
+ * <dt>Stats</dt> <dd>The stream counters. Buffered_Length and Connected are filled in when they are
+ *     read.</dd>
+ * <dt>Quit</dt> <dd>Set to make the writer thread exit.</dd>
+ * <dt>Writer_Thread</dt> <dd>The writer thread.</dd>
+ * <dt>Mutex</dt> <dd>Mutex protecting the buffer offsets and counters.</dd>
+ * <dt>Writer_Condition</dt> <dd>Signalled to wake the writer thread.</dd>
+ * <dt>Progress_Condition</dt> <dd>Broadcast by the writer thread when frames have been written.</dd>
+ * </dl>
+ * @see #STREAM_FLUSH_LENGTH
+ */
+struct Log_UDP_Stream_Struct
+{
+	char Hostname[LOG_UDP_RESOLVE_HOSTNAME_LENGTH];
+	int Port_Number;
+	int Socket_Id;
+	char *Buffer;
+	size_t Buffer_Length;
+	size_t Head;
+	size_t Tail;
+	size_t Used_Length;
+	size_t Sent_Offset;
+	uint32_t Ack_Count;
+	unsigned char Ack_Buffer[LOG_UDP_STREAM_ACK_LENGTH];
+	int Ack_Length;
+	size_t Flush_Length;
+	int Flush_Interval_Ms;
+	int Reconnect_Delay_Ms;
+	int Flusher_Count;
+	struct Log_UDP_Stream_Stats_Struct Stats;
+	int Quit;
+	pthread_t Writer_Thread;
+	pthread_mutex_t Mutex;
+	pthread_cond_t Writer_Condition;
+	pthread_cond_t Progress_Condition;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static void *Stream_Writer_Thread(void *user_arg);
+static int Stream_Connect(Log_UDP_Stream_T stream,int *socket_id);
+static int Stream_Acknowledgement_Read(Log_UDP_Stream_T stream,int socket_id,int timeout_ms,
+				       unsigned long *frame_count);
+static int Stream_Acknowledged(Log_UDP_Stream_T stream,unsigned long frame_count);
+static void Stream_Disconnect(Log_UDP_Stream_T stream);
+static void Stream_Buffer_Put(Log_UDP_Stream_T stream,const char *data,size_t data_length);
+static size_t Stream_Frame_Length_Get(Log_UDP_Stream_T stream,size_t offset);
+static void Stream_Wait(Log_UDP_Stream_T stream,pthread_cond_t *condition,int milliseconds);
+static void Stream_Time_Add(struct timespec *abs_time,int milliseconds);
+static int Stream_Time_Passed(struct timespec *abs_time);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Open a stream, and start it's writer thread. The connection is made by the writer thread, so this
+ * routine never waits for it: frames written before the connection is made are buffered.
+ * @param hostname The hostname to connect to, either numeric or via /etc/hosts or DNS.
+ * @param port_number The port number to connect to in host (normal) byte order.
+ * @param buffer_length The length of the frame buffer in bytes, at least LOG_UDP_STREAM_BUFFER_LENGTH_MIN.
+ *        Zero uses LOG_UDP_STREAM_DEFAULT_BUFFER_LENGTH.
+ * @param flush_interval_ms How long a buffered frame waits for others to be written with it, in
+ *        milliseconds. Zero uses LOG_UDP_STREAM_DEFAULT_FLUSH_INTERVAL_MS.
+ * @param stream The address of a Log_UDP_Stream_T to fill in with the opened stream.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Stream_Writer_Thread
+ * @see #STREAM_FLUSH_LENGTH
+ */
+int Log_UDP_Stream_Open(char *hostname,int port_number,size_t buffer_length,int flush_interval_ms,
+			Log_UDP_Stream_T *stream)
+{
+	Log_UDP_Stream_T new_stream = NULL;
+	int retval;
+
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Stream_Open(%s,%d):started.\n",hostname,port_number);
+#endif
+	if(stream == NULL)
+	{
+		Log_Error_Number = 1400;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:stream was NULL.");
+		return FALSE;
+	}
+	if((hostname == NULL)||(strlen(hostname) >= LOG_UDP_RESOLVE_HOSTNAME_LENGTH))
+	{
+		Log_Error_Number = 1401;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:hostname was NULL or too long.");
+		return FALSE;
+	}
+	if(buffer_length == 0)
+		buffer_length = LOG_UDP_STREAM_DEFAULT_BUFFER_LENGTH;
+	if(buffer_length < LOG_UDP_STREAM_BUFFER_LENGTH_MIN)
+	{
+		Log_Error_Number = 1402;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:Illegal buffer length %lu.",buffer_length);
+		return FALSE;
+	}
+	if(flush_interval_ms == 0)
+		flush_interval_ms = LOG_UDP_STREAM_DEFAULT_FLUSH_INTERVAL_MS;
+	if(flush_interval_ms < 0)
+	{
+		Log_Error_Number = 1403;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:Illegal flush interval %d.",flush_interval_ms);
+		return FALSE;
+	}
+	new_stream = (Log_UDP_Stream_T)calloc(1,sizeof(struct Log_UDP_Stream_Struct));
+	if(new_stream == NULL)
+	{
+		Log_Error_Number = 1404;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:Failed to allocate stream.");
+		return FALSE;
+	}
+	new_stream->Buffer = (char *)malloc(buffer_length);
+	if(new_stream->Buffer == NULL)
+	{
+		free(new_stream);
+		Log_Error_Number = 1405;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:Failed to allocate buffer of %lu bytes.",buffer_length);
+		return FALSE;
+	}
+	strcpy(new_stream->Hostname,hostname);
+	new_stream->Port_Number = port_number;
+	new_stream->Socket_Id = -1;
+	new_stream->Buffer_Length = buffer_length;
+	new_stream->Head = 0;
+	new_stream->Tail = 0;
+	new_stream->Used_Length = 0;
+	new_stream->Sent_Offset = 0;
+	new_stream->Ack_Count = 0;
+	new_stream->Ack_Length = 0;
+	new_stream->Flush_Length = buffer_length/4;
+	if(new_stream->Flush_Length > STREAM_FLUSH_LENGTH)
+		new_stream->Flush_Length = STREAM_FLUSH_LENGTH;
+	new_stream->Flush_Interval_Ms = flush_interval_ms;
+	new_stream->Reconnect_Delay_Ms = STREAM_RECONNECT_DELAY_MIN_MS;
+	new_stream->Flusher_Count = 0;
+	new_stream->Quit = FALSE;
+	pthread_mutex_init(&(new_stream->Mutex),NULL);
+	pthread_cond_init(&(new_stream->Writer_Condition),NULL);
+	pthread_cond_init(&(new_stream->Progress_Condition),NULL);
+	retval = pthread_create(&(new_stream->Writer_Thread),NULL,Stream_Writer_Thread,(void *)new_stream);
+	if(retval != 0)
+	{
+		pthread_cond_destroy(&(new_stream->Progress_Condition));
+		pthread_cond_destroy(&(new_stream->Writer_Condition));
+		pthread_mutex_destroy(&(new_stream->Mutex));
+		free(new_stream->Buffer);
+		free(new_stream);
+		Log_Error_Number = 1406;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Open:Failed to create writer thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	(*stream) = new_stream;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Stream_Open(%s,%d):finished.\n",hostname,port_number);
+#endif
+	return TRUE;
+}
+
+/**
+ * Write a packet to a stream. The packet is framed and copied into the stream's buffer, to be written
+ * to the connection by the writer thread. The writer thread is only signalled when the first frame of a
+ * batch is buffered, or the unwritten frames pass the flush length. If the buffer doesn't have room for the
+ * frame (the connection is down or slow), the packet is dropped: the routine returns TRUE with dropped set,
+ * and the stream's drop counter is incremented.
+ * @param stream The stream, opened with Log_UDP_Stream_Open.
+ * @param message_buffer The packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dropped The address of an integer, set to TRUE if the packet was dropped because the buffer was
+ *        full and FALSE if it was buffered. Can be NULL.
+ * @return The routine returns TRUE if the packet was buffered or dropped, and FALSE if it could never be
+ *         buffered (it's frame is longer than a quarter of the buffer).
+ * @see #Stream_Buffer_Put
+ * @see #LOG_UDP_STREAM_FRAME_HEADER_LENGTH
+ */
+int Log_UDP_Stream_Write(Log_UDP_Stream_T stream,const char *message_buffer,size_t message_buffer_length,
+			 int *dropped)
+{
+	char frame_header[LOG_UDP_STREAM_FRAME_HEADER_LENGTH];
+	size_t frame_length,unwritten_length;
+
+	if(dropped != NULL)
+		(*dropped) = FALSE;
+	if(stream == NULL)
+	{
+		Log_Error_Number = 1407;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Write:stream was NULL.");
+		return FALSE;
+	}
+	if(message_buffer == NULL)
+	{
+		Log_Error_Number = 1408;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Write:message_buffer was NULL.");
+		return FALSE;
+	}
+	frame_length = LOG_UDP_STREAM_FRAME_HEADER_LENGTH+message_buffer_length;
+	if(frame_length > (stream->Buffer_Length/4))
+	{
+		Log_Error_Number = 1409;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Write:Packet of %lu bytes is too long for a buffer of %lu.",
+			message_buffer_length,stream->Buffer_Length);
+		return FALSE;
+	}
+	frame_header[0] = (char)((message_buffer_length>>24)&0xff);
+	frame_header[1] = (char)((message_buffer_length>>16)&0xff);
+	frame_header[2] = (char)((message_buffer_length>>8)&0xff);
+	frame_header[3] = (char)(message_buffer_length&0xff);
+	pthread_mutex_lock(&(stream->Mutex));
+	if((stream->Used_Length+frame_length) > stream->Buffer_Length)
+	{
+		stream->Stats.Drop_Count++;
+		pthread_mutex_unlock(&(stream->Mutex));
+		if(dropped != NULL)
+			(*dropped) = TRUE;
+		return TRUE;
+	}
+	Stream_Buffer_Put(stream,frame_header,LOG_UDP_STREAM_FRAME_HEADER_LENGTH);
+	Stream_Buffer_Put(stream,message_buffer,message_buffer_length);
+	unwritten_length = stream->Used_Length-stream->Sent_Offset;
+	stream->Used_Length += frame_length;
+	stream->Stats.Write_Count++;
+	/* start the flush interval, or write now */
+	if((unwritten_length == 0)||
+	   ((unwritten_length < stream->Flush_Length)&&((unwritten_length+frame_length) >= stream->Flush_Length)))
+	{
+		pthread_cond_signal(&(stream->Writer_Condition));
+	}
+	pthread_mutex_unlock(&(stream->Mutex));
+	return TRUE;
+}
+
+/**
+ * Wait until every packet written to the stream before this routine was called has been acknowledged by
+ * the receiver. The writer thread writes buffered frames at once, rather than waiting for the flush interval,
+ * whilst this routine is waiting.
+ * @param stream The stream, opened with Log_UDP_Stream_Open.
+ * @param timeout_ms How long to wait in milliseconds. A negative number waits forever.
+ * @return The routine returns TRUE if the stream was flushed, and FALSE on failure or timeout.
+ * @see #Stream_Wait
+ */
+int Log_UDP_Stream_Flush(Log_UDP_Stream_T stream,int timeout_ms)
+{
+	struct timespec deadline;
+	unsigned long target_count;
+
+	if(stream == NULL)
+	{
+		Log_Error_Number = 1410;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Flush:stream was NULL.");
+		return FALSE;
+	}
+	clock_gettime(CLOCK_REALTIME,&deadline);
+	Stream_Time_Add(&deadline,timeout_ms);
+	pthread_mutex_lock(&(stream->Mutex));
+	target_count = stream->Stats.Write_Count;
+	stream->Flusher_Count++;
+	pthread_cond_signal(&(stream->Writer_Condition));
+	while(stream->Stats.Sent_Count < target_count)
+	{
+		if((timeout_ms >= 0)&&Stream_Time_Passed(&deadline))
+		{
+			stream->Flusher_Count--;
+			Log_Error_Number = 1411;
+			sprintf(Log_Error_String,"Log_UDP_Stream_Flush:Timed out after %d ms with %lu packets not "
+				"acknowledged (%s).",timeout_ms,target_count-stream->Stats.Sent_Count,
+				(stream->Socket_Id < 0) ? "disconnected" : "connected");
+			pthread_mutex_unlock(&(stream->Mutex));
+			return FALSE;
+		}
+		Stream_Wait(stream,&(stream->Progress_Condition),PROGRESS_WAIT_MS);
+	}
+	stream->Flusher_Count--;
+	pthread_mutex_unlock(&(stream->Mutex));
+	return TRUE;
+}
+
+/**
+ * Get a stream's counters.
+ * @param stream The stream, opened with Log_UDP_Stream_Open.
+ * @param stats The address of a structure to fill in with the counters.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Stream_Stats_Get(Log_UDP_Stream_T stream,struct Log_UDP_Stream_Stats_Struct *stats)
+{
+	if(stream == NULL)
+	{
+		Log_Error_Number = 1412;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Stats_Get:stream was NULL.");
+		return FALSE;
+	}
+	if(stats == NULL)
+	{
+		Log_Error_Number = 1413;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Stats_Get:stats was NULL.");
+		return FALSE;
+	}
+	pthread_mutex_lock(&(stream->Mutex));
+	(*stats) = stream->Stats;
+	stats->Buffered_Length = stream->Used_Length;
+	stats->Connected = (stream->Socket_Id >= 0);
+	pthread_mutex_unlock(&(stream->Mutex));
+	return TRUE;
+}
+
+/**
+ * Close a stream. The buffered packets are flushed, waiting up to LOG_UDP_STREAM_FLUSH_TIMEOUT_MS, then the
+ * writer thread is stopped, the connection closed and the stream freed. No other thread should be calling
+ * Log_UDP_Stream_Write with this stream whilst this routine is running.
+ * @param stream The stream, opened with Log_UDP_Stream_Open.
+ * @return The routine returns TRUE if every packet was acknowledged by the receiver, and FALSE if some were
+ *         not (the stream is still closed).
+ * @see #Log_UDP_Stream_Flush
+ * @see #LOG_UDP_STREAM_FLUSH_TIMEOUT_MS
+ */
+int Log_UDP_Stream_Close(Log_UDP_Stream_T stream)
+{
+	int retval,flush_retval;
+
+	if(stream == NULL)
+	{
+		Log_Error_Number = 1414;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Close:stream was NULL.");
+		return FALSE;
+	}
+	flush_retval = Log_UDP_Stream_Flush(stream,LOG_UDP_STREAM_FLUSH_TIMEOUT_MS);
+	pthread_mutex_lock(&(stream->Mutex));
+	stream->Quit = TRUE;
+	pthread_cond_signal(&(stream->Writer_Condition));
+	pthread_mutex_unlock(&(stream->Mutex));
+	retval = pthread_join(stream->Writer_Thread,NULL);
+	if(retval != 0)
+	{
+		Log_Error_Number = 1415;
+		sprintf(Log_Error_String,"Log_UDP_Stream_Close:Failed to join writer thread (%d:%s).",retval,
+			strerror(retval));
+		return FALSE;
+	}
+	pthread_cond_destroy(&(stream->Progress_Condition));
+	pthread_cond_destroy(&(stream->Writer_Condition));
+	pthread_mutex_destroy(&(stream->Mutex));
+	free(stream->Buffer);
+	free(stream);
+	return flush_retval;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * The writer thread. Connects (and reconnects) the stream, writes the buffered frames in batches, and reads
+ * the receiver's acknowledgements, until Quit is set.
+ * @param user_arg The Log_UDP_Stream_T the thread is writing for.
+ * @return The routine returns NULL.
+ * @see #Stream_Connect
+ * @see #Stream_Acknowledgement_Read
+ * @see #Stream_Acknowledged
+ * @see #Stream_Disconnect
+ * @see #STREAM_ACK_WAIT_MS
+ * @see #STREAM_RECONNECT_DELAY_MIN_MS
+ * @see #STREAM_RECONNECT_DELAY_MAX_MS
+ */
+static void *Stream_Writer_Thread(void *user_arg)
+{
+	Log_UDP_Stream_T stream = (Log_UDP_Stream_T)user_arg;
+	struct timespec batch_deadline;
+	struct iovec iov[2];
+	struct msghdr message;
+	unsigned long acknowledged_count;
+	size_t start,length;
+	ssize_t sent_length;
+	int socket_id,batch_started,connected,connection_open,send_errno;
+
+#if DEBUG > 1
+	fprintf(stdout,"Stream_Writer_Thread:started.\n");
+#endif
+	batch_started = FALSE;
+	pthread_mutex_lock(&(stream->Mutex));
+	while(stream->Quit == FALSE)
+	{
+		if(stream->Socket_Id < 0)
+		{
+			pthread_mutex_unlock(&(stream->Mutex));
+			connected = Stream_Connect(stream,&socket_id);
+			pthread_mutex_lock(&(stream->Mutex));
+			if(!connected)
+			{
+				Stream_Wait(stream,&(stream->Writer_Condition),stream->Reconnect_Delay_Ms);
+				stream->Reconnect_Delay_Ms *= 2;
+				if(stream->Reconnect_Delay_Ms > STREAM_RECONNECT_DELAY_MAX_MS)
+					stream->Reconnect_Delay_Ms = STREAM_RECONNECT_DELAY_MAX_MS;
+				continue;
+			}
+#if DEBUG > 1
+			fprintf(stdout,"Stream_Writer_Thread:Connected to %s:%d.\n",stream->Hostname,
+				stream->Port_Number);
+#endif
+			stream->Socket_Id = socket_id;
+			/* every frame not acknowledged over the last connection is written again */
+			stream->Sent_Offset = 0;
+			stream->Ack_Count = 0;
+			stream->Ack_Length = 0;
+			stream->Reconnect_Delay_Ms = STREAM_RECONNECT_DELAY_MIN_MS;
+			stream->Stats.Connect_Count++;
+			continue;
+		}
+		socket_id = stream->Socket_Id;
+		length = stream->Used_Length-stream->Sent_Offset;
+		if(length == 0)
+		{
+			batch_started = FALSE;
+			if(stream->Sent_Offset == 0)
+			{
+				Stream_Wait(stream,&(stream->Writer_Condition),STREAM_IDLE_WAIT_MS);
+				continue;
+			}
+			/* everything has been written, wait for the receiver to acknowledge it */
+			pthread_mutex_unlock(&(stream->Mutex));
+			connection_open = Stream_Acknowledgement_Read(stream,socket_id,STREAM_ACK_WAIT_MS,
+								      &acknowledged_count);
+			pthread_mutex_lock(&(stream->Mutex));
+			if((!Stream_Acknowledged(stream,acknowledged_count))||(!connection_open))
+				Stream_Disconnect(stream);
+			continue;
+		}
+		/* wait for more frames, unless there are enough to write or a flush is waiting */
+		if((length < stream->Flush_Length)&&(stream->Flusher_Count == 0))
+		{
+			if(!batch_started)
+			{
+				clock_gettime(CLOCK_REALTIME,&batch_deadline);
+				Stream_Time_Add(&batch_deadline,stream->Flush_Interval_Ms);
+				batch_started = TRUE;
+			}
+			if(!Stream_Time_Passed(&batch_deadline))
+			{
+				pthread_cond_timedwait(&(stream->Writer_Condition),&(stream->Mutex),&batch_deadline);
+				continue;
+			}
+		}
+		batch_started = FALSE;
+		/* the unwritten bytes, which may wrap round the end of the buffer */
+		start = (stream->Tail+stream->Sent_Offset)%stream->Buffer_Length;
+		iov[0].iov_base = stream->Buffer+start;
+		iov[0].iov_len = length;
+		if((start+length) > stream->Buffer_Length)
+			iov[0].iov_len = stream->Buffer_Length-start;
+		iov[1].iov_base = stream->Buffer;
+		iov[1].iov_len = length-iov[0].iov_len;
+		memset(&message,0,sizeof(message));
+		message.msg_iov = iov;
+		message.msg_iovlen = (iov[1].iov_len > 0) ? 2 : 1;
+		pthread_mutex_unlock(&(stream->Mutex));
+		sent_length = -1;
+		send_errno = 0;
+		connection_open = Stream_Acknowledgement_Read(stream,socket_id,0,&acknowledged_count);
+		if(connection_open)
+		{
+			sent_length = sendmsg(socket_id,&message,MSG_NOSIGNAL);
+			send_errno = errno;
+		}
+		pthread_mutex_lock(&(stream->Mutex));
+		if(!Stream_Acknowledged(stream,acknowledged_count))
+		{
+			Stream_Disconnect(stream);
+			continue;
+		}
+		if(sent_length < 0)
+		{
+			/* a send timeout or signal, try again */
+			if(connection_open&&((send_errno == EINTR)||(send_errno == EAGAIN)||(send_errno == EWOULDBLOCK)))
+				continue;
+			Stream_Disconnect(stream);
+			continue;
+		}
+		stream->Sent_Offset += sent_length;
+		stream->Stats.Byte_Count += sent_length;
+		stream->Stats.Batch_Count++;
+	}
+	if(stream->Socket_Id >= 0)
+	{
+		close(stream->Socket_Id);
+		stream->Socket_Id = -1;
+	}
+	pthread_mutex_unlock(&(stream->Mutex));
+#if DEBUG > 1
+	fprintf(stdout,"Stream_Writer_Thread:finished.\n");
+#endif
+	return NULL;
+}
+
+/**
+ * Connect a stream socket to the stream's hostname and port. The connection is made without blocking for
+ * longer than STREAM_CONNECT_TIMEOUT_MS. The connected socket has Nagle's algorithm turned off (frames are
+ * already batched) and a send timeout of STREAM_SEND_TIMEOUT_MS.
+ * @param stream The stream.
+ * @param socket_id The address of an integer, filled in with the connected socket.
+ * @return The routine returns TRUE if the connection was made, and FALSE otherwise.
+ * @see #STREAM_CONNECT_TIMEOUT_MS
+ * @see #STREAM_SEND_TIMEOUT_MS
+ * @see log_udp.html#Log_UDP_Resolve
+ */
+static int Stream_Connect(Log_UDP_Stream_T stream,int *socket_id)
+{
+	struct sockaddr_storage address;
+	struct pollfd poll_fd;
+	struct timeval send_timeout;
+	socklen_t address_length,option_length;
+	int new_socket_id,flags,retval,socket_error,no_delay;
+
+	if(!Log_UDP_Resolve(stream->Hostname,stream->Port_Number,&address,&address_length))
+		return FALSE;
+	new_socket_id = socket(address.ss_family,SOCK_STREAM,0);
+	if(new_socket_id < 0)
+		return FALSE;
+	flags = fcntl(new_socket_id,F_GETFL,0);
+	if((flags < 0)||(fcntl(new_socket_id,F_SETFL,flags|O_NONBLOCK) < 0))
+	{
+		close(new_socket_id);
+		return FALSE;
+	}
+	retval = connect(new_socket_id,(struct sockaddr *)&address,address_length);
+	if((retval < 0)&&(errno != EINPROGRESS))
+	{
+		close(new_socket_id);
+		return FALSE;
+	}
+	if(retval < 0)
+	{
+		poll_fd.fd = new_socket_id;
+		poll_fd.events = POLLOUT;
+		poll_fd.revents = 0;
+		option_length = sizeof(socket_error);
+		if((poll(&poll_fd,1,STREAM_CONNECT_TIMEOUT_MS) <= 0)||
+		   (getsockopt(new_socket_id,SOL_SOCKET,SO_ERROR,&socket_error,&option_length) < 0)||
+		   (socket_error != 0))
+		{
+			close(new_socket_id);
+			return FALSE;
+		}
+	}
+	if(fcntl(new_socket_id,F_SETFL,flags) < 0)
+	{
+		close(new_socket_id);
+		return FALSE;
+	}
+	/* fails harmlessly on non-TCP sockets */
+	no_delay = 1;
+	setsockopt(new_socket_id,IPPROTO_TCP,TCP_NODELAY,&no_delay,sizeof(no_delay));
+	send_timeout.tv_sec = STREAM_SEND_TIMEOUT_MS/ONE_SECOND_MS;
+	send_timeout.tv_usec = (STREAM_SEND_TIMEOUT_MS%ONE_SECOND_MS)*ONE_MILLISECOND_US;
+	setsockopt(new_socket_id,SOL_SOCKET,SO_SNDTIMEO,&send_timeout,sizeof(send_timeout));
+	(*socket_id) = new_socket_id;
+	return TRUE;
+}
+
+/**
+ * Read the receiver's acknowledgements. Acknowledgements may arrive split across reads, the bytes of a
+ * partial one are kept in Ack_Buffer. Only the writer thread calls this, without the stream's mutex locked.
+ * @param stream The stream.
+ * @param socket_id The connected socket.
+ * @param timeout_ms How long to wait for an acknowledgement, in milliseconds.
+ * @param frame_count The address of an unsigned long, filled in with the number of frames newly
+ *        acknowledged.
+ * @return The routine returns TRUE if the connection is still open, and FALSE if the receiver has closed
+ *         it or it has failed.
+ * @see #LOG_UDP_STREAM_ACK_LENGTH
+ */
+static int Stream_Acknowledgement_Read(Log_UDP_Stream_T stream,int socket_id,int timeout_ms,
+				       unsigned long *frame_count)
+{
+	struct pollfd poll_fd;
+	unsigned char read_buffer[256];
+	uint32_t ack_count;
+	ssize_t read_length;
+	int retval,i,j;
+
+	(*frame_count) = 0;
+	poll_fd.fd = socket_id;
+	poll_fd.events = POLLIN;
+	poll_fd.revents = 0;
+	retval = poll(&poll_fd,1,timeout_ms);
+	if(retval < 0)
+		return (errno == EINTR);
+	if(retval == 0)
+		return TRUE;
+	read_length = recv(socket_id,read_buffer,sizeof(read_buffer),MSG_DONTWAIT);
+	if(read_length == 0)
+		return FALSE;
+	if(read_length < 0)
+		return ((errno == EAGAIN)||(errno == EWOULDBLOCK)||(errno == EINTR));
+	for(i = 0; i < read_length; i++)
+	{
+		stream->Ack_Buffer[stream->Ack_Length++] = read_buffer[i];
+		if(stream->Ack_Length < LOG_UDP_STREAM_ACK_LENGTH)
+			continue;
+		ack_count = 0;
+		for(j = 0; j < LOG_UDP_STREAM_ACK_LENGTH; j++)
+			ack_count = (ack_count<<8)|stream->Ack_Buffer[j];
+		/* the counts wrap, so the difference is taken modulo 2^32 */
+		(*frame_count) += (uint32_t)(ack_count-stream->Ack_Count);
+		stream->Ack_Count = ack_count;
+		stream->Ack_Length = 0;
+	}
+	return TRUE;
+}
+
+/**
+ * Remove acknowledged frames from the buffer, and wake threads waiting in Log_UDP_Stream_Flush.
+ * The stream's mutex should be locked.
+ * @param stream The stream.
+ * @param frame_count The number of frames newly acknowledged.
+ * @return The routine returns TRUE on success, and FALSE if the receiver acknowledged frames that
+ *         haven't been written to it.
+ * @see #Stream_Frame_Length_Get
+ */
+static int Stream_Acknowledged(Log_UDP_Stream_T stream,unsigned long frame_count)
+{
+	size_t frame_length;
+
+	if(frame_count == 0)
+		return TRUE;
+	for(; frame_count > 0; frame_count--)
+	{
+		if(stream->Sent_Offset == 0)
+			return FALSE;
+		frame_length = Stream_Frame_Length_Get(stream,stream->Tail);
+		if(frame_length > stream->Sent_Offset)
+			return FALSE;
+		stream->Tail = (stream->Tail+frame_length)%stream->Buffer_Length;
+		stream->Used_Length -= frame_length;
+		stream->Sent_Offset -= frame_length;
+		stream->Stats.Sent_Count++;
+	}
+	pthread_cond_broadcast(&(stream->Progress_Condition));
+	return TRUE;
+}
+
+/**
+ * Close the stream's connection, after it has failed. Every frame not acknowledged is written again
+ * when the writer thread reconnects. The stream's mutex should be locked.
+ * @param stream The stream.
+ */
+static void Stream_Disconnect(Log_UDP_Stream_T stream)
+{
+#if DEBUG > 1
+	fprintf(stdout,"Stream_Disconnect:Lost connection to %s:%d.\n",stream->Hostname,stream->Port_Number);
+#endif
+	close(stream->Socket_Id);
+	stream->Socket_Id = -1;
+	stream->Sent_Offset = 0;
+	stream->Stats.Disconnect_Count++;
+}
+
+/**
+ * Copy data into the stream's buffer at Head, wrapping round the end of the buffer, and advance Head.
+ * The stream's mutex should be locked, and there must be room for the data.
+ * @param stream The stream.
+ * @param data The data.
+ * @param data_length The length of the data in bytes.
+ */
+static void Stream_Buffer_Put(Log_UDP_Stream_T stream,const char *data,size_t data_length)
+{
+	size_t first_length;
+
+	first_length = stream->Buffer_Length-stream->Head;
+	if(first_length > data_length)
+		first_length = data_length;
+	memcpy(stream->Buffer+stream->Head,data,first_length);
+	memcpy(stream->Buffer,data+first_length,data_length-first_length);
+	stream->Head = (stream->Head+data_length)%stream->Buffer_Length;
+}
+
+/**
+ * Get the length of the frame starting at an offset in the stream's buffer, from it's frame header.
+ * @param stream The stream.
+ * @param offset The offset of the frame in the buffer.
+ * @return The length of the frame, including the frame header.
+ */
+static size_t Stream_Frame_Length_Get(Log_UDP_Stream_T stream,size_t offset)
+{
+	size_t message_length;
+	int i;
+
+	message_length = 0;
+	for(i = 0; i < LOG_UDP_STREAM_FRAME_HEADER_LENGTH; i++)
+	{
+		message_length = (message_length<<8)|
+			((unsigned char)(stream->Buffer[(offset+i)%stream->Buffer_Length]));
+	}
+	return LOG_UDP_STREAM_FRAME_HEADER_LENGTH+message_length;
+}
+
+/**
+ * Wait on one of the stream's conditions for up to a number of milliseconds. The stream's mutex should
+ * be locked.
+ * @param stream The stream.
+ * @param condition The condition to wait on.
+ * @param milliseconds How long to wait.
+ */
+static void Stream_Wait(Log_UDP_Stream_T stream,pthread_cond_t *condition,int milliseconds)
+{
+	struct timespec wait_time;
+
+	clock_gettime(CLOCK_REALTIME,&wait_time);
+	Stream_Time_Add(&wait_time,milliseconds);
+	pthread_cond_timedwait(condition,&(stream->Mutex),&wait_time);
+}
+
+/**
+ * Add a number of milliseconds to an absolute time.
+ * @param abs_time The address of the time to modify.
+ * @param milliseconds The number of milliseconds to add. Negative numbers are treated as zero.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ * @see #ONE_SECOND_NS
+ */
+static void Stream_Time_Add(struct timespec *abs_time,int milliseconds)
+{
+	if(milliseconds < 0)
+		return;
+	abs_time->tv_sec += milliseconds/ONE_SECOND_MS;
+	abs_time->tv_nsec += (milliseconds%ONE_SECOND_MS)*ONE_MILLISECOND_NS;
+	if(abs_time->tv_nsec >= ONE_SECOND_NS)
+	{
+		abs_time->tv_sec++;
+		abs_time->tv_nsec -= ONE_SECOND_NS;
+	}
+}
+
+/**
+ * Return whether the (CLOCK_REALTIME) absolute time has passed.
+ * @param abs_time The address of the time to test.
+ * @return TRUE if the time has passed, FALSE if it has not.
+ */
+static int Stream_Time_Passed(struct timespec *abs_time)
+{
+	struct timespec current_time;
+
+	clock_gettime(CLOCK_REALTIME,&current_time);
+	if(current_time.tv_sec != abs_time->tv_sec)
+		return (current_time.tv_sec > abs_time->tv_sec);
+	return (current_time.tv_nsec >= abs_time->tv_nsec);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,1147 @@
+/* log_udp_template.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Message templates for version 2 packets. Much of our traffic is the same printf-style format with different
+ * numbers (TCS status lines, autoguider centroids). A process registers each format once with
+ * Log_UDP_Template_Register, and is given a template identifier. When a handle sends with
+ * LOG_UDP_V2_FLAG_TEMPLATE set, the packet's Message field holds the identifier and the binary encoded arguments
+ * rather than formatted text, so the sender does no formatting, and the receiver can group messages by
+ * template without parsing text. The Message field is:
+ * <ul>
+ * <li>A varint code: (id &lt;&lt; 1)|1 if the template with identifier id is defined in this packet, in which
+ *     case the format follows (varint length and characters), or (id &lt;&lt; 1) for a reference to a
+ *     template defined earlier.</li>
+ * <li>The number of arguments as a varint.</li>
+ * <li>Each argument as a type byte (LOG_UDP_TEMPLATE_ARGUMENT) and the value.</li>
+ * </ul>
+ * A template is defined in the first packet that uses it, and again after each refresh interval, so a
+ * receiver that restarts or misses a definition recovers. Definitions carry the whole format, so a receiver
+ * just remembers the latest one for each identifier. Until it has seen a definition, a receiver expands the
+ * message as "&lt;template N&gt;" followed by the arguments.
+ * Formats may use the d, i, o, u, x, X, c, e, E, f, F, g, G, a, A, s and p conversions, with flags, numeric
+ * widths and precisions, and the hh, h, l, ll, j, z, t and L length modifiers. '*' widths, positional
+ * arguments, %n and wide characters are not supported.
+ * A table is not thread safe: the sender's handle mutex protects it.
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993
+ * clock_gettime prototypes.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>   /* Error number definitions */
+#include <stdarg.h>
+#include <stddef.h>
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_template.h"
+#include "log_udp_wire.h"
+
+/* hash defines */
+/**
+ * Length modifier: none.
+ */
+#define TEMPLATE_LENGTH_NONE            (0)
+/**
+ * Length modifier: hh (char).
+ */
+#define TEMPLATE_LENGTH_CHAR            (1)
+/**
+ * Length modifier: h (short).
+ */
+#define TEMPLATE_LENGTH_SHORT           (2)
+/**
+ * Length modifier: l (long).
+ */
+#define TEMPLATE_LENGTH_LONG            (3)
+/**
+ * Length modifier: ll or q (long long).
+ */
+#define TEMPLATE_LENGTH_LONG_LONG       (4)
+/**
+ * Length modifier: j (intmax_t).
+ */
+#define TEMPLATE_LENGTH_INTMAX          (5)
+/**
+ * Length modifier: z (size_t).
+ */
+#define TEMPLATE_LENGTH_SIZE            (6)
+/**
+ * Length modifier: t (ptrdiff_t).
+ */
+#define TEMPLATE_LENGTH_PTRDIFF         (7)
+/**
+ * Length modifier: L (long double).
+ */
+#define TEMPLATE_LENGTH_LONG_DOUBLE     (8)
+/**
+ * Not a length modifier, the argument is a pointer (%p).
+ */
+#define TEMPLATE_LENGTH_POINTER         (9)
+/**
+ * The length of the buffer a single conversion specification is rebuilt in by the receiver.
+ */
+#define TEMPLATE_SPEC_LENGTH            (32)
+/**
+ * The number of milliseconds in one second.
+ */
+#define ONE_SECOND_MS                   (1000)
+/**
+ * The number of nanoseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_NS              (1000000)
+
+/* structures */
+/**
+ * One template.
+ * <dl>
+ * <dt>Format</dt> <dd>The printf-style format.</dd>
+ * <dt>Type_List</dt> <dd>The wire type of each argument, a member of LOG_UDP_TEMPLATE_ARGUMENT.</dd>
+ * <dt>Length_List</dt> <dd>The length modifier of each argument (TEMPLATE_LENGTH_*), which tells the sender
+ *     how to read it.</dd>
+ * <dt>Argument_Count</dt> <dd>The number of arguments the format takes.</dd>
+ * <dt>Is_Defined</dt> <dd>For the sender, whether the template's definition has been sent since the last
+ *     refresh. For the receiver, whether the template's definition has been received.</dd>
+ * </dl>
+ * @see #LOG_UDP_TEMPLATE_ARGUMENT_COUNT
+ */
+struct Template_Entry_Struct
+{
+	char Format[LOG_RECORD_MESSAGE_LENGTH];
+	unsigned char Type_List[LOG_UDP_TEMPLATE_ARGUMENT_COUNT];
+	unsigned char Length_List[LOG_UDP_TEMPLATE_ARGUMENT_COUNT];
+	int Argument_Count;
+	int Is_Defined;
+};
+
+/**
+ * A decoded argument.
+ * <dl>
+ * <dt>Type</dt> <dd>The wire type, a member of LOG_UDP_TEMPLATE_ARGUMENT.</dd>
+ * <dt>Int</dt> <dd>The value of an integer argument.</dd>
+ * <dt>Unsigned</dt> <dd>The value of an unsigned argument.</dd>
+ * <dt>Double</dt> <dd>The value of a floating point argument.</dd>
+ * <dt>String</dt> <dd>The value of a string argument.</dd>
+ * </dl>
+ */
+struct Template_Argument_Struct
+{
+	int Type;
+	int64_t Int;
+	uint64_t Unsigned;
+	double Double;
+	char String[LOG_UDP_TEMPLATE_STRING_LENGTH];
+};
+
+/**
+ * A template table, for one sender or one receiver.
+ * <dl>
+ * <dt>Entry_List</dt> <dd>The templates, entry id-1 holds the template with identifier id. Entries are
+ *     allocated when a template is registered or defined.</dd>
+ * <dt>Entry_Count</dt> <dd>The number of templates registered. Sender only.</dd>
+ * <dt>Pending_Id</dt> <dd>The identifier of the template defined in the packet being encoded, or zero.</dd>
+ * <dt>Refresh_Interval_Ms</dt> <dd>The time between refreshes in milliseconds.</dd>
+ * <dt>Refresh_Time_Ms</dt> <dd>The monotonic time in milliseconds of the last refresh.</dd>
+ * </dl>
+ * @see #LOG_UDP_TEMPLATE_COUNT
+ */
+struct Log_UDP_Template_Table_Struct
+{
+	struct Template_Entry_Struct *Entry_List[LOG_UDP_TEMPLATE_COUNT];
+	int Entry_Count;
+	int Pending_Id;
+	int Refresh_Interval_Ms;
+	int64_t Refresh_Time_Ms;
+};
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static int Template_Parse(const char *format,struct Template_Entry_Struct *entry);
+static int Template_Conversion_Parse(const char *format,size_t *format_position,size_t *length_position,
+				     int *length_modifier,char *conversion);
+static int Template_Encode_Argument(char *message_buffer,size_t message_buffer_length,
+				    size_t *message_buffer_position,int type,int length_modifier,
+				    va_list *argument_list);
+static int Template_Decode_Argument(const char *message_buffer,size_t message_buffer_length,
+				    size_t *message_buffer_position,struct Template_Argument_Struct *argument);
+static int Template_Decode_String(const char *message_buffer,size_t message_buffer_length,
+				  size_t *message_buffer_position,char *field,size_t field_length);
+static void Template_Expand(struct Template_Entry_Struct *entry,struct Template_Argument_Struct *argument_list,
+			    char *message,size_t message_length);
+static void Template_Expand_Unknown(int template_id,struct Template_Argument_Struct *argument_list,
+				    int argument_count,char *message,size_t message_length);
+static void Template_Append(char *message,size_t message_length,size_t *message_position,int print_length);
+static int64_t Template_Monotonic_Ms(void);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Create an empty template table, refreshed every LOG_UDP_TEMPLATE_DEFAULT_REFRESH_MS milliseconds.
+ * @param table The address of a template table to fill in.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Template_Table_Destroy
+ * @see #LOG_UDP_TEMPLATE_DEFAULT_REFRESH_MS
+ */
+int Log_UDP_Template_Table_Create(Log_UDP_Template_Table_T *table)
+{
+	Log_UDP_Template_Table_T new_table = NULL;
+
+	if(table == NULL)
+	{
+		Log_Error_Number = 800;
+		sprintf(Log_Error_String,"Log_UDP_Template_Table_Create:table was NULL.");
+		return FALSE;
+	}
+	new_table = (Log_UDP_Template_Table_T)calloc(1,sizeof(struct Log_UDP_Template_Table_Struct));
+	if(new_table == NULL)
+	{
+		Log_Error_Number = 801;
+		sprintf(Log_Error_String,"Log_UDP_Template_Table_Create:Failed to allocate table.");
+		return FALSE;
+	}
+	new_table->Entry_Count = 0;
+	new_table->Pending_Id = 0;
+	new_table->Refresh_Interval_Ms = LOG_UDP_TEMPLATE_DEFAULT_REFRESH_MS;
+	new_table->Refresh_Time_Ms = Template_Monotonic_Ms();
+	(*table) = new_table;
+	return TRUE;
+}
+
+/**
+ * Register a template with a sender's table. Registering a format that is already registered returns the
+ * same identifier. Identifiers are never reused while the table exists.
+ * @param table The template table.
+ * @param format The printf-style format, shorter than LOG_RECORD_MESSAGE_LENGTH, with at most
+ *        LOG_UDP_TEMPLATE_ARGUMENT_COUNT conversions.
+ * @param template_id The address of an integer, filled in with the template's identifier.
+ * @return The routine returns TRUE on success and FALSE on failure (including a format using a conversion
+ *         that is not supported).
+ * @see #Template_Parse
+ */
+int Log_UDP_Template_Register(Log_UDP_Template_Table_T table,const char *format,int *template_id)
+{
+	struct Template_Entry_Struct *entry = NULL;
+	int i;
+
+	if((table == NULL)||(format == NULL)||(template_id == NULL))
+	{
+		Log_Error_Number = 802;
+		sprintf(Log_Error_String,"Log_UDP_Template_Register:NULL argument.");
+		return FALSE;
+	}
+	for(i = 0; i < table->Entry_Count; i++)
+	{
+		if(strcmp(table->Entry_List[i]->Format,format) == 0)
+		{
+			(*template_id) = i+1;
+			return TRUE;
+		}
+	}
+	if(table->Entry_Count >= LOG_UDP_TEMPLATE_COUNT)
+	{
+		Log_Error_Number = 803;
+		sprintf(Log_Error_String,"Log_UDP_Template_Register:Template table is full(%d).",
+			LOG_UDP_TEMPLATE_COUNT);
+		return FALSE;
+	}
+	if(strlen(format) >= LOG_RECORD_MESSAGE_LENGTH)
+	{
+		Log_Error_Number = 804;
+		sprintf(Log_Error_String,"Log_UDP_Template_Register:Format too long(%d).",(int)strlen(format));
+		return FALSE;
+	}
+	entry = (struct Template_Entry_Struct *)malloc(sizeof(struct Template_Entry_Struct));
+	if(entry == NULL)
+	{
+		Log_Error_Number = 805;
+		sprintf(Log_Error_String,"Log_UDP_Template_Register:Failed to allocate template.");
+		return FALSE;
+	}
+	if(!Template_Parse(format,entry))
+	{
+		free(entry);
+		return FALSE;
+	}
+	entry->Is_Defined = FALSE;
+	table->Entry_List[table->Entry_Count++] = entry;
+	(*template_id) = table->Entry_Count;
+#if DEBUG > 1
+	fprintf(stdout,"Log_UDP_Template_Register:Registered template %d '%s' with %d arguments.\n",
+		(*template_id),format,entry->Argument_Count);
+#endif
+	return TRUE;
+}
+
+/**
+ * Get the format of a registered template.
+ * @param table The template table.
+ * @param template_id The template's identifier.
+ * @param format The address of a string pointer, set to the table's copy of the format.
+ * @return The routine returns TRUE on success and FALSE if the template is not registered.
+ */
+int Log_UDP_Template_Format_Get(Log_UDP_Template_Table_T table,int template_id,const char **format)
+{
+	if((table == NULL)||(format == NULL))
+	{
+		Log_Error_Number = 806;
+		sprintf(Log_Error_String,"Log_UDP_Template_Format_Get:NULL argument.");
+		return FALSE;
+	}
+	if((template_id < 1)||(template_id > LOG_UDP_TEMPLATE_COUNT)||(table->Entry_List[template_id-1] == NULL))
+	{
+		Log_Error_Number = 807;
+		sprintf(Log_Error_String,"Log_UDP_Template_Format_Get:Unknown template %d.",template_id);
+		return FALSE;
+	}
+	(*format) = table->Entry_List[template_id-1]->Format;
+	return TRUE;
+}
+
+/**
+ * Set how often a sender's templates are defined again.
+ * @param table The template table.
+ * @param refresh_interval_ms The time between refreshes in milliseconds, greater than zero.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Template_Refresh_Set(Log_UDP_Template_Table_T table,int refresh_interval_ms)
+{
+	if(table == NULL)
+	{
+		Log_Error_Number = 808;
+		sprintf(Log_Error_String,"Log_UDP_Template_Refresh_Set:table was NULL.");
+		return FALSE;
+	}
+	if(refresh_interval_ms <= 0)
+	{
+		Log_Error_Number = 809;
+		sprintf(Log_Error_String,"Log_UDP_Template_Refresh_Set:Illegal refresh interval %d.",
+			refresh_interval_ms);
+		return FALSE;
+	}
+	table->Refresh_Interval_Ms = refresh_interval_ms;
+	return TRUE;
+}
+
+/**
+ * Refresh a sender's templates now, rather than when the refresh interval has passed, so each template is
+ * defined again the next time it is used. A handle does this when packets that may have carried definitions
+ * were written to it's journal rather than sent. Call this between packets, not whilst one is being encoded.
+ * @param table The template table.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+int Log_UDP_Template_Refresh(Log_UDP_Template_Table_T table)
+{
+	int i;
+
+	if(table == NULL)
+	{
+		Log_Error_Number = 827;
+		sprintf(Log_Error_String,"Log_UDP_Template_Refresh:table was NULL.");
+		return FALSE;
+	}
+	for(i = 0; i < table->Entry_Count; i++)
+		table->Entry_List[i]->Is_Defined = FALSE;
+	table->Refresh_Time_Ms = Template_Monotonic_Ms();
+	return TRUE;
+}
+
+/**
+ * Encode a templated Message field. The template is defined if this is the first packet to use it since
+ * the last refresh. The arguments are read from argument_list according to the template's conversions.
+ * The caller must call Log_UDP_Template_Packet_End once it knows whether the packet was sent.
+ * @param table The sender's template table.
+ * @param template_id The template's identifier, returned by Log_UDP_Template_Register.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the field.
+ * @param argument_list The arguments for the template's format.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Template_Packet_End
+ * @see #Template_Encode_Argument
+ */
+int Log_UDP_Template_Encode(Log_UDP_Template_Table_T table,int template_id,char *message_buffer,
+			    size_t message_buffer_length,size_t *message_buffer_position,va_list argument_list)
+{
+	struct Template_Entry_Struct *entry = NULL;
+	va_list argument_list_copy;
+	int64_t now_ms;
+	int retval,i;
+
+	if(table == NULL)
+	{
+		Log_Error_Number = 810;
+		sprintf(Log_Error_String,"Log_UDP_Template_Encode:table was NULL.");
+		return FALSE;
+	}
+	if((template_id < 1)||(template_id > LOG_UDP_TEMPLATE_COUNT)||(table->Entry_List[template_id-1] == NULL))
+	{
+		Log_Error_Number = 811;
+		sprintf(Log_Error_String,"Log_UDP_Template_Encode:Unknown template %d.",template_id);
+		return FALSE;
+	}
+	now_ms = Template_Monotonic_Ms();
+	if((now_ms-table->Refresh_Time_Ms) >= table->Refresh_Interval_Ms)
+		Log_UDP_Template_Refresh(table);
+	table->Pending_Id = 0;
+	entry = table->Entry_List[template_id-1];
+	if(entry->Is_Defined)
+	{
+		retval = Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+					       ((uint64_t)template_id)<<1);
+	}
+	else
+	{
+		retval = Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+					       (((uint64_t)template_id)<<1)|1);
+		retval = retval && Log_UDP_Encode_Varint_String(message_buffer,message_buffer_length,
+								message_buffer_position,entry->Format,
+								LOG_RECORD_MESSAGE_LENGTH);
+		entry->Is_Defined = TRUE;
+		table->Pending_Id = template_id;
+	}
+	retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+						 (uint64_t)entry->Argument_Count);
+	va_copy(argument_list_copy,argument_list);
+	for(i = 0; retval && (i < entry->Argument_Count); i++)
+	{
+		retval = Template_Encode_Argument(message_buffer,message_buffer_length,message_buffer_position,
+						  entry->Type_List[i],entry->Length_List[i],&argument_list_copy);
+	}
+	va_end(argument_list_copy);
+	return retval;
+}
+
+/**
+ * Finish encoding a packet with a sender's template table. If the packet was not sent, a definition it
+ * contained is forgotten, so the template is defined again in the next packet that uses it.
+ * @param table The template table.
+ * @param sent Whether the packet was sent, TRUE or FALSE.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Template_Encode
+ */
+int Log_UDP_Template_Packet_End(Log_UDP_Template_Table_T table,int sent)
+{
+	if(table == NULL)
+	{
+		Log_Error_Number = 812;
+		sprintf(Log_Error_String,"Log_UDP_Template_Packet_End:table was NULL.");
+		return FALSE;
+	}
+	if((!sent)&&(table->Pending_Id != 0))
+		table->Entry_List[table->Pending_Id-1]->Is_Defined = FALSE;
+	table->Pending_Id = 0;
+	return TRUE;
+}
+
+/**
+ * Decode a templated Message field and expand it into text. Definitions are remembered in the receiver's
+ * table. A reference to a template this receiver never saw defined is expanded as "&lt;template N&gt;"
+ * followed by the arguments.
+ * @param table The receiver's template table for the packet's sender.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to read from,
+ *        updated to the position after the field.
+ * @param message The Message field to fill in.
+ * @param message_length The length of message, longer expansions are truncated.
+ * @param template_id The address of an integer, filled in with the template's identifier.
+ * @param is_known The address of an integer, set to FALSE if the template was not known and left
+ *        alone otherwise.
+ * @return The routine returns TRUE on success and FALSE if the field was malformed.
+ * @see #Template_Decode_Argument
+ * @see #Template_Expand
+ * @see #Template_Expand_Unknown
+ */
+int Log_UDP_Template_Decode(Log_UDP_Template_Table_T table,const char *message_buffer,
+			    size_t message_buffer_length,size_t *message_buffer_position,
+			    char *message,size_t message_length,int *template_id,int *is_known)
+{
+	struct Template_Argument_Struct argument_list[LOG_UDP_TEMPLATE_ARGUMENT_COUNT];
+	struct Template_Entry_Struct *entry = NULL;
+	char format[LOG_RECORD_MESSAGE_LENGTH];
+	uint64_t code,id,argument_count;
+	int i,is_match;
+
+	if((table == NULL)||(message == NULL)||(template_id == NULL)||(is_known == NULL))
+	{
+		Log_Error_Number = 813;
+		sprintf(Log_Error_String,"Log_UDP_Template_Decode:NULL argument.");
+		return FALSE;
+	}
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&code))
+		return FALSE;
+	id = code >> 1;
+	if((id < 1)||(id > LOG_UDP_TEMPLATE_COUNT))
+	{
+		Log_Error_Number = 814;
+		sprintf(Log_Error_String,"Log_UDP_Template_Decode:Illegal template id %llu.",(unsigned long long)id);
+		return FALSE;
+	}
+	(*template_id) = (int)id;
+	if(code&1)
+	{
+		if(!Template_Decode_String(message_buffer,message_buffer_length,message_buffer_position,format,
+					   LOG_RECORD_MESSAGE_LENGTH))
+			return FALSE;
+		entry = table->Entry_List[id-1];
+		if(entry == NULL)
+		{
+			entry = (struct Template_Entry_Struct *)malloc(sizeof(struct Template_Entry_Struct));
+			if(entry == NULL)
+			{
+				Log_Error_Number = 815;
+				sprintf(Log_Error_String,"Log_UDP_Template_Decode:Failed to allocate template.");
+				return FALSE;
+			}
+			entry->Is_Defined = FALSE;
+			table->Entry_List[id-1] = entry;
+		}
+		/* a definition we can't parse leaves the template unknown */
+		entry->Is_Defined = Template_Parse(format,entry);
+	}
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&argument_count))
+		return FALSE;
+	if(argument_count > LOG_UDP_TEMPLATE_ARGUMENT_COUNT)
+	{
+		Log_Error_Number = 816;
+		sprintf(Log_Error_String,"Log_UDP_Template_Decode:Illegal argument count %llu.",
+			(unsigned long long)argument_count);
+		return FALSE;
+	}
+	for(i = 0; i < (int)argument_count; i++)
+	{
+		if(!Template_Decode_Argument(message_buffer,message_buffer_length,message_buffer_position,
+					     &(argument_list[i])))
+			return FALSE;
+	}
+	entry = table->Entry_List[id-1];
+	is_match = (entry != NULL)&&(entry->Is_Defined)&&(entry->Argument_Count == (int)argument_count);
+	for(i = 0; is_match && (i < (int)argument_count); i++)
+		is_match = (entry->Type_List[i] == argument_list[i].Type);
+	if(is_match)
+		Template_Expand(entry,argument_list,message,message_length);
+	else
+	{
+		Template_Expand_Unknown((int)id,argument_list,(int)argument_count,message,message_length);
+		(*is_known) = FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Free a template table and it's templates.
+ * @param table The template table, created with Log_UDP_Template_Table_Create.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Log_UDP_Template_Table_Create
+ */
+int Log_UDP_Template_Table_Destroy(Log_UDP_Template_Table_T table)
+{
+	int i;
+
+	if(table == NULL)
+	{
+		Log_Error_Number = 817;
+		sprintf(Log_Error_String,"Log_UDP_Template_Table_Destroy:table was NULL.");
+		return FALSE;
+	}
+	for(i = 0; i < LOG_UDP_TEMPLATE_COUNT; i++)
+	{
+		if(table->Entry_List[i] != NULL)
+			free(table->Entry_List[i]);
+	}
+	free(table);
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Parse a format, filling in a template's format, argument types and length modifiers.
+ * @param format The printf-style format.
+ * @param entry The template to fill in. Is_Defined is not changed.
+ * @return The routine returns TRUE on success and FALSE if the format uses something that is not supported,
+ *         or has too many conversions.
+ * @see #Template_Conversion_Parse
+ */
+static int Template_Parse(const char *format,struct Template_Entry_Struct *entry)
+{
+	size_t format_position,length_position;
+	int length_modifier,type;
+	char conversion;
+
+	strncpy(entry->Format,format,LOG_RECORD_MESSAGE_LENGTH-1);
+	entry->Format[LOG_RECORD_MESSAGE_LENGTH-1] = '\0';
+	entry->Argument_Count = 0;
+	format_position = 0;
+	while(entry->Format[format_position] != '\0')
+	{
+		if(entry->Format[format_position] != '%')
+		{
+			format_position++;
+			continue;
+		}
+		if(!Template_Conversion_Parse(entry->Format,&format_position,&length_position,&length_modifier,
+					      &conversion))
+			return FALSE;
+		switch(conversion)
+		{
+			case '%':
+				continue;
+			case 'd': case 'i': case 'c':
+				type = LOG_UDP_TEMPLATE_ARGUMENT_INT;
+				break;
+			case 'o': case 'u': case 'x': case 'X': case 'p':
+				type = LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED;
+				break;
+			case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+				type = LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE;
+				break;
+			case 's':
+				type = LOG_UDP_TEMPLATE_ARGUMENT_STRING;
+				break;
+			default:
+				Log_Error_Number = 818;
+				sprintf(Log_Error_String,"Template_Parse:Unsupported conversion '%c' in '%.80s'.",
+					conversion,format);
+				return FALSE;
+		}
+		/* wide characters/strings, and integer length modifiers on floating point conversions */
+		if((((conversion == 'c')||(conversion == 's'))&&(length_modifier != TEMPLATE_LENGTH_NONE))||
+		   ((type == LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE)&&(length_modifier != TEMPLATE_LENGTH_NONE)&&
+		    (length_modifier != TEMPLATE_LENGTH_LONG)&&(length_modifier != TEMPLATE_LENGTH_LONG_DOUBLE))||
+		   ((type != LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE)&&(length_modifier == TEMPLATE_LENGTH_LONG_DOUBLE)))
+		{
+			Log_Error_Number = 819;
+			sprintf(Log_Error_String,"Template_Parse:Unsupported length modifier for '%c' in '%.80s'.",
+				conversion,format);
+			return FALSE;
+		}
+		if(conversion == 'p')
+		{
+			if(length_modifier != TEMPLATE_LENGTH_NONE)
+			{
+				Log_Error_Number = 819;
+				sprintf(Log_Error_String,"Template_Parse:Unsupported length modifier for '%c' in '%.80s'.",
+					conversion,format);
+				return FALSE;
+			}
+			length_modifier = TEMPLATE_LENGTH_POINTER;
+		}
+		if(entry->Argument_Count >= LOG_UDP_TEMPLATE_ARGUMENT_COUNT)
+		{
+			Log_Error_Number = 820;
+			sprintf(Log_Error_String,"Template_Parse:More than %d arguments in '%.80s'.",
+				LOG_UDP_TEMPLATE_ARGUMENT_COUNT,format);
+			return FALSE;
+		}
+		entry->Type_List[entry->Argument_Count] = (unsigned char)type;
+		entry->Length_List[entry->Argument_Count] = (unsigned char)length_modifier;
+		entry->Argument_Count++;
+	}
+	return TRUE;
+}
+
+/**
+ * Parse one conversion specification ('%', flags, width, precision, length modifier and conversion character).
+ * @param format The format.
+ * @param format_position The address of the position of the '%' in format, updated to the position after
+ *        the conversion character.
+ * @param length_position The address of a position, filled in with the position of the length modifier
+ *        (or the conversion character if there isn't one). The characters before it are the '%', flags,
+ *        width and precision.
+ * @param length_modifier The address of an integer, filled in with the length modifier (TEMPLATE_LENGTH_*).
+ * @param conversion The address of a character, filled in with the conversion character ('%' for "%%").
+ * @return The routine returns TRUE on success and FALSE if the specification is not supported.
+ */
+static int Template_Conversion_Parse(const char *format,size_t *format_position,size_t *length_position,
+				     int *length_modifier,char *conversion)
+{
+	size_t position;
+
+	position = (*format_position)+1;
+	if(format[position] == '%')
+	{
+		(*length_position) = position;
+		(*length_modifier) = TEMPLATE_LENGTH_NONE;
+		(*conversion) = '%';
+		(*format_position) = position+1;
+		return TRUE;
+	}
+	while((format[position] != '\0')&&(strchr("-+ #0'",format[position]) != NULL))
+		position++;
+	while((format[position] >= '0')&&(format[position] <= '9'))
+		position++;
+	if(format[position] == '.')
+	{
+		position++;
+		while((format[position] >= '0')&&(format[position] <= '9'))
+			position++;
+	}
+	if((format[position] == '*')||(format[position] == '$'))
+	{
+		Log_Error_Number = 821;
+		sprintf(Log_Error_String,"Template_Conversion_Parse:'*' widths and positional arguments are not "
+			"supported in '%.80s'.",format);
+		return FALSE;
+	}
+	(*length_position) = position;
+	(*length_modifier) = TEMPLATE_LENGTH_NONE;
+	switch(format[position])
+	{
+		case 'h':
+			position++;
+			if(format[position] == 'h')
+			{
+				position++;
+				(*length_modifier) = TEMPLATE_LENGTH_CHAR;
+			}
+			else
+				(*length_modifier) = TEMPLATE_LENGTH_SHORT;
+			break;
+		case 'l':
+			position++;
+			if(format[position] == 'l')
+			{
+				position++;
+				(*length_modifier) = TEMPLATE_LENGTH_LONG_LONG;
+			}
+			else
+				(*length_modifier) = TEMPLATE_LENGTH_LONG;
+			break;
+		case 'q':
+			position++;
+			(*length_modifier) = TEMPLATE_LENGTH_LONG_LONG;
+			break;
+		case 'j':
+			position++;
+			(*length_modifier) = TEMPLATE_LENGTH_INTMAX;
+			break;
+		case 'z':
+			position++;
+			(*length_modifier) = TEMPLATE_LENGTH_SIZE;
+			break;
+		case 't':
+			position++;
+			(*length_modifier) = TEMPLATE_LENGTH_PTRDIFF;
+			break;
+		case 'L':
+			position++;
+			(*length_modifier) = TEMPLATE_LENGTH_LONG_DOUBLE;
+			break;
+		default:
+			break;
+	}
+	if(format[position] == '\0')
+	{
+		Log_Error_Number = 822;
+		sprintf(Log_Error_String,"Template_Conversion_Parse:Incomplete conversion at the end of '%.80s'.",
+			format);
+		return FALSE;
+	}
+	(*conversion) = format[position];
+	(*format_position) = position+1;
+	return TRUE;
+}
+
+/**
+ * Read one argument from the argument list and encode it, with it's type byte.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param type The argument's wire type, a member of LOG_UDP_TEMPLATE_ARGUMENT.
+ * @param length_modifier The argument's length modifier (TEMPLATE_LENGTH_*), which determines the C type read.
+ * @param argument_list The address of the argument list, the argument is read from it.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see log_udp_wire.html#Log_UDP_Encode_Varint
+ * @see log_udp_wire.html#Log_UDP_Encode_Varint_String
+ */
+static int Template_Encode_Argument(char *message_buffer,size_t message_buffer_length,
+				    size_t *message_buffer_position,int type,int length_modifier,
+				    va_list *argument_list)
+{
+	const char *string = NULL;
+	uint64_t unsigned_value;
+	int64_t int_value;
+	double double_value;
+	int i;
+
+	if(((*message_buffer_position)+1) > message_buffer_length)
+	{
+		Log_Error_Number = 823;
+		sprintf(Log_Error_String,"Template_Encode_Argument:Message Buffer overun(position %d + 1 > length %d).",
+			(*message_buffer_position),message_buffer_length);
+		return FALSE;
+	}
+	message_buffer[(*message_buffer_position)++] = (char)type;
+	switch(type)
+	{
+		case LOG_UDP_TEMPLATE_ARGUMENT_INT:
+			switch(length_modifier)
+			{
+				case TEMPLATE_LENGTH_CHAR:
+					int_value = (signed char)va_arg(*argument_list,int);
+					break;
+				case TEMPLATE_LENGTH_SHORT:
+					int_value = (short)va_arg(*argument_list,int);
+					break;
+				case TEMPLATE_LENGTH_LONG:
+					int_value = va_arg(*argument_list,long);
+					break;
+				case TEMPLATE_LENGTH_LONG_LONG:
+					int_value = va_arg(*argument_list,long long);
+					break;
+				case TEMPLATE_LENGTH_INTMAX:
+					int_value = va_arg(*argument_list,intmax_t);
+					break;
+				case TEMPLATE_LENGTH_SIZE:
+					int_value = (int64_t)va_arg(*argument_list,size_t);
+					break;
+				case TEMPLATE_LENGTH_PTRDIFF:
+					int_value = va_arg(*argument_list,ptrdiff_t);
+					break;
+				default:
+					int_value = va_arg(*argument_list,int);
+					break;
+			}
+			/* zig-zag, so small negative numbers are short too */
+			unsigned_value = (((uint64_t)int_value)<<1)^((uint64_t)(int_value>>63));
+			return Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+						     unsigned_value);
+		case LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED:
+			switch(length_modifier)
+			{
+				case TEMPLATE_LENGTH_CHAR:
+					unsigned_value = (unsigned char)va_arg(*argument_list,unsigned int);
+					break;
+				case TEMPLATE_LENGTH_SHORT:
+					unsigned_value = (unsigned short)va_arg(*argument_list,unsigned int);
+					break;
+				case TEMPLATE_LENGTH_LONG:
+					unsigned_value = va_arg(*argument_list,unsigned long);
+					break;
+				case TEMPLATE_LENGTH_LONG_LONG:
+					unsigned_value = va_arg(*argument_list,unsigned long long);
+					break;
+				case TEMPLATE_LENGTH_INTMAX:
+					unsigned_value = va_arg(*argument_list,uintmax_t);
+					break;
+				case TEMPLATE_LENGTH_SIZE:
+					unsigned_value = va_arg(*argument_list,size_t);
+					break;
+				case TEMPLATE_LENGTH_PTRDIFF:
+					unsigned_value = (uint64_t)va_arg(*argument_list,ptrdiff_t);
+					break;
+				case TEMPLATE_LENGTH_POINTER:
+					unsigned_value = (uint64_t)(uintptr_t)va_arg(*argument_list,void *);
+					break;
+				default:
+					unsigned_value = va_arg(*argument_list,unsigned int);
+					break;
+			}
+			return Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+						     unsigned_value);
+		case LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE:
+			if(length_modifier == TEMPLATE_LENGTH_LONG_DOUBLE)
+				double_value = (double)va_arg(*argument_list,long double);
+			else
+				double_value = va_arg(*argument_list,double);
+			if(((*message_buffer_position)+sizeof(uint64_t)) > message_buffer_length)
+			{
+				Log_Error_Number = 823;
+				sprintf(Log_Error_String,"Template_Encode_Argument:Message Buffer overun"
+					"(position %d + 8 > length %d).",(*message_buffer_position),message_buffer_length);
+				return FALSE;
+			}
+			memcpy(&unsigned_value,&double_value,sizeof(uint64_t));
+			for(i = 7; i >= 0; i--)
+				message_buffer[(*message_buffer_position)++] = (char)((unsigned_value>>(i*8))&0xff);
+			return TRUE;
+		default:
+			string = va_arg(*argument_list,const char *);
+			if(string == NULL)
+				string = "(null)";
+			return Log_UDP_Encode_Varint_String(message_buffer,message_buffer_length,message_buffer_position,
+							    string,LOG_UDP_TEMPLATE_STRING_LENGTH);
+	}
+}
+
+/**
+ * Decode one argument and it's type byte.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the argument.
+ * @param argument The address of an argument to fill in.
+ * @return The routine returns TRUE on success and FALSE if the argument was malformed.
+ * @see #Template_Decode_String
+ */
+static int Template_Decode_Argument(const char *message_buffer,size_t message_buffer_length,
+				    size_t *message_buffer_position,struct Template_Argument_Struct *argument)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+	uint64_t value;
+	int i;
+
+	if((*message_buffer_position) >= message_buffer_length)
+	{
+		Log_Error_Number = 824;
+		sprintf(Log_Error_String,"Template_Decode_Argument:Packet too short(%d).",message_buffer_length);
+		return FALSE;
+	}
+	argument->Type = buffer[(*message_buffer_position)++];
+	switch(argument->Type)
+	{
+		case LOG_UDP_TEMPLATE_ARGUMENT_INT:
+			if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&value))
+				return FALSE;
+			argument->Int = (int64_t)((value>>1)^(-(value&1)));
+			return TRUE;
+		case LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED:
+			return Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+						     &(argument->Unsigned));
+		case LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE:
+			if(((*message_buffer_position)+sizeof(uint64_t)) > message_buffer_length)
+			{
+				Log_Error_Number = 824;
+				sprintf(Log_Error_String,"Template_Decode_Argument:Packet too short(%d).",
+					message_buffer_length);
+				return FALSE;
+			}
+			value = 0;
+			for(i = 0; i < 8; i++)
+				value = (value<<8)|buffer[(*message_buffer_position)++];
+			memcpy(&(argument->Double),&value,sizeof(double));
+			return TRUE;
+		case LOG_UDP_TEMPLATE_ARGUMENT_STRING:
+			return Template_Decode_String(message_buffer,message_buffer_length,message_buffer_position,
+						      argument->String,LOG_UDP_TEMPLATE_STRING_LENGTH);
+		default:
+			Log_Error_Number = 825;
+			sprintf(Log_Error_String,"Template_Decode_Argument:Unknown argument type %d.",argument->Type);
+			return FALSE;
+	}
+}
+
+/**
+ * Decode a varint length prefixed string, truncating it to fit the field.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the string.
+ * @param field The field to fill in.
+ * @param field_length The length of the field.
+ * @return The routine returns TRUE on success and FALSE if the string ran off the end of the buffer.
+ */
+static int Template_Decode_String(const char *message_buffer,size_t message_buffer_length,
+				  size_t *message_buffer_position,char *field,size_t field_length)
+{
+	uint64_t string_length;
+	size_t copy_length;
+
+	if(!Log_UDP_Decode_Varint(message_buffer,message_buffer_length,message_buffer_position,&string_length))
+		return FALSE;
+	if(string_length > (message_buffer_length-(*message_buffer_position)))
+	{
+		Log_Error_Number = 826;
+		sprintf(Log_Error_String,"Template_Decode_String:String length %llu at position %d overruns length %d.",
+			(unsigned long long)string_length,(*message_buffer_position),message_buffer_length);
+		return FALSE;
+	}
+	copy_length = (size_t)string_length;
+	if(copy_length > (field_length-1))
+		copy_length = field_length-1;
+	memcpy(field,message_buffer+(*message_buffer_position),copy_length);
+	field[copy_length] = '\0';
+	(*message_buffer_position) += (size_t)string_length;
+	return TRUE;
+}
+
+/**
+ * Expand a template with it's decoded arguments. Each conversion specification is rebuilt with the length
+ * modifier of the decoded value (long long for integers), and printed with snprintf.
+ * The argument types must already have been checked against the template.
+ * @param entry The template.
+ * @param argument_list The decoded arguments.
+ * @param message The buffer to expand into.
+ * @param message_length The length of message, the expansion is truncated to fit.
+ * @see #Template_Conversion_Parse
+ * @see #Template_Append
+ */
+static void Template_Expand(struct Template_Entry_Struct *entry,struct Template_Argument_Struct *argument_list,
+			    char *message,size_t message_length)
+{
+	struct Template_Argument_Struct *argument = NULL;
+	char spec[TEMPLATE_SPEC_LENGTH];
+	size_t format_position,spec_start,length_position,message_position,spec_length;
+	int length_modifier,argument_index,print_length;
+	char conversion;
+
+	message_position = 0;
+	message[0] = '\0';
+	format_position = 0;
+	argument_index = 0;
+	while((entry->Format[format_position] != '\0')&&(message_position < (message_length-1)))
+	{
+		if(entry->Format[format_position] != '%')
+		{
+			message[message_position++] = entry->Format[format_position++];
+			message[message_position] = '\0';
+			continue;
+		}
+		spec_start = format_position;
+		/* the format was parsed when it was defined */
+		Template_Conversion_Parse(entry->Format,&format_position,&length_position,&length_modifier,
+					  &conversion);
+		if(conversion == '%')
+		{
+			message[message_position++] = '%';
+			message[message_position] = '\0';
+			continue;
+		}
+		argument = &(argument_list[argument_index++]);
+		spec_length = length_position-spec_start;
+		if(spec_length > (TEMPLATE_SPEC_LENGTH-5))
+			spec_length = TEMPLATE_SPEC_LENGTH-5;
+		memcpy(spec,entry->Format+spec_start,spec_length);
+		switch(conversion)
+		{
+			case 'd': case 'i':
+				strcpy(spec+spec_length,"lld");
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							(long long)argument->Int);
+				break;
+			case 'c':
+				spec[spec_length] = 'c';
+				spec[spec_length+1] = '\0';
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							(int)argument->Int);
+				break;
+			case 'p':
+				strcpy(spec+spec_length,"llx");
+				Template_Append(message,message_length,&message_position,
+						snprintf(message+message_position,message_length-message_position,"0x"));
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							(unsigned long long)argument->Unsigned);
+				break;
+			case 'o': case 'u': case 'x': case 'X':
+				spec[spec_length] = 'l';
+				spec[spec_length+1] = 'l';
+				spec[spec_length+2] = conversion;
+				spec[spec_length+3] = '\0';
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							(unsigned long long)argument->Unsigned);
+				break;
+			case 's':
+				spec[spec_length] = 's';
+				spec[spec_length+1] = '\0';
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							argument->String);
+				break;
+			default:
+				spec[spec_length] = conversion;
+				spec[spec_length+1] = '\0';
+				print_length = snprintf(message+message_position,message_length-message_position,spec,
+							argument->Double);
+				break;
+		}
+		Template_Append(message,message_length,&message_position,print_length);
+	}
+}
+
+/**
+ * Expand a template the receiver doesn't know (or whose arguments don't match it's definition) as
+ * "&lt;template N&gt;" followed by each argument.
+ * @param template_id The template's identifier.
+ * @param argument_list The decoded arguments.
+ * @param argument_count The number of arguments.
+ * @param message The buffer to expand into.
+ * @param message_length The length of message, the expansion is truncated to fit.
+ * @see #Template_Append
+ */
+static void Template_Expand_Unknown(int template_id,struct Template_Argument_Struct *argument_list,
+				    int argument_count,char *message,size_t message_length)
+{
+	size_t message_position;
+	int i,print_length;
+
+	message_position = 0;
+	print_length = snprintf(message,message_length,"<template %d>",template_id);
+	Template_Append(message,message_length,&message_position,print_length);
+	for(i = 0; i < argument_count; i++)
+	{
+		switch(argument_list[i].Type)
+		{
+			case LOG_UDP_TEMPLATE_ARGUMENT_INT:
+				print_length = snprintf(message+message_position,message_length-message_position," %lld",
+							(long long)argument_list[i].Int);
+				break;
+			case LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED:
+				print_length = snprintf(message+message_position,message_length-message_position," %llu",
+							(unsigned long long)argument_list[i].Unsigned);
+				break;
+			case LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE:
+				print_length = snprintf(message+message_position,message_length-message_position," %g",
+							argument_list[i].Double);
+				break;
+			default:
+				print_length = snprintf(message+message_position,message_length-message_position," %s",
+							argument_list[i].String);
+				break;
+		}
+		Template_Append(message,message_length,&message_position,print_length);
+	}
+}
+
+/**
+ * Move the message position past the characters snprintf printed, allowing for truncation.
+ * @param message The message being expanded.
+ * @param message_length The length of message.
+ * @param message_position The address of the position in message, updated.
+ * @param print_length The value snprintf returned.
+ */
+static void Template_Append(char *message,size_t message_length,size_t *message_position,int print_length)
+{
+	if(print_length < 0)
+	{
+		message[(*message_position)] = '\0';
+		return;
+	}
+	if(((*message_position)+print_length) > (message_length-1))
+		(*message_position) = message_length-1;
+	else
+		(*message_position) += print_length;
+}
+
+/**
+ * Get the current monotonic time in milliseconds.
+ * @return The time in milliseconds.
+ * @see #ONE_SECOND_MS
+ * @see #ONE_MILLISECOND_NS
+ */
+static int64_t Template_Monotonic_Ms(void)
+{
+	struct timespec now_time;
+
+	clock_gettime(CLOCK_MONOTONIC,&now_time);
+	return (((int64_t)now_time.tv_sec)*ONE_SECOND_MS)+(now_time.tv_nsec/ONE_MILLISECOND_NS);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,1043 @@
+/* log_udp_wire.c
+** GLS logging using UDP packets
+** $Header$
+*/
+/**
+ * Wire format version 2 encoding, and the reference decoder for version 1 and version 2 packets.
+ * A version 2 packet is:
+ * <ul>
+ * <li>The magic word LOG_UDP_PACKET_MAGIC_WORD_V2, two bytes in network byte order.</li>
+ * <li>A flags byte (LOG_UDP_V2_FLAG_*).</li>
+ * <li>If LOG_UDP_V2_FLAG_DICTIONARY is set, one byte holding the sender's dictionary generation.</li>
+ * <li>The timestamp as a varint, in milliseconds (or microseconds if LOG_UDP_V2_FLAG_MICROSECONDS is set)
+ *     since 1970.</li>
+ * <li>One byte, the Severity in the top 4 bits and the Verbosity in the bottom 4 bits.</li>
+ * <li>The System, Sub_System, Source_File, Source_Instance, Function, Category and Message,
+ *     each as a varint length followed by that many bytes (no NULL terminator).</li>
+ * <li>The number of contexts as a varint, then each context's Keyword and Value as varint length
+ *     prefixed strings.</li>
+ * </ul>
+ * If LOG_UDP_V2_FLAG_DICTIONARY is set, every string is sent through the sender's string dictionary instead
+ * (see log_udp_dictionary.c). If LOG_UDP_V2_FLAG_TEMPLATE is set, the Message is a template identifier and
+ * it's arguments (see log_udp_template.c). If LOG_UDP_V2_FLAG_COMPRESSED is set, everything after the flags byte
+ * is compressed (see Log_UDP_Compress_V2).
+ * Varints are unsigned LEB128: 7 bits per byte, least significant group first, with the top bit set on every
+ * byte but the last. The decoder accepts non-minimal varints (Log_UDP_Sendf uses a fixed two byte length).
+ * @author Chris Mottram
+ * @version $Revision$
+ */
+#include <errno.h>   /* Error number definitions */
+#ifdef __linux
+#include <stdint.h>  /* defines int64_t (Java long) */
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_template.h"
+#include "log_udp_compress.h"
+#include "log_udp_container.h"
+#include "log_udp_wire.h"
+
+/* hash defines */
+/**
+ * The number of microseconds in one millisecond.
+ */
+#define ONE_MILLISECOND_US              (1000)
+
+/* internal variables */
+/**
+ * Revision Control System identifier.
+ */
+static char rcsid[] = "$Id$";
+
+/* internal function declarations */
+static int Decode_V1(const unsigned char *message_buffer,size_t message_buffer_length,
+		     struct Log_Record_Struct *log_record,int *log_context_count,
+		     struct Log_Context_Struct **log_context_list);
+static int Decode_V2(const unsigned char *message_buffer,size_t message_buffer_length,
+		     Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+		     struct Log_Record_Struct *log_record,int *log_context_count,
+		     struct Log_Context_Struct **log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info);
+static int Decode_V2_Compressed(const unsigned char *message_buffer,size_t message_buffer_length,
+				Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+				struct Log_Record_Struct *log_record,int *log_context_count,
+				struct Log_Context_Struct **log_context_list,
+				struct Log_UDP_Packet_Info_Struct *packet_info);
+static int Decode_V1_Int(const unsigned char *message_buffer,size_t message_buffer_length,
+			 size_t *message_buffer_position,int64_t *value,int byte_count);
+static int Decode_V1_String(const unsigned char *message_buffer,size_t message_buffer_length,
+			    size_t *message_buffer_position,char *field,size_t field_length);
+static int Decode_V2_String(const unsigned char *message_buffer,size_t message_buffer_length,
+			    size_t *message_buffer_position,char *field,size_t field_length);
+static int Decode_V2_Name(Log_UDP_Dictionary_T dictionary,const unsigned char *message_buffer,
+			  size_t message_buffer_length,size_t *message_buffer_position,char *field,size_t field_length,
+			  struct Log_UDP_Packet_Info_Struct *packet_info);
+static int Encode_V2_Name(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			  size_t *message_buffer_position,const char *string,size_t field_length);
+static int Encode_V2_Value(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			   size_t *message_buffer_position,const char *string,size_t field_length);
+static int Decode_Context_List_Allocate(int log_context_count,struct Log_Context_Struct **log_context_list);
+
+/* ---------------------------------------------------------------
+**  External functions
+** --------------------------------------------------------------- */
+/**
+ * Encode a log record and it's contexts into a version 2 packet. The timestamp is sent in milliseconds.
+ * If a sender's dictionary is supplied, the packet is sent with LOG_UDP_V2_FLAG_DICTIONARY set. The caller
+ * must then call Log_UDP_Dictionary_Packet_End once it knows whether the packet was sent (even if this
+ * routine fails). If a stream tag is supplied, the packet is sent with LOG_UDP_V2_FLAG_SEQUENCE set.
+ * @param log_record The address of the log record.
+ * @param log_context_count The number of context records in log_context_list.
+ * @param log_context_list An allocated list of log contexts.
+ * @param dictionary The sender's dictionary, or NULL to send every string in full.
+ * @param stream_tag The sender's stream tag (Sequence_Host_Id, Sequence_Pid and Sequence_Start_Us) and the
+ *        packet's Sequence_Number, or NULL to send the packet without a sequence number.
+ * @param message_buffer The buffer to encode into, at least LOG_UDP_V2_BUFFER_LENGTH(log_context_count)
+ *        bytes long.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param encoded_length The address of a size_t, on success filled in with the length of the packet in bytes.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_PACKET_MAGIC_WORD_V2
+ * @see #LOG_UDP_V2_BUFFER_LENGTH
+ * @see #Log_UDP_Encode_Varint
+ * @see #Log_UDP_Encode_Varint_String
+ * @see #Encode_V2_Name
+ * @see #Encode_V2_Value
+ * @see #LOG_UDP_V2_FLAG_SEQUENCE
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Packet_Start
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Packet_End
+ */
+int Log_UDP_Encode_V2(const struct Log_Record_Struct *log_record,int log_context_count,
+		      const struct Log_Context_Struct *log_context_list,Log_UDP_Dictionary_T dictionary,
+		      const struct Log_UDP_Packet_Info_Struct *stream_tag,char *message_buffer,
+		      size_t message_buffer_length,size_t *encoded_length)
+{
+	size_t message_buffer_position;
+	int retval,generation,i;
+
+	if(log_record == NULL)
+	{
+		Log_Error_Number = 600;
+		sprintf(Log_Error_String,"Log_UDP_Encode_V2:log_record was NULL.");
+		return FALSE;
+	}
+	if((log_context_count < 0)||((log_context_count > 0)&&(log_context_list == NULL)))
+	{
+		Log_Error_Number = 601;
+		sprintf(Log_Error_String,"Log_UDP_Encode_V2:Illegal log context list (count %d).",log_context_count);
+		return FALSE;
+	}
+	if((message_buffer == NULL)||(encoded_length == NULL))
+	{
+		Log_Error_Number = 602;
+		sprintf(Log_Error_String,"Log_UDP_Encode_V2:message_buffer or encoded_length was NULL.");
+		return FALSE;
+	}
+	if(message_buffer_length < 4)
+	{
+		Log_Error_Number = 603;
+		sprintf(Log_Error_String,"Log_UDP_Encode_V2:Message Buffer overun(length %d).",message_buffer_length);
+		return FALSE;
+	}
+	/* magic word and flags */
+	message_buffer[0] = (char)((LOG_UDP_PACKET_MAGIC_WORD_V2 >> 8)&0xff);
+	message_buffer[1] = (char)(LOG_UDP_PACKET_MAGIC_WORD_V2&0xff);
+	message_buffer[2] = 0;
+	message_buffer_position = 3;
+	if(dictionary != NULL)
+	{
+		if(!Log_UDP_Dictionary_Packet_Start(dictionary,&generation))
+			return FALSE;
+		message_buffer[2] = LOG_UDP_V2_FLAG_DICTIONARY;
+		message_buffer[message_buffer_position++] = (char)generation;
+	}
+	retval = TRUE;
+	if(stream_tag != NULL)
+	{
+		message_buffer[2] |= LOG_UDP_V2_FLAG_SEQUENCE;
+		retval = Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+					       stream_tag->Sequence_Host_Id);
+		retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+							 stream_tag->Sequence_Pid);
+		retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+							 stream_tag->Sequence_Start_Us);
+		retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+							 stream_tag->Sequence_Number);
+	}
+	retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+						 (uint64_t)log_record->Timestamp);
+	if(retval && (message_buffer_position >= message_buffer_length))
+	{
+		Log_Error_Number = 603;
+		sprintf(Log_Error_String,"Log_UDP_Encode_V2:Message Buffer overun(length %d).",message_buffer_length);
+		retval = FALSE;
+	}
+	if(retval)
+	{
+		message_buffer[message_buffer_position++] = (char)(((log_record->Severity&0xf) << 4)|
+								   (log_record->Verbosity&0xf));
+	}
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->System,LOG_RECORD_SYSTEM_LENGTH);
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Sub_System,LOG_RECORD_SUB_SYSTEM_LENGTH);
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Source_File,LOG_RECORD_SOURCE_FILE_LENGTH);
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Source_Instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH);
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Function,LOG_RECORD_FUNCTION_LENGTH);
+	retval = retval && Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Category,LOG_RECORD_CATEGORY_LENGTH);
+	retval = retval && Encode_V2_Value(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					   log_record->Message,LOG_RECORD_MESSAGE_LENGTH);
+	retval = retval && Log_UDP_Encode_Varint(message_buffer,message_buffer_length,&message_buffer_position,
+						 (uint64_t)log_context_count);
+	for(i = 0; retval && (i < log_context_count); i++)
+	{
+		retval = Encode_V2_Name(dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					log_context_list[i].Keyword,LOG_CONTEXT_KEYWORD_LENGTH);
+		retval = retval && Encode_V2_Value(dictionary,message_buffer,message_buffer_length,
+						   &message_buffer_position,log_context_list[i].Value,
+						   LOG_CONTEXT_VALUE_LENGTH);
+	}
+	if(!retval)
+		return FALSE;
+	(*encoded_length) = message_buffer_position;
+	return TRUE;
+}
+
+/**
+ * Encode an unsigned integer as a varint (unsigned LEB128) into a message buffer.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the varint.
+ * @param value The value to encode.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ */
+int Log_UDP_Encode_Varint(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+			  uint64_t value)
+{
+	size_t position;
+
+	position = (*message_buffer_position);
+	do
+	{
+		if(position >= message_buffer_length)
+		{
+			Log_Error_Number = 604;
+			sprintf(Log_Error_String,"Log_UDP_Encode_Varint:Message Buffer overun(position %d, length %d).",
+				position,message_buffer_length);
+			return FALSE;
+		}
+		if(value > 0x7f)
+			message_buffer[position++] = (char)((value&0x7f)|0x80);
+		else
+			message_buffer[position++] = (char)value;
+		value >>= 7;
+	}
+	while(value > 0);
+	(*message_buffer_position) = position;
+	return TRUE;
+}
+
+/**
+ * Encode a string, truncated to fit into a log record field of field_length bytes, as a varint length
+ * followed by the characters (without a NULL terminator). A NULL string is encoded as an empty string.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to,
+ *        updated to the position after the string.
+ * @param string The string to encode, or NULL.
+ * @param field_length The length of the log record field, the string is truncated to (field_length-1)
+ *        characters.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Log_UDP_Encode_Varint
+ */
+int Log_UDP_Encode_Varint_String(char *message_buffer,size_t message_buffer_length,
+				 size_t *message_buffer_position,const char *string,size_t field_length)
+{
+	const char *end_ch = NULL;
+	size_t string_length;
+
+	if(string == NULL)
+		string_length = 0;
+	else
+	{
+		end_ch = memchr(string,'\0',field_length-1);
+		if(end_ch != NULL)
+			string_length = end_ch-string;
+		else
+			string_length = field_length-1;
+	}
+	if(!Log_UDP_Encode_Varint(message_buffer,message_buffer_length,message_buffer_position,
+				  (uint64_t)string_length))
+		return FALSE;
+	if(((*message_buffer_position)+string_length) > message_buffer_length)
+	{
+		Log_Error_Number = 605;
+		sprintf(Log_Error_String,"Log_UDP_Encode_Varint_String:Message Buffer overun"
+			"(position %d + %d > length %d).",(*message_buffer_position),string_length,message_buffer_length);
+		return FALSE;
+	}
+	if(string_length > 0)
+		memcpy(message_buffer+(*message_buffer_position),string,string_length);
+	(*message_buffer_position) += string_length;
+	return TRUE;
+}
+
+/**
+ * Compress an encoded version 2 packet. The magic word is copied, the flags byte has LOG_UDP_V2_FLAG_COMPRESSED
+ * added, and the rest of the packet is compressed, preceded by it's length as a varint. Small packets, and
+ * those that don't compress, can come out longer: the caller should send whichever is shorter.
+ * @param message_buffer The encoded version 2 packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param compressed_buffer The buffer to write the compressed packet to.
+ *        3 + LOG_UDP_VARINT_LENGTH + LOG_UDP_COMPRESS_BOUND(message_buffer_length) bytes is always enough.
+ * @param compressed_buffer_length The length of compressed_buffer in bytes.
+ * @param compressed_length The address of a size_t, on success filled in with the length of the
+ *        compressed packet.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_V2_FLAG_COMPRESSED
+ * @see log_udp_compress.html#Log_UDP_Compress
+ */
+int Log_UDP_Compress_V2(const char *message_buffer,size_t message_buffer_length,char *compressed_buffer,
+			size_t compressed_buffer_length,size_t *compressed_length)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+	size_t compressed_buffer_position,body_length;
+
+	if((message_buffer == NULL)||(compressed_buffer == NULL)||(compressed_length == NULL))
+	{
+		Log_Error_Number = 619;
+		sprintf(Log_Error_String,"Log_UDP_Compress_V2:NULL argument.");
+		return FALSE;
+	}
+	if((message_buffer_length < 3)||(buffer[0] != ((LOG_UDP_PACKET_MAGIC_WORD_V2 >> 8)&0xff))||
+	   (buffer[1] != (LOG_UDP_PACKET_MAGIC_WORD_V2&0xff))||(buffer[2]&LOG_UDP_V2_FLAG_COMPRESSED))
+	{
+		Log_Error_Number = 620;
+		sprintf(Log_Error_String,"Log_UDP_Compress_V2:Not an uncompressed version 2 packet(length %d).",
+			message_buffer_length);
+		return FALSE;
+	}
+	if(compressed_buffer_length < 3)
+	{
+		Log_Error_Number = 621;
+		sprintf(Log_Error_String,"Log_UDP_Compress_V2:Compressed buffer too short(%d).",
+			compressed_buffer_length);
+		return FALSE;
+	}
+	compressed_buffer[0] = message_buffer[0];
+	compressed_buffer[1] = message_buffer[1];
+	compressed_buffer[2] = (char)(buffer[2]|LOG_UDP_V2_FLAG_COMPRESSED);
+	compressed_buffer_position = 3;
+	body_length = message_buffer_length-3;
+	if(!Log_UDP_Encode_Varint(compressed_buffer,compressed_buffer_length,&compressed_buffer_position,
+				  (uint64_t)body_length))
+		return FALSE;
+	if(!Log_UDP_Compress(message_buffer+3,body_length,compressed_buffer+compressed_buffer_position,
+			     compressed_buffer_length-compressed_buffer_position,&body_length))
+		return FALSE;
+	(*compressed_length) = compressed_buffer_position+body_length;
+	return TRUE;
+}
+
+/**
+ * Decode a received packet, in either wire format, back into a log record and it's contexts.
+ * This is the reference decoder: every length is checked against the packet, and strings longer
+ * than the log record fields are truncated. Packets sent with a dictionary can't be decoded,
+ * use Log_UDP_Decode_Dictionary for those.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer. On success this is set to a newly allocated
+ *        list of contexts (or NULL if there were none), which the caller should free.
+ * @param packet_info The address of a structure filled in with the wire format, flags and microsecond
+ *        timestamp. Can be NULL.
+ * @return The routine returns TRUE on success and FALSE if the packet could not be decoded.
+ * @see #Log_UDP_Decode_Dictionary
+ */
+int Log_UDP_Decode(const char *message_buffer,size_t message_buffer_length,
+		   struct Log_Record_Struct *log_record,int *log_context_count,
+		   struct Log_Context_Struct **log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	return Log_UDP_Decode_Dictionary(message_buffer,message_buffer_length,NULL,log_record,log_context_count,
+					 log_context_list,packet_info);
+}
+
+/**
+ * Decode a received packet, in either wire format, back into a log record and it's contexts, using
+ * a receiver's dictionary for packets sent with LOG_UDP_V2_FLAG_DICTIONARY. The dictionary holds the
+ * strings defined by one sender, so the receiver should keep one for each sender address.
+ * Packets sent with LOG_UDP_V2_FLAG_TEMPLATE can't be decoded, use Log_UDP_Decode_Template.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dictionary The receiver's dictionary for the packet's sender, or NULL.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer. On success this is set to a newly allocated
+ *        list of contexts (or NULL if there were none), which the caller should free.
+ * @param packet_info The address of a structure filled in with the wire format, flags, microsecond
+ *        timestamp and whether every dictionary reference was known. Can be NULL.
+ * @return The routine returns TRUE on success and FALSE if the packet could not be decoded.
+ * @see #Log_UDP_Decode_Template
+ */
+int Log_UDP_Decode_Dictionary(const char *message_buffer,size_t message_buffer_length,
+			      Log_UDP_Dictionary_T dictionary,struct Log_Record_Struct *log_record,
+			      int *log_context_count,struct Log_Context_Struct **log_context_list,
+			      struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	return Log_UDP_Decode_Template(message_buffer,message_buffer_length,dictionary,NULL,log_record,
+				       log_context_count,log_context_list,packet_info);
+}
+
+/**
+ * Decode a received packet, in either wire format, back into a log record and it's contexts, using
+ * a receiver's dictionary for packets sent with LOG_UDP_V2_FLAG_DICTIONARY, and a receiver's template table
+ * for packets sent with LOG_UDP_V2_FLAG_TEMPLATE. Both hold what one sender has defined, so the receiver
+ * should keep one of each for each sender address.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dictionary The receiver's dictionary for the packet's sender, or NULL.
+ * @param template_table The receiver's template table for the packet's sender, or NULL.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer. On success this is set to a newly allocated
+ *        list of contexts (or NULL if there were none), which the caller should free.
+ * @param packet_info The address of a structure filled in with the wire format, flags, microsecond
+ *        timestamp, template identifier, whether every dictionary reference and template was known,
+ *        and the stream tag and sequence number.
+ *        Can be NULL.
+ * @return The routine returns TRUE on success and FALSE if the packet could not be decoded.
+ * @see #Decode_V1
+ * @see #Decode_V2
+ * @see #Log_UDP_Packet_Info_Struct
+ */
+int Log_UDP_Decode_Template(const char *message_buffer,size_t message_buffer_length,
+			    Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+			    struct Log_Record_Struct *log_record,int *log_context_count,
+			    struct Log_Context_Struct **log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	const unsigned char *buffer = (const unsigned char *)message_buffer;
+	struct Log_UDP_Packet_Info_Struct info;
+
+	if((message_buffer == NULL)||(log_record == NULL)||(log_context_count == NULL)||(log_context_list == NULL))
+	{
+		Log_Error_Number = 606;
+		sprintf(Log_Error_String,"Log_UDP_Decode_Template:NULL argument.");
+		return FALSE;
+	}
+	memset(log_record,0,sizeof(struct Log_Record_Struct));
+	(*log_context_count) = 0;
+	(*log_context_list) = NULL;
+	memset(&info,0,sizeof(struct Log_UDP_Packet_Info_Struct));
+	info.Dictionary_Complete = TRUE;
+	info.Template_Complete = TRUE;
+	if((message_buffer_length >= 4)&&(buffer[0] == 0)&&(buffer[1] == 0)&&
+	   (buffer[2] == ((LOG_UDP_PACKET_MAGIC_WORD >> 8)&0xff))&&(buffer[3] == (LOG_UDP_PACKET_MAGIC_WORD&0xff)))
+	{
+		info.Format = LOG_UDP_WIRE_FORMAT_V1;
+		if(!Decode_V1(buffer,message_buffer_length,log_record,log_context_count,log_context_list))
+			return FALSE;
+		info.Timestamp_Us = log_record->Timestamp*ONE_MILLISECOND_US;
+	}
+	else if((message_buffer_length >= 2)&&(buffer[0] == ((LOG_UDP_PACKET_MAGIC_WORD_V2 >> 8)&0xff))&&
+		(buffer[1] == (LOG_UDP_PACKET_MAGIC_WORD_V2&0xff)))
+	{
+		info.Format = LOG_UDP_WIRE_FORMAT_V2;
+		if(!Decode_V2(buffer,message_buffer_length,dictionary,template_table,log_record,log_context_count,
+			      log_context_list,&info))
+			return FALSE;
+	}
+	else if(Log_UDP_Container_Is_Container(message_buffer,message_buffer_length))
+	{
+		Log_Error_Number = 625;
+		sprintf(Log_Error_String,"Log_UDP_Decode_Template:Packet of length %d is a container:"
+			"unpack it with Log_UDP_Container_Unpack_Next.",message_buffer_length);
+		return FALSE;
+	}
+	else
+	{
+		Log_Error_Number = 607;
+		sprintf(Log_Error_String,"Log_UDP_Decode_Template:Unknown magic word in packet of length %d.",
+			message_buffer_length);
+		return FALSE;
+	}
+	if(packet_info != NULL)
+		(*packet_info) = info;
+	return TRUE;
+}
+
+/**
+ * Decode a varint (unsigned LEB128) from a message buffer.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to read from,
+ *        updated to the position after the varint.
+ * @param value The address of an unsigned 64 bit integer to fill in with the value.
+ * @return The routine returns TRUE on success and FALSE if the varint ran off the end of the buffer,
+ *         or was longer than LOG_UDP_VARINT_LENGTH bytes.
+ * @see #LOG_UDP_VARINT_LENGTH
+ */
+int Log_UDP_Decode_Varint(const char *message_buffer,size_t message_buffer_length,
+			  size_t *message_buffer_position,uint64_t *value)
+{
+	uint64_t result;
+	size_t position;
+	unsigned char ch;
+	int shift;
+
+	result = 0;
+	shift = 0;
+	position = (*message_buffer_position);
+	do
+	{
+		if((position >= message_buffer_length)||(shift >= (7*LOG_UDP_VARINT_LENGTH)))
+		{
+			Log_Error_Number = 608;
+			sprintf(Log_Error_String,"Log_UDP_Decode_Varint:Illegal varint at position %d (length %d).",
+				(*message_buffer_position),message_buffer_length);
+			return FALSE;
+		}
+		ch = (unsigned char)message_buffer[position++];
+		result |= ((uint64_t)(ch&0x7f)) << shift;
+		shift += 7;
+	}
+	while(ch&0x80);
+	(*message_buffer_position) = position;
+	(*value) = result;
+	return TRUE;
+}
+
+/* ---------------------------------------------------------------
+**  Internal functions
+** --------------------------------------------------------------- */
+/**
+ * Decode a version 1 packet.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer, set to a newly allocated list.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Decode_V1_Int
+ * @see #Decode_V1_String
+ * @see #Decode_Context_List_Allocate
+ */
+static int Decode_V1(const unsigned char *message_buffer,size_t message_buffer_length,
+		     struct Log_Record_Struct *log_record,int *log_context_count,
+		     struct Log_Context_Struct **log_context_list)
+{
+	size_t message_buffer_position;
+	int64_t value;
+	int retval,i;
+
+	/* skip magic word */
+	message_buffer_position = 4;
+	retval = Decode_V1_Int(message_buffer,message_buffer_length,&message_buffer_position,
+			       &(log_record->Timestamp),8);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->System,LOG_RECORD_SYSTEM_LENGTH);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Sub_System,LOG_RECORD_SUB_SYSTEM_LENGTH);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Source_File,LOG_RECORD_SOURCE_FILE_LENGTH);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Source_Instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Function,LOG_RECORD_FUNCTION_LENGTH);
+	retval = retval && Decode_V1_Int(message_buffer,message_buffer_length,&message_buffer_position,&value,4);
+	log_record->Severity = (int)value;
+	retval = retval && Decode_V1_Int(message_buffer,message_buffer_length,&message_buffer_position,&value,4);
+	log_record->Verbosity = (int)value;
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Category,LOG_RECORD_CATEGORY_LENGTH);
+	retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					    log_record->Message,LOG_RECORD_MESSAGE_LENGTH);
+	retval = retval && Decode_V1_Int(message_buffer,message_buffer_length,&message_buffer_position,&value,4);
+	if(!retval)
+		return FALSE;
+	/* each context takes at least two bytes */
+	if((value < 0)||(value > (int64_t)((message_buffer_length-message_buffer_position)/2)))
+	{
+		Log_Error_Number = 611;
+		sprintf(Log_Error_String,"Decode_V1:Illegal context count %lld.",(long long)value);
+		return FALSE;
+	}
+	if(!Decode_Context_List_Allocate((int)value,log_context_list))
+		return FALSE;
+	(*log_context_count) = (int)value;
+	for(i = 0; i < (*log_context_count); i++)
+	{
+		retval = Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+					  (*log_context_list)[i].Keyword,LOG_CONTEXT_KEYWORD_LENGTH);
+		retval = retval && Decode_V1_String(message_buffer,message_buffer_length,&message_buffer_position,
+						    (*log_context_list)[i].Value,LOG_CONTEXT_VALUE_LENGTH);
+		if(!retval)
+		{
+			free(*log_context_list);
+			(*log_context_list) = NULL;
+			(*log_context_count) = 0;
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Decode a version 2 packet.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dictionary The receiver's dictionary for the packet's sender, or NULL.
+ * @param template_table The receiver's template table for the packet's sender, or NULL.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer, set to a newly allocated list.
+ * @param packet_info The address of a structure to fill in with the flags, microsecond timestamp,
+ *        template identifier, and stream tag and sequence number.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_V2_FLAG_MICROSECONDS
+ * @see #LOG_UDP_V2_FLAG_DICTIONARY
+ * @see #LOG_UDP_V2_FLAG_TEMPLATE
+ * @see #LOG_UDP_V2_FLAG_SEQUENCE
+ * @see #Decode_V2_String
+ * @see #Decode_V2_Name
+ * @see #Decode_Context_List_Allocate
+ * @see log_udp_template.html#Log_UDP_Template_Decode
+ */
+static int Decode_V2(const unsigned char *message_buffer,size_t message_buffer_length,
+		     Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+		     struct Log_Record_Struct *log_record,int *log_context_count,
+		     struct Log_Context_Struct **log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	const char *buffer = (const char *)message_buffer;
+	Log_UDP_Dictionary_T name_dictionary = NULL;
+	size_t message_buffer_position;
+	uint64_t value;
+	int retval,i;
+
+	if(message_buffer_length < 3)
+	{
+		Log_Error_Number = 609;
+		sprintf(Log_Error_String,"Decode_V2:Packet too short(%d).",message_buffer_length);
+		return FALSE;
+	}
+	packet_info->Flags = message_buffer[2];
+	if((packet_info->Flags&(~LOG_UDP_V2_FLAG_ALL)) != 0)
+	{
+		Log_Error_Number = 610;
+		sprintf(Log_Error_String,"Decode_V2:Unknown flags 0x%x.",packet_info->Flags);
+		return FALSE;
+	}
+	if((packet_info->Flags&LOG_UDP_V2_FLAG_TEMPLATE)&&(template_table == NULL))
+	{
+		Log_Error_Number = 618;
+		sprintf(Log_Error_String,"Decode_V2:Packet was sent with a template, but no template table supplied.");
+		return FALSE;
+	}
+	if(packet_info->Flags&LOG_UDP_V2_FLAG_COMPRESSED)
+	{
+		return Decode_V2_Compressed(message_buffer,message_buffer_length,dictionary,template_table,log_record,
+					    log_context_count,log_context_list,packet_info);
+	}
+	message_buffer_position = 3;
+	if(packet_info->Flags&LOG_UDP_V2_FLAG_DICTIONARY)
+	{
+		if(dictionary == NULL)
+		{
+			Log_Error_Number = 617;
+			sprintf(Log_Error_String,"Decode_V2:Packet was sent with a dictionary, but none supplied.");
+			return FALSE;
+		}
+		if(message_buffer_length < 4)
+		{
+			Log_Error_Number = 609;
+			sprintf(Log_Error_String,"Decode_V2:Packet too short(%d).",message_buffer_length);
+			return FALSE;
+		}
+		if(!Log_UDP_Dictionary_Generation_Check(dictionary,message_buffer[message_buffer_position++]))
+			return FALSE;
+		name_dictionary = dictionary;
+	}
+	if(packet_info->Flags&LOG_UDP_V2_FLAG_SEQUENCE)
+	{
+		if((!Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,
+					   &(packet_info->Sequence_Host_Id)))||
+		   (!Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,
+					   &(packet_info->Sequence_Pid)))||
+		   (!Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,
+					   &(packet_info->Sequence_Start_Us)))||
+		   (!Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,
+					   &(packet_info->Sequence_Number))))
+			return FALSE;
+	}
+	if(!Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,&value))
+		return FALSE;
+	if(packet_info->Flags&LOG_UDP_V2_FLAG_MICROSECONDS)
+	{
+		packet_info->Timestamp_Us = (int64_t)value;
+		log_record->Timestamp = ((int64_t)value)/ONE_MILLISECOND_US;
+	}
+	else
+	{
+		packet_info->Timestamp_Us = ((int64_t)value)*ONE_MILLISECOND_US;
+		log_record->Timestamp = (int64_t)value;
+	}
+	if(message_buffer_position >= message_buffer_length)
+	{
+		Log_Error_Number = 609;
+		sprintf(Log_Error_String,"Decode_V2:Packet too short(%d).",message_buffer_length);
+		return FALSE;
+	}
+	log_record->Severity = (message_buffer[message_buffer_position] >> 4)&0xf;
+	log_record->Verbosity = message_buffer[message_buffer_position]&0xf;
+	message_buffer_position++;
+	retval = Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					log_record->System,LOG_RECORD_SYSTEM_LENGTH,packet_info);
+	retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Sub_System,LOG_RECORD_SUB_SYSTEM_LENGTH,packet_info);
+	retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Source_File,LOG_RECORD_SOURCE_FILE_LENGTH,packet_info);
+	retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Source_Instance,LOG_RECORD_SOURCE_INSTANCE_LENGTH,packet_info);
+	retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Function,LOG_RECORD_FUNCTION_LENGTH,packet_info);
+	retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					  log_record->Category,LOG_RECORD_CATEGORY_LENGTH,packet_info);
+	if(packet_info->Flags&LOG_UDP_V2_FLAG_TEMPLATE)
+	{
+		retval = retval && Log_UDP_Template_Decode(template_table,buffer,message_buffer_length,
+							   &message_buffer_position,log_record->Message,
+							   LOG_RECORD_MESSAGE_LENGTH,&(packet_info->Template_Id),
+							   &(packet_info->Template_Complete));
+	}
+	else
+	{
+		retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,
+						  &message_buffer_position,log_record->Message,LOG_RECORD_MESSAGE_LENGTH,
+						  packet_info);
+	}
+	retval = retval && Log_UDP_Decode_Varint(buffer,message_buffer_length,&message_buffer_position,&value);
+	if(!retval)
+		return FALSE;
+	/* each context takes at least two bytes */
+	if(value > (message_buffer_length-message_buffer_position)/2)
+	{
+		Log_Error_Number = 611;
+		sprintf(Log_Error_String,"Decode_V2:Illegal context count %llu.",(unsigned long long)value);
+		return FALSE;
+	}
+	if(!Decode_Context_List_Allocate((int)value,log_context_list))
+		return FALSE;
+	(*log_context_count) = (int)value;
+	for(i = 0; i < (*log_context_count); i++)
+	{
+		retval = Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,&message_buffer_position,
+					(*log_context_list)[i].Keyword,LOG_CONTEXT_KEYWORD_LENGTH,packet_info);
+		retval = retval && Decode_V2_Name(name_dictionary,message_buffer,message_buffer_length,
+						  &message_buffer_position,(*log_context_list)[i].Value,
+						  LOG_CONTEXT_VALUE_LENGTH,packet_info);
+		if(!retval)
+		{
+			free(*log_context_list);
+			(*log_context_list) = NULL;
+			(*log_context_count) = 0;
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Decode a compressed version 2 packet. The packet is decompressed into an allocated buffer, with the magic
+ * word and flags (less LOG_UDP_V2_FLAG_COMPRESSED) in front, and that is decoded.
+ * @param message_buffer The received packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param dictionary The receiver's dictionary for the packet's sender, or NULL.
+ * @param template_table The receiver's template table for the packet's sender, or NULL.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of an integer, filled in with the number of contexts.
+ * @param log_context_list The address of a context list pointer, set to a newly allocated list.
+ * @param packet_info The address of a structure to fill in. Flags includes LOG_UDP_V2_FLAG_COMPRESSED.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #LOG_UDP_V2_DECOMPRESSED_LENGTH_MAX
+ * @see #Decode_V2
+ * @see log_udp_compress.html#Log_UDP_Decompress
+ */
+static int Decode_V2_Compressed(const unsigned char *message_buffer,size_t message_buffer_length,
+				Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+				struct Log_Record_Struct *log_record,int *log_context_count,
+				struct Log_Context_Struct **log_context_list,
+				struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	unsigned char *decompressed_buffer = NULL;
+	size_t message_buffer_position,decompressed_length;
+	uint64_t body_length;
+	int retval;
+
+	message_buffer_position = 3;
+	if(!Log_UDP_Decode_Varint((const char *)message_buffer,message_buffer_length,&message_buffer_position,
+				  &body_length))
+		return FALSE;
+	if(body_length > (LOG_UDP_V2_DECOMPRESSED_LENGTH_MAX-3))
+	{
+		Log_Error_Number = 622;
+		sprintf(Log_Error_String,"Decode_V2_Compressed:Decompressed length %llu too long.",
+			(unsigned long long)body_length);
+		return FALSE;
+	}
+	decompressed_buffer = (unsigned char *)malloc((size_t)body_length+3);
+	if(decompressed_buffer == NULL)
+	{
+		Log_Error_Number = 623;
+		sprintf(Log_Error_String,"Decode_V2_Compressed:Failed to allocate %llu bytes.",
+			(unsigned long long)body_length+3);
+		return FALSE;
+	}
+	decompressed_buffer[0] = message_buffer[0];
+	decompressed_buffer[1] = message_buffer[1];
+	decompressed_buffer[2] = message_buffer[2]&(~LOG_UDP_V2_FLAG_COMPRESSED);
+	if(!Log_UDP_Decompress((const char *)message_buffer+message_buffer_position,
+			       message_buffer_length-message_buffer_position,(char *)decompressed_buffer+3,
+			       (size_t)body_length,&decompressed_length))
+	{
+		free(decompressed_buffer);
+		return FALSE;
+	}
+	if(decompressed_length != body_length)
+	{
+		free(decompressed_buffer);
+		Log_Error_Number = 624;
+		sprintf(Log_Error_String,"Decode_V2_Compressed:Decompressed %d bytes, expected %llu.",
+			decompressed_length,(unsigned long long)body_length);
+		return FALSE;
+	}
+	retval = Decode_V2(decompressed_buffer,decompressed_length+3,dictionary,template_table,log_record,
+			   log_context_count,log_context_list,packet_info);
+	free(decompressed_buffer);
+	packet_info->Flags |= LOG_UDP_V2_FLAG_COMPRESSED;
+	return retval;
+}
+
+/**
+ * Decode a big endian (network byte order) signed integer from a version 1 packet.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the integer.
+ * @param value The address of a 64 bit integer to fill in.
+ * @param byte_count The size of the integer in the packet, 4 or 8 bytes.
+ * @return The routine returns TRUE on success and FALSE if the integer ran off the end of the buffer.
+ */
+static int Decode_V1_Int(const unsigned char *message_buffer,size_t message_buffer_length,
+			 size_t *message_buffer_position,int64_t *value,int byte_count)
+{
+	uint64_t result;
+	int i;
+
+	if(((*message_buffer_position)+byte_count) > message_buffer_length)
+	{
+		Log_Error_Number = 612;
+		sprintf(Log_Error_String,"Decode_V1_Int:Packet too short(position %d + %d > length %d).",
+			(*message_buffer_position),byte_count,message_buffer_length);
+		return FALSE;
+	}
+	result = 0;
+	for(i = 0; i < byte_count; i++)
+		result = (result << 8)|message_buffer[(*message_buffer_position)+i];
+	(*message_buffer_position) += byte_count;
+	if(byte_count == 4)
+		(*value) = (int32_t)(uint32_t)result;
+	else
+		(*value) = (int64_t)result;
+	return TRUE;
+}
+
+/**
+ * Decode a NULL terminated string from a version 1 packet, truncating it to fit the field.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the terminator.
+ * @param field The log record field to fill in.
+ * @param field_length The length of the field.
+ * @return The routine returns TRUE on success and FALSE if there was no terminator in the buffer.
+ */
+static int Decode_V1_String(const unsigned char *message_buffer,size_t message_buffer_length,
+			    size_t *message_buffer_position,char *field,size_t field_length)
+{
+	const unsigned char *end_ch = NULL;
+	size_t string_length,copy_length;
+
+	if((*message_buffer_position) < message_buffer_length)
+	{
+		end_ch = memchr(message_buffer+(*message_buffer_position),'\0',
+				message_buffer_length-(*message_buffer_position));
+	}
+	if(end_ch == NULL)
+	{
+		Log_Error_Number = 613;
+		sprintf(Log_Error_String,"Decode_V1_String:Unterminated string at position %d (length %d).",
+			(*message_buffer_position),message_buffer_length);
+		return FALSE;
+	}
+	string_length = end_ch-(message_buffer+(*message_buffer_position));
+	copy_length = string_length;
+	if(copy_length > (field_length-1))
+		copy_length = field_length-1;
+	memcpy(field,message_buffer+(*message_buffer_position),copy_length);
+	field[copy_length] = '\0';
+	(*message_buffer_position) += string_length+1;
+	return TRUE;
+}
+
+/**
+ * Decode a varint length prefixed string from a version 2 packet, truncating it to fit the field.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the string.
+ * @param field The log record field to fill in.
+ * @param field_length The length of the field.
+ * @return The routine returns TRUE on success and FALSE if the string ran off the end of the buffer.
+ * @see #Log_UDP_Decode_Varint
+ */
+static int Decode_V2_String(const unsigned char *message_buffer,size_t message_buffer_length,
+			    size_t *message_buffer_position,char *field,size_t field_length)
+{
+	uint64_t string_length;
+	size_t copy_length;
+
+	if(!Log_UDP_Decode_Varint((const char *)message_buffer,message_buffer_length,message_buffer_position,
+				  &string_length))
+		return FALSE;
+	if(string_length > (message_buffer_length-(*message_buffer_position)))
+	{
+		Log_Error_Number = 614;
+		sprintf(Log_Error_String,"Decode_V2_String:String length %llu at position %d overruns length %d.",
+			(unsigned long long)string_length,(*message_buffer_position),message_buffer_length);
+		return FALSE;
+	}
+	copy_length = (size_t)string_length;
+	if(copy_length > (field_length-1))
+		copy_length = field_length-1;
+	memcpy(field,message_buffer+(*message_buffer_position),copy_length);
+	field[copy_length] = '\0';
+	(*message_buffer_position) += (size_t)string_length;
+	return TRUE;
+}
+
+/**
+ * Decode a string field of a version 2 packet, through the dictionary if the packet was sent with one.
+ * @param dictionary The receiver's dictionary, or NULL if the packet was sent without one.
+ * @param message_buffer The buffer to decode from.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position to read from, updated past the field.
+ * @param field The log record field to fill in.
+ * @param field_length The length of the field.
+ * @param packet_info The packet information, Dictionary_Complete is cleared if the field referred to
+ *        a string the dictionary does not hold.
+ * @return The routine returns TRUE on success and FALSE if the field was malformed.
+ * @see #Decode_V2_String
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Decode_String
+ */
+static int Decode_V2_Name(Log_UDP_Dictionary_T dictionary,const unsigned char *message_buffer,
+			  size_t message_buffer_length,size_t *message_buffer_position,char *field,size_t field_length,
+			  struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	if(dictionary == NULL)
+	{
+		return Decode_V2_String(message_buffer,message_buffer_length,message_buffer_position,field,
+					field_length);
+	}
+	return Log_UDP_Dictionary_Decode_String(dictionary,(const char *)message_buffer,message_buffer_length,
+						message_buffer_position,field,field_length,
+						&(packet_info->Dictionary_Complete));
+}
+
+/**
+ * Encode a string field of a version 2 packet that is sent through the dictionary, if there is one.
+ * @param dictionary The sender's dictionary, or NULL to send the string in full.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param string The string to encode, or NULL.
+ * @param field_length The length of the log record field.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Log_UDP_Encode_Varint_String
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Encode_String
+ */
+static int Encode_V2_Name(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			  size_t *message_buffer_position,const char *string,size_t field_length)
+{
+	if(dictionary == NULL)
+	{
+		return Log_UDP_Encode_Varint_String(message_buffer,message_buffer_length,message_buffer_position,
+						    string,field_length);
+	}
+	return Log_UDP_Dictionary_Encode_String(dictionary,message_buffer,message_buffer_length,
+						message_buffer_position,string,field_length);
+}
+
+/**
+ * Encode a value field (the Message or a context Value) of a version 2 packet, through the dictionary
+ * if there is one.
+ * @param dictionary The sender's dictionary, or NULL to send the string in full.
+ * @param message_buffer The buffer to encode into.
+ * @param message_buffer_length The length of message_buffer in bytes.
+ * @param message_buffer_position The address of the position in message_buffer to write to, updated.
+ * @param string The string to encode, or NULL.
+ * @param field_length The length of the log record field.
+ * @return The routine returns TRUE on success and FALSE if there was no room in the buffer.
+ * @see #Log_UDP_Encode_Varint_String
+ * @see log_udp_dictionary.html#Log_UDP_Dictionary_Encode_Value
+ */
+static int Encode_V2_Value(Log_UDP_Dictionary_T dictionary,char *message_buffer,size_t message_buffer_length,
+			   size_t *message_buffer_position,const char *string,size_t field_length)
+{
+	if(dictionary == NULL)
+	{
+		return Log_UDP_Encode_Varint_String(message_buffer,message_buffer_length,message_buffer_position,
+						    string,field_length);
+	}
+	return Log_UDP_Dictionary_Encode_Value(dictionary,message_buffer,message_buffer_length,
+					       message_buffer_position,string,field_length);
+}
+
+/**
+ * Allocate a list of contexts for the decoder.
+ * @param log_context_count The number of contexts.
+ * @param log_context_list The address of a context list pointer, set to the allocated list
+ *        (or NULL if log_context_count is zero).
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Decode_Context_List_Allocate(int log_context_count,struct Log_Context_Struct **log_context_list)
+{
+	if(log_context_count < 0)
+	{
+		Log_Error_Number = 615;
+		sprintf(Log_Error_String,"Decode_Context_List_Allocate:Illegal context count %d.",log_context_count);
+		return FALSE;
+	}
+	if(log_context_count == 0)
+	{
+		(*log_context_list) = NULL;
+		return TRUE;
+	}
+	(*log_context_list) = (struct Log_Context_Struct *)calloc(log_context_count,sizeof(struct Log_Context_Struct));
+	if((*log_context_list) == NULL)
+	{
+		Log_Error_Number = 616;
+		sprintf(Log_Error_String,"Decode_Context_List_Allocate:Failed to allocate %d contexts.",
+			log_context_count);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+** $Log$
+*/
@@ -12,6 +12,8 @@ extern int Log_Create_Record(char *system,char *sub_system,char *source_file,cha
 extern int Log_Create_Context_List_Add(struct Log_Context_Struct **log_context_list,int *log_context_count,
 				       char *keyword,char *value);
 extern int Log_Create_Record_Timestamp_Set(struct tm time_tm,struct Log_Record_Struct *log_record);
+extern int Log_Create_Timestamp_Get(int64_t *timestamp);
+extern int Log_Create_Timestamp_Us_Get(int64_t *timestamp_us);
 #endif
 /*
 ** $Log: not supported by cvs2svn $
@@ -22,6 +22,16 @@
  * How long the error string is.
  */
 #define LOG_GENERAL_ERROR_LENGTH (1024)
+/**
+ * Storage class for the error variables. Each thread gets it's own copy, so a library thread (the
+ * asynchronous sender thread, for instance) reporting an error does not overwrite an error the caller's
+ * thread is about to report.
+ */
+#ifdef __GNUC__
+#define LOG_GENERAL_THREAD __thread
+#else
+#define LOG_GENERAL_THREAD
+#endif
 
 /* external functions */
 extern void Log_General_Error(void);
@@ -29,8 +39,8 @@ extern void Log_General_Error_To_String(char *error_string);
 extern int Log_General_Get_Error_Number(void);
 
 /* external variables */
-extern int Log_Error_Number;
-extern char Log_Error_String[];
+extern LOG_GENERAL_THREAD int Log_Error_Number;
+extern LOG_GENERAL_THREAD char Log_Error_String[];
 
 /*
 ** $Log: not supported by cvs2svn $
@@ -3,6 +3,9 @@
 */
 #ifndef LOG_UDP_H
 #define LOG_UDP_H
+#include <stddef.h> /* size_t */
+#include <sys/socket.h> /* struct sockaddr_storage, socklen_t */
+#include <sys/uio.h> /* struct iovec */
 
 /* stdint.h defines int64_t (Java long) but only exists under Linux */
 #ifdef __linux
@@ -18,6 +21,10 @@ typedef long long int           int64_t;
 #endif
 
 /* hash defines */
+/**
+ * Magic word (4 bytes) to distinguish Java and C packets.
+ */
+#define LOG_UDP_PACKET_MAGIC_WORD            (0xC0C0)
 /**
  * The length of the Log_Context_Struct Keyword string field in characters/bytes.
  * @see #Log_Context_Struct
@@ -114,6 +121,47 @@ enum LOG_SEVERITY
  */
 #define LOG_UDP_IS_SEVERITY(severity) ((severity == LOG_SEVERITY_INFO)||(severity == LOG_SEVERITY_ERROR))
 
+/**
+ * Macro to check whether a log message with the specified severity and verbosity passes the process-wide
+ * filter (set with Log_UDP_Filter_Set). Test this before calling Log_Create_Record, so filtered messages
+ * cost a couple of comparisons rather than building a whole log record.
+ * @see #Log_UDP_Filter_Severity
+ * @see #Log_UDP_Filter_Verbosity
+ * @see #Log_UDP_Filter_Set
+ */
+#define Log_UDP_Is_Enabled(severity,verbosity) (((severity) >= Log_UDP_Filter_Severity)&& \
+						((verbosity) <= Log_UDP_Filter_Verbosity))
+
+/**
+ * The lowest (least important) verbosity compiled into programs using the LOG_UDP_COMPILE_IS_ENABLED macro 
+ * (and the LOG_UDP_HANDLE_SEND macro in log_udp_handle.h). Log calls with a constant verbosity greater 
+ * than this are removed by the compiler. Override with -DLOG_UDP_COMPILE_VERBOSITY=n.
+ * @see #LOG_VERBOSITY
+ */
+#ifndef LOG_UDP_COMPILE_VERBOSITY
+#define LOG_UDP_COMPILE_VERBOSITY            (LOG_VERBOSITY_VERY_VERBOSE)
+#endif
+/**
+ * The lowest severity compiled into programs using the LOG_UDP_COMPILE_IS_ENABLED macro 
+ * (and the LOG_UDP_HANDLE_SEND macro in log_udp_handle.h). Log calls with a constant severity less 
+ * than this are removed by the compiler. Override with -DLOG_UDP_COMPILE_SEVERITY=n.
+ * @see #LOG_SEVERITY
+ */
+#ifndef LOG_UDP_COMPILE_SEVERITY
+#define LOG_UDP_COMPILE_SEVERITY             (LOG_SEVERITY_INFO)
+#endif
+/**
+ * Macro to check whether a log message passes both the compile-time levels and the process-wide filter.
+ * When severity and verbosity are constants below the compile-time levels this is a constant FALSE,
+ * and the compiler removes any code it guards.
+ * @see #LOG_UDP_COMPILE_SEVERITY
+ * @see #LOG_UDP_COMPILE_VERBOSITY
+ * @see #Log_UDP_Is_Enabled
+ */
+#define LOG_UDP_COMPILE_IS_ENABLED(severity,verbosity) (((severity) >= LOG_UDP_COMPILE_SEVERITY)&& \
+							((verbosity) <= LOG_UDP_COMPILE_VERBOSITY)&& \
+							Log_UDP_Is_Enabled(severity,verbosity))
+
 /* structures */
 /**
  * Structure used to define a context for a log message, a list of these keyword-value pairs
@@ -184,10 +232,120 @@ struct Log_Record_Struct
 	char Message[LOG_RECORD_MESSAGE_LENGTH];
 };
 
+/**
+ * Macro returning a buffer length (in bytes) always big enough to hold an encoded packet 
+ * containing one log record and log_context_count contexts. This is the size of the log record,
+ * plus the contexts, plus 4 bytes for the log context count and 4 bytes for the magic word.
+ * @see #Log_Record_Struct
+ * @see #Log_Context_Struct
+ */
+#define LOG_UDP_BUFFER_LENGTH(log_context_count) (sizeof(struct Log_Record_Struct)+sizeof(int)+sizeof(int)+ \
+						  ((log_context_count)*sizeof(struct Log_Context_Struct)))
+
+/**
+ * Macro returning the number of iovecs Log_UDP_Encode_Iovec needs to describe a packet containing one log record
+ * and log_context_count contexts. This is one for the magic word and timestamp, seven for the record's strings,
+ * one for the severity and verbosity, one for the context count, and two per context.
+ * @see #Log_UDP_Encode_Iovec
+ */
+#define LOG_UDP_IOVEC_LENGTH(log_context_count)  (10+(2*(log_context_count)))
+
+/**
+ * Structure holding the integer fields of a packet in network byte order, referenced by the 
+ * iovecs filled in by Log_UDP_Encode_Iovec.
+ * <dl>
+ * <dt>Prefix</dt> <dd>The magic word and Timestamp.</dd>
+ * <dt>Severity_Verbosity</dt> <dd>The Severity and Verbosity.</dd>
+ * <dt>Context_Count</dt> <dd>The number of contexts.</dd>
+ * </dl>
+ * @see #Log_UDP_Encode_Iovec
+ */
+struct Log_UDP_Iovec_Header_Struct
+{
+	char Prefix[12];
+	char Severity_Verbosity[8];
+	char Context_Count[4];
+};
+
+/**
+ * Counts of the packets the process has sent, and failed to send, over log sockets.
+ * <dl>
+ * <dt>Packet_Count</dt> <dd>The number of packets sent.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes sent.</dd>
+ * <dt>Would_Block_Drop_Count</dt> <dd>The number of packets dropped because a non-blocking socket's send buffer
+ *     was full (EAGAIN/EWOULDBLOCK).</dd>
+ * <dt>No_Buffer_Drop_Count</dt> <dd>The number of packets dropped because the kernel ran out of buffer space
+ *     or the interface queue was full (ENOBUFS).</dd>
+ * <dt>Error_Count</dt> <dd>The number of packets that failed to send for any other reason.</dd>
+ * </dl>
+ * @see #Log_UDP_Send_Stats_Get
+ */
+struct Log_UDP_Send_Stats_Struct
+{
+	unsigned long Packet_Count;
+	unsigned long Byte_Count;
+	unsigned long Would_Block_Drop_Count;
+	unsigned long No_Buffer_Drop_Count;
+	unsigned long Error_Count;
+};
+
+/**
+ * The type of a routine the rate limiter and coalescer use to send a summary record. The summary is sent
+ * through whatever sent the records it summarises (a socket, or a logger handle with it's wire format,
+ * container and journal), without being filtered, coalesced or rate limited itself.
+ * The first parameter is the summary_arg passed with the routine to Log_UDP_Rate_Limit_Allow or 
+ * Log_UDP_Coalesce_Allow, followed by the summary record and it's contexts. 
+ * The routine returns TRUE on success and FALSE on failure.
+ * @see log_udp_rate.html#Log_UDP_Rate_Limit_Allow
+ * @see log_udp_coalesce.html#Log_UDP_Coalesce_Allow
+ */
+typedef int (*Log_UDP_Summary_Send_T)(void *summary_arg,const struct Log_Record_Struct *log_record,
+				      int log_context_count,const struct Log_Context_Struct *log_context_list);
+
 extern int Log_UDP_Open(char *hostname,int port_number,int *socket_id);
+extern int Log_UDP_Resolve(char *hostname,int port_number,struct sockaddr_storage *address,
+			   socklen_t *address_length);
+extern int Log_UDP_Multicast_Set(int ttl,int loopback,char *interface_address);
+extern int Log_UDP_Multicast_Configure(int socket_id,struct sockaddr_storage *address);
+extern int Log_UDP_Socket_Options_Set(int non_blocking,int send_buffer_length);
+extern int Log_UDP_Socket_Configure(int socket_id);
+extern int Log_UDP_Send_Stats_Get(struct Log_UDP_Send_Stats_Struct *stats);
+extern int Log_UDP_Fragment_Set(int datagram_length);
 extern int Log_UDP_Send(int socket_id,struct Log_Record_Struct log_record,
 		 int log_context_count,struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Send_Record(int socket_id,const struct Log_Record_Struct *log_record,
+			       int log_context_count,const struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Send_Record_Gather(int socket_id,const struct Log_Record_Struct *log_record,
+				      int log_context_count,const struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Send_Batch(int socket_id,const struct Log_Record_Struct *log_record_list,
+			      const int *log_context_count_list,
+			      const struct Log_Context_Struct * const *log_context_list_list,
+			      int record_count,int *sent_list);
+extern int Log_UDP_Encode(const struct Log_Record_Struct *log_record,int log_context_count,
+			  const struct Log_Context_Struct *log_context_list,char *message_buffer,
+			  size_t message_buffer_length,size_t *encoded_length);
+extern int Log_UDP_Encode_Iovec(const struct Log_Record_Struct *log_record,int log_context_count,
+				const struct Log_Context_Struct *log_context_list,
+				struct Log_UDP_Iovec_Header_Struct *header,struct iovec *iovec_list,int iovec_length,
+				int *iovec_count);
+extern int Log_UDP_Send_Encoded(int socket_id,char *message_buffer,size_t message_buffer_length);
+extern int Log_UDP_Send_Encoded_Status(int socket_id,char *message_buffer,size_t message_buffer_length,
+				       int *dropped);
+extern int Log_UDP_Send_Encoded_List(int socket_id,char *message_buffer,size_t message_buffer_length,
+				     struct sockaddr_storage *address_list,socklen_t *address_length_list,
+				     int address_count,int *sent_list,int *dropped_list);
+extern int Log_UDP_Encode_Int(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+			      int value);
+extern int Log_UDP_Encode_Int64(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+				int64_t value);
+extern int Log_UDP_Encode_String(char *message_buffer,size_t message_buffer_length,
+				 size_t *message_buffer_position,const char *string);
 extern int Log_UDP_Close(int socket_id);
+extern int Log_UDP_Filter_Set(int severity,int verbosity);
+
+/* external variables */
+extern int Log_UDP_Filter_Severity;
+extern int Log_UDP_Filter_Verbosity;
 
 #endif
 /*
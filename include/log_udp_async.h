@@ -0,0 +1,53 @@
+/* log_udp_async.h
+** $Header$
+*/
+#ifndef LOG_UDP_ASYNC_H
+#define LOG_UDP_ASYNC_H
+#include "log_udp.h"
+
+/* enums */
+/**
+ * This enum describes what Log_UDP_Async_Send does when the queue of records waiting to be sent is full.
+ * <dl>
+ * <dt>LOG_UDP_ASYNC_OVERFLOW_DROP_NEWEST</dt> <dd>The record being queued is dropped.</dd>
+ * <dt>LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST</dt> <dd>The oldest queued record is dropped to make room.</dd>
+ * <dt>LOG_UDP_ASYNC_OVERFLOW_BLOCK</dt> <dd>The caller waits (up to a timeout) for room in the queue,
+ *     and the record is dropped if the timeout expires.</dd>
+ * </dl>
+ */
+enum LOG_UDP_ASYNC_OVERFLOW
+{
+	LOG_UDP_ASYNC_OVERFLOW_DROP_NEWEST=1,
+	LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST=2,
+	LOG_UDP_ASYNC_OVERFLOW_BLOCK=3
+};
+
+/**
+ * Macro to check whether the overflow policy is a legal value.
+ * @see #LOG_UDP_ASYNC_OVERFLOW
+ */
+#define LOG_UDP_ASYNC_IS_OVERFLOW(overflow) (((overflow) == LOG_UDP_ASYNC_OVERFLOW_DROP_NEWEST)|| \
+					     ((overflow) == LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST)|| \
+					     ((overflow) == LOG_UDP_ASYNC_OVERFLOW_BLOCK))
+
+/* typedefs */
+/**
+ * Typedef for an asynchronous sender. The structure itself is private to log_udp_async.c.
+ */
+typedef struct Log_UDP_Async_Struct *Log_UDP_Async_T;
+
+extern int Log_UDP_Async_Open(int socket_id,int queue_length,int overflow,int block_timeout_ms,
+			      Log_UDP_Async_T *async);
+extern int Log_UDP_Async_Send(Log_UDP_Async_T async,const struct Log_Record_Struct *log_record,
+			      int log_context_count,const struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Flush(Log_UDP_Async_T async,int timeout_ms);
+extern int Log_UDP_Async_Statistics_Get(Log_UDP_Async_T async,unsigned long *queued_count,
+					unsigned long *sent_count,unsigned long *failed_count,
+					unsigned long *dropped_count);
+extern int Log_UDP_Async_Error_Get(Log_UDP_Async_T async,int *error_number,char *error_string);
+extern int Log_UDP_Async_Close(Log_UDP_Async_T async);
+
+#endif
+/*
+** $Log$
+*/
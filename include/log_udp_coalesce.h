@@ -0,0 +1,20 @@
+/* log_udp_coalesce.h
+** $Header$
+*/
+#ifndef LOG_UDP_COALESCE_H
+#define LOG_UDP_COALESCE_H
+#include "log_udp.h"
+
+extern int Log_UDP_Coalesce_Set(int window_ms);
+extern int Log_UDP_Coalesce_Allow(Log_UDP_Summary_Send_T summary_send,void *summary_arg,const char *system,
+				  const char *sub_system,const char *source_file,const char *source_instance,
+				  const char *function,int severity,int verbosity,const char *category,const char *message,
+				  int64_t timestamp,int log_context_count,const struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Coalesce_Flush(void);
+extern int Log_UDP_Coalesce_Release(Log_UDP_Summary_Send_T summary_send,void *summary_arg);
+extern int Log_UDP_Coalesce_Count_Get(unsigned long *coalesced_count);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,24 @@
+/* log_udp_compress.h
+** $Header$
+*/
+#ifndef LOG_UDP_COMPRESS_H
+#define LOG_UDP_COMPRESS_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * Macro returning a buffer length (in bytes) always big enough to hold data of length input_length
+ * after compression with Log_UDP_Compress. Data that doesn't compress grows by one length byte for every
+ * 255 bytes, plus a few bytes.
+ */
+#define LOG_UDP_COMPRESS_BOUND(input_length) ((input_length)+((input_length)/255)+16)
+
+extern int Log_UDP_Compress(const char *input_buffer,size_t input_length,char *output_buffer,
+			    size_t output_buffer_length,size_t *output_length);
+extern int Log_UDP_Decompress(const char *input_buffer,size_t input_length,char *output_buffer,
+			      size_t output_buffer_length,size_t *output_length);
+
+#endif
+/*
+** $Log$
+*/
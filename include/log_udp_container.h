@@ -0,0 +1,56 @@
+/* log_udp_container.h
+** $Header$
+*/
+#ifndef LOG_UDP_CONTAINER_H
+#define LOG_UDP_CONTAINER_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * The magic word at the start of a container datagram, sent as two bytes in network byte order.
+ * @see log_udp_wire.html#LOG_UDP_PACKET_MAGIC_WORD_V2
+ */
+#define LOG_UDP_PACKET_MAGIC_WORD_CONTAINER   (0xC0C3)
+/**
+ * The length of a container datagram's header: the magic word and a two byte record count.
+ */
+#define LOG_UDP_CONTAINER_HEADER_LENGTH       (4)
+/**
+ * The default container datagram length in bytes: an Ethernet MTU of 1500 bytes, less 20 bytes of IPv4
+ * header and 8 bytes of UDP header, so containers are never fragmented.
+ */
+#define LOG_UDP_CONTAINER_DEFAULT_LENGTH      (1472)
+/**
+ * The longest container datagram, in bytes: the longest UDP payload over IPv4.
+ */
+#define LOG_UDP_CONTAINER_LENGTH_MAX          (65507)
+/**
+ * The most records a container holds, the largest two byte record count.
+ */
+#define LOG_UDP_CONTAINER_RECORD_COUNT_MAX    (65535)
+
+/* typedefs */
+/**
+ * Typedef for a container being filled. The structure itself is private to log_udp_container.c.
+ */
+typedef struct Log_UDP_Container_Struct *Log_UDP_Container_T;
+
+extern int Log_UDP_Container_Create(size_t datagram_length,Log_UDP_Container_T *container);
+extern int Log_UDP_Container_Add(Log_UDP_Container_T container,const char *message_buffer,
+				 size_t message_buffer_length,int *added);
+extern int Log_UDP_Container_Record_Count_Get(Log_UDP_Container_T container,int *record_count);
+extern int Log_UDP_Container_Finish(Log_UDP_Container_T container,char **message_buffer,
+				    size_t *message_buffer_length);
+extern int Log_UDP_Container_Clear(Log_UDP_Container_T container);
+extern int Log_UDP_Container_Send(Log_UDP_Container_T container,int socket_id);
+extern int Log_UDP_Container_Destroy(Log_UDP_Container_T container);
+extern int Log_UDP_Container_Is_Container(const char *message_buffer,size_t message_buffer_length);
+extern int Log_UDP_Container_Unpack_Start(const char *message_buffer,size_t message_buffer_length,
+					  int *record_count,size_t *message_buffer_position);
+extern int Log_UDP_Container_Unpack_Next(const char *message_buffer,size_t message_buffer_length,
+					 size_t *message_buffer_position,const char **packet,size_t *packet_length);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,50 @@
+/* log_udp_dictionary.h
+** $Header$
+*/
+#ifndef LOG_UDP_DICTIONARY_H
+#define LOG_UDP_DICTIONARY_H
+#include "log_udp.h"
+
+/* hash defines */
+/**
+ * The maximum number of strings a dictionary holds. Identifiers run from 1 to this value, so a reference
+ * or definition code always fits in a two byte varint (one byte for the first 63 strings).
+ */
+#define LOG_UDP_DICTIONARY_ENTRY_COUNT        (127)
+/**
+ * The longest string (including the NULL terminator) a dictionary holds. This is the longest log record
+ * field that is sent through the dictionary (Source_File and Source_Instance).
+ */
+#define LOG_UDP_DICTIONARY_STRING_LENGTH      (LOG_RECORD_SOURCE_FILE_LENGTH)
+/**
+ * The default time between dictionary refreshes, in milliseconds.
+ */
+#define LOG_UDP_DICTIONARY_DEFAULT_REFRESH_MS (10000)
+
+/* typedefs */
+/**
+ * Typedef for a string dictionary. The structure itself is private to log_udp_dictionary.c.
+ */
+typedef struct Log_UDP_Dictionary_Struct *Log_UDP_Dictionary_T;
+
+extern int Log_UDP_Dictionary_Create(Log_UDP_Dictionary_T *dictionary);
+extern int Log_UDP_Dictionary_Refresh_Set(Log_UDP_Dictionary_T dictionary,int refresh_interval_ms);
+extern int Log_UDP_Dictionary_Refresh(Log_UDP_Dictionary_T dictionary);
+extern int Log_UDP_Dictionary_Packet_Start(Log_UDP_Dictionary_T dictionary,int *generation);
+extern int Log_UDP_Dictionary_Encode_String(Log_UDP_Dictionary_T dictionary,char *message_buffer,
+					    size_t message_buffer_length,size_t *message_buffer_position,
+					    const char *string,size_t field_length);
+extern int Log_UDP_Dictionary_Encode_Value(Log_UDP_Dictionary_T dictionary,char *message_buffer,
+					   size_t message_buffer_length,size_t *message_buffer_position,
+					   const char *string,size_t field_length);
+extern int Log_UDP_Dictionary_Packet_End(Log_UDP_Dictionary_T dictionary,int sent);
+extern int Log_UDP_Dictionary_Generation_Check(Log_UDP_Dictionary_T dictionary,int generation);
+extern int Log_UDP_Dictionary_Decode_String(Log_UDP_Dictionary_T dictionary,const char *message_buffer,
+					    size_t message_buffer_length,size_t *message_buffer_position,
+					    char *field,size_t field_length,int *is_known);
+extern int Log_UDP_Dictionary_Destroy(Log_UDP_Dictionary_T dictionary);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,103 @@
+/* log_udp_fragment.h
+** $Header$
+*/
+#ifndef LOG_UDP_FRAGMENT_H
+#define LOG_UDP_FRAGMENT_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * The magic word at the start of a fragment datagram, sent as two bytes in network byte order.
+ * @see log_udp_container.html#LOG_UDP_PACKET_MAGIC_WORD_CONTAINER
+ */
+#define LOG_UDP_PACKET_MAGIC_WORD_FRAGMENT    (0xC0C4)
+/**
+ * The length of a fragment datagram's header: the magic word, a four byte message identifier, a two byte
+ * fragment index, a two byte fragment count and the four byte length of the whole message.
+ */
+#define LOG_UDP_FRAGMENT_HEADER_LENGTH        (14)
+/**
+ * The most fragments a message is split into, the largest two byte fragment count.
+ */
+#define LOG_UDP_FRAGMENT_COUNT_MAX            (65535)
+/**
+ * The shortest fragment datagram that can be configured, in bytes.
+ */
+#define LOG_UDP_FRAGMENT_LENGTH_MIN           (64)
+/**
+ * The longest fragment datagram that can be configured, in bytes: the longest UDP payload over IPv4.
+ */
+#define LOG_UDP_FRAGMENT_LENGTH_MAX           (65507)
+/**
+ * The longest datagram that is never IP fragmented on any IPv6 path: the IPv6 minimum MTU of 1280 bytes,
+ * less 40 bytes of IPv6 header and 8 bytes of UDP header. When fragmenting to the path MTU, shorter packets
+ * are sent without looking the MTU up.
+ */
+#define LOG_UDP_FRAGMENT_LENGTH_SAFE          (1232)
+/**
+ * The fragment datagram length used when the path MTU can't be found: an Ethernet MTU of 1500 bytes,
+ * less 20 bytes of IPv4 header and 8 bytes of UDP header.
+ */
+#define LOG_UDP_FRAGMENT_DEFAULT_LENGTH       (1472)
+/**
+ * Value passed to Log_UDP_Fragment_Set to fragment packets that don't fit in the path MTU of the socket
+ * they are sent over.
+ */
+#define LOG_UDP_FRAGMENT_PATH_MTU             (-1)
+/**
+ * The default memory a reassembler uses for partly received messages, in bytes.
+ */
+#define LOG_UDP_REASSEMBLY_DEFAULT_MEMORY     (4*1024*1024)
+/**
+ * The default time a reassembler waits for the rest of a message's fragments, in milliseconds.
+ */
+#define LOG_UDP_REASSEMBLY_DEFAULT_TIMEOUT_MS (2000)
+
+/* structures */
+/**
+ * Reassembly counters.
+ * <dl>
+ * <dt>Complete_Count</dt> <dd>The number of messages reassembled.</dd>
+ * <dt>Timeout_Count</dt> <dd>The number of partly received messages discarded because the rest of their
+ *     fragments did not arrive within the timeout.</dd>
+ * <dt>Evicted_Count</dt> <dd>The number of partly received messages discarded to make room for newer ones.</dd>
+ * <dt>Oversize_Count</dt> <dd>The number of messages discarded because they were longer than the
+ *     reassembler's memory.</dd>
+ * <dt>Duplicate_Count</dt> <dd>The number of fragments received more than once.</dd>
+ * <dt>Memory_Length</dt> <dd>The memory currently used by partly received messages, in bytes.</dd>
+ * </dl>
+ */
+struct Log_UDP_Reassembly_Stats_Struct
+{
+	unsigned long Complete_Count;
+	unsigned long Timeout_Count;
+	unsigned long Evicted_Count;
+	unsigned long Oversize_Count;
+	unsigned long Duplicate_Count;
+	size_t Memory_Length;
+};
+
+/* typedefs */
+/**
+ * Typedef for a reassembler. The structure itself is private to log_udp_fragment.c.
+ */
+typedef struct Log_UDP_Reassembly_Struct *Log_UDP_Reassembly_T;
+
+extern int Log_UDP_Fragment_Count_Get(size_t message_length,size_t datagram_length,int *fragment_count);
+extern unsigned int Log_UDP_Fragment_Message_Id_Get(void);
+extern int Log_UDP_Fragment_Header_Encode(char *header_buffer,unsigned int message_id,int fragment_index,
+					  int fragment_count,size_t message_length);
+extern int Log_UDP_Fragment_Is_Fragment(const char *message_buffer,size_t message_buffer_length);
+extern int Log_UDP_Reassembly_Create(size_t memory_length,int timeout_ms,Log_UDP_Reassembly_T *reassembly);
+extern int Log_UDP_Reassembly_Add(Log_UDP_Reassembly_T reassembly,const char *message_buffer,
+				  size_t message_buffer_length,int *complete,const char **message,
+				  size_t *message_length);
+extern int Log_UDP_Reassembly_Expire(Log_UDP_Reassembly_T reassembly);
+extern int Log_UDP_Reassembly_Stats_Get(Log_UDP_Reassembly_T reassembly,
+					struct Log_UDP_Reassembly_Stats_Struct *stats);
+extern int Log_UDP_Reassembly_Destroy(Log_UDP_Reassembly_T reassembly);
+
+#endif
+/*
+** $Log$
+*/
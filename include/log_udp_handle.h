@@ -0,0 +1,102 @@
+/* log_udp_handle.h
+** $Header$
+*/
+#ifndef LOG_UDP_HANDLE_H
+#define LOG_UDP_HANDLE_H
+#include <stdarg.h>
+#include "log_udp.h"
+
+/* hash defines */
+/**
+ * Macro to send a log message using a logger handle, with the same arguments as Log_UDP_Handle_Send.
+ * The call is removed by the compiler when a constant severity/verbosity is below the compile-time levels
+ * (LOG_UDP_COMPILE_SEVERITY/LOG_UDP_COMPILE_VERBOSITY), and is skipped (without evaluating the other
+ * arguments) when it doesn't pass the process-wide filter. The return value of Log_UDP_Handle_Send
+ * is discarded.
+ * @see log_udp.html#LOG_UDP_COMPILE_IS_ENABLED
+ * @see #Log_UDP_Handle_Send
+ */
+#define LOG_UDP_HANDLE_SEND(handle,function,severity,verbosity,category,message,log_context_count, \
+			    log_context_list) \
+	do \
+	{ \
+		if(LOG_UDP_COMPILE_IS_ENABLED(severity,verbosity)) \
+			Log_UDP_Handle_Send(handle,function,severity,verbosity,category,message,log_context_count, \
+					    log_context_list); \
+	} while(0)
+
+/**
+ * The maximum number of destinations a logger handle sends to.
+ * @see #Log_UDP_Handle_Destination_Add
+ */
+#define LOG_UDP_HANDLE_DESTINATION_COUNT  (8)
+
+/* structures */
+/**
+ * The number of packets sent to one of a logger handle's destinations.
+ * <dl>
+ * <dt>Packet_Count</dt> <dd>The number of datagrams sent.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes sent.</dd>
+ * <dt>Drop_Count</dt> <dd>The number of datagrams dropped because the send buffer (ring or stream buffer) was
+ *     full.</dd>
+ * <dt>Error_Count</dt> <dd>The number of datagrams that failed to send.</dd>
+ * <dt>Journal_Count</dt> <dd>The number of datagrams written to the handle's journal, to be replayed
+ *     later, rather than sent.</dd>
+ * </dl>
+ * @see #Log_UDP_Handle_Destination_Stats_Get
+ */
+struct Log_UDP_Handle_Destination_Stats_Struct
+{
+	unsigned long Packet_Count;
+	unsigned long Byte_Count;
+	unsigned long Drop_Count;
+	unsigned long Error_Count;
+	unsigned long Journal_Count;
+};
+
+/* typedefs */
+/**
+ * Typedef for a logger handle. The structure itself is private to log_udp_handle.c.
+ */
+typedef struct Log_UDP_Handle_Struct *Log_UDP_Handle_T;
+
+extern int Log_UDP_Handle_Open(char *hostname,int port_number,char *system,char *sub_system,char *source_file,
+			       char *source_instance,Log_UDP_Handle_T *handle);
+extern int Log_UDP_Handle_Send(Log_UDP_Handle_T handle,char *function,int severity,int verbosity,char *category,
+			       char *message,int log_context_count,const struct Log_Context_Struct *log_context_list);
+#ifdef __GNUC__
+extern int Log_UDP_Sendf(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,const char *format,...)
+	__attribute__ ((format (printf,5,6)));
+#else
+extern int Log_UDP_Sendf(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,const char *format,...);
+#endif
+extern int Log_UDP_Vsendf(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,const char *format,
+			  va_list argument_list);
+extern int Log_UDP_Handle_Send_Record(Log_UDP_Handle_T handle,const struct Log_Record_Struct *log_record,
+				      int log_context_count,const struct Log_Context_Struct *log_context_list);
+extern int Log_UDP_Handle_Filter_Set(Log_UDP_Handle_T handle,int severity,int verbosity);
+extern int Log_UDP_Handle_Format_Set(Log_UDP_Handle_T handle,int format,int flags);
+extern int Log_UDP_Handle_Dictionary_Refresh_Set(Log_UDP_Handle_T handle,int refresh_interval_ms);
+extern int Log_UDP_Handle_Template_Register(Log_UDP_Handle_T handle,const char *format,int *template_id);
+extern int Log_UDP_Handle_Template_Send(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,
+					int template_id,...);
+extern int Log_UDP_Handle_Template_Vsend(Log_UDP_Handle_T handle,int severity,int verbosity,char *category,
+					 int template_id,va_list argument_list);
+extern int Log_UDP_Handle_Template_Refresh_Set(Log_UDP_Handle_T handle,int refresh_interval_ms);
+extern int Log_UDP_Handle_Compression_Threshold_Set(Log_UDP_Handle_T handle,int threshold);
+extern int Log_UDP_Handle_Container_Set(Log_UDP_Handle_T handle,size_t datagram_length,int flush_interval_ms);
+extern int Log_UDP_Handle_Flush(Log_UDP_Handle_T handle);
+extern int Log_UDP_Handle_Journal_Set(Log_UDP_Handle_T handle,const char *filename,int replay_rate);
+extern int Log_UDP_Handle_Destination_Add(Log_UDP_Handle_T handle,char *hostname,int port_number,
+					  int *destination_index);
+extern int Log_UDP_Handle_Destination_Count_Get(Log_UDP_Handle_T handle,int *destination_count);
+extern int Log_UDP_Handle_Destination_Stats_Get(Log_UDP_Handle_T handle,int destination_index,
+						struct Log_UDP_Handle_Destination_Stats_Struct *stats);
+extern int Log_UDP_Handle_Is_Enabled(Log_UDP_Handle_T handle,int severity,int verbosity);
+extern int Log_UDP_Handle_Socket_Get(Log_UDP_Handle_T handle,int *socket_id);
+extern int Log_UDP_Handle_Close(Log_UDP_Handle_T handle);
+
+#endif
+/*
+** $Log$
+*/
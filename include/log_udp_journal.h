@@ -0,0 +1,63 @@
+/* log_udp_journal.h
+** $Header$
+*/
+#ifndef LOG_UDP_JOURNAL_H
+#define LOG_UDP_JOURNAL_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * The replay rate used when a journal is opened with a replay rate of zero, in packets per second.
+ */
+#define LOG_UDP_JOURNAL_DEFAULT_REPLAY_RATE  (1000)
+/**
+ * The longest packet that can be written to a journal, in bytes.
+ */
+#define LOG_UDP_JOURNAL_PACKET_LENGTH_MAX    (65536)
+
+/* structures */
+/**
+ * Journal counters.
+ * <dl>
+ * <dt>Write_Count</dt> <dd>The number of packets written to the journal.</dd>
+ * <dt>Replay_Count</dt> <dd>The number of packets replayed to the collector, including packets replayed
+ *     again after the collector refused them.</dd>
+ * <dt>Retry_Count</dt> <dd>The number of times the replayer found the collector unreachable, and waited
+ *     to try again.</dd>
+ * <dt>Discard_Count</dt> <dd>The number of packets discarded because they could never be sent.</dd>
+ * <dt>Error_Count</dt> <dd>The number of packets lost because the journal file couldn't be written.</dd>
+ * <dt>Pending_Length</dt> <dd>The number of bytes in the journal waiting to be replayed.</dd>
+ * <dt>Spilling</dt> <dd>TRUE if packets are currently being written to the journal rather than sent,
+ *     FALSE otherwise.</dd>
+ * </dl>
+ */
+struct Log_UDP_Journal_Stats_Struct
+{
+	unsigned long Write_Count;
+	unsigned long Replay_Count;
+	unsigned long Retry_Count;
+	unsigned long Discard_Count;
+	unsigned long Error_Count;
+	size_t Pending_Length;
+	int Spilling;
+};
+
+/* typedefs */
+/**
+ * Typedef for a journal. The structure itself is private to log_udp_journal.c.
+ */
+typedef struct Log_UDP_Journal_Struct *Log_UDP_Journal_T;
+
+extern int Log_UDP_Journal_Open(const char *filename,char *hostname,int port_number,int replay_rate,
+				Log_UDP_Journal_T *journal);
+extern int Log_UDP_Journal_Is_Spilling(Log_UDP_Journal_T journal);
+extern int Log_UDP_Journal_Unreachable(int send_errno);
+extern int Log_UDP_Journal_Write(Log_UDP_Journal_T journal,const char *message_buffer,size_t message_buffer_length);
+extern int Log_UDP_Journal_Flush(Log_UDP_Journal_T journal);
+extern int Log_UDP_Journal_Stats_Get(Log_UDP_Journal_T journal,struct Log_UDP_Journal_Stats_Struct *stats);
+extern int Log_UDP_Journal_Close(Log_UDP_Journal_T journal);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,18 @@
+/* log_udp_rate.h
+** $Header$
+*/
+#ifndef LOG_UDP_RATE_H
+#define LOG_UDP_RATE_H
+#include "log_udp.h"
+
+extern int Log_UDP_Rate_Limit_Set(double records_per_second,int burst_count,int summary_interval_ms);
+extern int Log_UDP_Rate_Limit_Allow(Log_UDP_Summary_Send_T summary_send,void *summary_arg,const char *system,
+				    const char *sub_system,const char *category,int severity);
+extern int Log_UDP_Rate_Limit_Flush(void);
+extern int Log_UDP_Rate_Limit_Release(Log_UDP_Summary_Send_T summary_send,void *summary_arg);
+extern int Log_UDP_Rate_Limit_Suppressed_Count_Get(unsigned long *suppressed_count);
+
+#endif
+/*
+** $Log$
+*/
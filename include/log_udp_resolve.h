@@ -0,0 +1,37 @@
+/* log_udp_resolve.h
+** $Header$
+*/
+#ifndef LOG_UDP_RESOLVE_H
+#define LOG_UDP_RESOLVE_H
+#include <sys/types.h>
+#include <sys/socket.h>
+
+/* hash defines */
+/**
+ * The longest hostname that is cached, including the terminating NULL. Longer hostnames are still resolved,
+ * but not cached.
+ */
+#define LOG_UDP_RESOLVE_HOSTNAME_LENGTH         (256)
+/**
+ * The default length of time in seconds a resolved address is used before it is re-resolved.
+ */
+#define LOG_UDP_RESOLVE_DEFAULT_TTL             (300)
+/**
+ * Hostnames starting with this prefix are the path of a local Unix domain datagram socket, for instance
+ * "unix:/var/run/log_relay.sock". The port number is ignored.
+ */
+#define LOG_UDP_RESOLVE_UNIX_PREFIX             "unix:"
+
+extern int Log_UDP_Resolve_Address(const char *hostname,int port_number,struct sockaddr_storage *address,
+				   socklen_t *address_length);
+extern int Log_UDP_Resolve_Cache_Get(const char *hostname,int port_number,struct sockaddr_storage *address,
+				     socklen_t *address_length,int *found);
+extern int Log_UDP_Resolve_TTL_Set(int ttl);
+
+/* external variables */
+extern int Log_UDP_Resolve_Generation;
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,84 @@
+/* log_udp_ring.h
+** $Header$
+*/
+#ifndef LOG_UDP_RING_H
+#define LOG_UDP_RING_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * Hostnames starting with this prefix passed to Log_UDP_Handle_Open name a shared memory ring rather than
+ * a UDP destination, for instance "shm:log_relay". The port number is ignored.
+ */
+#define LOG_UDP_RING_PREFIX                 "shm:"
+/**
+ * The directory ring names that are not absolute paths are created in.
+ */
+#define LOG_UDP_RING_DIRECTORY              "/dev/shm/"
+/**
+ * The longest ring filename, including the terminating NULL.
+ */
+#define LOG_UDP_RING_PATH_LENGTH            (256)
+/**
+ * The smallest ring data area that can be created, in bytes.
+ */
+#define LOG_UDP_RING_DATA_LENGTH_MIN        (64*1024)
+/**
+ * The largest ring data area that can be created, in bytes.
+ */
+#define LOG_UDP_RING_DATA_LENGTH_MAX        (1024*1024*1024)
+/**
+ * The data area length used when a ring is created with a data length of zero, in bytes.
+ */
+#define LOG_UDP_RING_DEFAULT_DATA_LENGTH    (4*1024*1024)
+/**
+ * The default time the reader waits for a writer to finish a record it has reserved space for, before
+ * deciding the writer has died and skipping the record, in milliseconds.
+ */
+#define LOG_UDP_RING_DEFAULT_STALL_TIMEOUT_MS (5000)
+
+/* structures */
+/**
+ * Ring counters. Write_Count and Drop_Count are kept in the shared memory, so they cover every process
+ * writing to the ring.
+ * <dl>
+ * <dt>Write_Count</dt> <dd>The number of packets written to the ring.</dd>
+ * <dt>Drop_Count</dt> <dd>The number of packets dropped because the ring was full.</dd>
+ * <dt>Read_Count</dt> <dd>The number of packets read from the ring.</dd>
+ * <dt>Abandoned_Count</dt> <dd>The number of records skipped because their writer never finished them.</dd>
+ * <dt>Wake_Count</dt> <dd>The number of times a writer woke the waiting reader.</dd>
+ * <dt>Used_Length</dt> <dd>The number of bytes of the data area currently holding records.</dd>
+ * <dt>Data_Length</dt> <dd>The length of the data area in bytes.</dd>
+ * </dl>
+ */
+struct Log_UDP_Ring_Stats_Struct
+{
+	unsigned long Write_Count;
+	unsigned long Drop_Count;
+	unsigned long Read_Count;
+	unsigned long Abandoned_Count;
+	unsigned long Wake_Count;
+	size_t Used_Length;
+	size_t Data_Length;
+};
+
+/* typedefs */
+/**
+ * Typedef for a ring. The structure itself is private to log_udp_ring.c.
+ */
+typedef struct Log_UDP_Ring_Struct *Log_UDP_Ring_T;
+
+extern int Log_UDP_Ring_Open(const char *name,size_t data_length,Log_UDP_Ring_T *ring);
+extern int Log_UDP_Ring_Write(Log_UDP_Ring_T ring,const char *message_buffer,size_t message_buffer_length,
+			      int *dropped);
+extern int Log_UDP_Ring_Read(Log_UDP_Ring_T ring,int timeout_ms,const char **message,size_t *message_length,
+			     int *found);
+extern int Log_UDP_Ring_Stall_Timeout_Set(Log_UDP_Ring_T ring,int timeout_ms);
+extern int Log_UDP_Ring_Stats_Get(Log_UDP_Ring_T ring,struct Log_UDP_Ring_Stats_Struct *stats);
+extern int Log_UDP_Ring_Close(Log_UDP_Ring_T ring);
+extern int Log_UDP_Ring_Unlink(const char *name);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,88 @@
+/* log_udp_stream.h
+** $Header$
+*/
+#ifndef LOG_UDP_STREAM_H
+#define LOG_UDP_STREAM_H
+#include <stddef.h>
+
+/* hash defines */
+/**
+ * Hostnames starting with this prefix passed to Log_UDP_Handle_Open are sent to over a stream connection
+ * rather than as UDP datagrams, for instance "tcp:loghost".
+ */
+#define LOG_UDP_STREAM_PREFIX                 "tcp:"
+/**
+ * The length of the frame header in front of each packet on a stream: the packet length, four bytes in
+ * network byte order.
+ */
+#define LOG_UDP_STREAM_FRAME_HEADER_LENGTH    (4)
+/**
+ * The length of an acknowledgement the receiver sends back on a stream: the number of frames received over
+ * the connection so far (modulo 2^32), four bytes in network byte order.
+ */
+#define LOG_UDP_STREAM_ACK_LENGTH             (4)
+/**
+ * The smallest stream buffer that can be created, in bytes.
+ */
+#define LOG_UDP_STREAM_BUFFER_LENGTH_MIN      (64*1024)
+/**
+ * The stream buffer length used when a stream is opened with a buffer length of zero, in bytes.
+ */
+#define LOG_UDP_STREAM_DEFAULT_BUFFER_LENGTH  (1024*1024)
+/**
+ * The flush interval used when a stream is opened with a flush interval of zero, in milliseconds.
+ */
+#define LOG_UDP_STREAM_DEFAULT_FLUSH_INTERVAL_MS (10)
+/**
+ * How long Log_UDP_Stream_Close and Log_UDP_Handle_Flush wait for buffered packets to be acknowledged,
+ * in milliseconds.
+ */
+#define LOG_UDP_STREAM_FLUSH_TIMEOUT_MS       (2000)
+
+/* structures */
+/**
+ * Stream counters.
+ * <dl>
+ * <dt>Write_Count</dt> <dd>The number of packets buffered.</dd>
+ * <dt>Drop_Count</dt> <dd>The number of packets dropped because the buffer was full.</dd>
+ * <dt>Sent_Count</dt> <dd>The number of packets acknowledged by the receiver.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes written to the connection, including frame headers and
+ *     frames written again after a reconnection.</dd>
+ * <dt>Batch_Count</dt> <dd>The number of writes made, each with as many packets as were buffered.</dd>
+ * <dt>Connect_Count</dt> <dd>The number of times the connection was made.</dd>
+ * <dt>Disconnect_Count</dt> <dd>The number of times the connection was lost.</dd>
+ * <dt>Buffered_Length</dt> <dd>The number of bytes buffered, waiting to be written or acknowledged.</dd>
+ * <dt>Connected</dt> <dd>TRUE if the stream is currently connected, FALSE otherwise.</dd>
+ * </dl>
+ */
+struct Log_UDP_Stream_Stats_Struct
+{
+	unsigned long Write_Count;
+	unsigned long Drop_Count;
+	unsigned long Sent_Count;
+	unsigned long Byte_Count;
+	unsigned long Batch_Count;
+	unsigned long Connect_Count;
+	unsigned long Disconnect_Count;
+	size_t Buffered_Length;
+	int Connected;
+};
+
+/* typedefs */
+/**
+ * Typedef for a stream. The structure itself is private to log_udp_stream.c.
+ */
+typedef struct Log_UDP_Stream_Struct *Log_UDP_Stream_T;
+
+extern int Log_UDP_Stream_Open(char *hostname,int port_number,size_t buffer_length,int flush_interval_ms,
+			       Log_UDP_Stream_T *stream);
+extern int Log_UDP_Stream_Write(Log_UDP_Stream_T stream,const char *message_buffer,size_t message_buffer_length,
+				int *dropped);
+extern int Log_UDP_Stream_Flush(Log_UDP_Stream_T stream,int timeout_ms);
+extern int Log_UDP_Stream_Stats_Get(Log_UDP_Stream_T stream,struct Log_UDP_Stream_Stats_Struct *stats);
+extern int Log_UDP_Stream_Close(Log_UDP_Stream_T stream);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,75 @@
+/* log_udp_template.h
+** $Header$
+*/
+#ifndef LOG_UDP_TEMPLATE_H
+#define LOG_UDP_TEMPLATE_H
+#include <stdarg.h>
+#include "log_udp.h"
+
+/* hash defines */
+/**
+ * The maximum number of templates in a table. Template identifiers run from 1 to this value.
+ */
+#define LOG_UDP_TEMPLATE_COUNT                (256)
+/**
+ * The maximum number of arguments (conversions) in a template.
+ */
+#define LOG_UDP_TEMPLATE_ARGUMENT_COUNT       (16)
+/**
+ * The longest string argument (including the NULL terminator) sent. Longer strings are truncated.
+ */
+#define LOG_UDP_TEMPLATE_STRING_LENGTH        (LOG_CONTEXT_VALUE_LENGTH)
+/**
+ * The maximum number of bytes a template encodes to in the Message field: the code, the template definition,
+ * the argument count, and each argument's type byte and value.
+ */
+#define LOG_UDP_TEMPLATE_ENCODED_LENGTH       (3+2+LOG_RECORD_MESSAGE_LENGTH+1+ \
+					       (LOG_UDP_TEMPLATE_ARGUMENT_COUNT*(1+2+LOG_UDP_TEMPLATE_STRING_LENGTH)))
+/**
+ * The default time between template table refreshes (every template defined again), in milliseconds.
+ */
+#define LOG_UDP_TEMPLATE_DEFAULT_REFRESH_MS   (10000)
+
+/* enums */
+/**
+ * The argument types sent on the wire, one byte before each argument.
+ * <dl>
+ * <dt>LOG_UDP_TEMPLATE_ARGUMENT_INT</dt> <dd>A signed integer (%d, %i, %c), sent as a zig-zag varint.</dd>
+ * <dt>LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED</dt> <dd>An unsigned integer (%u, %o, %x, %X, %p), sent as a varint.</dd>
+ * <dt>LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE</dt> <dd>A floating point number (%e, %f, %g, %a), sent as an 8 byte
+ *     IEEE 754 double in network byte order.</dd>
+ * <dt>LOG_UDP_TEMPLATE_ARGUMENT_STRING</dt> <dd>A string (%s), sent as a varint length and characters.</dd>
+ * </dl>
+ */
+enum LOG_UDP_TEMPLATE_ARGUMENT
+{
+	LOG_UDP_TEMPLATE_ARGUMENT_INT=1,
+	LOG_UDP_TEMPLATE_ARGUMENT_UNSIGNED=2,
+	LOG_UDP_TEMPLATE_ARGUMENT_DOUBLE=3,
+	LOG_UDP_TEMPLATE_ARGUMENT_STRING=4
+};
+
+/* typedefs */
+/**
+ * Typedef for a template table. The structure itself is private to log_udp_template.c.
+ */
+typedef struct Log_UDP_Template_Table_Struct *Log_UDP_Template_Table_T;
+
+extern int Log_UDP_Template_Table_Create(Log_UDP_Template_Table_T *table);
+extern int Log_UDP_Template_Register(Log_UDP_Template_Table_T table,const char *format,int *template_id);
+extern int Log_UDP_Template_Format_Get(Log_UDP_Template_Table_T table,int template_id,const char **format);
+extern int Log_UDP_Template_Refresh_Set(Log_UDP_Template_Table_T table,int refresh_interval_ms);
+extern int Log_UDP_Template_Refresh(Log_UDP_Template_Table_T table);
+extern int Log_UDP_Template_Encode(Log_UDP_Template_Table_T table,int template_id,char *message_buffer,
+				   size_t message_buffer_length,size_t *message_buffer_position,
+				   va_list argument_list);
+extern int Log_UDP_Template_Packet_End(Log_UDP_Template_Table_T table,int sent);
+extern int Log_UDP_Template_Decode(Log_UDP_Template_Table_T table,const char *message_buffer,
+				   size_t message_buffer_length,size_t *message_buffer_position,
+				   char *message,size_t message_length,int *template_id,int *is_known);
+extern int Log_UDP_Template_Table_Destroy(Log_UDP_Template_Table_T table);
+
+#endif
+/*
+** $Log$
+*/
@@ -0,0 +1,171 @@
+/* log_udp_wire.h
+** $Header$
+*/
+#ifndef LOG_UDP_WIRE_H
+#define LOG_UDP_WIRE_H
+#include "log_udp.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_template.h"
+
+/* hash defines */
+/**
+ * The magic word at the start of a version 2 packet, sent as two bytes in network byte order.
+ * Version 1 packets start with the four byte integer LOG_UDP_PACKET_MAGIC_WORD, whose first two bytes
+ * are zero, so the two can't be confused.
+ * @see log_udp.html#LOG_UDP_PACKET_MAGIC_WORD
+ */
+#define LOG_UDP_PACKET_MAGIC_WORD_V2         (0xC0C2)
+/**
+ * Version 2 packet flag: the timestamp is in microseconds since 1970, rather than milliseconds.
+ */
+#define LOG_UDP_V2_FLAG_MICROSECONDS         (1<<0)
+/**
+ * Version 2 packet flag: the strings are sent through the sender's string dictionary, and a dictionary
+ * generation byte follows the flags.
+ * @see log_udp_dictionary.html
+ */
+#define LOG_UDP_V2_FLAG_DICTIONARY           (1<<1)
+/**
+ * Version 2 packet flag: the Message is a template identifier and binary encoded arguments, rather than text.
+ * Set on a handle, it allows Log_UDP_Handle_Template_Send to send templated packets. It is only set in
+ * packets that hold a templated Message.
+ * @see log_udp_template.html
+ */
+#define LOG_UDP_V2_FLAG_TEMPLATE             (1<<2)
+/**
+ * Version 2 packet flag: everything after the flags byte is compressed (see log_udp_compress.c), preceded by
+ * it's uncompressed length as a varint. The other flags describe the packet once it is decompressed.
+ * @see #Log_UDP_Compress_V2
+ */
+#define LOG_UDP_V2_FLAG_COMPRESSED           (1<<3)
+/**
+ * Version 2 packet flag: the packet carries the sender's stream tag (a host identifier, process id and
+ * start time, as varints) and a 64 bit sequence number (a varint), after the dictionary generation.
+ * The sequence number increases by one for each packet in the stream, so receivers can count lost
+ * and reordered packets.
+ * @see #LOG_UDP_V2_SEQUENCE_LENGTH
+ */
+#define LOG_UDP_V2_FLAG_SEQUENCE             (1<<4)
+/**
+ * A mask of all the version 2 packet flags this version of the library understands.
+ */
+#define LOG_UDP_V2_FLAG_ALL                  (LOG_UDP_V2_FLAG_MICROSECONDS|LOG_UDP_V2_FLAG_DICTIONARY| \
+					      LOG_UDP_V2_FLAG_TEMPLATE|LOG_UDP_V2_FLAG_COMPRESSED| \
+					      LOG_UDP_V2_FLAG_SEQUENCE)
+/**
+ * The longest packet the decoder will decompress a compressed packet into, in bytes.
+ */
+#define LOG_UDP_V2_DECOMPRESSED_LENGTH_MAX   (1024*1024)
+/**
+ * The maximum number of bytes in an encoded varint (a 64 bit value, 7 bits per byte).
+ */
+#define LOG_UDP_VARINT_LENGTH                (10)
+/**
+ * The maximum number of bytes taken by the stream tag and sequence number of a packet sent with
+ * LOG_UDP_V2_FLAG_SEQUENCE: four varints.
+ * @see #LOG_UDP_V2_FLAG_SEQUENCE
+ */
+#define LOG_UDP_V2_SEQUENCE_LENGTH           (4*LOG_UDP_VARINT_LENGTH)
+/**
+ * Macro returning a buffer length (in bytes) always big enough to hold a version 2 packet containing one log
+ * record and log_context_count contexts. Each string has a varint length of at most 2 bytes in place of
+ * version 1's NULL terminator, plus a dictionary code of at most 2 bytes.
+ * The other fields are no longer than in version 1, and there may be a stream tag and sequence number.
+ * @see log_udp.html#LOG_UDP_BUFFER_LENGTH
+ * @see #LOG_UDP_V2_SEQUENCE_LENGTH
+ */
+#define LOG_UDP_V2_BUFFER_LENGTH(log_context_count) (LOG_UDP_BUFFER_LENGTH(log_context_count)+ \
+						     (5*(log_context_count))+40+LOG_UDP_V2_SEQUENCE_LENGTH)
+
+/* enums */
+/**
+ * The wire formats a log record can be encoded in.
+ * <dl>
+ * <dt>LOG_UDP_WIRE_FORMAT_V1</dt> <dd>The original format: magic word 0xC0C0, NULL terminated strings and
+ *     four byte integers.</dd>
+ * <dt>LOG_UDP_WIRE_FORMAT_V2</dt> <dd>The compact format: magic word 0xC0C2, a flags byte, a varint timestamp,
+ *     severity and verbosity packed into one byte, and varint length prefixed strings.</dd>
+ * </dl>
+ */
+enum LOG_UDP_WIRE_FORMAT
+{
+	LOG_UDP_WIRE_FORMAT_V1=1,
+	LOG_UDP_WIRE_FORMAT_V2=2
+};
+
+/**
+ * Macro to check whether the wire format is a legal value.
+ * @see #LOG_UDP_WIRE_FORMAT
+ */
+#define LOG_UDP_IS_WIRE_FORMAT(format) (((format) == LOG_UDP_WIRE_FORMAT_V1)|| \
+					((format) == LOG_UDP_WIRE_FORMAT_V2))
+
+/* structures */
+/**
+ * Information about a decoded packet that does not fit in a log record.
+ * <dl>
+ * <dt>Format</dt> <dd>The packet's wire format, a member of LOG_UDP_WIRE_FORMAT.</dd>
+ * <dt>Flags</dt> <dd>The version 2 packet flags (zero for version 1 packets).</dd>
+ * <dt>Timestamp_Us</dt> <dd>The timestamp in microseconds since 1970. Only microsecond accurate if
+ *     LOG_UDP_V2_FLAG_MICROSECONDS is set in Flags.</dd>
+ * <dt>Dictionary_Complete</dt> <dd>FALSE if a field referred to a dictionary string the receiver
+ *     does not hold (it is decoded as a placeholder), TRUE otherwise.</dd>
+ * <dt>Template_Id</dt> <dd>The template identifier, if the Message was sent as a template
+ *     (LOG_UDP_V2_FLAG_TEMPLATE), zero otherwise. Messages from one sender with the same identifier
+ *     came from the same format.</dd>
+ * <dt>Template_Complete</dt> <dd>FALSE if the Message was sent as a template the receiver does not hold
+ *     (it is decoded as a placeholder and the arguments), TRUE otherwise.</dd>
+ * <dt>Sequence_Host_Id</dt> <dd>If LOG_UDP_V2_FLAG_SEQUENCE is set in Flags, a hash of the sending host's
+ *     name, zero otherwise.</dd>
+ * <dt>Sequence_Pid</dt> <dd>If LOG_UDP_V2_FLAG_SEQUENCE is set, the sending process's id, zero otherwise.</dd>
+ * <dt>Sequence_Start_Us</dt> <dd>If LOG_UDP_V2_FLAG_SEQUENCE is set, the time the sender's stream started
+ *     in microseconds since 1970, zero otherwise. Together with Sequence_Host_Id and Sequence_Pid this
+ *     identifies the stream, even after the process id is reused.</dd>
+ * <dt>Sequence_Number</dt> <dd>If LOG_UDP_V2_FLAG_SEQUENCE is set, the packet's position in the stream,
+ *     starting at zero, zero otherwise.</dd>
+ * </dl>
+ * @see #LOG_UDP_WIRE_FORMAT
+ */
+struct Log_UDP_Packet_Info_Struct
+{
+	int Format;
+	int Flags;
+	int64_t Timestamp_Us;
+	int Dictionary_Complete;
+	int Template_Id;
+	int Template_Complete;
+	uint64_t Sequence_Host_Id;
+	uint64_t Sequence_Pid;
+	uint64_t Sequence_Start_Us;
+	uint64_t Sequence_Number;
+};
+
+extern int Log_UDP_Encode_V2(const struct Log_Record_Struct *log_record,int log_context_count,
+			     const struct Log_Context_Struct *log_context_list,Log_UDP_Dictionary_T dictionary,
+			     const struct Log_UDP_Packet_Info_Struct *stream_tag,char *message_buffer,
+			     size_t message_buffer_length,size_t *encoded_length);
+extern int Log_UDP_Encode_Varint(char *message_buffer,size_t message_buffer_length,size_t *message_buffer_position,
+				 uint64_t value);
+extern int Log_UDP_Encode_Varint_String(char *message_buffer,size_t message_buffer_length,
+					size_t *message_buffer_position,const char *string,size_t field_length);
+extern int Log_UDP_Compress_V2(const char *message_buffer,size_t message_buffer_length,char *compressed_buffer,
+			       size_t compressed_buffer_length,size_t *compressed_length);
+extern int Log_UDP_Decode(const char *message_buffer,size_t message_buffer_length,
+			  struct Log_Record_Struct *log_record,int *log_context_count,
+			  struct Log_Context_Struct **log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info);
+extern int Log_UDP_Decode_Dictionary(const char *message_buffer,size_t message_buffer_length,
+				     Log_UDP_Dictionary_T dictionary,struct Log_Record_Struct *log_record,
+				     int *log_context_count,struct Log_Context_Struct **log_context_list,
+				     struct Log_UDP_Packet_Info_Struct *packet_info);
+extern int Log_UDP_Decode_Template(const char *message_buffer,size_t message_buffer_length,
+				   Log_UDP_Dictionary_T dictionary,Log_UDP_Template_Table_T template_table,
+				   struct Log_Record_Struct *log_record,int *log_context_count,
+				   struct Log_Context_Struct **log_context_list,
+				   struct Log_UDP_Packet_Info_Struct *packet_info);
+extern int Log_UDP_Decode_Varint(const char *message_buffer,size_t message_buffer_length,
+				 size_t *message_buffer_position,uint64_t *value);
+
+#endif
+/*
+** $Log$
+*/
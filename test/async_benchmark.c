@@ -0,0 +1,560 @@
+/* async_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.1c threads and
+ * POSIX.4/IEEE1003.1b-1993 clock_gettime prototypes.
+ */
+#define _POSIX_C_SOURCE 199506L
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include "log_general.h"
+#include "log_create.h"
+#include "log_udp.h"
+#include "log_udp_async.h"
+#include "log_udp_resolve.h"
+
+/**
+ * This program tests the asynchronous sender (log_udp_async.c) with each overflow policy in turn.
+ * Several producer threads queue records with Log_UDP_Async_Send onto a short queue, so the queue
+ * overflows. Log_UDP_Flush is then called, and the program checks the sender's counters add up, that
+ * nothing failed to send, and that the receiver got every record the sender says it sent. The receiver is
+ * a Unix domain datagram socket, drained by it's own thread, so no packets are lost between the sender and
+ * the receiver. The time taken by the producers and the flush is reported for each policy.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The length of the Unix domain socket path.
+ */
+#define UNIX_PATH_LENGTH                 (108)
+/**
+ * The maximum number of producer threads.
+ */
+#define MAX_PRODUCER_COUNT               (64)
+/**
+ * How long the receiver thread waits for a packet (in milliseconds) before checking whether it should quit.
+ */
+#define RECEIVE_TIMEOUT_MS               (100)
+/**
+ * How long to wait (in milliseconds) for the receiver to get the packets sent, once the queue is flushed.
+ */
+#define RECEIVE_WAIT_MS                  (2000)
+/**
+ * How long to wait (in milliseconds) for Log_UDP_Flush.
+ */
+#define FLUSH_TIMEOUT_MS                 (60000)
+
+/* structures */
+/**
+ * Data for one producer thread.
+ * <dl>
+ * <dt>Index</dt> <dd>The producer's index, put in the messages it sends.</dd>
+ * <dt>Async</dt> <dd>The asynchronous sender to queue records on.</dd>
+ * <dt>Queued_Count</dt> <dd>The number of records Log_UDP_Async_Send queued (returned TRUE for).</dd>
+ * <dt>Thread</dt> <dd>The producer thread.</dd>
+ * </dl>
+ */
+struct Producer_Struct
+{
+	int Index;
+	Log_UDP_Async_T Async;
+	unsigned long Queued_Count;
+	pthread_t Thread;
+};
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of producer threads.
+ * @see #MAX_PRODUCER_COUNT
+ */
+static int Producer_Count = 8;
+/**
+ * The number of records each producer thread queues.
+ */
+static int Message_Count = 10000;
+/**
+ * The asynchronous sender's queue length.
+ */
+static int Queue_Length = 64;
+/**
+ * The Unix domain socket the receiver thread reads.
+ */
+static int Receive_Socket_Id = -1;
+/**
+ * The number of packets the receiver thread has got.
+ */
+static volatile unsigned long Received_Count = 0;
+/**
+ * Set to make the receiver thread exit.
+ */
+static volatile int Receiver_Quit = FALSE;
+/**
+ * Buffer to receive packets into. Only used by the receiver thread.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int Unix_Receiver_Open(char *unix_path,int *socket_id);
+static void *Receiver_Thread(void *user_arg);
+static void *Producer_Thread(void *user_arg);
+static int Overflow_Test(int socket_id,int overflow,char *overflow_name,int *check_failed);
+static unsigned long Received_Wait(unsigned long sent_count);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive integer if it fails.
+ * @see #Unix_Receiver_Open
+ * @see #Receiver_Thread
+ * @see #Overflow_Test
+ */
+int main(int argc, char *argv[])
+{
+	pthread_t receiver_thread;
+	char unix_path[UNIX_PATH_LENGTH];
+	char hostname[UNIX_PATH_LENGTH+8];
+	int socket_id,retval,check_failed;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"async_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	snprintf(unix_path,UNIX_PATH_LENGTH,"/tmp/async_benchmark.%d",(int)getpid());
+	if(!Unix_Receiver_Open(unix_path,&Receive_Socket_Id))
+		return 2;
+	retval = pthread_create(&receiver_thread,NULL,Receiver_Thread,(void *)&Receive_Socket_Id);
+	if(retval != 0)
+	{
+		fprintf(stderr,"async_benchmark:Failed to create receiver thread (%d:%s).\n",retval,strerror(retval));
+		close(Receive_Socket_Id);
+		unlink(unix_path);
+		return 3;
+	}
+	snprintf(hostname,sizeof(hostname),"%s%s",LOG_UDP_RESOLVE_UNIX_PREFIX,unix_path);
+	check_failed = FALSE;
+	retval = Log_UDP_Open(hostname,0,&socket_id);
+	if(retval)
+	{
+		retval = Overflow_Test(socket_id,LOG_UDP_ASYNC_OVERFLOW_DROP_NEWEST,"DROP_NEWEST",&check_failed)&&
+			Overflow_Test(socket_id,LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST,"DROP_OLDEST",&check_failed)&&
+			Overflow_Test(socket_id,LOG_UDP_ASYNC_OVERFLOW_BLOCK,"BLOCK",&check_failed);
+		Log_UDP_Close(socket_id);
+	}
+	Receiver_Quit = TRUE;
+	pthread_join(receiver_thread,NULL);
+	close(Receive_Socket_Id);
+	unlink(unix_path);
+	if(!retval)
+	{
+		Log_General_Error();
+		return 4;
+	}
+	if(check_failed)
+	{
+		fprintf(stderr,"async_benchmark:Checks failed.\n");
+		return 5;
+	}
+	fprintf(stdout,"async_benchmark:All checks passed.\n");
+	return 0;
+}
+
+/**
+ * Open a Unix domain datagram socket bound to a path, with a receive timeout of RECEIVE_TIMEOUT_MS.
+ * @param unix_path The path to bind the socket to. Any file already there is removed.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #RECEIVE_TIMEOUT_MS
+ */
+static int Unix_Receiver_Open(char *unix_path,int *socket_id)
+{
+	struct sockaddr_un address;
+	struct timeval timeout;
+
+	(*socket_id) = socket(AF_UNIX,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"async_benchmark:Failed to create Unix domain socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path,unix_path,sizeof(address.sun_path)-1);
+	unlink(unix_path);
+	if(bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)
+	{
+		fprintf(stderr,"async_benchmark:Failed to bind to %s (%d:%s).\n",unix_path,errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	timeout.tv_sec = 0;
+	timeout.tv_usec = RECEIVE_TIMEOUT_MS*1000;
+	if(setsockopt((*socket_id),SOL_SOCKET,SO_RCVTIMEO,&timeout,sizeof(timeout)) < 0)
+	{
+		fprintf(stderr,"async_benchmark:Failed to set receive timeout (%d:%s).\n",errno,strerror(errno));
+		close((*socket_id));
+		unlink(unix_path);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * The receiver thread. Counts the packets received on the socket until Receiver_Quit is set.
+ * @param user_arg The address of the integer holding the socket to receive on.
+ * @return The routine returns NULL.
+ * @see #Received_Count
+ * @see #Receiver_Quit
+ */
+static void *Receiver_Thread(void *user_arg)
+{
+	int socket_id = (*(int *)user_arg);
+
+	while(!Receiver_Quit)
+	{
+		if(recv(socket_id,Packet_Buffer,PACKET_LENGTH,0) > 0)
+			__sync_fetch_and_add(&Received_Count,1);
+	}
+	return NULL;
+}
+
+/**
+ * A producer thread. Queues Message_Count records with Log_UDP_Async_Send, counting the ones queued.
+ * Records dropped because the queue was full are expected, so failures are not reported.
+ * @param user_arg The producer's Producer_Struct.
+ * @return The routine returns NULL.
+ * @see #Producer_Struct
+ * @see #Message_Count
+ */
+static void *Producer_Thread(void *user_arg)
+{
+	struct Producer_Struct *producer = (struct Producer_Struct *)user_arg;
+	struct Log_Record_Struct log_record;
+	char message[64];
+	int i;
+
+	for(i = 0; i < Message_Count; i++)
+	{
+		sprintf(message,"Producer %d message %d.",producer->Index,i);
+		if(!Log_Create_Record("Async","async_benchmark","async_benchmark.c",NULL,"Producer_Thread",
+				      LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",message,&log_record))
+		{
+			Log_General_Error();
+			break;
+		}
+		if(Log_UDP_Async_Send(producer->Async,&log_record,0,NULL))
+			producer->Queued_Count++;
+	}
+	return NULL;
+}
+
+/**
+ * Create an asynchronous sender with the overflow policy, start Producer_Count producer threads queueing
+ * records on it, wait for them to finish, then flush it. Checks the sender's counters against the
+ * records the producers queued, and against the packets the receiver thread got:
+ * <ul>
+ * <li>Every record Log_UDP_Async_Send returned TRUE for is counted as queued.
+ * <li>Every queued record was sent, or dropped (only DROP_OLDEST drops queued records). None failed.
+ * <li>Every record Log_UDP_Async_Send was called with was queued, or dropped (BLOCK never drops).
+ * <li>The receiver got every record sent.
+ * </ul>
+ * @param socket_id The socket the sender sends on.
+ * @param overflow The overflow policy, a member of LOG_UDP_ASYNC_OVERFLOW.
+ * @param overflow_name The overflow policy's name, for printing.
+ * @param check_failed The address of an integer, set to TRUE if a check fails. It is not cleared
+ *        if the checks pass.
+ * @return The routine returns TRUE if the test ran, and FALSE if an error stopped it.
+ * @see #Producer_Thread
+ * @see #Received_Wait
+ * @see #Producer_Count
+ * @see #Queue_Length
+ * @see #FLUSH_TIMEOUT_MS
+ */
+static int Overflow_Test(int socket_id,int overflow,char *overflow_name,int *check_failed)
+{
+	struct Producer_Struct producer_list[MAX_PRODUCER_COUNT];
+	Log_UDP_Async_T async = NULL;
+	struct timespec start_time,produced_time,flushed_time;
+	char error_string[LOG_GENERAL_ERROR_LENGTH];
+	unsigned long queued_count,sent_count,failed_count,dropped_count,producer_queued_count,received_count;
+	unsigned long attempt_count,start_received_count,queue_dropped_count;
+	int i,retval,created_count,error_number;
+
+	if(!Log_UDP_Async_Open(socket_id,Queue_Length,overflow,-1,&async))
+		return FALSE;
+	start_received_count = Received_Wait(0);
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	for(created_count = 0; created_count < Producer_Count; created_count++)
+	{
+		producer_list[created_count].Index = created_count;
+		producer_list[created_count].Async = async;
+		producer_list[created_count].Queued_Count = 0;
+		retval = pthread_create(&(producer_list[created_count].Thread),NULL,Producer_Thread,
+					(void *)&(producer_list[created_count]));
+		if(retval != 0)
+		{
+			fprintf(stderr,"async_benchmark:Failed to create producer thread %d (%d:%s).\n",created_count,
+				retval,strerror(retval));
+			break;
+		}
+	}
+	producer_queued_count = 0;
+	for(i = 0; i < created_count; i++)
+	{
+		pthread_join(producer_list[i].Thread,NULL);
+		producer_queued_count += producer_list[i].Queued_Count;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&produced_time);
+	if(created_count < Producer_Count)
+	{
+		Log_UDP_Async_Close(async);
+		(*check_failed) = TRUE;
+		return TRUE;
+	}
+	if(!Log_UDP_Flush(async,FLUSH_TIMEOUT_MS))
+	{
+		Log_UDP_Async_Close(async);
+		return FALSE;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&flushed_time);
+	if((!Log_UDP_Async_Statistics_Get(async,&queued_count,&sent_count,&failed_count,&dropped_count))||
+	   (!Log_UDP_Async_Error_Get(async,&error_number,error_string)))
+	{
+		Log_UDP_Async_Close(async);
+		return FALSE;
+	}
+	if(!Log_UDP_Async_Close(async))
+		return FALSE;
+	received_count = Received_Wait(start_received_count+sent_count)-start_received_count;
+	attempt_count = ((unsigned long)Producer_Count)*((unsigned long)Message_Count);
+	/* DROP_OLDEST throws away records already queued, the other policies drop the record being queued */
+	if(overflow == LOG_UDP_ASYNC_OVERFLOW_DROP_OLDEST)
+		queue_dropped_count = dropped_count;
+	else
+		queue_dropped_count = 0;
+	fprintf(stdout,"%s: %d producers x %d records, queue length %d: produce %.3f s, flush %.3f s.\n",
+		overflow_name,Producer_Count,Message_Count,Queue_Length,Time_Difference(start_time,produced_time),
+		Time_Difference(produced_time,flushed_time));
+	fprintf(stdout,"%s: queued %lu, sent %lu, failed %lu, dropped %lu, received %lu.\n",overflow_name,
+		queued_count,sent_count,failed_count,dropped_count,received_count);
+	if(queued_count != producer_queued_count)
+	{
+		fprintf(stderr,"async_benchmark:%s:Sender queued %lu records, producers queued %lu.\n",
+			overflow_name,queued_count,producer_queued_count);
+		(*check_failed) = TRUE;
+	}
+	if(failed_count != 0)
+	{
+		fprintf(stderr,"async_benchmark:%s:%lu records failed to send, last error (%d) : %s\n",overflow_name,
+			failed_count,error_number,error_string);
+		(*check_failed) = TRUE;
+	}
+	if(queued_count != (sent_count+failed_count+queue_dropped_count))
+	{
+		fprintf(stderr,"async_benchmark:%s:Flush left records unsent: queued %lu, sent %lu, failed %lu, "
+			"dropped from queue %lu.\n",overflow_name,queued_count,sent_count,failed_count,
+			queue_dropped_count);
+		(*check_failed) = TRUE;
+	}
+	if(attempt_count != (queued_count+dropped_count-queue_dropped_count))
+	{
+		fprintf(stderr,"async_benchmark:%s:Records lost: %lu sent to the queue, %lu queued, %lu dropped.\n",
+			overflow_name,attempt_count,queued_count,dropped_count);
+		(*check_failed) = TRUE;
+	}
+	if((overflow == LOG_UDP_ASYNC_OVERFLOW_BLOCK)&&(dropped_count != 0))
+	{
+		fprintf(stderr,"async_benchmark:%s:Blocking sender dropped %lu records.\n",overflow_name,dropped_count);
+		(*check_failed) = TRUE;
+	}
+	if(received_count != sent_count)
+	{
+		fprintf(stderr,"async_benchmark:%s:Sent %lu records, receiver got %lu.\n",overflow_name,sent_count,
+			received_count);
+		(*check_failed) = TRUE;
+	}
+	return TRUE;
+}
+
+/**
+ * Wait until the receiver thread has got a number of packets, or no more packets have arrived for
+ * RECEIVE_WAIT_MS.
+ * @param sent_count The number of packets to wait for. With 0, waits until no more packets arrive.
+ * @return The number of packets the receiver thread has got.
+ * @see #Received_Count
+ * @see #RECEIVE_WAIT_MS
+ */
+static unsigned long Received_Wait(unsigned long sent_count)
+{
+	struct timespec sleep_time;
+	unsigned long received_count,last_received_count;
+	int idle_ms;
+
+	sleep_time.tv_sec = 0;
+	sleep_time.tv_nsec = 10*(ONE_SECOND_NS/1000);
+	received_count = __sync_fetch_and_add(&Received_Count,0);
+	last_received_count = received_count;
+	idle_ms = 0;
+	while(((sent_count == 0)||(received_count < sent_count))&&(idle_ms < RECEIVE_WAIT_MS))
+	{
+		nanosleep(&sleep_time,NULL);
+		received_count = __sync_fetch_and_add(&Received_Count,0);
+		if(received_count == last_received_count)
+			idle_ms += 10;
+		else
+			idle_ms = 0;
+		last_received_count = received_count;
+		/* when just waiting for the receiver to go quiet, a short idle time will do */
+		if((sent_count == 0)&&(idle_ms >= RECEIVE_TIMEOUT_MS))
+			break;
+	}
+	return received_count;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ * @see #Producer_Count
+ * @see #Queue_Length
+ * @see #MAX_PRODUCER_COUNT
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"async_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"async_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-producers")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Producer_Count);
+				if((retval != 1)||(Producer_Count < 1)||(Producer_Count > MAX_PRODUCER_COUNT))
+				{
+					fprintf(stderr,"async_benchmark:Parse_Arguments:"
+						"Failed to parse producer count '%s' (1..%d).\n",argv[i+1],
+						MAX_PRODUCER_COUNT);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"async_benchmark:Parse_Arguments:Producer count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-queue_length")==0)||(strcmp(argv[i],"-q")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Queue_Length);
+				if((retval != 1)||(Queue_Length < 1))
+				{
+					fprintf(stderr,"async_benchmark:Parse_Arguments:"
+						"Failed to parse queue length '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"async_benchmark:Parse_Arguments:Queue length requires a number.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"async_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"async_benchmark help.\n");
+	fprintf(stdout,"async_benchmark queues records from several producer threads onto an asynchronous sender,\n");
+	fprintf(stdout,"once with each overflow policy (DROP_NEWEST, DROP_OLDEST and BLOCK), flushes it, and checks\n");
+	fprintf(stdout,"every queued record was sent or dropped, and that a Unix domain receiver got every record sent.\n");
+	fprintf(stdout,"It prints the time taken, and exits with a non-zero status if a check fails.\n");
+	fprintf(stdout,"async_benchmark [-c[ount] <records per producer>][-p[roducers] <number of producer threads>]\n");
+	fprintf(stdout,"\t[-q[ueue_length] <queue length>][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,380 @@
+/* container_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_container.h"
+#include "log_udp_handle.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program compares sending short syslog style messages one per datagram against packing them into
+ * multi-record container datagrams. It sends to a socket it binds on the loopback interface, and reports
+ * the sender time, the receiver time (receiving, unpacking and decoding), and the datagrams and bytes
+ * received for each method.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The number of messages sent before the receive socket is drained. Small enough to fit in the
+ * socket's receive buffer when sent one per datagram.
+ */
+#define DRAIN_COUNT                      (64)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The flush interval used for containers, in milliseconds.
+ */
+#define FLUSH_INTERVAL_MS                (1000)
+
+/* structures */
+/**
+ * The results of sending messages with one method.
+ * <dl>
+ * <dt>Send_Time</dt> <dd>The time spent sending, in seconds.</dd>
+ * <dt>Receive_Time</dt> <dd>The time spent receiving, unpacking and decoding, in seconds.</dd>
+ * <dt>Datagram_Count</dt> <dd>The number of datagrams received.</dd>
+ * <dt>Record_Count</dt> <dd>The number of records decoded.</dd>
+ * <dt>Byte_Count</dt> <dd>The number of bytes received.</dd>
+ * </dl>
+ */
+struct Result_Struct
+{
+	double Send_Time;
+	double Receive_Time;
+	unsigned long Datagram_Count;
+	unsigned long Record_Count;
+	unsigned long Byte_Count;
+};
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of messages to send with each method.
+ */
+static int Message_Count = 100000;
+/**
+ * The container datagram length in bytes.
+ */
+static int Datagram_Length = LOG_UDP_CONTAINER_DEFAULT_LENGTH;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int Send_Messages(Log_UDP_Handle_T handle,int receive_socket_id,struct Result_Struct *result);
+static int Drain(int receive_socket_id,struct Result_Struct *result);
+static int Decode(const char *packet,size_t packet_length,struct Result_Struct *result);
+static void Print_Result(char *name,struct Result_Struct *result);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Message_Count
+ * @see #Datagram_Length
+ * @see #Send_Messages
+ */
+int main(int argc, char *argv[])
+{
+	Log_UDP_Handle_T handle = NULL;
+	struct sockaddr_in address;
+	struct Result_Struct single_result,container_result;
+	socklen_t address_length;
+	int receive_socket_id;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"container_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	receive_socket_id = socket(AF_INET,SOCK_DGRAM,0);
+	if(receive_socket_id < 0)
+	{
+		fprintf(stderr,"container_benchmark:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return 2;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	address_length = sizeof(address);
+	if((bind(receive_socket_id,(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname(receive_socket_id,(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"container_benchmark:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close(receive_socket_id);
+		return 3;
+	}
+	if(!Log_UDP_Handle_Open("127.0.0.1",ntohs(address.sin_port),"Messages","sshd","container_benchmark.c",
+				NULL,&handle))
+	{
+		Log_General_Error();
+		close(receive_socket_id);
+		return 4;
+	}
+	/* one record per datagram */
+	if((!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,0))||
+	   (!Send_Messages(handle,receive_socket_id,&single_result)))
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle);
+		close(receive_socket_id);
+		return 5;
+	}
+	/* containers */
+	if((!Log_UDP_Handle_Container_Set(handle,(size_t)Datagram_Length,FLUSH_INTERVAL_MS))||
+	   (!Send_Messages(handle,receive_socket_id,&container_result)))
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle);
+		close(receive_socket_id);
+		return 6;
+	}
+	Log_UDP_Handle_Close(handle);
+	close(receive_socket_id);
+	Print_Result("one per datagram:",&single_result);
+	Print_Result("containers:",&container_result);
+	return 0;
+}
+
+/**
+ * Send Message_Count short syslog style messages, draining the receive socket every DRAIN_COUNT messages.
+ * The handle is flushed before the last drain.
+ * @param handle The logger handle.
+ * @param receive_socket_id The socket the handle sends to.
+ * @param result The address of a structure to fill in with the results.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see #Drain
+ * @see #DRAIN_COUNT
+ */
+static int Send_Messages(Log_UDP_Handle_T handle,int receive_socket_id,struct Result_Struct *result)
+{
+	struct timespec start_time,end_time;
+	int i,retval;
+
+	memset(result,0,sizeof(struct Result_Struct));
+	for(i = 0; i < Message_Count; i++)
+	{
+		if((i%DRAIN_COUNT) == 0)
+			clock_gettime(CLOCK_MONOTONIC,&start_time);
+		retval = Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",
+				       "Accepted publickey for eng from 192.168.1.%d port %d ssh2",1+(i%254),
+				       1024+(i%60000));
+		if(retval && (i == (Message_Count-1)))
+			retval = Log_UDP_Handle_Flush(handle);
+		if(!retval)
+			return FALSE;
+		if((((i+1)%DRAIN_COUNT) == 0)||(i == (Message_Count-1)))
+		{
+			clock_gettime(CLOCK_MONOTONIC,&end_time);
+			result->Send_Time += Time_Difference(start_time,end_time);
+			if(!Drain(receive_socket_id,result))
+				return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Receive and decode every packet waiting on the socket, unpacking containers.
+ * @param receive_socket_id The socket.
+ * @param result The results, the receive time and counts are added to.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Packet_Buffer
+ * @see #Decode
+ */
+static int Drain(int receive_socket_id,struct Result_Struct *result)
+{
+	struct timespec start_time,end_time;
+	const char *packet = NULL;
+	size_t packet_position,packet_length;
+	ssize_t datagram_length;
+	int record_count,i,retval;
+
+	retval = TRUE;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	while(retval && ((datagram_length = recv(receive_socket_id,Packet_Buffer,PACKET_LENGTH,MSG_DONTWAIT)) > 0))
+	{
+		result->Datagram_Count++;
+		result->Byte_Count += datagram_length;
+		if(Log_UDP_Container_Is_Container(Packet_Buffer,(size_t)datagram_length))
+		{
+			retval = Log_UDP_Container_Unpack_Start(Packet_Buffer,(size_t)datagram_length,&record_count,
+								&packet_position);
+			for(i = 0; retval && (i < record_count); i++)
+			{
+				retval = Log_UDP_Container_Unpack_Next(Packet_Buffer,(size_t)datagram_length,
+								       &packet_position,&packet,&packet_length);
+				retval = retval && Decode(packet,packet_length,result);
+			}
+		}
+		else
+			retval = Decode(Packet_Buffer,(size_t)datagram_length,result);
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	result->Receive_Time += Time_Difference(start_time,end_time);
+	return retval;
+}
+
+/**
+ * Decode one packet.
+ * @param packet The encoded packet.
+ * @param packet_length The length of the packet in bytes.
+ * @param result The results, the record count is incremented.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Decode(const char *packet,size_t packet_length,struct Result_Struct *result)
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	int log_context_count;
+
+	if(!Log_UDP_Decode(packet,packet_length,&log_record,&log_context_count,&log_context_list,NULL))
+		return FALSE;
+	if(log_context_list != NULL)
+		free(log_context_list);
+	result->Record_Count++;
+	return TRUE;
+}
+
+/**
+ * Print the results of one method.
+ * @param name The name of the method.
+ * @param result The results.
+ */
+static void Print_Result(char *name,struct Result_Struct *result)
+{
+	fprintf(stdout,"%-18s %lu records in %lu datagrams (%.1f records/datagram, %lu bytes): "
+		"send %.2f us/record, receive %.2f us/record.\n",name,result->Record_Count,result->Datagram_Count,
+		((double)result->Record_Count)/((double)result->Datagram_Count),result->Byte_Count,
+		(result->Send_Time*1000000.0)/Message_Count,(result->Receive_Time*1000000.0)/Message_Count);
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ * @see #Datagram_Length
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"container_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"container_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-length")==0)||(strcmp(argv[i],"-l")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Datagram_Length);
+				if((retval != 1)||(Datagram_Length < 1))
+				{
+					fprintf(stderr,"container_benchmark:Parse_Arguments:"
+						"Failed to parse datagram length '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"container_benchmark:Parse_Arguments:Datagram length requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"container_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"container_benchmark help.\n");
+	fprintf(stdout,"container_benchmark sends short syslog style messages over the loopback interface, one per\n");
+	fprintf(stdout,"datagram and packed into container datagrams, and prints the sender and receiver time taken\n");
+	fprintf(stdout,"and the datagrams and bytes sent by each.\n");
+	fprintf(stdout,"container_benchmark [-c[ount] <number of messages>][-l[ength] <datagram length>][-help]\n");
+}
+
+/*
+** $Log$
+*/
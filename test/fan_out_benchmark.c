@@ -0,0 +1,333 @@
+/* fan_out_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_handle.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program compares sending every message to two receivers using two logger handles (two encodes and
+ * two sends per message) against one handle with two destinations (one encode, and one sendmmsg call
+ * per message). It binds two sockets on the loopback interface, and reports the sender time for each
+ * method, and the packets each receiver got and the fan out handle's destination counters.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The number of messages sent before the receive sockets are drained. Small enough to fit in the
+ * sockets' receive buffers.
+ */
+#define DRAIN_COUNT                      (64)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The number of receivers.
+ */
+#define RECEIVER_COUNT                   (2)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of messages to send with each method.
+ */
+static int Message_Count = 100000;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int Receiver_Open(int *socket_id,int *port_number);
+static int Send_Messages(Log_UDP_Handle_T *handle_list,int handle_count,int *receive_socket_id_list,
+			 double *send_time,unsigned long *packet_count_list);
+static unsigned long Drain(int receive_socket_id);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Message_Count
+ * @see #Receiver_Open
+ * @see #Send_Messages
+ */
+int main(int argc, char *argv[])
+{
+	Log_UDP_Handle_T handle_list[RECEIVER_COUNT];
+	struct Log_UDP_Handle_Destination_Stats_Struct stats;
+	unsigned long separate_packet_count_list[RECEIVER_COUNT],fan_out_packet_count_list[RECEIVER_COUNT];
+	double separate_time,fan_out_time;
+	int receive_socket_id_list[RECEIVER_COUNT],port_number_list[RECEIVER_COUNT];
+	int i,retval;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"fan_out_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	for(i = 0; i < RECEIVER_COUNT; i++)
+	{
+		if(!Receiver_Open(&(receive_socket_id_list[i]),&(port_number_list[i])))
+			return 2;
+	}
+	/* one handle per receiver */
+	for(i = 0; i < RECEIVER_COUNT; i++)
+	{
+		if((!Log_UDP_Handle_Open("127.0.0.1",port_number_list[i],"Messages","sshd","fan_out_benchmark.c",
+					 NULL,&(handle_list[i])))||
+		   (!Log_UDP_Handle_Format_Set(handle_list[i],LOG_UDP_WIRE_FORMAT_V2,0)))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
+	retval = Send_Messages(handle_list,RECEIVER_COUNT,receive_socket_id_list,&separate_time,
+			       separate_packet_count_list);
+	for(i = 0; i < RECEIVER_COUNT; i++)
+		Log_UDP_Handle_Close(handle_list[i]);
+	if(!retval)
+	{
+		Log_General_Error();
+		return 4;
+	}
+	/* one handle, with a destination per receiver */
+	if(!Log_UDP_Handle_Open("127.0.0.1",port_number_list[0],"Messages","sshd","fan_out_benchmark.c",NULL,
+				&(handle_list[0])))
+	{
+		Log_General_Error();
+		return 5;
+	}
+	retval = Log_UDP_Handle_Format_Set(handle_list[0],LOG_UDP_WIRE_FORMAT_V2,0);
+	for(i = 1; retval && (i < RECEIVER_COUNT); i++)
+		retval = Log_UDP_Handle_Destination_Add(handle_list[0],"127.0.0.1",port_number_list[i],NULL);
+	retval = retval && Send_Messages(handle_list,1,receive_socket_id_list,&fan_out_time,
+					 fan_out_packet_count_list);
+	if(!retval)
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle_list[0]);
+		return 6;
+	}
+	fprintf(stdout,"%d handles:             %d messages: send %.2f us/message.",RECEIVER_COUNT,Message_Count,
+		(separate_time*1000000.0)/Message_Count);
+	for(i = 0; i < RECEIVER_COUNT; i++)
+		fprintf(stdout," Receiver %d got %lu.",i,separate_packet_count_list[i]);
+	fprintf(stdout,"\n");
+	fprintf(stdout,"1 handle, %d destinations: %d messages: send %.2f us/message.",RECEIVER_COUNT,Message_Count,
+		(fan_out_time*1000000.0)/Message_Count);
+	for(i = 0; i < RECEIVER_COUNT; i++)
+		fprintf(stdout," Receiver %d got %lu.",i,fan_out_packet_count_list[i]);
+	fprintf(stdout,"\n");
+	for(i = 0; i < RECEIVER_COUNT; i++)
+	{
+		if(Log_UDP_Handle_Destination_Stats_Get(handle_list[0],i,&stats))
+		{
+			fprintf(stdout,"Destination %d: %lu packets, %lu bytes, %lu dropped, %lu errors.\n",i,
+				stats.Packet_Count,stats.Byte_Count,stats.Drop_Count,stats.Error_Count);
+		}
+	}
+	Log_UDP_Handle_Close(handle_list[0]);
+	for(i = 0; i < RECEIVER_COUNT; i++)
+		close(receive_socket_id_list[i]);
+	return 0;
+}
+
+/**
+ * Open a socket bound to an unused port on the loopback interface.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @param port_number The address of an integer, filled in with the port number.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Receiver_Open(int *socket_id,int *port_number)
+{
+	struct sockaddr_in address;
+	socklen_t address_length;
+
+	(*socket_id) = socket(AF_INET,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"fan_out_benchmark:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	address_length = sizeof(address);
+	if((bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname((*socket_id),(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"fan_out_benchmark:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	(*port_number) = ntohs(address.sin_port);
+	return TRUE;
+}
+
+/**
+ * Send Message_Count short syslog style messages with each handle in turn, and drain every receive socket
+ * every DRAIN_COUNT messages. Only the sending is timed.
+ * @param handle_list The logger handles to send each message with.
+ * @param handle_count The number of handles in handle_list.
+ * @param receive_socket_id_list The receive sockets, RECEIVER_COUNT of them.
+ * @param send_time The address of a double, filled in with the time spent sending in seconds.
+ * @param packet_count_list A list of RECEIVER_COUNT unsigned longs, filled in with the number of
+ *        packets each receiver got.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see #Drain
+ * @see #DRAIN_COUNT
+ */
+static int Send_Messages(Log_UDP_Handle_T *handle_list,int handle_count,int *receive_socket_id_list,
+			 double *send_time,unsigned long *packet_count_list)
+{
+	struct timespec start_time,end_time;
+	int i,j;
+
+	(*send_time) = 0.0;
+	for(j = 0; j < RECEIVER_COUNT; j++)
+		packet_count_list[j] = 0;
+	for(i = 0; i < Message_Count; i++)
+	{
+		if((i%DRAIN_COUNT) == 0)
+			clock_gettime(CLOCK_MONOTONIC,&start_time);
+		for(j = 0; j < handle_count; j++)
+		{
+			if(!Log_UDP_Sendf(handle_list[j],LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",
+					  "Accepted publickey for eng from 192.168.1.%d port %d ssh2",1+(i%254),
+					  1024+(i%60000)))
+				return FALSE;
+		}
+		if((((i+1)%DRAIN_COUNT) == 0)||(i == (Message_Count-1)))
+		{
+			clock_gettime(CLOCK_MONOTONIC,&end_time);
+			(*send_time) += Time_Difference(start_time,end_time);
+			for(j = 0; j < RECEIVER_COUNT; j++)
+				packet_count_list[j] += Drain(receive_socket_id_list[j]);
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Receive every packet waiting on the socket.
+ * @param receive_socket_id The socket.
+ * @return The number of packets received.
+ * @see #Packet_Buffer
+ */
+static unsigned long Drain(int receive_socket_id)
+{
+	unsigned long packet_count;
+
+	packet_count = 0;
+	while(recv(receive_socket_id,Packet_Buffer,PACKET_LENGTH,MSG_DONTWAIT) > 0)
+		packet_count++;
+	return packet_count;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"fan_out_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"fan_out_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"fan_out_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"fan_out_benchmark help.\n");
+	fprintf(stdout,"fan_out_benchmark sends short syslog style messages to two receivers on the loopback\n");
+	fprintf(stdout,"interface, using a handle per receiver and one handle with two destinations, and prints\n");
+	fprintf(stdout,"the time taken by each and the packets each receiver got.\n");
+	fprintf(stdout,"fan_out_benchmark [-c[ount] <number of messages>][-help]\n");
+}
+
+/*
+** $Log$
+*/
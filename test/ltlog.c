@@ -28,6 +28,10 @@ static char *Hostname = NULL;
  * The port number.
  */
 static int Port_Number = 0;
+/**
+ * The multicast time to live, used when the hostname is a multicast group.
+ */
+static int Multicast_TTL = 1;
 /**
  * Parsed system.
  */
@@ -89,6 +93,7 @@ static void Help(void);
  * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
  * @see #Hostname
  * @see #Port_Number
+ * @see #Multicast_TTL
  * @see #System
  * @see #Sub_System
  * @see #Source_File
@@ -137,6 +142,11 @@ int main(int argc, char *argv[])
 #if DEBUG > 1
 	fprintf(stdout,"ltlog:Opening socket.\n");
 #endif
+	if(!Log_UDP_Multicast_Set(Multicast_TTL,TRUE,NULL))
+	{
+		Log_General_Error();
+		return 4;
+	}
 	if(!Log_UDP_Open(Hostname,Port_Number,&socket_id))
 	{
 		Log_General_Error();
@@ -145,7 +155,7 @@ int main(int argc, char *argv[])
 #if DEBUG > 1
 	fprintf(stdout,"ltlog:Sending record.\n");
 #endif
-	if(!Log_UDP_Send(socket_id,log_record,Log_Context_Count,Log_Context_List))
+	if(!Log_UDP_Send_Record(socket_id,&log_record,Log_Context_Count,Log_Context_List))
 	{
 		Log_General_Error();
 		Log_UDP_Close(socket_id);
@@ -188,6 +198,7 @@ int main(int argc, char *argv[])
  * @see #Hostname
  * @see #Hostname
  * @see #Port_Number
+ * @see #Multicast_TTL
  * @see #System
  * @see #Sub_System
  * @see #Source_File
@@ -376,6 +387,25 @@ static int Parse_Arguments(int argc, char *argv[])
 				return FALSE;
 			}
 		}
+		else if(strcmp(argv[i],"-ttl")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Multicast_TTL);
+				if(retval != 1)
+				{
+					fprintf(stderr,"ltlog:Parse_Arguments:Failed to parse time to live '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ltlog:Parse_Arguments:Time to live requires a number.\n");
+				return FALSE;
+			}
+		}
 		else if((strcmp(argv[i],"-verbosity")==0)||(strcmp(argv[i],"-v")==0))
 		{
 			if((i+1)<argc)
@@ -435,7 +465,7 @@ static void Help(void)
 	fprintf(stdout,"\t-v[erbosity] <veryterse|terse|intermediate|verbose|veryverbose|1|2|3|4|5>\n");
 	fprintf(stdout,"\t[-s[ystem] <system>][-sub_system <subsystem>][-source_file <source_file>]\n");
 	fprintf(stdout,"\t[-source_instance <instance>][-f[unction] <function>]\n");
-	fprintf(stdout,"\t[-c[ategory] <category>][-help]\n");
+	fprintf(stdout,"\t[-c[ategory] <category>][-ttl <multicast time to live>][-help]\n");
 	fprintf(stdout,"\t[-co[ntext] <keyword> <value>]\n");
 	fprintf(stdout,"\t-m[essage] <string> <string> ...\n");
 }
@@ -11,6 +11,8 @@
 #include "log_general.h"
 #include "log_udp.h"
 #include "log_create.h"
+#include "log_udp_coalesce.h"
+#include "log_udp_rate.h"
 
 /**
  * This program attempts to tail/read a /var/log/messages file, 
@@ -90,6 +92,22 @@ static char Message_Buffer[MESSAGE_BUFFER_LENGTH];
  * Socket used for sending the message via UDP.
  */
 static int Socket_Id = -1;
+/**
+ * Parsed duplicate message coalescing window in milliseconds. Zero means no coalescing.
+ * @see ../cdocs/log_udp_coalesce.html#Log_UDP_Coalesce_Set
+ */
+static int Coalesce_Window_Ms = 0;
+/**
+ * Parsed rate limit, the number of records per second sent for each System/Sub_System/Category.
+ * Zero means no rate limit.
+ * @see ../cdocs/log_udp_rate.html#Log_UDP_Rate_Limit_Set
+ */
+static double Rate_Limit = 0.0;
+/**
+ * Parsed rate limit burst, the number of records for each System/Sub_System/Category that can be sent at once.
+ * @see ../cdocs/log_udp_rate.html#Log_UDP_Rate_Limit_Set
+ */
+static int Rate_Burst = 10;
 
 /* internal routines */
 static void Messages_To_UDP(void);
@@ -109,6 +127,9 @@ static void Help(void);
  * @see #Port_Number
  * @see #Message_Filename
  * @see #System
+ * @see #Coalesce_Window_Ms
+ * @see #Rate_Limit
+ * @see #Rate_Burst
  * @see #Messages_To_UDP
  */
 int main(int argc, char *argv[])
@@ -133,6 +154,22 @@ int main(int argc, char *argv[])
 		fprintf(stderr,"messages_to_udp:No message filename specified.\n");
 		return 2;
 	}
+	if(Coalesce_Window_Ms > 0)
+	{
+		if(!Log_UDP_Coalesce_Set(Coalesce_Window_Ms))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
+	if(Rate_Limit > 0.0)
+	{
+		if(!Log_UDP_Rate_Limit_Set(Rate_Limit,Rate_Burst,0))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
 	Messages_To_UDP();
 #if DEBUG > 1
 	fprintf(stdout,"messages_to_udp:Freeing allocated data.\n");
@@ -317,6 +354,15 @@ static void Messages_To_UDP(void)
 #if DEBUG > 1
 	fprintf(stdout,"messages_to_udp:Closing socket.\n");
 #endif
+	/* report any records still being coalesced or suppressed */
+	if(!Log_UDP_Coalesce_Flush())
+	{
+		Log_General_Error();
+	}
+	if(!Log_UDP_Rate_Limit_Flush())
+	{
+		Log_General_Error();
+	}
 	if(!Log_UDP_Close(Socket_Id))
 	{
 		Log_General_Error();
@@ -440,7 +486,7 @@ static void Process_Line_Buffer(char *line_buffer)
 		/* attempt to continue */
 	}
 	/* send log record */
-	if(!Log_UDP_Send(Socket_Id,log_record,log_context_count,log_context_list))
+	if(!Log_UDP_Send_Record(Socket_Id,&log_record,log_context_count,log_context_list))
 	{
 		Log_General_Error();
 		Log_UDP_Close(Socket_Id);
@@ -570,6 +616,9 @@ static int Is_Log_Rolled(FILE *fp)
  * @see #Verbosity
  * @see #Start_At_End
  * @see #End_At_End
+ * @see #Coalesce_Window_Ms
+ * @see #Rate_Limit
+ * @see #Rate_Burst
  */
 static int Parse_Arguments(int argc, char *argv[])
 {
@@ -643,6 +692,63 @@ static int Parse_Arguments(int argc, char *argv[])
 		{
 			Start_At_End = TRUE;
 		}
+		else if(strcmp(argv[i],"-coalesce")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Coalesce_Window_Ms);
+				if((retval != 1)||(Coalesce_Window_Ms < 0))
+				{
+					fprintf(stderr,"messages_to_udp:Parse_Arguments:Failed to parse coalesce window '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"messages_to_udp:Parse_Arguments:Coalesce window requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-rate_burst")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Rate_Burst);
+				if((retval != 1)||(Rate_Burst < 1))
+				{
+					fprintf(stderr,"messages_to_udp:Parse_Arguments:Failed to parse rate burst '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"messages_to_udp:Parse_Arguments:Rate burst requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-rate_limit")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lf",&Rate_Limit);
+				if((retval != 1)||(Rate_Limit < 0.0))
+				{
+					fprintf(stderr,"messages_to_udp:Parse_Arguments:Failed to parse rate limit '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"messages_to_udp:Parse_Arguments:Rate limit requires a number.\n");
+				return FALSE;
+			}
+		}
 		else if((strcmp(argv[i],"-system")==0)||(strcmp(argv[i],"-s")==0))
 		{
 			if((i+1)<argc)
@@ -715,6 +821,8 @@ static void Help(void)
 	fprintf(stdout,"\t-v[erbosity] <veryterse|terse|intermediate|verbose|veryverbose|1|2|3|4|5>\n");
 	fprintf(stdout,"\t[-s[ystem] <system>]\n");
 	fprintf(stdout,"\t[-start_at_end][-end_at_end]\n");
+	fprintf(stdout,"\t[-coalesce <window ms>]\n");
+	fprintf(stdout,"\t[-rate_limit <records per second>][-rate_burst <records>]\n");
 }
 
 /*
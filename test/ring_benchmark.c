@@ -0,0 +1,332 @@
+/* ring_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_handle.h"
+#include "log_udp_ring.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program compares sending to a local relay over UDP on the loopback interface against writing to it
+ * through a shared memory ring ("shm:" handle). It sends the same messages through a logger handle to a
+ * UDP receiver and to a ring, draining each every DRAIN_COUNT messages as a relay would, and reports the
+ * sender time per message and the packets received.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The number of messages sent before the receive socket or ring is drained. Small enough to fit in the
+ * socket's receive buffer.
+ */
+#define DRAIN_COUNT                      (64)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The length of the ring name.
+ */
+#define RING_NAME_LENGTH                 (64)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of messages to send with each transport.
+ */
+static int Message_Count = 100000;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int Receiver_Open(int *socket_id,int *port_number);
+static int Send_Messages(char *hostname,int port_number,int receive_socket_id,Log_UDP_Ring_T ring,
+			 double *send_time,unsigned long *packet_count);
+static unsigned long Drain(int receive_socket_id);
+static unsigned long Ring_Drain(Log_UDP_Ring_T ring);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Message_Count
+ * @see #Receiver_Open
+ * @see #Send_Messages
+ */
+int main(int argc, char *argv[])
+{
+	Log_UDP_Ring_T ring = NULL;
+	struct Log_UDP_Ring_Stats_Struct stats;
+	char ring_name[RING_NAME_LENGTH];
+	char hostname[RING_NAME_LENGTH+8];
+	unsigned long udp_packet_count,ring_packet_count;
+	double udp_time,ring_time;
+	int socket_id,port_number,retval;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"ring_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	if(!Receiver_Open(&socket_id,&port_number))
+		return 2;
+	/* the benchmark reads the ring itself, as the relay would */
+	snprintf(ring_name,RING_NAME_LENGTH,"ring_benchmark.%d",(int)getpid());
+	if(!Log_UDP_Ring_Open(ring_name,0,&ring))
+	{
+		Log_General_Error();
+		close(socket_id);
+		return 3;
+	}
+	snprintf(hostname,sizeof(hostname),"%s%s",LOG_UDP_RING_PREFIX,ring_name);
+	retval = Send_Messages("127.0.0.1",port_number,socket_id,NULL,&udp_time,&udp_packet_count)&&
+		Send_Messages(hostname,0,-1,ring,&ring_time,&ring_packet_count);
+	close(socket_id);
+	if(!retval)
+	{
+		Log_General_Error();
+		Log_UDP_Ring_Close(ring);
+		Log_UDP_Ring_Unlink(ring_name);
+		return 4;
+	}
+	fprintf(stdout,"Loopback UDP: %d messages: send %.2f us/message. Receiver got %lu.\n",Message_Count,
+		(udp_time*1000000.0)/Message_Count,udp_packet_count);
+	fprintf(stdout,"Ring:         %d messages: send %.2f us/message. Reader got %lu.\n",Message_Count,
+		(ring_time*1000000.0)/Message_Count,ring_packet_count);
+	if(Log_UDP_Ring_Stats_Get(ring,&stats))
+	{
+		fprintf(stdout,"Ring: %lu written, %lu dropped, %lu read, %lu wakes.\n",stats.Write_Count,
+			stats.Drop_Count,stats.Read_Count,stats.Wake_Count);
+	}
+	Log_UDP_Ring_Close(ring);
+	Log_UDP_Ring_Unlink(ring_name);
+	return 0;
+}
+
+/**
+ * Open a socket bound to an unused port on the loopback interface.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @param port_number The address of an integer, filled in with the port number.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Receiver_Open(int *socket_id,int *port_number)
+{
+	struct sockaddr_in address;
+	socklen_t address_length;
+
+	(*socket_id) = socket(AF_INET,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"ring_benchmark:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	address_length = sizeof(address);
+	if((bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname((*socket_id),(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"ring_benchmark:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	(*port_number) = ntohs(address.sin_port);
+	return TRUE;
+}
+
+/**
+ * Open a logger handle, send Message_Count short syslog style messages with it, and drain the receive
+ * socket or ring every DRAIN_COUNT messages. Only the sending is timed.
+ * @param hostname The receiver's hostname, or LOG_UDP_RING_PREFIX followed by the ring name.
+ * @param port_number The receiver's port number.
+ * @param receive_socket_id The receive socket, or -1 to drain the ring.
+ * @param ring The ring to drain, if receive_socket_id is -1.
+ * @param send_time The address of a double, filled in with the time spent sending in seconds.
+ * @param packet_count The address of an unsigned long, filled in with the number of packets received.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see #Drain
+ * @see #Ring_Drain
+ * @see #DRAIN_COUNT
+ */
+static int Send_Messages(char *hostname,int port_number,int receive_socket_id,Log_UDP_Ring_T ring,
+			 double *send_time,unsigned long *packet_count)
+{
+	Log_UDP_Handle_T handle = NULL;
+	struct timespec start_time,end_time;
+	int i;
+
+	(*send_time) = 0.0;
+	(*packet_count) = 0;
+	if((!Log_UDP_Handle_Open(hostname,port_number,"Messages","sshd","ring_benchmark.c",NULL,&handle))||
+	   (!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,0)))
+	{
+		if(handle != NULL)
+			Log_UDP_Handle_Close(handle);
+		return FALSE;
+	}
+	for(i = 0; i < Message_Count; i++)
+	{
+		if((i%DRAIN_COUNT) == 0)
+			clock_gettime(CLOCK_MONOTONIC,&start_time);
+		if(!Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",
+				  "Accepted publickey for eng from 192.168.1.%d port %d ssh2",1+(i%254),1024+(i%60000)))
+		{
+			Log_UDP_Handle_Close(handle);
+			return FALSE;
+		}
+		if((((i+1)%DRAIN_COUNT) == 0)||(i == (Message_Count-1)))
+		{
+			clock_gettime(CLOCK_MONOTONIC,&end_time);
+			(*send_time) += Time_Difference(start_time,end_time);
+			if(receive_socket_id >= 0)
+				(*packet_count) += Drain(receive_socket_id);
+			else
+				(*packet_count) += Ring_Drain(ring);
+		}
+	}
+	Log_UDP_Handle_Close(handle);
+	return TRUE;
+}
+
+/**
+ * Receive every packet waiting on the socket.
+ * @param receive_socket_id The socket.
+ * @return The number of packets received.
+ * @see #Packet_Buffer
+ */
+static unsigned long Drain(int receive_socket_id)
+{
+	unsigned long packet_count;
+
+	packet_count = 0;
+	while(recv(receive_socket_id,Packet_Buffer,PACKET_LENGTH,MSG_DONTWAIT) > 0)
+		packet_count++;
+	return packet_count;
+}
+
+/**
+ * Read every packet waiting in the ring.
+ * @param ring The ring.
+ * @return The number of packets read.
+ */
+static unsigned long Ring_Drain(Log_UDP_Ring_T ring)
+{
+	const char *message = NULL;
+	size_t message_length;
+	unsigned long packet_count;
+	int found;
+
+	packet_count = 0;
+	while(Log_UDP_Ring_Read(ring,0,&message,&message_length,&found) && found)
+		packet_count++;
+	return packet_count;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"ring_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"ring_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"ring_benchmark help.\n");
+	fprintf(stdout,"ring_benchmark sends short syslog style messages to a receiver on the loopback interface\n");
+	fprintf(stdout,"over UDP, and writes them to a shared memory ring, and prints the time taken by each\n");
+	fprintf(stdout,"and the packets received.\n");
+	fprintf(stdout,"ring_benchmark [-c[ount] <number of messages>][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,323 @@
+/* ring_relay.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_ring.h"
+
+/**
+ * This program is a local relay for the shared memory ring transport. It opens (creating if need be) a ring,
+ * and forwards every packet producers write to it (with a logger handle opened on "shm:<ring name>") to
+ * a UDP destination. The packets are forwarded unchanged, so the collector sees the same packets as if the
+ * producers had sent them. The relay sleeps on the ring's futex when it is empty.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * How long to wait for a packet before checking whether to print the counters, in milliseconds.
+ */
+#define READ_TIMEOUT_MS                  (1000)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The name of the ring to read.
+ */
+static char *Ring_Name = NULL;
+/**
+ * The length of the ring's data area, if the relay creates it. Zero uses the default length.
+ */
+static int Ring_Data_Length = 0;
+/**
+ * The hostname to forward packets to.
+ */
+static char *Hostname = NULL;
+/**
+ * The port number to forward packets to.
+ */
+static int Port_Number = 0;
+/**
+ * The number of packets to forward before exiting, or zero to run forever.
+ */
+static int Packet_Count = 0;
+/**
+ * How often to print the ring and send counters, in seconds, or zero not to.
+ */
+static int Stats_Interval = 0;
+
+/* internal routines */
+static void Stats_Print(Log_UDP_Ring_T ring,unsigned long forward_count,unsigned long error_count);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Ring_Name
+ * @see #Ring_Data_Length
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Stats_Interval
+ * @see #Stats_Print
+ */
+int main(int argc, char *argv[])
+{
+	Log_UDP_Ring_T ring = NULL;
+	const char *message = NULL;
+	size_t message_length;
+	unsigned long forward_count,error_count;
+	time_t stats_time;
+	int socket_id,found,dropped;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"ring_relay:Parse Arguments failed.\n");
+		return 1;
+	}
+	if((Ring_Name == NULL)||(Hostname == NULL)||(Port_Number == 0))
+	{
+		fprintf(stderr,"ring_relay:A ring name, hostname and port number must be specified.\n");
+		return 2;
+	}
+	if(!Log_UDP_Open(Hostname,Port_Number,&socket_id))
+	{
+		Log_General_Error();
+		return 3;
+	}
+	if(!Log_UDP_Ring_Open(Ring_Name,Ring_Data_Length,&ring))
+	{
+		Log_General_Error();
+		Log_UDP_Close(socket_id);
+		close(socket_id);
+		return 4;
+	}
+	forward_count = 0;
+	error_count = 0;
+	stats_time = time(NULL);
+	while((Packet_Count == 0)||(forward_count < (unsigned long)Packet_Count))
+	{
+		if(!Log_UDP_Ring_Read(ring,READ_TIMEOUT_MS,&message,&message_length,&found))
+		{
+			Log_General_Error();
+			break;
+		}
+		if(found)
+		{
+			/* dropped packets are counted in the send counters, not here */
+			if(Log_UDP_Send_Encoded_Status(socket_id,(char *)message,message_length,&dropped))
+				forward_count++;
+			else
+				error_count++;
+		}
+		if((Stats_Interval > 0)&&(time(NULL) >= (stats_time+Stats_Interval)))
+		{
+			Stats_Print(ring,forward_count,error_count);
+			stats_time = time(NULL);
+		}
+	}
+	Stats_Print(ring,forward_count,error_count);
+	Log_UDP_Ring_Close(ring);
+	Log_UDP_Close(socket_id);
+	close(socket_id);
+	return 0;
+}
+
+/**
+ * Print the ring's counters and the number of packets forwarded.
+ * @param ring The ring.
+ * @param forward_count The number of packets forwarded (sent, or dropped by the kernel).
+ * @param error_count The number of packets that failed to send.
+ * @see log_udp.html#Log_UDP_Send_Stats_Get
+ */
+static void Stats_Print(Log_UDP_Ring_T ring,unsigned long forward_count,unsigned long error_count)
+{
+	struct Log_UDP_Ring_Stats_Struct ring_stats;
+	struct Log_UDP_Send_Stats_Struct send_stats;
+
+	if(!Log_UDP_Ring_Stats_Get(ring,&ring_stats))
+	{
+		Log_General_Error();
+		return;
+	}
+	fprintf(stdout,"Ring: %lu written, %lu dropped (ring full), %lu read, %lu abandoned, %lu wakes, "
+		"%lu of %lu bytes used.\n",ring_stats.Write_Count,ring_stats.Drop_Count,ring_stats.Read_Count,
+		ring_stats.Abandoned_Count,ring_stats.Wake_Count,(unsigned long)ring_stats.Used_Length,
+		(unsigned long)ring_stats.Data_Length);
+	fprintf(stdout,"Forwarded: %lu, %lu errors.",forward_count,error_count);
+	if(Log_UDP_Send_Stats_Get(&send_stats))
+	{
+		fprintf(stdout," Dropped by the kernel: %lu would block, %lu no buffer.",
+			send_stats.Would_Block_Drop_Count,send_stats.No_Buffer_Drop_Count);
+	}
+	fprintf(stdout,"\n");
+	fflush(stdout);
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Ring_Name
+ * @see #Ring_Data_Length
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Stats_Interval
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Packet_Count);
+				if((retval != 1)||(Packet_Count < 0))
+				{
+					fprintf(stderr,"ring_relay:Parse_Arguments:"
+						"Failed to parse packet count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Packet count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-hostname")==0)||(strcmp(argv[i],"-h")==0))
+		{
+			if((i+1)<argc)
+			{
+				Hostname = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Hostname requires a name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-length")==0)||(strcmp(argv[i],"-l")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Ring_Data_Length);
+				if((retval != 1)||(Ring_Data_Length < 0))
+				{
+					fprintf(stderr,"ring_relay:Parse_Arguments:"
+						"Failed to parse ring length '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Ring length requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"ring_relay:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-ring")==0)||(strcmp(argv[i],"-r")==0))
+		{
+			if((i+1)<argc)
+			{
+				Ring_Name = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Ring requires a name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-stats")==0)||(strcmp(argv[i],"-s")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Stats_Interval);
+				if((retval != 1)||(Stats_Interval < 0))
+				{
+					fprintf(stderr,"ring_relay:Parse_Arguments:"
+						"Failed to parse stats interval '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"ring_relay:Parse_Arguments:Stats interval requires a number of seconds.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"ring_relay:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"ring_relay help.\n");
+	fprintf(stdout,"ring_relay forwards the packets written to a shared memory ring (by logger handles opened\n");
+	fprintf(stdout,"on shm:<ring name>) to a UDP destination.\n");
+	fprintf(stdout,"ring_relay -r[ing] <name> -h[ostname] <host> -p[ort_number] <n>\n");
+	fprintf(stdout,"\t[-l[ength] <ring data bytes>][-c[ount] <number of packets>][-s[tats] <seconds>][-help]\n");
+	fprintf(stdout,"Ring names not starting with '/' are created in %s.\n",LOG_UDP_RING_DIRECTORY);
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,291 @@
+/* send_batch_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.1-2008 prototypes
+ * for clock_gettime and strdup.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+
+/**
+ * This program benchmarks sending log records one at a time using Log_UDP_Send_Record (one send system call
+ * per record) against sending them in batches using Log_UDP_Send_Batch (one sendmmsg system call per batch).
+ * Run it under 'strace -c -f' to confirm the system call counts.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The maximum number of records sent in one call to Log_UDP_Send_Batch.
+ */
+#define MAX_BATCH_COUNT                  (1024)
+/**
+ * The number of records Log_UDP_Send_Batch passes to the kernel in each sendmmsg call.
+ * This is UDP_BATCH_LENGTH in log_udp.c.
+ */
+#define LIBRARY_BATCH_LENGTH             (64)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The hostname to send to.
+ */
+static char *Hostname = NULL;
+/**
+ * The port number.
+ */
+static int Port_Number = 0;
+/**
+ * The number of records to send with each method.
+ */
+static int Record_Count = 100000;
+/**
+ * The number of records to pass to each Log_UDP_Send_Batch call.
+ * @see #MAX_BATCH_COUNT
+ */
+static int Batch_Count = 64;
+/**
+ * The list of records sent in each batch.
+ * @see #MAX_BATCH_COUNT
+ */
+static struct Log_Record_Struct Log_Record_List[MAX_BATCH_COUNT];
+/**
+ * The list of TRUE/FALSE values filled in by Log_UDP_Send_Batch.
+ * @see #MAX_BATCH_COUNT
+ */
+static int Sent_List[MAX_BATCH_COUNT];
+
+/* internal routines */
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Record_Count
+ * @see #Batch_Count
+ * @see #Log_Record_List
+ * @see #Sent_List
+ * @see #Time_Difference
+ */
+int main(int argc, char *argv[])
+{
+	struct timespec start_time,end_time;
+	double single_time,batch_time;
+	int socket_id,i,j,count,batch_call_count,sent_count;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"send_batch_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	if(Hostname == NULL)
+	{
+		fprintf(stderr,"send_batch_benchmark:No hostname specified.\n");
+		return 2;
+	}
+	for(i = 0; i < Batch_Count; i++)
+	{
+		if(!Log_Create_Record("Benchmark","Batch","send_batch_benchmark.c",NULL,"main",LOG_SEVERITY_INFO,
+				      LOG_VERBOSITY_VERBOSE,"Benchmark",
+				      "A typical short log message of about the length we usually send.",
+				      &(Log_Record_List[i])))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
+	if(!Log_UDP_Open(Hostname,Port_Number,&socket_id))
+	{
+		Log_General_Error();
+		return 4;
+	}
+	/* one Log_UDP_Send_Record (send system call) per record */
+	sent_count = 0;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	for(i = 0; i < Record_Count; i++)
+	{
+		if(Log_UDP_Send_Record(socket_id,&(Log_Record_List[0]),0,NULL))
+			sent_count++;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	single_time = Time_Difference(start_time,end_time);
+	fprintf(stdout,"Log_UDP_Send_Record: %d records (%d accepted) in %.3f s: %.0f records/s: "
+		"%.3f send calls/record.\n",Record_Count,sent_count,single_time,Record_Count/single_time,1.0);
+	/* Log_UDP_Send_Batch */
+	sent_count = 0;
+	batch_call_count = 0;
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	for(i = 0; i < Record_Count; i += Batch_Count)
+	{
+		count = Batch_Count;
+		if((i+count) > Record_Count)
+			count = Record_Count-i;
+		Log_UDP_Send_Batch(socket_id,Log_Record_List,NULL,NULL,count,Sent_List);
+		for(j = 0; j < count; j++)
+		{
+			if(Sent_List[j])
+				sent_count++;
+		}
+		batch_call_count += (count+LIBRARY_BATCH_LENGTH-1)/LIBRARY_BATCH_LENGTH;
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	batch_time = Time_Difference(start_time,end_time);
+	fprintf(stdout,"Log_UDP_Send_Batch(%d): %d records (%d accepted) in %.3f s: %.0f records/s: "
+		"%.3f sendmmsg calls/record (if every call accepts the whole batch).\n",Batch_Count,Record_Count,
+		sent_count,batch_time,Record_Count/batch_time,((double)batch_call_count)/((double)Record_Count));
+	if(batch_time > 0.0)
+		fprintf(stdout,"Speedup: %.2f.\n",single_time/batch_time);
+	Log_UDP_Close(socket_id);
+	return 0;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Record_Count
+ * @see #Batch_Count
+ * @see #MAX_BATCH_COUNT
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-batch")==0)||(strcmp(argv[i],"-b")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Batch_Count);
+				if((retval != 1)||(Batch_Count < 1)||(Batch_Count > MAX_BATCH_COUNT))
+				{
+					fprintf(stderr,"send_batch_benchmark:Parse_Arguments:"
+						"Failed to parse batch count '%s' (1..%d).\n",argv[i+1],MAX_BATCH_COUNT);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_batch_benchmark:Parse_Arguments:Batch count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Record_Count);
+				if(retval != 1)
+				{
+					fprintf(stderr,"send_batch_benchmark:Parse_Arguments:"
+						"Failed to parse record count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_batch_benchmark:Parse_Arguments:Record count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-hostname")==0)||(strcmp(argv[i],"-ip")==0))
+		{
+			if((i+1)<argc)
+			{
+				Hostname = strdup(argv[i+1]);
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_batch_benchmark:Parse_Arguments:Hostname requires a name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"send_batch_benchmark:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_batch_benchmark:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"send_batch_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"send_batch_benchmark help.\n");
+	fprintf(stdout,"send_batch_benchmark compares Log_UDP_Send_Record against Log_UDP_Send_Batch.\n");
+	fprintf(stdout,"Run under 'strace -c -f' to count the send and sendmmsg system calls made.\n");
+	fprintf(stdout,"send_batch_benchmark -hostname|-ip <hostname> -p[ort_number] <n>\n");
+	fprintf(stdout,"\t[-c[ount] <number of records>][-b[atch] <records per batch>][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,303 @@
+/* send_buffer_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_handle.h"
+
+/**
+ * This program helps size the send buffer of non-blocking log sockets. For each send buffer length
+ * it opens a non-blocking logger handle with that SO_SNDBUF, sends a burst of log messages as fast as possible,
+ * and prints the send buffer length the kernel actually used, the time taken, and the number of packets
+ * sent and dropped (from Log_UDP_Send_Stats_Get). Send to a host off this machine: loopback packets
+ * leave the send buffer at once, so never fill it.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The maximum number of send buffer lengths that can be tried.
+ */
+#define MAX_SEND_BUFFER_COUNT            (16)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The hostname to send to.
+ */
+static char *Hostname = NULL;
+/**
+ * The port number.
+ */
+static int Port_Number = 0;
+/**
+ * The number of messages in each burst.
+ */
+static int Message_Count = 100000;
+/**
+ * The send buffer lengths to try, in bytes. 0 means the system default.
+ * @see #MAX_SEND_BUFFER_COUNT
+ */
+static int Send_Buffer_Length_List[MAX_SEND_BUFFER_COUNT] = {0,16384,65536,262144,1048576};
+/**
+ * The number of entries in Send_Buffer_Length_List used.
+ */
+static int Send_Buffer_Length_Count = 5;
+
+/* internal routines */
+static int Send_Burst(int send_buffer_length);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Send_Buffer_Length_List
+ * @see #Send_Buffer_Length_Count
+ * @see #Send_Burst
+ */
+int main(int argc, char *argv[])
+{
+	int i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"send_buffer_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	if((Hostname == NULL)||(Port_Number == 0))
+	{
+		fprintf(stderr,"send_buffer_benchmark:No hostname or port number specified.\n");
+		return 2;
+	}
+	for(i = 0; i < Send_Buffer_Length_Count; i++)
+	{
+		if(!Send_Burst(Send_Buffer_Length_List[i]))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Open a non-blocking logger handle with the send buffer length, send Message_Count messages as
+ * fast as possible, and print the results.
+ * @param send_buffer_length The send buffer length to ask for, in bytes, or 0 for the system default.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see ../cdocs/log_udp.html#Log_UDP_Socket_Options_Set
+ * @see ../cdocs/log_udp.html#Log_UDP_Send_Stats_Get
+ */
+static int Send_Burst(int send_buffer_length)
+{
+	Log_UDP_Handle_T handle = NULL;
+	struct Log_UDP_Send_Stats_Struct start_stats,end_stats;
+	struct timespec start_time,end_time;
+	socklen_t actual_length_length;
+	double send_time;
+	unsigned long dropped_count;
+	int socket_id,actual_length,i;
+
+	if(!Log_UDP_Socket_Options_Set(TRUE,send_buffer_length))
+		return FALSE;
+	if(!Log_UDP_Handle_Open(Hostname,Port_Number,"Messages","sshd","send_buffer_benchmark.c",NULL,&handle))
+		return FALSE;
+	if(!Log_UDP_Handle_Socket_Get(handle,&socket_id))
+	{
+		Log_UDP_Handle_Close(handle);
+		return FALSE;
+	}
+	actual_length_length = sizeof(actual_length);
+	if(getsockopt(socket_id,SOL_SOCKET,SO_SNDBUF,&actual_length,&actual_length_length) < 0)
+		actual_length = -1;
+	Log_UDP_Send_Stats_Get(&start_stats);
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	/* send failures (ICMP port unreachable reported as ECONNREFUSED, for instance) are counted as errors */
+	for(i = 0; i < Message_Count; i++)
+	{
+		Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",
+			      "Accepted publickey for eng from 192.168.1.%d port %d ssh2",1+(i%254),1024+(i%60000));
+	}
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	Log_UDP_Send_Stats_Get(&end_stats);
+	Log_UDP_Handle_Close(handle);
+	send_time = Time_Difference(start_time,end_time);
+	dropped_count = (end_stats.Would_Block_Drop_Count-start_stats.Would_Block_Drop_Count)+
+		(end_stats.No_Buffer_Drop_Count-start_stats.No_Buffer_Drop_Count);
+	fprintf(stdout,"SO_SNDBUF asked %7d got %7d: %d messages in %.3f s: sent %lu, dropped %lu (%.1f%%), "
+		"errors %lu.\n",send_buffer_length,actual_length,Message_Count,send_time,
+		end_stats.Packet_Count-start_stats.Packet_Count,dropped_count,
+		(100.0*dropped_count)/Message_Count,end_stats.Error_Count-start_stats.Error_Count);
+	return TRUE;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Hostname
+ * @see #Port_Number
+ * @see #Message_Count
+ * @see #Send_Buffer_Length_List
+ * @see #Send_Buffer_Length_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval,user_lengths;
+
+	user_lengths = FALSE;
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-hostname")==0)||(strcmp(argv[i],"-ip")==0))
+		{
+			if((i+1)<argc)
+			{
+				Hostname = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:Hostname requires a name.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-send_buffer")==0)||(strcmp(argv[i],"-b")==0))
+		{
+			if((i+1)<argc)
+			{
+				/* the first length given replaces the default list */
+				if(!user_lengths)
+				{
+					Send_Buffer_Length_Count = 0;
+					user_lengths = TRUE;
+				}
+				if(Send_Buffer_Length_Count >= MAX_SEND_BUFFER_COUNT)
+				{
+					fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:"
+						"Too many send buffer lengths (%d).\n",MAX_SEND_BUFFER_COUNT);
+					return FALSE;
+				}
+				retval = sscanf(argv[i+1],"%d",&(Send_Buffer_Length_List[Send_Buffer_Length_Count]));
+				if((retval != 1)||(Send_Buffer_Length_List[Send_Buffer_Length_Count] < 0))
+				{
+					fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:"
+						"Failed to parse send buffer length '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				Send_Buffer_Length_Count++;
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:"
+					"Send buffer requires a length in bytes.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"send_buffer_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"send_buffer_benchmark help.\n");
+	fprintf(stdout,"send_buffer_benchmark sends bursts of log messages over non-blocking sockets with different\n");
+	fprintf(stdout,"send buffer lengths, and prints how many were dropped because the send buffer was full.\n");
+	fprintf(stdout,"send_buffer_benchmark -hostname|-ip <hostname> -p[ort_number] <n>\n");
+	fprintf(stdout,"\t[-c[ount] <number of messages>][-b|-send_buffer <bytes> ...][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,466 @@
+/* stream_server.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.1-2008 prototypes for poll
+ * and MSG_NOSIGNAL.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_stream.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program is a loopback stand-in for a collector receiving the stream transport. It listens for
+ * stream connections (from logger handles opened on "tcp:<hostname>"), splits what each connection sends
+ * into the length-prefixed frames, decodes each packet, and acknowledges them. It can drop each connection
+ * after a number of packets, to test the sender reconnects without losing any.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The most connections handled at once.
+ */
+#define CLIENT_COUNT                     (16)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * How long poll waits for a connection or data, in milliseconds.
+ */
+#define POLL_TIMEOUT_MS                  (1000)
+
+/* structures */
+/**
+ * Data for one connection.
+ * <dl>
+ * <dt>Socket_Id</dt> <dd>The connected socket, or -1 if this entry is unused.</dd>
+ * <dt>Buffer</dt> <dd>Bytes received but not yet processed, a partial frame.</dd>
+ * <dt>Buffer_Length</dt> <dd>The number of bytes in Buffer.</dd>
+ * <dt>Packet_Count</dt> <dd>The number of packets received over this connection.</dd>
+ * </dl>
+ */
+struct Client_Struct
+{
+	int Socket_Id;
+	char Buffer[LOG_UDP_STREAM_FRAME_HEADER_LENGTH+PACKET_LENGTH];
+	size_t Buffer_Length;
+	unsigned long Packet_Count;
+};
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The port number to listen on.
+ */
+static int Port_Number = 0;
+/**
+ * The number of packets to receive before exiting, or zero to run forever.
+ */
+static int Packet_Count = 0;
+/**
+ * The number of packets to receive over a connection before closing it, or zero not to.
+ */
+static int Disconnect_Count = 0;
+/**
+ * Whether to print each packet's message.
+ */
+static int Verbose = FALSE;
+/**
+ * The connections.
+ * @see #CLIENT_COUNT
+ */
+static struct Client_Struct Client_List[CLIENT_COUNT];
+/**
+ * The number of packets received over every connection.
+ */
+static unsigned long Total_Packet_Count = 0;
+/**
+ * The number of packets that failed to decode.
+ */
+static unsigned long Decode_Error_Count = 0;
+/**
+ * The number of connections accepted.
+ */
+static unsigned long Connection_Count = 0;
+
+/* internal routines */
+static int Listen_Open(int port_number,int *socket_id);
+static void Client_Accept(int listen_socket_id);
+static void Client_Read(struct Client_Struct *client);
+static void Client_Acknowledge(struct Client_Struct *client);
+static void Client_Close(struct Client_Struct *client);
+static void Packet_Process(const char *packet,size_t packet_length);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Listen_Open
+ * @see #Client_Accept
+ * @see #Client_Read
+ */
+int main(int argc, char *argv[])
+{
+	struct pollfd poll_list[CLIENT_COUNT+1];
+	int client_index_list[CLIENT_COUNT+1];
+	int listen_socket_id,poll_count,retval,i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"stream_server:Parse Arguments failed.\n");
+		return 1;
+	}
+	if(Port_Number == 0)
+	{
+		fprintf(stderr,"stream_server:A port number must be specified.\n");
+		return 2;
+	}
+	if(!Listen_Open(Port_Number,&listen_socket_id))
+		return 3;
+	for(i = 0; i < CLIENT_COUNT; i++)
+		Client_List[i].Socket_Id = -1;
+	while((Packet_Count == 0)||(Total_Packet_Count < (unsigned long)Packet_Count))
+	{
+		poll_list[0].fd = listen_socket_id;
+		poll_list[0].events = POLLIN;
+		poll_list[0].revents = 0;
+		poll_count = 1;
+		for(i = 0; i < CLIENT_COUNT; i++)
+		{
+			if(Client_List[i].Socket_Id < 0)
+				continue;
+			poll_list[poll_count].fd = Client_List[i].Socket_Id;
+			poll_list[poll_count].events = POLLIN;
+			poll_list[poll_count].revents = 0;
+			client_index_list[poll_count] = i;
+			poll_count++;
+		}
+		retval = poll(poll_list,poll_count,POLL_TIMEOUT_MS);
+		if(retval < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			fprintf(stderr,"stream_server:poll failed (%d:%s).\n",errno,strerror(errno));
+			break;
+		}
+		for(i = 1; i < poll_count; i++)
+		{
+			if(poll_list[i].revents != 0)
+				Client_Read(&(Client_List[client_index_list[i]]));
+		}
+		if(poll_list[0].revents != 0)
+			Client_Accept(listen_socket_id);
+	}
+	for(i = 0; i < CLIENT_COUNT; i++)
+	{
+		if(Client_List[i].Socket_Id >= 0)
+			Client_Close(&(Client_List[i]));
+	}
+	close(listen_socket_id);
+	fprintf(stdout,"Received %lu packets over %lu connections, %lu failed to decode.\n",Total_Packet_Count,
+		Connection_Count,Decode_Error_Count);
+	return 0;
+}
+
+/**
+ * Open a stream socket listening on a port.
+ * @param port_number The port number to listen on.
+ * @param socket_id The address of an integer, filled in with the listening socket.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Listen_Open(int port_number,int *socket_id)
+{
+	struct sockaddr_in address;
+	int reuse;
+
+	(*socket_id) = socket(AF_INET,SOCK_STREAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"stream_server:socket failed (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	reuse = 1;
+	setsockopt((*socket_id),SOL_SOCKET,SO_REUSEADDR,&reuse,sizeof(reuse));
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port_number);
+	if((bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (listen((*socket_id),CLIENT_COUNT) < 0))
+	{
+		fprintf(stderr,"stream_server:Failed to listen on port %d (%d:%s).\n",port_number,errno,
+			strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Accept a connection, and add it to the client list. If the list is full, the connection is closed.
+ * @param listen_socket_id The listening socket.
+ * @see #Client_List
+ */
+static void Client_Accept(int listen_socket_id)
+{
+	int socket_id,i;
+
+	socket_id = accept(listen_socket_id,NULL,NULL);
+	if(socket_id < 0)
+		return;
+	for(i = 0; i < CLIENT_COUNT; i++)
+	{
+		if(Client_List[i].Socket_Id < 0)
+		{
+			Client_List[i].Socket_Id = socket_id;
+			Client_List[i].Buffer_Length = 0;
+			Client_List[i].Packet_Count = 0;
+			Connection_Count++;
+			return;
+		}
+	}
+	fprintf(stderr,"stream_server:Too many connections.\n");
+	close(socket_id);
+}
+
+/**
+ * Read what a connection has sent, and process every complete frame. A partial frame is kept until the
+ * rest arrives. The connection is closed when the sender closes it, on a frame too long to receive, or
+ * once Disconnect_Count packets have been received.
+ * @param client The connection.
+ * @see #Packet_Process
+ * @see #Client_Acknowledge
+ * @see #Disconnect_Count
+ */
+static void Client_Read(struct Client_Struct *client)
+{
+	ssize_t read_length;
+	size_t position,packet_length;
+	int i;
+
+	read_length = recv(client->Socket_Id,client->Buffer+client->Buffer_Length,
+			   sizeof(client->Buffer)-client->Buffer_Length,0);
+	if(read_length <= 0)
+	{
+		if((read_length < 0)&&(errno == EINTR))
+			return;
+		Client_Close(client);
+		return;
+	}
+	client->Buffer_Length += read_length;
+	position = 0;
+	while((client->Buffer_Length-position) >= LOG_UDP_STREAM_FRAME_HEADER_LENGTH)
+	{
+		packet_length = 0;
+		for(i = 0; i < LOG_UDP_STREAM_FRAME_HEADER_LENGTH; i++)
+			packet_length = (packet_length<<8)|((unsigned char)client->Buffer[position+i]);
+		if(packet_length > PACKET_LENGTH)
+		{
+			fprintf(stderr,"stream_server:Frame of %lu bytes is too long.\n",(unsigned long)packet_length);
+			Client_Close(client);
+			return;
+		}
+		if((client->Buffer_Length-position) < (LOG_UDP_STREAM_FRAME_HEADER_LENGTH+packet_length))
+			break;
+		Packet_Process(client->Buffer+position+LOG_UDP_STREAM_FRAME_HEADER_LENGTH,packet_length);
+		position += LOG_UDP_STREAM_FRAME_HEADER_LENGTH+packet_length;
+		client->Packet_Count++;
+	}
+	memmove(client->Buffer,client->Buffer+position,client->Buffer_Length-position);
+	client->Buffer_Length -= position;
+	if(position > 0)
+		Client_Acknowledge(client);
+	/* frames already read are processed first, as a collector shutting down cleanly would */
+	if((Disconnect_Count > 0)&&(client->Packet_Count >= (unsigned long)Disconnect_Count))
+		Client_Close(client);
+}
+
+/**
+ * Acknowledge the packets received over a connection, by sending back the number received so far.
+ * A failed send is ignored, the sender writes unacknowledged packets again when it reconnects.
+ * @param client The connection.
+ * @see #LOG_UDP_STREAM_ACK_LENGTH
+ */
+static void Client_Acknowledge(struct Client_Struct *client)
+{
+	unsigned char ack_buffer[LOG_UDP_STREAM_ACK_LENGTH];
+
+	ack_buffer[0] = (unsigned char)((client->Packet_Count>>24)&0xff);
+	ack_buffer[1] = (unsigned char)((client->Packet_Count>>16)&0xff);
+	ack_buffer[2] = (unsigned char)((client->Packet_Count>>8)&0xff);
+	ack_buffer[3] = (unsigned char)(client->Packet_Count&0xff);
+	send(client->Socket_Id,ack_buffer,LOG_UDP_STREAM_ACK_LENGTH,MSG_NOSIGNAL);
+}
+
+/**
+ * Close a connection, discarding any partial frame, and free it's client list entry.
+ * @param client The connection.
+ */
+static void Client_Close(struct Client_Struct *client)
+{
+	if(Verbose)
+	{
+		fprintf(stdout,"Connection closed after %lu packets (%lu bytes of a partial frame).\n",
+			client->Packet_Count,(unsigned long)client->Buffer_Length);
+	}
+	close(client->Socket_Id);
+	client->Socket_Id = -1;
+	client->Buffer_Length = 0;
+}
+
+/**
+ * Decode a received packet, and print it's message if Verbose is set.
+ * @param packet The packet.
+ * @param packet_length The length of the packet in bytes.
+ * @see #Verbose
+ * @see log_udp_wire.html#Log_UDP_Decode
+ */
+static void Packet_Process(const char *packet,size_t packet_length)
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	int log_context_count;
+
+	Total_Packet_Count++;
+	if(!Log_UDP_Decode(packet,packet_length,&log_record,&log_context_count,&log_context_list,NULL))
+	{
+		Decode_Error_Count++;
+		if(Verbose)
+			Log_General_Error();
+		return;
+	}
+	if(Verbose)
+		fprintf(stdout,"%s:%s\n",log_record.Category,log_record.Message);
+	if(log_context_list != NULL)
+		free(log_context_list);
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Disconnect_Count
+ * @see #Verbose
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Packet_Count);
+				if((retval != 1)||(Packet_Count < 0))
+				{
+					fprintf(stderr,"stream_server:Parse_Arguments:"
+						"Failed to parse packet count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"stream_server:Parse_Arguments:Packet count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-disconnect")==0)||(strcmp(argv[i],"-d")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Disconnect_Count);
+				if((retval != 1)||(Disconnect_Count < 0))
+				{
+					fprintf(stderr,"stream_server:Parse_Arguments:"
+						"Failed to parse disconnect count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"stream_server:Parse_Arguments:Disconnect count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"stream_server:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"stream_server:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-verbose")==0)||(strcmp(argv[i],"-v")==0))
+		{
+			Verbose = TRUE;
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"stream_server:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"stream_server help.\n");
+	fprintf(stdout,"stream_server receives the stream transport (logger handles opened on tcp:<hostname>)\n");
+	fprintf(stdout,"on a local port, and decodes the packets.\n");
+	fprintf(stdout,"stream_server -p[ort_number] <n>\n");
+	fprintf(stdout,"\t[-c[ount] <number of packets>][-d[isconnect] <packets per connection>][-v[erbose]][-help]\n");
+}
+
+/*
+** $Log$
+*/
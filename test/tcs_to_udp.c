@@ -11,6 +11,9 @@
 #include "log_general.h"
 #include "log_udp.h"
 #include "log_create.h"
+#include "log_udp_async.h"
+#include "log_udp_coalesce.h"
+#include "log_udp_rate.h"
 
 /**
  * This program attempts to read a TCS log file, 
@@ -72,6 +75,32 @@ static char Message_Buffer[MESSAGE_BUFFER_LENGTH];
  * Socket used for sending the message via UDP.
  */
 static int Socket_Id = -1;
+/**
+ * Parsed duplicate message coalescing window in milliseconds. Zero means no coalescing.
+ * @see ../cdocs/log_udp_coalesce.html#Log_UDP_Coalesce_Set
+ */
+static int Coalesce_Window_Ms = 0;
+/**
+ * Parsed rate limit, the number of records per second sent for each System/Sub_System/Category.
+ * Zero means no rate limit.
+ * @see ../cdocs/log_udp_rate.html#Log_UDP_Rate_Limit_Set
+ */
+static double Rate_Limit = 0.0;
+/**
+ * Parsed rate limit burst, the number of records for each System/Sub_System/Category that can be sent at once.
+ * @see ../cdocs/log_udp_rate.html#Log_UDP_Rate_Limit_Set
+ */
+static int Rate_Burst = 10;
+/**
+ * Parsed asynchronous sender queue length. Zero means records are sent by the reading thread.
+ * @see ../cdocs/log_udp_async.html#Log_UDP_Async_Open
+ */
+static int Async_Queue_Length = 0;
+/**
+ * The asynchronous sender, created when Async_Queue_Length is positive.
+ * @see #Async_Queue_Length
+ */
+static Log_UDP_Async_T Async = NULL;
 
 /* internal routines */
 static void Messages_To_UDP(void);
@@ -92,6 +121,10 @@ static void Help(void);
  * @see #Hostname
  * @see #Port_Number
  * @see #Message_Filename
+ * @see #Coalesce_Window_Ms
+ * @see #Rate_Limit
+ * @see #Rate_Burst
+ * @see #Async_Queue_Length
  * @see #Messages_To_UDP
  */
 int main(int argc, char *argv[])
@@ -116,6 +149,22 @@ int main(int argc, char *argv[])
 		fprintf(stderr,"tcs_to_udp:No message filename specified.\n");
 		return 2;
 	}
+	if(Coalesce_Window_Ms > 0)
+	{
+		if(!Log_UDP_Coalesce_Set(Coalesce_Window_Ms))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
+	if(Rate_Limit > 0.0)
+	{
+		if(!Log_UDP_Rate_Limit_Set(Rate_Limit,Rate_Burst,0))
+		{
+			Log_General_Error();
+			return 3;
+		}
+	}
 	Messages_To_UDP();
 #if DEBUG > 1
 	fprintf(stdout,"tcs_to_udp:Freeing allocated data.\n");
@@ -132,8 +181,11 @@ int main(int argc, char *argv[])
 
 /**
  * Routine to open a UDP socket, open and read the mesasge file, and create new log records
- * as each new message (line) is added to the file.
+ * as each new message (line) is added to the file. If Async_Queue_Length is positive, an asynchronous
+ * sender is created once the socket is open, and flushed before the socket is closed.
  * @see #Socket_Id
+ * @see #Async_Queue_Length
+ * @see #Async
  * @see #Hostname
  * @see #Port_Number
  * @see #Message_Buffer
@@ -143,7 +195,9 @@ static void Messages_To_UDP(void)
 {
 	int my_errno;
 	int current_message_buffer_position;
-	int done;
+	int done,error_number;
+	char error_string[LOG_GENERAL_ERROR_LENGTH];
+	unsigned long failed_count;
 	FILE *fp = NULL;
 	long current_position,end_position;
 	size_t number_read;
@@ -177,6 +231,12 @@ static void Messages_To_UDP(void)
 #endif
 			if(!Log_UDP_Open(Hostname,Port_Number,&Socket_Id))
 				Log_General_Error();
+			/* send records from a sender thread, waiting for room in the queue so none are dropped */
+			else if((Async_Queue_Length > 0)&&(Async == NULL))
+			{
+				if(!Log_UDP_Async_Open(Socket_Id,Async_Queue_Length,LOG_UDP_ASYNC_OVERFLOW_BLOCK,-1,&Async))
+					Log_General_Error();
+			}
 		}
 		/* if message filename is not open open it */
 		if(fp == NULL)
@@ -263,6 +323,34 @@ static void Messages_To_UDP(void)
 #if DEBUG > 1
 	fprintf(stdout,"tcs_to_udp:Closing socket.\n");
 #endif
+	/* wait for the sender thread to send the queued records */
+	if(Async != NULL)
+	{
+		if(!Log_UDP_Flush(Async,-1))
+		{
+			Log_General_Error();
+		}
+		if(Log_UDP_Async_Statistics_Get(Async,NULL,NULL,&failed_count,NULL)&&(failed_count > 0)&&
+		   Log_UDP_Async_Error_Get(Async,&error_number,error_string))
+		{
+			fprintf(stderr,"tcs_to_udp:%lu records failed to send, last error (%d) : %s\n",failed_count,
+				error_number,error_string);
+		}
+		if(!Log_UDP_Async_Close(Async))
+		{
+			Log_General_Error();
+		}
+		Async = NULL;
+	}
+	/* report any records still being coalesced or suppressed */
+	if(!Log_UDP_Coalesce_Flush())
+	{
+		Log_General_Error();
+	}
+	if(!Log_UDP_Rate_Limit_Flush())
+	{
+		Log_General_Error();
+	}
 	if(!Log_UDP_Close(Socket_Id))
 	{
 		Log_General_Error();
@@ -394,8 +482,17 @@ static void Process_Line_Buffer(char *line_buffer)
 		Log_General_Error();
 		/* attempt to continue */
 	}
+	/* queue log record for the sender thread. It copies the contexts, and reports it's own send failures */
+	if(Async != NULL)
+	{
+		if(!Log_UDP_Async_Send(Async,&log_record,log_context_count,log_context_list))
+			Log_General_Error();
+		if(log_context_list != NULL)
+			free(log_context_list);
+		return;
+	}
 	/* send log record */
-	if(!Log_UDP_Send(Socket_Id,log_record,log_context_count,log_context_list))
+	if(!Log_UDP_Send_Record(Socket_Id,&log_record,log_context_count,log_context_list))
 	{
 		Log_General_Error();
 		Log_UDP_Close(Socket_Id);
@@ -670,6 +767,10 @@ static int Create_Time(char *month_buff,int day_of_month,char *time_buff,struct
  * @see #Hostname
  * @see #Port_Number
  * @see #System
+ * @see #Coalesce_Window_Ms
+ * @see #Rate_Limit
+ * @see #Rate_Burst
+ * @see #Async_Queue_Length
  */
 static int Parse_Arguments(int argc, char *argv[])
 {
@@ -677,7 +778,26 @@ static int Parse_Arguments(int argc, char *argv[])
 
 	for(i=1;i<argc;i++)
 	{
-		if((strcmp(argv[i],"-filename")==0)||(strcmp(argv[i],"-f")==0))
+		if(strcmp(argv[i],"-async")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Async_Queue_Length);
+				if((retval != 1)||(Async_Queue_Length < 0))
+				{
+					fprintf(stderr,"tcs_to_udp:Parse_Arguments:Failed to parse async queue length '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"tcs_to_udp:Parse_Arguments:Async queue length requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-filename")==0)||(strcmp(argv[i],"-f")==0))
 		{
 			if((i+1)<argc)
 			{
@@ -727,6 +847,63 @@ static int Parse_Arguments(int argc, char *argv[])
 				return FALSE;
 			}
 		}
+		else if(strcmp(argv[i],"-coalesce")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Coalesce_Window_Ms);
+				if((retval != 1)||(Coalesce_Window_Ms < 0))
+				{
+					fprintf(stderr,"tcs_to_udp:Parse_Arguments:Failed to parse coalesce window '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"tcs_to_udp:Parse_Arguments:Coalesce window requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-rate_burst")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Rate_Burst);
+				if((retval != 1)||(Rate_Burst < 1))
+				{
+					fprintf(stderr,"tcs_to_udp:Parse_Arguments:Failed to parse rate burst '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"tcs_to_udp:Parse_Arguments:Rate burst requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-rate_limit")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%lf",&Rate_Limit);
+				if((retval != 1)||(Rate_Limit < 0.0))
+				{
+					fprintf(stderr,"tcs_to_udp:Parse_Arguments:Failed to parse rate limit '%s'.\n",
+						argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"tcs_to_udp:Parse_Arguments:Rate limit requires a number.\n");
+				return FALSE;
+			}
+		}
 		else if((strcmp(argv[i],"-system")==0)||(strcmp(argv[i],"-s")==0))
 		{
 			if((i+1)<argc)
@@ -759,6 +936,10 @@ static void Help(void)
 	fprintf(stdout,"tcs_to_udp reads a TCS log file and emits Log_UDP messages from them.\n");
 	fprintf(stdout,"tcs_to_udp -hostname|-ip <hostname> -p[ort_number] <n> -f[ilename] <message filename>\n");
 	fprintf(stdout,"\t[-help][-s[ystem] <system>]\n");
+	fprintf(stdout,"\t[-coalesce <window ms>]\n");
+	fprintf(stdout,"\t[-rate_limit <records per second>][-rate_burst <records>]\n");
+	fprintf(stdout,"\t[-async <queue length>]\n");
+	fprintf(stdout,"-async sends the records from a sender thread, through a queue of that length.\n");
 }
 
 /*
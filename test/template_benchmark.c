@@ -0,0 +1,325 @@
+/* template_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_handle.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program compares sending TCS status lines and autoguider centroid messages with Log_UDP_Sendf
+ * (formatted text) against Log_UDP_Handle_Template_Send (template identifier and binary arguments).
+ * It sends to a socket it binds on the loopback interface, and reports the sender time and the bytes
+ * per packet for each method.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The number of messages sent before the receive socket is drained. Small enough to fit in the
+ * socket's receive buffer.
+ */
+#define DRAIN_COUNT                      (64)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The TCS status line format.
+ */
+#define STATUS_FORMAT                    "Status az=%.4f alt=%.4f rot=%.4f state=%s dome=%.2f"
+/**
+ * The autoguider centroid format.
+ */
+#define CENTROID_FORMAT                  "Centroid frame=%d x=%.3f y=%.3f fwhm=%.2f counts=%ld"
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of messages to send with each method.
+ */
+static int Message_Count = 100000;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int Send_Messages(Log_UDP_Handle_T handle,int receive_socket_id,int use_template,int status_id,
+			 int centroid_id,double *send_time,unsigned long *byte_count);
+static unsigned long Drain(int receive_socket_id);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Message_Count
+ * @see #Send_Messages
+ */
+int main(int argc, char *argv[])
+{
+	Log_UDP_Handle_T handle = NULL;
+	struct sockaddr_in address;
+	socklen_t address_length;
+	unsigned long sendf_byte_count,template_byte_count;
+	double sendf_time,template_time;
+	int receive_socket_id,status_id,centroid_id;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"template_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	receive_socket_id = socket(AF_INET,SOCK_DGRAM,0);
+	if(receive_socket_id < 0)
+	{
+		fprintf(stderr,"template_benchmark:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return 2;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	address_length = sizeof(address);
+	if((bind(receive_socket_id,(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname(receive_socket_id,(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"template_benchmark:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close(receive_socket_id);
+		return 3;
+	}
+	if(!Log_UDP_Handle_Open("127.0.0.1",ntohs(address.sin_port),"TCS","Autoguider","template_benchmark.c",
+				NULL,&handle))
+	{
+		Log_General_Error();
+		close(receive_socket_id);
+		return 4;
+	}
+	if((!Log_UDP_Handle_Template_Register(handle,STATUS_FORMAT,&status_id))||
+	   (!Log_UDP_Handle_Template_Register(handle,CENTROID_FORMAT,&centroid_id)))
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle);
+		close(receive_socket_id);
+		return 5;
+	}
+	/* formatted text, version 2 */
+	if((!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,0))||
+	   (!Send_Messages(handle,receive_socket_id,FALSE,status_id,centroid_id,&sendf_time,&sendf_byte_count)))
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle);
+		close(receive_socket_id);
+		return 6;
+	}
+	/* templates, version 2 */
+	if((!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,LOG_UDP_V2_FLAG_TEMPLATE))||
+	   (!Send_Messages(handle,receive_socket_id,TRUE,status_id,centroid_id,&template_time,
+			   &template_byte_count)))
+	{
+		Log_General_Error();
+		Log_UDP_Handle_Close(handle);
+		close(receive_socket_id);
+		return 7;
+	}
+	Log_UDP_Handle_Close(handle);
+	close(receive_socket_id);
+	fprintf(stdout,"Log_UDP_Sendf:                %d messages in %.3f s: %.2f us/message: %.1f bytes/packet.\n",
+		Message_Count,sendf_time,(sendf_time*1000000.0)/Message_Count,
+		((double)sendf_byte_count)/Message_Count);
+	fprintf(stdout,"Log_UDP_Handle_Template_Send: %d messages in %.3f s: %.2f us/message: %.1f bytes/packet.\n",
+		Message_Count,template_time,(template_time*1000000.0)/Message_Count,
+		((double)template_byte_count)/Message_Count);
+	return 0;
+}
+
+/**
+ * Send Message_Count messages, alternating TCS status lines and autoguider centroids, and drain the
+ * receive socket every DRAIN_COUNT messages. Only the sending is timed.
+ * @param handle The logger handle.
+ * @param receive_socket_id The socket the handle sends to.
+ * @param use_template If TRUE send with Log_UDP_Handle_Template_Send, otherwise with Log_UDP_Sendf.
+ * @param status_id The TCS status line template's identifier.
+ * @param centroid_id The autoguider centroid template's identifier.
+ * @param send_time The address of a double, filled in with the time spent sending in seconds.
+ * @param byte_count The address of an unsigned long, filled in with the number of bytes received.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see #Drain
+ * @see #DRAIN_COUNT
+ */
+static int Send_Messages(Log_UDP_Handle_T handle,int receive_socket_id,int use_template,int status_id,
+			 int centroid_id,double *send_time,unsigned long *byte_count)
+{
+	struct timespec start_time,end_time;
+	int i,retval;
+
+	(*send_time) = 0.0;
+	(*byte_count) = 0;
+	for(i = 0; i < Message_Count; i++)
+	{
+		if((i%DRAIN_COUNT) == 0)
+			clock_gettime(CLOCK_MONOTONIC,&start_time);
+		if((i%2) == 0)
+		{
+			if(use_template)
+			{
+				retval = Log_UDP_Handle_Template_Send(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_VERBOSE,
+								      "Status",status_id,180.0+(i%3600)/10.0,
+								      45.0+(i%450)/10.0,(i%360)/2.0,"TRACKING",
+								      90.0+(i%900)/10.0);
+			}
+			else
+			{
+				retval = Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_VERBOSE,"Status",
+						       STATUS_FORMAT,180.0+(i%3600)/10.0,45.0+(i%450)/10.0,
+						       (i%360)/2.0,"TRACKING",90.0+(i%900)/10.0);
+			}
+		}
+		else
+		{
+			if(use_template)
+			{
+				retval = Log_UDP_Handle_Template_Send(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_VERBOSE,
+								      "Centroid",centroid_id,i,512.0+(i%100)/7.0,
+								      512.0-(i%100)/9.0,1.2+(i%10)/10.0,
+								      (long)(100000+(i%5000)));
+			}
+			else
+			{
+				retval = Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_VERBOSE,"Centroid",
+						       CENTROID_FORMAT,i,512.0+(i%100)/7.0,512.0-(i%100)/9.0,
+						       1.2+(i%10)/10.0,(long)(100000+(i%5000)));
+			}
+		}
+		if(!retval)
+			return FALSE;
+		if((((i+1)%DRAIN_COUNT) == 0)||(i == (Message_Count-1)))
+		{
+			clock_gettime(CLOCK_MONOTONIC,&end_time);
+			(*send_time) += Time_Difference(start_time,end_time);
+			(*byte_count) += Drain(receive_socket_id);
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Receive every packet waiting on the socket.
+ * @param receive_socket_id The socket.
+ * @return The number of bytes received.
+ * @see #Packet_Buffer
+ */
+static unsigned long Drain(int receive_socket_id)
+{
+	unsigned long byte_count;
+	ssize_t packet_length;
+
+	byte_count = 0;
+	while((packet_length = recv(receive_socket_id,Packet_Buffer,PACKET_LENGTH,MSG_DONTWAIT)) > 0)
+		byte_count += packet_length;
+	return byte_count;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"template_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"template_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"template_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"template_benchmark help.\n");
+	fprintf(stdout,"template_benchmark sends TCS status and autoguider centroid messages over the loopback\n");
+	fprintf(stdout,"interface, formatted with Log_UDP_Sendf and as templates with Log_UDP_Handle_Template_Send,\n");
+	fprintf(stdout,"and prints the time taken and bytes sent by each.\n");
+	fprintf(stdout,"template_benchmark [-c[ount] <number of messages>][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,552 @@
+/* udp_decode.c
+** $Header$
+*/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_container.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_fragment.h"
+#include "log_udp_template.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program is the reference receiver for the log_udp wire formats. It binds to a UDP port,
+ * decodes each packet received (version 1 or version 2) with Log_UDP_Decode_Template, and prints the log record.
+ * A string dictionary and a template table are kept for each sender address, for packets sent with
+ * LOG_UDP_V2_FLAG_DICTIONARY and LOG_UDP_V2_FLAG_TEMPLATE. Container datagrams are unpacked, and each record
+ * in them decoded in turn. Fragmented packets are reassembled (with a reassembler per sender) and then
+ * handled as if they had arrived in one datagram. With -multicast, the receiver joins a multicast group, so several copies of
+ * the receiver on the same machine all get every packet sent to the group. With -unix, the receiver binds
+ * a Unix domain datagram socket instead, to receive packets sent to a "unix:/path" destination.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The number of senders a dictionary and template table are kept for. When more send, the oldest sender's
+ * are reused.
+ */
+#define SENDER_COUNT                     (64)
+
+/* structures */
+/**
+ * A sender, and the strings and templates it has defined.
+ * <dl>
+ * <dt>Address</dt> <dd>The sender's address and port (or Unix domain socket address).</dd>
+ * <dt>Address_Length</dt> <dd>The length of Address in bytes.</dd>
+ * <dt>Dictionary</dt> <dd>The sender's string dictionary.</dd>
+ * <dt>Template_Table</dt> <dd>The sender's message templates.</dd>
+ * <dt>Reassembly</dt> <dd>The sender's partly received fragmented packets.</dd>
+ * </dl>
+ */
+struct Sender_Struct
+{
+	struct sockaddr_storage Address;
+	socklen_t Address_Length;
+	Log_UDP_Dictionary_T Dictionary;
+	Log_UDP_Template_Table_T Template_Table;
+	Log_UDP_Reassembly_T Reassembly;
+};
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The port number to receive on.
+ */
+static int Port_Number = 0;
+/**
+ * The number of packets to receive before exiting. Zero means receive forever.
+ */
+static int Packet_Count = 0;
+/**
+ * The multicast group to join, or NULL to receive unicast packets only.
+ */
+static char *Multicast_Group = NULL;
+/**
+ * The numeric address of the local interface to join the multicast group on, or NULL to let the kernel
+ * choose.
+ */
+static char *Multicast_Interface = NULL;
+/**
+ * The path of the Unix domain socket to receive on, or NULL to receive UDP packets on Port_Number.
+ */
+static char *Unix_Path = NULL;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+/**
+ * The senders a dictionary and template table are kept for.
+ * @see #SENDER_COUNT
+ */
+static struct Sender_Struct Sender_List[SENDER_COUNT];
+/**
+ * The number of entries in Sender_List used.
+ */
+static int Sender_Count = 0;
+/**
+ * The index in Sender_List that is reused next, when all the entries are used.
+ */
+static int Sender_Reuse_Index = 0;
+
+/* internal routines */
+static int Unix_Socket_Open(int *socket_id);
+static struct Sender_Struct *Sender_Get(struct sockaddr_storage *address,socklen_t address_length);
+static void Decode_Packet(struct Sender_Struct *sender,const char *packet,size_t packet_length,int received_count);
+static void Print_Record(struct Log_Record_Struct *log_record,int log_context_count,
+			 struct Log_Context_Struct *log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Multicast_Group
+ * @see #Multicast_Interface
+ * @see #Unix_Path
+ * @see #Packet_Buffer
+ * @see #Unix_Socket_Open
+ * @see #Sender_Get
+ * @see #Decode_Packet
+ */
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in address;
+	struct sockaddr_storage sender_address;
+	struct ip_mreq multicast_request;
+	socklen_t sender_address_length;
+	struct Sender_Struct *sender = NULL;
+	const char *packet = NULL;
+	const char *datagram = NULL;
+	size_t packet_position,record_packet_length,datagram_length;
+	ssize_t packet_length;
+	int socket_id,received_count,record_count,reuse,complete,i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"udp_decode:Parse Arguments failed.\n");
+		return 1;
+	}
+	if((Port_Number == 0)&&(Unix_Path == NULL))
+	{
+		fprintf(stderr,"udp_decode:No port number or Unix domain socket path specified.\n");
+		return 2;
+	}
+	if(Unix_Path != NULL)
+	{
+		if(!Unix_Socket_Open(&socket_id))
+			return 8;
+	}
+	else
+	{
+		socket_id = socket(AF_INET,SOCK_DGRAM,0);
+		if(socket_id < 0)
+		{
+			fprintf(stderr,"udp_decode:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+			return 3;
+		}
+		/* let several receivers on this machine bind the port, to all get the multicast packets */
+		if(Multicast_Group != NULL)
+		{
+			reuse = 1;
+			setsockopt(socket_id,SOL_SOCKET,SO_REUSEADDR,&reuse,sizeof(reuse));
+		}
+		memset(&address,0,sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(Port_Number);
+		if(bind(socket_id,(struct sockaddr *)&address,sizeof(address)) < 0)
+		{
+			fprintf(stderr,"udp_decode:Failed to bind to port %d (%d:%s).\n",Port_Number,errno,strerror(errno));
+			close(socket_id);
+			return 4;
+		}
+		if(Multicast_Group != NULL)
+		{
+			memset(&multicast_request,0,sizeof(multicast_request));
+			multicast_request.imr_interface.s_addr = htonl(INADDR_ANY);
+			if((inet_aton(Multicast_Group,&(multicast_request.imr_multiaddr)) == 0)||
+			   ((Multicast_Interface != NULL)&&(inet_aton(Multicast_Interface,
+								      &(multicast_request.imr_interface)) == 0)))
+			{
+				fprintf(stderr,"udp_decode:Illegal multicast group '%s' or interface '%s'.\n",Multicast_Group,
+					(Multicast_Interface != NULL) ? Multicast_Interface : "");
+				close(socket_id);
+				return 6;
+			}
+			if(setsockopt(socket_id,IPPROTO_IP,IP_ADD_MEMBERSHIP,&multicast_request,sizeof(multicast_request)) < 0)
+			{
+				fprintf(stderr,"udp_decode:Failed to join multicast group %s (%d:%s).\n",Multicast_Group,errno,
+					strerror(errno));
+				close(socket_id);
+				return 7;
+			}
+		}
+	}
+	received_count = 0;
+	while((Packet_Count == 0)||(received_count < Packet_Count))
+	{
+		sender_address_length = sizeof(sender_address);
+		packet_length = recvfrom(socket_id,Packet_Buffer,PACKET_LENGTH,0,(struct sockaddr *)&sender_address,
+					 &sender_address_length);
+		if(packet_length < 0)
+		{
+			if(errno == EINTR)
+				continue;
+			fprintf(stderr,"udp_decode:recv failed (%d:%s).\n",errno,strerror(errno));
+			close(socket_id);
+			return 5;
+		}
+		received_count++;
+		sender = Sender_Get(&sender_address,sender_address_length);
+		datagram = Packet_Buffer;
+		datagram_length = (size_t)packet_length;
+		/* fragments are held until the whole packet has arrived, which is then handled as one datagram */
+		if(Log_UDP_Fragment_Is_Fragment(Packet_Buffer,(size_t)packet_length))
+		{
+			if(sender->Reassembly == NULL)
+				continue;
+			if(!Log_UDP_Reassembly_Add(sender->Reassembly,Packet_Buffer,(size_t)packet_length,&complete,
+						   &datagram,&datagram_length))
+			{
+				fprintf(stdout,"Fragment %d of %ld bytes is corrupt:\n",received_count,(long)packet_length);
+				fflush(stdout);
+				Log_General_Error();
+				continue;
+			}
+			if(!complete)
+				continue;
+		}
+		if(Log_UDP_Container_Is_Container(datagram,datagram_length))
+		{
+			if(!Log_UDP_Container_Unpack_Start(datagram,datagram_length,&record_count,&packet_position))
+			{
+				Log_General_Error();
+				continue;
+			}
+			for(i = 0; i < record_count; i++)
+			{
+				if(!Log_UDP_Container_Unpack_Next(datagram,datagram_length,&packet_position,&packet,
+								  &record_packet_length))
+				{
+					fprintf(stdout,"Container %d of %ld bytes is corrupt after %d of %d records:\n",
+						received_count,(long)datagram_length,i,record_count);
+					fflush(stdout);
+					Log_General_Error();
+					break;
+				}
+				Decode_Packet(sender,packet,record_packet_length,received_count);
+			}
+		}
+		else
+			Decode_Packet(sender,datagram,datagram_length,received_count);
+		fflush(stdout);
+	}
+	close(socket_id);
+	return 0;
+}
+
+/**
+ * Open a Unix domain datagram socket bound to Unix_Path. A socket file left behind by an earlier run is
+ * removed first.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Unix_Path
+ */
+static int Unix_Socket_Open(int *socket_id)
+{
+	struct sockaddr_un address;
+
+	if(strlen(Unix_Path) >= sizeof(address.sun_path))
+	{
+		fprintf(stderr,"udp_decode:Unix domain socket path '%s' is too long.\n",Unix_Path);
+		return FALSE;
+	}
+	(*socket_id) = socket(AF_UNIX,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"udp_decode:Failed to create Unix domain socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	strcpy(address.sun_path,Unix_Path);
+	unlink(Unix_Path);
+	if(bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)
+	{
+		fprintf(stderr,"udp_decode:Failed to bind to %s (%d:%s).\n",Unix_Path,errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Get a sender's entry, with it's dictionary, template table and reassembler, creating them if this is a new
+ * sender.
+ * @param address The sender's address.
+ * @param address_length The length of the sender's address.
+ * @return The sender's entry. The dictionary, template table or reassembler is NULL if it could not be
+ *         created.
+ * @see #Sender_List
+ * @see #Sender_Count
+ * @see #Sender_Reuse_Index
+ */
+static struct Sender_Struct *Sender_Get(struct sockaddr_storage *address,socklen_t address_length)
+{
+	struct Sender_Struct *sender = NULL;
+	int i;
+
+	for(i = 0; i < Sender_Count; i++)
+	{
+		if((Sender_List[i].Address_Length == address_length)&&
+		   (memcmp(&(Sender_List[i].Address),address,address_length) == 0))
+			return &(Sender_List[i]);
+	}
+	if(Sender_Count < SENDER_COUNT)
+		sender = &(Sender_List[Sender_Count++]);
+	else
+	{
+		sender = &(Sender_List[Sender_Reuse_Index]);
+		Sender_Reuse_Index = (Sender_Reuse_Index+1)%SENDER_COUNT;
+		if(sender->Dictionary != NULL)
+			Log_UDP_Dictionary_Destroy(sender->Dictionary);
+		if(sender->Template_Table != NULL)
+			Log_UDP_Template_Table_Destroy(sender->Template_Table);
+		if(sender->Reassembly != NULL)
+			Log_UDP_Reassembly_Destroy(sender->Reassembly);
+	}
+	sender->Address = (*address);
+	sender->Address_Length = address_length;
+	sender->Dictionary = NULL;
+	sender->Template_Table = NULL;
+	sender->Reassembly = NULL;
+	if(!Log_UDP_Dictionary_Create(&(sender->Dictionary)))
+		Log_General_Error();
+	if(!Log_UDP_Template_Table_Create(&(sender->Template_Table)))
+		Log_General_Error();
+	if(!Log_UDP_Reassembly_Create(LOG_UDP_REASSEMBLY_DEFAULT_MEMORY,LOG_UDP_REASSEMBLY_DEFAULT_TIMEOUT_MS,
+				      &(sender->Reassembly)))
+		Log_General_Error();
+	return sender;
+}
+
+/**
+ * Decode a packet, received on it's own or unpacked from a container, and print the log record.
+ * @param sender The sender's entry, with it's dictionary and template table.
+ * @param packet The encoded packet.
+ * @param packet_length The length of the packet in bytes.
+ * @param received_count The number of the datagram the packet arrived in.
+ * @see #Print_Record
+ */
+static void Decode_Packet(struct Sender_Struct *sender,const char *packet,size_t packet_length,int received_count)
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	struct Log_UDP_Packet_Info_Struct packet_info;
+	int log_context_count;
+
+	if(Log_UDP_Decode_Template(packet,packet_length,sender->Dictionary,sender->Template_Table,&log_record,
+				   &log_context_count,&log_context_list,&packet_info))
+	{
+		Print_Record(&log_record,log_context_count,log_context_list,&packet_info);
+		if(log_context_list != NULL)
+			free(log_context_list);
+	}
+	else
+	{
+		fprintf(stdout,"Packet %d of %ld bytes could not be decoded:\n",received_count,(long)packet_length);
+		fflush(stdout);
+		Log_General_Error();
+	}
+}
+
+/**
+ * Print a decoded log record to stdout.
+ * @param log_record The decoded log record.
+ * @param log_context_count The number of contexts in log_context_list.
+ * @param log_context_list The decoded list of contexts.
+ * @param packet_info The wire format, flags, microsecond timestamp, template identifier and sequence number
+ *        of the packet.
+ */
+static void Print_Record(struct Log_Record_Struct *log_record,int log_context_count,
+			 struct Log_Context_Struct *log_context_list,struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	struct tm timestamp_tm;
+	time_t timestamp_secs;
+	char time_string[32];
+	int i;
+
+	timestamp_secs = (time_t)(packet_info->Timestamp_Us/1000000);
+	gmtime_r(&timestamp_secs,&timestamp_tm);
+	strftime(time_string,sizeof(time_string),"%Y-%m-%dT%H:%M:%S",&timestamp_tm);
+	if(packet_info->Flags & LOG_UDP_V2_FLAG_MICROSECONDS)
+		fprintf(stdout,"%s.%06d",time_string,(int)(packet_info->Timestamp_Us%1000000));
+	else
+		fprintf(stdout,"%s.%03d",time_string,(int)((packet_info->Timestamp_Us/1000)%1000));
+	fprintf(stdout," v%d %s %s %s %s %s sev=%d verb=%d [%s]",packet_info->Format,log_record->System,
+		log_record->Sub_System,log_record->Source_File,log_record->Source_Instance,log_record->Function,
+		log_record->Severity,log_record->Verbosity,log_record->Category);
+	if(packet_info->Template_Id != 0)
+		fprintf(stdout," template=%d",packet_info->Template_Id);
+	if(packet_info->Flags & LOG_UDP_V2_FLAG_SEQUENCE)
+	{
+		fprintf(stdout," seq=%08x:%lu:%llu:%llu",(unsigned int)packet_info->Sequence_Host_Id,
+			(unsigned long)packet_info->Sequence_Pid,(unsigned long long)packet_info->Sequence_Start_Us,
+			(unsigned long long)packet_info->Sequence_Number);
+	}
+	fprintf(stdout," %s\n",log_record->Message);
+	if(!packet_info->Dictionary_Complete)
+		fprintf(stdout,"\t(some fields refer to strings this receiver has not seen defined yet)\n");
+	if(!packet_info->Template_Complete)
+		fprintf(stdout,"\t(the message uses a template this receiver has not seen defined yet)\n");
+	for(i = 0; i < log_context_count; i++)
+		fprintf(stdout,"\t%s = %s\n",log_context_list[i].Keyword,log_context_list[i].Value);
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Multicast_Group
+ * @see #Multicast_Interface
+ * @see #Unix_Path
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Packet_Count);
+				if((retval != 1)||(Packet_Count < 0))
+				{
+					fprintf(stderr,"udp_decode:Parse_Arguments:"
+						"Failed to parse packet count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_decode:Parse_Arguments:Packet count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-interface")==0)||(strcmp(argv[i],"-i")==0))
+		{
+			if((i+1)<argc)
+			{
+				Multicast_Interface = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_decode:Parse_Arguments:Interface requires an address.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-multicast")==0)||(strcmp(argv[i],"-m")==0))
+		{
+			if((i+1)<argc)
+			{
+				Multicast_Group = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_decode:Parse_Arguments:Multicast requires a group address.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"udp_decode:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_decode:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-unix")==0)||(strcmp(argv[i],"-u")==0))
+		{
+			if((i+1)<argc)
+			{
+				Unix_Path = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_decode:Parse_Arguments:Unix requires a socket path.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"udp_decode:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"udp_decode help.\n");
+	fprintf(stdout,"udp_decode receives log_udp packets (wire format version 1 or 2) and prints them.\n");
+	fprintf(stdout,"udp_decode -p[ort_number] <n>|-u[nix] <socket path> [-c[ount] <number of packets>]\n");
+	fprintf(stdout,"\t[-m[ulticast] <group address> [-i[nterface] <local address>]][-help]\n");
+}
+
+/*
+** $Log$
+*/
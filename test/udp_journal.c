@@ -0,0 +1,354 @@
+/* udp_journal.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.1-2001 prototypes for poll.
+ */
+#define _POSIX_C_SOURCE 200112L
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+#include "log_udp_handle.h"
+#include "log_udp_journal.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program tests a logger handle's spill to disk journal. It logs numbered messages to a loopback port
+ * nothing is listening on, so the sends are refused and the messages are journaled, then binds a receiver
+ * to the port and waits for the journal to be replayed. It prints how many messages were received, missing
+ * and duplicated, and how many were received with their original timestamps (from before the receiver
+ * started). The first message is usually lost: it is sent before the port unreachable error that shows
+ * nothing is listening has come back.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * How long to wait for a replayed packet before giving up, in milliseconds. This must be longer than the
+ * journal's retry interval.
+ */
+#define RECEIVE_TIMEOUT_MS               (5000)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The journal filename.
+ */
+static char *Journal_Filename = NULL;
+/**
+ * The number of messages to log.
+ */
+static int Message_Count = 1000;
+/**
+ * The number of messages to replay per second, zero for the journal's default.
+ */
+static int Replay_Rate = 0;
+/**
+ * Whether to print each message received.
+ */
+static int Verbose = FALSE;
+
+/* internal routines */
+static int Socket_Open(int port_number,int *socket_id,int *bound_port_number);
+static int Receive(int socket_id,int64_t start_timestamp,char *received_list);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Journal_Filename
+ * @see #Message_Count
+ * @see #Replay_Rate
+ * @see #Socket_Open
+ * @see #Receive
+ */
+int main(int argc, char *argv[])
+{
+	struct Log_UDP_Handle_Destination_Stats_Struct stats;
+	Log_UDP_Handle_T handle = NULL;
+	int64_t start_timestamp;
+	char *received_list = NULL;
+	int socket_id,port_number,missing_count,i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"udp_journal:Parse Arguments failed.\n");
+		return 1;
+	}
+	if(Journal_Filename == NULL)
+	{
+		fprintf(stderr,"udp_journal:A journal filename must be specified.\n");
+		return 2;
+	}
+	/* find a free port, and leave nothing listening on it */
+	if(!Socket_Open(0,&socket_id,&port_number))
+		return 3;
+	close(socket_id);
+	if((!Log_UDP_Handle_Open("127.0.0.1",port_number,"Messages","sshd","udp_journal.c",NULL,&handle))||
+	   (!Log_UDP_Handle_Journal_Set(handle,Journal_Filename,Replay_Rate)))
+	{
+		Log_General_Error();
+		if(handle != NULL)
+			Log_UDP_Handle_Close(handle);
+		return 4;
+	}
+	for(i = 0; i < Message_Count; i++)
+	{
+		if(!Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_TERSE,"journal","%d",i))
+			Log_General_Error();
+	}
+	Log_UDP_Handle_Flush(handle);
+	Log_Create_Timestamp_Get(&start_timestamp);
+	received_list = (char *)calloc(Message_Count,sizeof(char));
+	if(received_list == NULL)
+	{
+		fprintf(stderr,"udp_journal:Failed to allocate received list.\n");
+		Log_UDP_Handle_Close(handle);
+		return 5;
+	}
+	if(!Socket_Open(port_number,&socket_id,&port_number))
+	{
+		free(received_list);
+		Log_UDP_Handle_Close(handle);
+		return 6;
+	}
+	Receive(socket_id,start_timestamp,received_list);
+	close(socket_id);
+	if(Log_UDP_Handle_Destination_Stats_Get(handle,0,&stats))
+	{
+		fprintf(stdout,"Handle:%lu sent, %lu journaled, %lu dropped, %lu failed.\n",stats.Packet_Count,
+			stats.Journal_Count,stats.Drop_Count,stats.Error_Count);
+	}
+	if(!Log_UDP_Handle_Close(handle))
+		Log_General_Error();
+	missing_count = 0;
+	for(i = 0; i < Message_Count; i++)
+	{
+		if(!received_list[i])
+		{
+			missing_count++;
+			if(Verbose)
+				fprintf(stdout,"Message %d missing.\n",i);
+		}
+	}
+	free(received_list);
+	fprintf(stdout,"%d of %d messages missing.\n",missing_count,Message_Count);
+	return 0;
+}
+
+/**
+ * Open a UDP socket bound to a loopback port.
+ * @param port_number The port number to bind to, or zero for any free port.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @param bound_port_number The address of an integer, filled in with the port number bound to.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Socket_Open(int port_number,int *socket_id,int *bound_port_number)
+{
+	struct sockaddr_in address;
+	socklen_t address_length;
+
+	(*socket_id) = socket(AF_INET,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"udp_journal:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = htons(port_number);
+	address_length = sizeof(address);
+	if((bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname((*socket_id),(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"udp_journal:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	(*bound_port_number) = ntohs(address.sin_port);
+	return TRUE;
+}
+
+/**
+ * Receive the replayed messages, until every one has been received or none arrives for RECEIVE_TIMEOUT_MS.
+ * @param socket_id The bound socket.
+ * @param start_timestamp The time the receiver started. Replayed messages should have earlier timestamps.
+ * @param received_list A list of Message_Count flags, set for each message received.
+ * @return The routine returns the number of distinct messages received.
+ * @see #Message_Count
+ * @see #RECEIVE_TIMEOUT_MS
+ * @see log_udp_wire.html#Log_UDP_Decode
+ */
+static int Receive(int socket_id,int64_t start_timestamp,char *received_list)
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	struct pollfd poll_fd;
+	char packet[PACKET_LENGTH];
+	ssize_t packet_length;
+	int log_context_count,received_count,duplicate_count,original_count,decode_error_count,index;
+
+	received_count = 0;
+	duplicate_count = 0;
+	original_count = 0;
+	decode_error_count = 0;
+	while(received_count < Message_Count)
+	{
+		poll_fd.fd = socket_id;
+		poll_fd.events = POLLIN;
+		poll_fd.revents = 0;
+		if(poll(&poll_fd,1,RECEIVE_TIMEOUT_MS) <= 0)
+			break;
+		packet_length = recv(socket_id,packet,sizeof(packet),0);
+		if(packet_length <= 0)
+			continue;
+		log_context_list = NULL;
+		if((!Log_UDP_Decode(packet,packet_length,&log_record,&log_context_count,&log_context_list,NULL))||
+		   (sscanf(log_record.Message,"%d",&index) != 1)||(index < 0)||(index >= Message_Count))
+		{
+			decode_error_count++;
+			if(log_context_list != NULL)
+				free(log_context_list);
+			continue;
+		}
+		if(log_context_list != NULL)
+			free(log_context_list);
+		if(Verbose)
+			fprintf(stdout,"%lld:%s\n",(long long)log_record.Timestamp,log_record.Message);
+		if(received_list[index])
+		{
+			duplicate_count++;
+			continue;
+		}
+		received_list[index] = TRUE;
+		received_count++;
+		if(log_record.Timestamp <= start_timestamp)
+			original_count++;
+	}
+	fprintf(stdout,"Received %d messages, %d with their original timestamps, %d duplicates, "
+		"%d failed to decode.\n",received_count,original_count,duplicate_count,decode_error_count);
+	return received_count;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Journal_Filename
+ * @see #Message_Count
+ * @see #Replay_Rate
+ * @see #Verbose
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"udp_journal:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_journal:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-file")==0)||(strcmp(argv[i],"-f")==0))
+		{
+			if((i+1)<argc)
+			{
+				Journal_Filename = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_journal:Parse_Arguments:Journal file requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-rate")==0)||(strcmp(argv[i],"-r")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Replay_Rate);
+				if((retval != 1)||(Replay_Rate < 0))
+				{
+					fprintf(stderr,"udp_journal:Parse_Arguments:"
+						"Failed to parse replay rate '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_journal:Parse_Arguments:Replay rate requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-verbose")==0)||(strcmp(argv[i],"-v")==0))
+		{
+			Verbose = TRUE;
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"udp_journal:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"udp_journal help.\n");
+	fprintf(stdout,"udp_journal logs messages to a loopback port with no receiver, so they are journaled,\n");
+	fprintf(stdout,"then starts a receiver and checks the journal replays them with their original timestamps.\n");
+	fprintf(stdout,"udp_journal -f[ile] <journal filename>\n");
+	fprintf(stdout,"\t[-c[ount] <number of messages>][-r[ate] <messages per second>][-v[erbose]][-help]\n");
+}
+
+/*
+** $Log$
+*/
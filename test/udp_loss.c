@@ -0,0 +1,772 @@
+/* udp_loss.c
+** $Header$
+*/
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_coalesce.h"
+#include "log_udp_container.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_fragment.h"
+#include "log_udp_handle.h"
+#include "log_udp_template.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program measures packet loss and reordering between log_udp senders and this receiver. Senders
+ * must use wire format version 2 with LOG_UDP_V2_FLAG_SEQUENCE set, so each packet carries a stream tag
+ * (host id, process id and start time) and a sequence number. The program binds to a UDP port, decodes each
+ * packet received (reassembling fragments and unpacking containers), and keeps the sequence numbers seen for each stream. When the
+ * packet count or duration is reached, it prints, for each stream, the packets received, missing,
+ * reordered (arrived after a later packet) and duplicated, and the loss and reorder percentages.
+ * With -check, the program first sends messages to itself over loopback, most of them repeats that are
+ * coalesced, and fails if any sequence numbers are missing: repeats that are not sent must not use them up.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The number of senders a dictionary and template table are kept for. When more send, the oldest sender's
+ * are reused.
+ */
+#define SENDER_COUNT                     (64)
+/**
+ * The number of streams statistics are kept for. Packets from further streams are counted as untracked.
+ */
+#define STREAM_COUNT                     (64)
+/**
+ * The number of sequence numbers, up to the highest received, each stream remembers having received. Packets
+ * arriving later than this are counted as reordered, but can not be told apart from duplicates.
+ */
+#define SEQUENCE_WINDOW                  (1024)
+/**
+ * The number of times each message is sent by -check. All but the first are coalesced.
+ */
+#define CHECK_REPEAT_COUNT               (3)
+/**
+ * The coalescing window used by -check, in milliseconds, long enough for every repeat to be coalesced.
+ */
+#define CHECK_COALESCE_WINDOW_MS         (60000)
+/**
+ * The number of seconds -check receives for, if no duration is specified.
+ */
+#define CHECK_DURATION                   (2)
+
+/* structures */
+/**
+ * A sender, and the strings and templates it has defined.
+ * <dl>
+ * <dt>Address</dt> <dd>The sender's address and port.</dd>
+ * <dt>Dictionary</dt> <dd>The sender's string dictionary.</dd>
+ * <dt>Template_Table</dt> <dd>The sender's message templates.</dd>
+ * <dt>Reassembly</dt> <dd>The sender's partly received fragmented packets.</dd>
+ * <dt>Tagged_Count</dt> <dd>The number of packets received from the sender with a sequence number.</dd>
+ * <dt>Untagged_Count</dt> <dd>The number of packets received from the sender without a sequence number.</dd>
+ * </dl>
+ */
+struct Sender_Struct
+{
+	struct sockaddr_in Address;
+	Log_UDP_Dictionary_T Dictionary;
+	Log_UDP_Template_Table_T Template_Table;
+	Log_UDP_Reassembly_T Reassembly;
+	long Tagged_Count;
+	long Untagged_Count;
+};
+
+/**
+ * The sequence numbers received from one stream.
+ * <dl>
+ * <dt>Host_Id</dt> <dd>The stream tag's host id.</dd>
+ * <dt>Pid</dt> <dd>The stream tag's process id.</dd>
+ * <dt>Start_Us</dt> <dd>The stream tag's start time.</dd>
+ * <dt>First_Sequence</dt> <dd>The lowest sequence number received.</dd>
+ * <dt>Highest_Sequence</dt> <dd>The highest sequence number received.</dd>
+ * <dt>Received_Count</dt> <dd>The number of packets received, including duplicates.</dd>
+ * <dt>Reordered_Count</dt> <dd>The number of packets received after a packet with a higher sequence number.</dd>
+ * <dt>Duplicate_Count</dt> <dd>The number of packets received whose sequence number had already been
+ *     received.</dd>
+ * <dt>Window</dt> <dd>A bit for each of the last SEQUENCE_WINDOW sequence numbers, up to Highest_Sequence,
+ *     set if that sequence number has been received.</dd>
+ * </dl>
+ * @see #SEQUENCE_WINDOW
+ */
+struct Stream_Struct
+{
+	uint64_t Host_Id;
+	uint64_t Pid;
+	uint64_t Start_Us;
+	uint64_t First_Sequence;
+	uint64_t Highest_Sequence;
+	long Received_Count;
+	long Reordered_Count;
+	long Duplicate_Count;
+	unsigned char Window[SEQUENCE_WINDOW/8];
+};
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The port number to receive on.
+ */
+static int Port_Number = 0;
+/**
+ * The number of datagrams to receive before printing the statistics. Zero means no limit.
+ */
+static int Packet_Count = 0;
+/**
+ * The number of seconds to receive for before printing the statistics. Zero means no limit.
+ */
+static int Duration = 0;
+/**
+ * The multicast group to join, or NULL to receive unicast packets only.
+ */
+static char *Multicast_Group = NULL;
+/**
+ * The numeric address of the local interface to join the multicast group on, or NULL to let the kernel
+ * choose.
+ */
+static char *Multicast_Interface = NULL;
+/**
+ * The number of messages -check sends to this program before receiving. Zero means only receive.
+ */
+static int Check_Count = 0;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+/**
+ * The senders a dictionary and template table are kept for.
+ * @see #SENDER_COUNT
+ */
+static struct Sender_Struct Sender_List[SENDER_COUNT];
+/**
+ * The number of entries in Sender_List used.
+ */
+static int Sender_Count = 0;
+/**
+ * The index in Sender_List that is reused next, when all the entries are used.
+ */
+static int Sender_Reuse_Index = 0;
+/**
+ * The streams statistics are kept for.
+ * @see #STREAM_COUNT
+ */
+static struct Stream_Struct Stream_List[STREAM_COUNT];
+/**
+ * The number of entries in Stream_List used.
+ */
+static int Stream_Count = 0;
+/**
+ * The number of packets received without a sequence number.
+ */
+static long Untagged_Count = 0;
+/**
+ * The number of packets received from streams after Stream_List was full.
+ */
+static long Untracked_Count = 0;
+/**
+ * The number of packets that could not be decoded.
+ */
+static long Failed_Count = 0;
+
+/* internal routines */
+static struct Sender_Struct *Sender_Get(struct sockaddr_in *address);
+static void Decode_Packet(struct Sender_Struct *sender,const char *packet,size_t packet_length);
+static void Sequence_Add(struct Log_UDP_Packet_Info_Struct *packet_info);
+static int Check_Send(void);
+static long Print_Statistics(void);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Duration
+ * @see #Multicast_Group
+ * @see #Multicast_Interface
+ * @see #Check_Count
+ * @see #Packet_Buffer
+ * @see #Sender_Get
+ * @see #Decode_Packet
+ * @see #Check_Send
+ * @see #Print_Statistics
+ */
+int main(int argc, char *argv[])
+{
+	struct sockaddr_in address,sender_address;
+	struct ip_mreq multicast_request;
+	struct timeval receive_timeout;
+	socklen_t sender_address_length;
+	struct Sender_Struct *sender = NULL;
+	const char *packet = NULL;
+	const char *datagram = NULL;
+	size_t packet_position,record_packet_length,datagram_length;
+	ssize_t packet_length;
+	time_t end_time;
+	long missing_count;
+	int socket_id,received_count,record_count,reuse,complete,i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"udp_loss:Parse Arguments failed.\n");
+		return 1;
+	}
+	if(Port_Number == 0)
+	{
+		fprintf(stderr,"udp_loss:No port number specified.\n");
+		return 2;
+	}
+	socket_id = socket(AF_INET,SOCK_DGRAM,0);
+	if(socket_id < 0)
+	{
+		fprintf(stderr,"udp_loss:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return 3;
+	}
+	if(Multicast_Group != NULL)
+	{
+		reuse = 1;
+		setsockopt(socket_id,SOL_SOCKET,SO_REUSEADDR,&reuse,sizeof(reuse));
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(Port_Number);
+	if(bind(socket_id,(struct sockaddr *)&address,sizeof(address)) < 0)
+	{
+		fprintf(stderr,"udp_loss:Failed to bind to port %d (%d:%s).\n",Port_Number,errno,strerror(errno));
+		close(socket_id);
+		return 4;
+	}
+	if(Multicast_Group != NULL)
+	{
+		memset(&multicast_request,0,sizeof(multicast_request));
+		multicast_request.imr_interface.s_addr = htonl(INADDR_ANY);
+		if((inet_aton(Multicast_Group,&(multicast_request.imr_multiaddr)) == 0)||
+		   ((Multicast_Interface != NULL)&&(inet_aton(Multicast_Interface,
+							      &(multicast_request.imr_interface)) == 0)))
+		{
+			fprintf(stderr,"udp_loss:Illegal multicast group '%s' or interface '%s'.\n",Multicast_Group,
+				(Multicast_Interface != NULL) ? Multicast_Interface : "");
+			close(socket_id);
+			return 6;
+		}
+		if(setsockopt(socket_id,IPPROTO_IP,IP_ADD_MEMBERSHIP,&multicast_request,sizeof(multicast_request)) < 0)
+		{
+			fprintf(stderr,"udp_loss:Failed to join multicast group %s (%d:%s).\n",Multicast_Group,errno,
+				strerror(errno));
+			close(socket_id);
+			return 7;
+		}
+	}
+	/* the packets sent wait in the socket's receive buffer */
+	if(Check_Count > 0)
+	{
+		if(!Check_Send())
+		{
+			Log_General_Error();
+			close(socket_id);
+			return 8;
+		}
+		if(Duration == 0)
+			Duration = CHECK_DURATION;
+	}
+	/* wake up once a second, to check the duration */
+	receive_timeout.tv_sec = 1;
+	receive_timeout.tv_usec = 0;
+	setsockopt(socket_id,SOL_SOCKET,SO_RCVTIMEO,&receive_timeout,sizeof(receive_timeout));
+	end_time = time(NULL)+Duration;
+	received_count = 0;
+	while(((Packet_Count == 0)||(received_count < Packet_Count))&&((Duration == 0)||(time(NULL) < end_time)))
+	{
+		sender_address_length = sizeof(sender_address);
+		packet_length = recvfrom(socket_id,Packet_Buffer,PACKET_LENGTH,0,(struct sockaddr *)&sender_address,
+					 &sender_address_length);
+		if(packet_length < 0)
+		{
+			if((errno == EINTR)||(errno == EAGAIN)||(errno == EWOULDBLOCK))
+				continue;
+			fprintf(stderr,"udp_loss:recv failed (%d:%s).\n",errno,strerror(errno));
+			close(socket_id);
+			return 5;
+		}
+		received_count++;
+		sender = Sender_Get(&sender_address);
+		datagram = Packet_Buffer;
+		datagram_length = (size_t)packet_length;
+		/* fragments are held until the whole packet has arrived, which is then handled as one datagram */
+		if(Log_UDP_Fragment_Is_Fragment(Packet_Buffer,(size_t)packet_length))
+		{
+			if(sender->Reassembly == NULL)
+				continue;
+			if(!Log_UDP_Reassembly_Add(sender->Reassembly,Packet_Buffer,(size_t)packet_length,&complete,
+						   &datagram,&datagram_length))
+			{
+				Failed_Count++;
+				continue;
+			}
+			if(!complete)
+				continue;
+		}
+		if(Log_UDP_Container_Is_Container(datagram,datagram_length))
+		{
+			if(!Log_UDP_Container_Unpack_Start(datagram,datagram_length,&record_count,&packet_position))
+			{
+				Failed_Count++;
+				continue;
+			}
+			for(i = 0; i < record_count; i++)
+			{
+				if(!Log_UDP_Container_Unpack_Next(datagram,datagram_length,&packet_position,&packet,
+								  &record_packet_length))
+				{
+					Failed_Count++;
+					break;
+				}
+				Decode_Packet(sender,packet,record_packet_length);
+			}
+		}
+		else
+			Decode_Packet(sender,datagram,datagram_length);
+	}
+	close(socket_id);
+	fprintf(stdout,"Received %d datagrams.\n",received_count);
+	missing_count = Print_Statistics();
+	if((Check_Count > 0)&&((Stream_Count != 1)||(missing_count > 0)))
+	{
+		fprintf(stdout,"Check failed: %ld packets missing from %d streams with coalescing on.\n",missing_count,
+			Stream_Count);
+		return 9;
+	}
+	return 0;
+}
+
+/**
+ * Get a sender's entry, with it's dictionary, template table and reassembler, creating them if this is a new
+ * sender.
+ * @param address The sender's address.
+ * @return The sender's entry. The dictionary, template table or reassembler is NULL if it could not be
+ *         created.
+ * @see #Sender_List
+ * @see #Sender_Count
+ * @see #Sender_Reuse_Index
+ */
+static struct Sender_Struct *Sender_Get(struct sockaddr_in *address)
+{
+	struct Sender_Struct *sender = NULL;
+	int i;
+
+	for(i = 0; i < Sender_Count; i++)
+	{
+		if((Sender_List[i].Address.sin_addr.s_addr == address->sin_addr.s_addr)&&
+		   (Sender_List[i].Address.sin_port == address->sin_port))
+			return &(Sender_List[i]);
+	}
+	if(Sender_Count < SENDER_COUNT)
+		sender = &(Sender_List[Sender_Count++]);
+	else
+	{
+		sender = &(Sender_List[Sender_Reuse_Index]);
+		Sender_Reuse_Index = (Sender_Reuse_Index+1)%SENDER_COUNT;
+		if(sender->Dictionary != NULL)
+			Log_UDP_Dictionary_Destroy(sender->Dictionary);
+		if(sender->Template_Table != NULL)
+			Log_UDP_Template_Table_Destroy(sender->Template_Table);
+		if(sender->Reassembly != NULL)
+			Log_UDP_Reassembly_Destroy(sender->Reassembly);
+	}
+	sender->Address = (*address);
+	sender->Dictionary = NULL;
+	sender->Template_Table = NULL;
+	sender->Reassembly = NULL;
+	sender->Tagged_Count = 0;
+	sender->Untagged_Count = 0;
+	if(!Log_UDP_Dictionary_Create(&(sender->Dictionary)))
+		Log_General_Error();
+	if(!Log_UDP_Template_Table_Create(&(sender->Template_Table)))
+		Log_General_Error();
+	if(!Log_UDP_Reassembly_Create(LOG_UDP_REASSEMBLY_DEFAULT_MEMORY,LOG_UDP_REASSEMBLY_DEFAULT_TIMEOUT_MS,
+				      &(sender->Reassembly)))
+		Log_General_Error();
+	return sender;
+}
+
+/**
+ * Decode a packet, received on it's own or unpacked from a container, and add it's sequence number to
+ * the statistics.
+ * @param sender The sender's entry, with it's dictionary and template table.
+ * @param packet The encoded packet.
+ * @param packet_length The length of the packet in bytes.
+ * @see #Sequence_Add
+ * @see #Untagged_Count
+ * @see #Failed_Count
+ */
+static void Decode_Packet(struct Sender_Struct *sender,const char *packet,size_t packet_length)
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	struct Log_UDP_Packet_Info_Struct packet_info;
+	int log_context_count;
+
+	if(!Log_UDP_Decode_Template(packet,packet_length,sender->Dictionary,sender->Template_Table,&log_record,
+				    &log_context_count,&log_context_list,&packet_info))
+	{
+		Failed_Count++;
+		return;
+	}
+	if(log_context_list != NULL)
+		free(log_context_list);
+	if(packet_info.Flags & LOG_UDP_V2_FLAG_SEQUENCE)
+	{
+		sender->Tagged_Count++;
+		Sequence_Add(&packet_info);
+	}
+	else
+	{
+		sender->Untagged_Count++;
+		Untagged_Count++;
+	}
+}
+
+/**
+ * Add a received sequence number to it's stream's statistics. A sequence number higher than any received
+ * before moves the stream's window up; one inside the window is reordered, or a duplicate if it's bit is
+ * already set; one below the window is counted as reordered.
+ * @param packet_info The decoded packet's stream tag and sequence number.
+ * @see #Stream_List
+ * @see #Stream_Count
+ * @see #Untracked_Count
+ * @see #SEQUENCE_WINDOW
+ */
+static void Sequence_Add(struct Log_UDP_Packet_Info_Struct *packet_info)
+{
+	struct Stream_Struct *stream = NULL;
+	uint64_t sequence,bit;
+	int i;
+
+	for(i = 0; i < Stream_Count; i++)
+	{
+		if((Stream_List[i].Host_Id == packet_info->Sequence_Host_Id)&&
+		   (Stream_List[i].Pid == packet_info->Sequence_Pid)&&
+		   (Stream_List[i].Start_Us == packet_info->Sequence_Start_Us))
+		{
+			stream = &(Stream_List[i]);
+			break;
+		}
+	}
+	sequence = packet_info->Sequence_Number;
+	if(stream == NULL)
+	{
+		if(Stream_Count >= STREAM_COUNT)
+		{
+			Untracked_Count++;
+			return;
+		}
+		stream = &(Stream_List[Stream_Count++]);
+		memset(stream,0,sizeof(struct Stream_Struct));
+		stream->Host_Id = packet_info->Sequence_Host_Id;
+		stream->Pid = packet_info->Sequence_Pid;
+		stream->Start_Us = packet_info->Sequence_Start_Us;
+		stream->First_Sequence = sequence;
+		stream->Highest_Sequence = sequence;
+		stream->Received_Count = 1;
+		stream->Window[(sequence%SEQUENCE_WINDOW)/8] |= (1<<(sequence%8));
+		return;
+	}
+	stream->Received_Count++;
+	if(sequence > stream->Highest_Sequence)
+	{
+		/* clear the bits of the sequence numbers skipped, they have not been received yet */
+		if((sequence-stream->Highest_Sequence) >= SEQUENCE_WINDOW)
+			memset(stream->Window,0,sizeof(stream->Window));
+		else
+		{
+			for(bit = stream->Highest_Sequence+1; bit < sequence; bit++)
+				stream->Window[(bit%SEQUENCE_WINDOW)/8] &= ~(1<<(bit%8));
+		}
+		stream->Highest_Sequence = sequence;
+		stream->Window[(sequence%SEQUENCE_WINDOW)/8] |= (1<<(sequence%8));
+	}
+	else if((stream->Highest_Sequence-sequence) < SEQUENCE_WINDOW)
+	{
+		/* numbers below First_Sequence inside the window have clear bits, they were never received */
+		if((sequence >= stream->First_Sequence)&&
+		   (stream->Window[(sequence%SEQUENCE_WINDOW)/8] & (1<<(sequence%8))))
+			stream->Duplicate_Count++;
+		else
+		{
+			stream->Reordered_Count++;
+			stream->Window[(sequence%SEQUENCE_WINDOW)/8] |= (1<<(sequence%8));
+		}
+	}
+	else
+		stream->Reordered_Count++;
+	if(sequence < stream->First_Sequence)
+		stream->First_Sequence = sequence;
+}
+
+/**
+ * Send Check_Count messages to this program over loopback, through a handle numbering it's packets, with
+ * coalescing on. Each message is sent CHECK_REPEAT_COUNT times, so all but the first copy are coalesced,
+ * and the repeat summaries are flushed before the handle is closed.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Check_Count
+ * @see #CHECK_REPEAT_COUNT
+ * @see #CHECK_COALESCE_WINDOW_MS
+ * @see ../cdocs/log_udp_coalesce.html#Log_UDP_Coalesce_Set
+ * @see ../cdocs/log_udp_handle.html#Log_UDP_Sendf
+ */
+static int Check_Send(void)
+{
+	Log_UDP_Handle_T handle = NULL;
+	int retval,i;
+
+	if(!Log_UDP_Handle_Open("127.0.0.1",Port_Number,"Check","udp_loss","udp_loss.c",NULL,&handle))
+		return FALSE;
+	if((!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,LOG_UDP_V2_FLAG_SEQUENCE))||
+	   (!Log_UDP_Coalesce_Set(CHECK_COALESCE_WINDOW_MS)))
+	{
+		Log_UDP_Handle_Close(handle);
+		return FALSE;
+	}
+	retval = TRUE;
+	for(i = 0; retval && (i < Check_Count); i++)
+	{
+		retval = Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_TERSE,"check","Message %d",
+				       i/CHECK_REPEAT_COUNT);
+	}
+	retval = retval && Log_UDP_Coalesce_Flush();
+	if(!Log_UDP_Handle_Close(handle))
+		retval = FALSE;
+	Log_UDP_Coalesce_Set(0);
+	return retval;
+}
+
+/**
+ * Print the statistics for each stream. A stream's expected packet count is the span from the lowest to
+ * the highest sequence number received, so packets lost before the first or after the last one received
+ * are not counted. Senders that sent some packets with sequence numbers and some without are listed.
+ * @return The routine returns the total number of packets missing from all the streams.
+ * @see #Stream_List
+ * @see #Stream_Count
+ * @see #Sender_List
+ */
+static long Print_Statistics(void)
+{
+	struct Stream_Struct *stream = NULL;
+	uint64_t expected_count;
+	long unique_count,missing_count,total_missing_count;
+	int i;
+
+	total_missing_count = 0;
+	fprintf(stdout,"%-8s %-8s %-16s %10s %10s %10s %10s %10s %8s %8s\n","host","pid","start_us","expected",
+		"received","missing","reordered","duplicate","loss%","reorder%");
+	for(i = 0; i < Stream_Count; i++)
+	{
+		stream = &(Stream_List[i]);
+		expected_count = stream->Highest_Sequence-stream->First_Sequence+1;
+		unique_count = stream->Received_Count-stream->Duplicate_Count;
+		missing_count = (long)expected_count-unique_count;
+		if(missing_count < 0)
+			missing_count = 0;
+		total_missing_count += missing_count;
+		fprintf(stdout,"%08x %-8lu %-16llu %10llu %10ld %10ld %10ld %10ld %8.3f %8.3f\n",
+			(unsigned int)stream->Host_Id,(unsigned long)stream->Pid,
+			(unsigned long long)stream->Start_Us,(unsigned long long)expected_count,
+			stream->Received_Count,missing_count,stream->Reordered_Count,stream->Duplicate_Count,
+			(100.0*missing_count)/expected_count,(100.0*stream->Reordered_Count)/stream->Received_Count);
+	}
+	if(Untagged_Count > 0)
+		fprintf(stdout,"%ld packets had no sequence number.\n",Untagged_Count);
+	/* a sender numbering some of it's packets should number all of them, or their loss goes unmeasured */
+	for(i = 0; i < Sender_Count; i++)
+	{
+		if((Sender_List[i].Tagged_Count > 0)&&(Sender_List[i].Untagged_Count > 0))
+		{
+			fprintf(stdout,"%s:%d sent %ld of %ld packets without a sequence number.\n",
+				inet_ntoa(Sender_List[i].Address.sin_addr),ntohs(Sender_List[i].Address.sin_port),
+				Sender_List[i].Untagged_Count,
+				Sender_List[i].Tagged_Count+Sender_List[i].Untagged_Count);
+		}
+	}
+	if(Untracked_Count > 0)
+		fprintf(stdout,"%ld packets came from streams after the first %d.\n",Untracked_Count,STREAM_COUNT);
+	if(Failed_Count > 0)
+		fprintf(stdout,"%ld packets could not be decoded.\n",Failed_Count);
+	return total_missing_count;
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Port_Number
+ * @see #Packet_Count
+ * @see #Duration
+ * @see #Multicast_Group
+ * @see #Multicast_Interface
+ * @see #Check_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if(strcmp(argv[i],"-check")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Check_Count);
+				if((retval != 1)||(Check_Count < 1))
+				{
+					fprintf(stderr,"udp_loss:Parse_Arguments:"
+						"Failed to parse check message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Check requires a number of messages.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Packet_Count);
+				if((retval != 1)||(Packet_Count < 0))
+				{
+					fprintf(stderr,"udp_loss:Parse_Arguments:"
+						"Failed to parse packet count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Packet count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-duration")==0)||(strcmp(argv[i],"-d")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Duration);
+				if((retval != 1)||(Duration < 0))
+				{
+					fprintf(stderr,"udp_loss:Parse_Arguments:"
+						"Failed to parse duration '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Duration requires a number of seconds.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-interface")==0)||(strcmp(argv[i],"-i")==0))
+		{
+			if((i+1)<argc)
+			{
+				Multicast_Interface = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Interface requires an address.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-multicast")==0)||(strcmp(argv[i],"-m")==0))
+		{
+			if((i+1)<argc)
+			{
+				Multicast_Group = argv[i+1];
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Multicast requires a group address.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-port_number")==0)||(strcmp(argv[i],"-p")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Port_Number);
+				if(retval != 1)
+				{
+					fprintf(stderr,"udp_loss:Parse_Arguments:"
+						"Failed to parse port number '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"udp_loss:Parse_Arguments:Port number requires a number.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"udp_loss:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"udp_loss help.\n");
+	fprintf(stdout,"udp_loss receives log_udp packets sent with sequence numbers, "
+		"and prints the loss and reordering of each stream.\n");
+	fprintf(stdout,"udp_loss -p[ort_number] <n> [-c[ount] <number of datagrams>][-d[uration] <seconds>]\n");
+	fprintf(stdout,"\t[-m[ulticast] <group address> [-i[nterface] <local address>]][-help]\n");
+	fprintf(stdout,"\t[-check <number of messages>]\n");
+	fprintf(stdout,"-check sends the messages to itself with coalescing on, and fails if any are missing.\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,331 @@
+/* unix_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.4/IEEE1003.1b-1993 prototypes
+ * for clock_gettime.
+ */
+#define _POSIX_C_SOURCE 199309L
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_udp_handle.h"
+#include "log_udp_resolve.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program compares sending to a local relay over UDP on the loopback interface against sending
+ * to it over a Unix domain datagram socket ("unix:/path" destination). It binds a receiver of each kind,
+ * sends the same messages through a logger handle to each, and reports the sender time per message and
+ * the packets each receiver got.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The number of messages sent before the receive socket is drained. Unix domain datagram sockets only
+ * queue net.unix.max_dgram_qlen datagrams (10 by default), and a blocking sender waits when the queue
+ * is full, so this must be smaller than that.
+ */
+#define DRAIN_COUNT                      (8)
+/**
+ * The largest packet that can be received.
+ */
+#define PACKET_LENGTH                    (65536)
+/**
+ * The length of the Unix domain socket path.
+ */
+#define UNIX_PATH_LENGTH                 (108)
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The number of messages to send with each transport.
+ */
+static int Message_Count = 100000;
+/**
+ * Buffer to receive packets into.
+ * @see #PACKET_LENGTH
+ */
+static char Packet_Buffer[PACKET_LENGTH];
+
+/* internal routines */
+static int UDP_Receiver_Open(int *socket_id,int *port_number);
+static int Unix_Receiver_Open(char *unix_path,int *socket_id);
+static int Send_Messages(char *hostname,int port_number,int receive_socket_id,double *send_time,
+			 unsigned long *packet_count);
+static unsigned long Drain(int receive_socket_id);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Message_Count
+ * @see #UDP_Receiver_Open
+ * @see #Unix_Receiver_Open
+ * @see #Send_Messages
+ */
+int main(int argc, char *argv[])
+{
+	char unix_path[UNIX_PATH_LENGTH];
+	char hostname[UNIX_PATH_LENGTH+8];
+	unsigned long udp_packet_count,unix_packet_count;
+	double udp_time,unix_time;
+	int udp_socket_id,unix_socket_id,port_number,retval;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"unix_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	snprintf(unix_path,UNIX_PATH_LENGTH,"/tmp/unix_benchmark.%d",(int)getpid());
+	if(!UDP_Receiver_Open(&udp_socket_id,&port_number))
+		return 2;
+	if(!Unix_Receiver_Open(unix_path,&unix_socket_id))
+	{
+		close(udp_socket_id);
+		return 3;
+	}
+	snprintf(hostname,sizeof(hostname),"%s%s",LOG_UDP_RESOLVE_UNIX_PREFIX,unix_path);
+	retval = Send_Messages("127.0.0.1",port_number,udp_socket_id,&udp_time,&udp_packet_count)&&
+		Send_Messages(hostname,0,unix_socket_id,&unix_time,&unix_packet_count);
+	close(udp_socket_id);
+	close(unix_socket_id);
+	unlink(unix_path);
+	if(!retval)
+	{
+		Log_General_Error();
+		return 4;
+	}
+	fprintf(stdout,"Loopback UDP: %d messages: send %.2f us/message. Receiver got %lu.\n",Message_Count,
+		(udp_time*1000000.0)/Message_Count,udp_packet_count);
+	fprintf(stdout,"Unix domain:  %d messages: send %.2f us/message. Receiver got %lu.\n",Message_Count,
+		(unix_time*1000000.0)/Message_Count,unix_packet_count);
+	return 0;
+}
+
+/**
+ * Open a UDP socket bound to an unused port on the loopback interface.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @param port_number The address of an integer, filled in with the port number.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int UDP_Receiver_Open(int *socket_id,int *port_number)
+{
+	struct sockaddr_in address;
+	socklen_t address_length;
+
+	(*socket_id) = socket(AF_INET,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"unix_benchmark:Failed to create socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	address_length = sizeof(address);
+	if((bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)||
+	   (getsockname((*socket_id),(struct sockaddr *)&address,&address_length) < 0))
+	{
+		fprintf(stderr,"unix_benchmark:Failed to bind socket (%d:%s).\n",errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	(*port_number) = ntohs(address.sin_port);
+	return TRUE;
+}
+
+/**
+ * Open a Unix domain datagram socket bound to a path.
+ * @param unix_path The path to bind the socket to. Any file already there is removed.
+ * @param socket_id The address of an integer, filled in with the socket.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Unix_Receiver_Open(char *unix_path,int *socket_id)
+{
+	struct sockaddr_un address;
+
+	(*socket_id) = socket(AF_UNIX,SOCK_DGRAM,0);
+	if((*socket_id) < 0)
+	{
+		fprintf(stderr,"unix_benchmark:Failed to create Unix domain socket (%d:%s).\n",errno,strerror(errno));
+		return FALSE;
+	}
+	memset(&address,0,sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path,unix_path,sizeof(address.sun_path)-1);
+	unlink(unix_path);
+	if(bind((*socket_id),(struct sockaddr *)&address,sizeof(address)) < 0)
+	{
+		fprintf(stderr,"unix_benchmark:Failed to bind to %s (%d:%s).\n",unix_path,errno,strerror(errno));
+		close((*socket_id));
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Open a logger handle to the receiver, send Message_Count short syslog style messages with it, and
+ * drain the receive socket every DRAIN_COUNT messages. Only the sending is timed.
+ * @param hostname The receiver's hostname, or "unix:" followed by its socket path.
+ * @param port_number The receiver's port number.
+ * @param receive_socket_id The receive socket.
+ * @param send_time The address of a double, filled in with the time spent sending in seconds.
+ * @param packet_count The address of an unsigned long, filled in with the number of packets the
+ *        receiver got.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Message_Count
+ * @see #Drain
+ * @see #DRAIN_COUNT
+ */
+static int Send_Messages(char *hostname,int port_number,int receive_socket_id,double *send_time,
+			 unsigned long *packet_count)
+{
+	Log_UDP_Handle_T handle = NULL;
+	struct timespec start_time,end_time;
+	int i;
+
+	(*send_time) = 0.0;
+	(*packet_count) = 0;
+	if((!Log_UDP_Handle_Open(hostname,port_number,"Messages","sshd","unix_benchmark.c",NULL,&handle))||
+	   (!Log_UDP_Handle_Format_Set(handle,LOG_UDP_WIRE_FORMAT_V2,0)))
+	{
+		if(handle != NULL)
+			Log_UDP_Handle_Close(handle);
+		return FALSE;
+	}
+	for(i = 0; i < Message_Count; i++)
+	{
+		if((i%DRAIN_COUNT) == 0)
+			clock_gettime(CLOCK_MONOTONIC,&start_time);
+		if(!Log_UDP_Sendf(handle,LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,"ltobs9",
+				  "Accepted publickey for eng from 192.168.1.%d port %d ssh2",1+(i%254),1024+(i%60000)))
+		{
+			Log_UDP_Handle_Close(handle);
+			return FALSE;
+		}
+		if((((i+1)%DRAIN_COUNT) == 0)||(i == (Message_Count-1)))
+		{
+			clock_gettime(CLOCK_MONOTONIC,&end_time);
+			(*send_time) += Time_Difference(start_time,end_time);
+			(*packet_count) += Drain(receive_socket_id);
+		}
+	}
+	Log_UDP_Handle_Close(handle);
+	return TRUE;
+}
+
+/**
+ * Receive every packet waiting on the socket.
+ * @param receive_socket_id The socket.
+ * @return The number of packets received.
+ * @see #Packet_Buffer
+ */
+static unsigned long Drain(int receive_socket_id)
+{
+	unsigned long packet_count;
+
+	packet_count = 0;
+	while(recv(receive_socket_id,Packet_Buffer,PACKET_LENGTH,MSG_DONTWAIT) > 0)
+		packet_count++;
+	return packet_count;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Message_Count
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if((strcmp(argv[i],"-count")==0)||(strcmp(argv[i],"-c")==0))
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Message_Count);
+				if((retval != 1)||(Message_Count < 1))
+				{
+					fprintf(stderr,"unix_benchmark:Parse_Arguments:"
+						"Failed to parse message count '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"unix_benchmark:Parse_Arguments:Message count requires a number.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else
+		{
+			fprintf(stderr,"unix_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"unix_benchmark help.\n");
+	fprintf(stdout,"unix_benchmark sends short syslog style messages to a receiver on the loopback interface\n");
+	fprintf(stdout,"over UDP, and to a receiver on a Unix domain datagram socket, and prints the time taken\n");
+	fprintf(stdout,"by each and the packets each receiver got.\n");
+	fprintf(stdout,"unix_benchmark [-c[ount] <number of messages>][-help]\n");
+}
+
+/*
+** $Log$
+*/
@@ -0,0 +1,550 @@
+/* wire_size_benchmark.c
+** $Header$
+*/
+/**
+ * This hash define is needed before including source files give us POSIX.1-2008 prototypes
+ * for clock_gettime and strdup.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "log_general.h"
+#include "log_udp.h"
+#include "log_create.h"
+#include "log_udp_compress.h"
+#include "log_udp_dictionary.h"
+#include "log_udp_wire.h"
+
+/**
+ * This program measures how many bytes each wire format puts on the network for a corpus of log lines,
+ * and how long each takes to encode.
+ * It reads a /var/log/messages file or a TCS log file, turns each line into a log record the way
+ * messages_to_udp or tcs_to_udp does, and encodes it as a version 1 packet, a version 2 packet, and a
+ * version 2 packet sent through a string dictionary. The two version 2 packets are then compressed,
+ * when they are at least as long as the compression threshold, and the shorter packet counted, as a handle
+ * sending with LOG_UDP_V2_FLAG_COMPRESSED does. Nothing is sent.
+ * @author $Author$
+ * @version $Revision$
+ */
+
+/* hash defines */
+/**
+ * Length of the line buffer.
+ */
+#define LINE_BUFFER_LENGTH               (1024)
+/**
+ * The number of wire encodings measured.
+ */
+#define ENCODING_COUNT                   (5)
+/**
+ * The number of nanoseconds in one second.
+ */
+#define ONE_SECOND_NS                    (1000000000)
+/**
+ * The default compression threshold, in bytes, the same as a logger handle's.
+ */
+#define DEFAULT_COMPRESSION_THRESHOLD    (256)
+/**
+ * MIN macro.
+ */
+#define MIN(A,B) ((A)<(B)?(A):(B))
+
+/* internal variables */
+/**
+ * Revision control system identifier.
+ */
+static char rcsid[] = "$Id$";
+/**
+ * The /var/log/messages format file to read.
+ */
+static char *Messages_Filename = NULL;
+/**
+ * The TCS log file to read.
+ */
+static char *TCS_Filename = NULL;
+/**
+ * Packets at least this many bytes long are compressed.
+ * @see #DEFAULT_COMPRESSION_THRESHOLD
+ */
+static int Compression_Threshold = DEFAULT_COMPRESSION_THRESHOLD;
+/**
+ * The names of the encodings measured.
+ * @see #ENCODING_COUNT
+ */
+static char *Encoding_Name_List[ENCODING_COUNT] = {"v1","v2","v2+dictionary","v2+compressed",
+						   "v2+dictionary+compressed"};
+/**
+ * The total number of bytes each encoding produced.
+ * @see #ENCODING_COUNT
+ */
+static unsigned long Encoding_Byte_Count_List[ENCODING_COUNT];
+/**
+ * The total time each encoding took, in seconds.
+ * @see #ENCODING_COUNT
+ */
+static double Encoding_Time_List[ENCODING_COUNT];
+
+/* internal routines */
+static int Messages_Line_To_Record(char *line_buffer,struct Log_Record_Struct *log_record,
+				   int *log_context_count,struct Log_Context_Struct **log_context_list);
+static int TCS_Line_To_Record(char *line_buffer,struct Log_Record_Struct *log_record,
+			      int *log_context_count,struct Log_Context_Struct **log_context_list);
+static int Parse_Parameter_Lists(char *message_buff,struct Log_Context_Struct **log_context_list,
+				 int *log_context_count);
+static int Encode_Record(Log_UDP_Dictionary_T dictionary,struct Log_Record_Struct *log_record,
+			 int log_context_count,struct Log_Context_Struct *log_context_list);
+static int Compress_Packet(char *message_buffer,size_t message_buffer_length,char *compressed_buffer,
+			   size_t compressed_buffer_length,size_t *packet_length);
+static double Time_Difference(struct timespec start_time,struct timespec end_time);
+static int Parse_Arguments(int argc, char *argv[]);
+static void Help(void);
+
+/**
+ * Main program.
+ * @param argc The number of arguments to the program.
+ * @param argv An array of argument strings.
+ * @return This function returns 0 if the program succeeds, and a positive boolean if it fails.
+ * @see #Messages_Filename
+ * @see #TCS_Filename
+ * @see #Encoding_Name_List
+ * @see #Encoding_Byte_Count_List
+ * @see #Encoding_Time_List
+ * @see #Messages_Line_To_Record
+ * @see #TCS_Line_To_Record
+ * @see #Encode_Record
+ */
+int main(int argc, char *argv[])
+{
+	struct Log_Record_Struct log_record;
+	struct Log_Context_Struct *log_context_list = NULL;
+	Log_UDP_Dictionary_T dictionary = NULL;
+	char line_buffer[LINE_BUFFER_LENGTH];
+	char *filename = NULL;
+	FILE *fp = NULL;
+	unsigned long record_count;
+	int log_context_count,retval,i;
+
+	if(!Parse_Arguments(argc,argv))
+	{
+		fprintf(stderr,"wire_size_benchmark:Parse Arguments failed.\n");
+		return 1;
+	}
+	if((Messages_Filename == NULL)&&(TCS_Filename == NULL))
+	{
+		fprintf(stderr,"wire_size_benchmark:No messages or TCS filename specified.\n");
+		return 2;
+	}
+	if(Messages_Filename != NULL)
+		filename = Messages_Filename;
+	else
+		filename = TCS_Filename;
+	fp = fopen(filename,"r");
+	if(fp == NULL)
+	{
+		fprintf(stderr,"wire_size_benchmark:Failed to open '%s'.\n",filename);
+		return 3;
+	}
+	if(!Log_UDP_Dictionary_Create(&dictionary))
+	{
+		Log_General_Error();
+		fclose(fp);
+		return 4;
+	}
+	record_count = 0;
+	while(fgets(line_buffer,LINE_BUFFER_LENGTH,fp) != NULL)
+	{
+		line_buffer[strcspn(line_buffer,"\n")] = '\0';
+		log_context_list = NULL;
+		log_context_count = 0;
+		if(Messages_Filename != NULL)
+			retval = Messages_Line_To_Record(line_buffer,&log_record,&log_context_count,&log_context_list);
+		else
+			retval = TCS_Line_To_Record(line_buffer,&log_record,&log_context_count,&log_context_list);
+		if(retval)
+		{
+			if(Encode_Record(dictionary,&log_record,log_context_count,log_context_list))
+				record_count++;
+			else
+				Log_General_Error();
+		}
+		if(log_context_list != NULL)
+			free(log_context_list);
+	}
+	fclose(fp);
+	Log_UDP_Dictionary_Destroy(dictionary);
+	if(record_count == 0)
+	{
+		fprintf(stderr,"wire_size_benchmark:No records in '%s'.\n",filename);
+		return 5;
+	}
+	fprintf(stdout,"%lu records from %s, compression threshold %d bytes.\n",record_count,filename,
+		Compression_Threshold);
+	for(i = 0; i < ENCODING_COUNT; i++)
+	{
+		fprintf(stdout,"%-24s %10lu bytes %8.1f bytes/record %6.1f%% of v1 %8.0f ns/record.\n",
+			Encoding_Name_List[i],Encoding_Byte_Count_List[i],
+			((double)Encoding_Byte_Count_List[i])/((double)record_count),
+			(100.0*Encoding_Byte_Count_List[i])/((double)Encoding_Byte_Count_List[0]),
+			(Encoding_Time_List[i]*((double)ONE_SECOND_NS))/((double)record_count));
+	}
+	return 0;
+}
+
+/**
+ * Turn a /var/log/messages line into a log record, as messages_to_udp does. Lines are of the form:
+ * <pre>
+ * Jan 15 20:17:25 ltobs9 gdm(pam_unix)[5232]: session closed for user cjm
+ * </pre>
+ * The timestamp is left as the current time, it is the same size in every line.
+ * @param line_buffer The line.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of the context count, updated.
+ * @param log_context_list The address of the context list, updated.
+ * @return The routine returns TRUE if the line was parsed, and FALSE if it was skipped.
+ */
+static int Messages_Line_To_Record(char *line_buffer,struct Log_Record_Struct *log_record,
+				   int *log_context_count,struct Log_Context_Struct **log_context_list)
+{
+	char month_buff[4];
+	char time_buff[9];
+	char machine_name_buff[128];
+	char sub_system_buff[128];
+	int day_of_month,char_count;
+
+	char_count = 0;
+	if(sscanf(line_buffer,"%3s %2d %8s %127s %127s %n",month_buff,&day_of_month,time_buff,
+		  machine_name_buff,sub_system_buff,&char_count) != 5)
+		return FALSE;
+	if(!Log_Create_Record("Messages",sub_system_buff,NULL,NULL,NULL,LOG_SEVERITY_INFO,
+			      LOG_VERBOSITY_INTERMEDIATE,machine_name_buff,line_buffer+char_count,log_record))
+	{
+		Log_General_Error();
+		return FALSE;
+	}
+	if(!Log_Create_Context_List_Add(log_context_list,log_context_count,"Machine Name",machine_name_buff))
+	{
+		Log_General_Error();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Turn a TCS log line into a log record, as tcs_to_udp does. Lines are of the form:
+ * <pre>
+ * Jan 20 00:00:33 <INFO>    USER  90000 Network command: FOCUS 27.575
+ * </pre>
+ * Any <<01>>ENABLED<<02>>... parameter lists in the message become contexts, followed by "Parameter Count"
+ * and "TCS Status Code" contexts. The severity and verbosity are left at their defaults, they are the
+ * same size whatever the TCS verbosity was, and the timestamp is left as the current time.
+ * @param line_buffer The line.
+ * @param log_record The address of a log record to fill in.
+ * @param log_context_count The address of the context count, updated.
+ * @param log_context_list The address of the context list, updated.
+ * @return The routine returns TRUE if the line was parsed, and FALSE if it was skipped.
+ * @see #Parse_Parameter_Lists
+ */
+static int TCS_Line_To_Record(char *line_buffer,struct Log_Record_Struct *log_record,
+			      int *log_context_count,struct Log_Context_Struct **log_context_list)
+{
+	char month_buff[4];
+	char time_buff[9];
+	char tcs_status_buff[16];
+	char verbosity_buff[128];
+	char sub_system_buff[128];
+	char message_buff[LINE_BUFFER_LENGTH];
+	int day_of_month,tcs_status_number,char_count;
+
+	char_count = 0;
+	if(sscanf(line_buffer,"%3s %2d %8s %127s %127s %x %n",month_buff,&day_of_month,time_buff,
+		  verbosity_buff,sub_system_buff,&tcs_status_number,&char_count) != 6)
+		return FALSE;
+	strcpy(message_buff,line_buffer+char_count);
+	Parse_Parameter_Lists(message_buff,log_context_list,log_context_count);
+	if(!Log_Create_Record("TCS",sub_system_buff,NULL,NULL,NULL,LOG_SEVERITY_INFO,LOG_VERBOSITY_INTERMEDIATE,
+			      NULL,message_buff,log_record))
+	{
+		Log_General_Error();
+		return FALSE;
+	}
+	sprintf(tcs_status_buff,"%#x",tcs_status_number);
+	if(!Log_Create_Context_List_Add(log_context_list,log_context_count,"TCS Status Code",tcs_status_buff))
+	{
+		Log_General_Error();
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * Parse TCS log message lines of the form:
+ * <pre>
+ * <<01>>ENABLED<<02>>DISABLED<<03>>OKAY<<04>>OKAY<<05>>FALSE<<06>>FALSE<<X>>
+ * </pre>
+ * into a list of contexts (01 = ENABLED), followed by a "Parameter Count" context, as tcs_to_udp does.
+ * Parsed parameters are removed from the message buffer.
+ * @param message_buff The message buffer part of the log message containing the parameter list.
+ * @param log_context_list The address of a pointer to a reallocatable list of Log_Context_Structs.
+ * @param log_context_count The address of an integer containing the number of contexts in log_context_list.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ */
+static int Parse_Parameter_Lists(char *message_buff,struct Log_Context_Struct **log_context_list,
+				 int *log_context_count)
+{
+	char keyword_string[LOG_CONTEXT_KEYWORD_LENGTH];
+	char value_string[LOG_CONTEXT_VALUE_LENGTH];
+	char *ch1 = NULL;
+	char *ch2 = NULL;
+	char *ch3 = NULL;
+	int string_length,parameter_count;
+
+	parameter_count = 0;
+	ch1 = strstr(message_buff,"<<");
+	while(ch1 != NULL)
+	{
+		ch2 = strstr(ch1+2,">>");
+		if(ch2 == NULL)
+			break;
+		ch3 = strstr(ch2+2,"<<");
+		if(ch3 == NULL)
+			break;
+		string_length = MIN((ch2-ch1)-2,LOG_CONTEXT_KEYWORD_LENGTH-1);
+		strncpy(keyword_string,ch1+2,string_length);
+		keyword_string[string_length] = '\0';
+		string_length = MIN((ch3-ch2)-2,LOG_CONTEXT_VALUE_LENGTH-1);
+		strncpy(value_string,ch2+2,string_length);
+		value_string[string_length] = '\0';
+		if(!Log_Create_Context_List_Add(log_context_list,log_context_count,keyword_string,value_string))
+			return FALSE;
+		parameter_count++;
+		/* remove keyword/value from message buff, the next start delimiter is now at ch1 */
+		memmove(ch1,ch3,strlen(ch3)+1);
+	}
+	sprintf(value_string,"%d",parameter_count);
+	if(!Log_Create_Context_List_Add(log_context_list,log_context_count,"Parameter Count",value_string))
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * Encode a record in each wire format, adding the packet lengths to Encoding_Byte_Count_List, and the time
+ * taken to Encoding_Time_List. The compressed encodings compress the version 2 packets, so their time is
+ * the version 2 encode time plus the compression time.
+ * The dictionary keeps it's state between records, as a handle's does.
+ * @param dictionary The string dictionary.
+ * @param log_record The log record.
+ * @param log_context_count The number of contexts.
+ * @param log_context_list The contexts.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Encoding_Byte_Count_List
+ * @see #Encoding_Time_List
+ * @see #Compress_Packet
+ */
+static int Encode_Record(Log_UDP_Dictionary_T dictionary,struct Log_Record_Struct *log_record,
+			 int log_context_count,struct Log_Context_Struct *log_context_list)
+{
+	struct timespec start_time,end_time;
+	char *message_buffer = NULL;
+	char *compressed_buffer = NULL;
+	size_t message_buffer_length,compressed_buffer_length,encoded_length,packet_length;
+	double encode_time;
+	int retval;
+
+	message_buffer_length = LOG_UDP_V2_BUFFER_LENGTH(log_context_count);
+	compressed_buffer_length = 3+LOG_UDP_VARINT_LENGTH+LOG_UDP_COMPRESS_BOUND(message_buffer_length);
+	message_buffer = (char *)malloc(message_buffer_length);
+	compressed_buffer = (char *)malloc(compressed_buffer_length);
+	if((message_buffer == NULL)||(compressed_buffer == NULL))
+	{
+		fprintf(stderr,"wire_size_benchmark:Encode_Record:Failed to allocate buffers.\n");
+		if(message_buffer != NULL)
+			free(message_buffer);
+		if(compressed_buffer != NULL)
+			free(compressed_buffer);
+		return FALSE;
+	}
+	/* v1 */
+	clock_gettime(CLOCK_MONOTONIC,&start_time);
+	retval = Log_UDP_Encode(log_record,log_context_count,log_context_list,message_buffer,
+				message_buffer_length,&encoded_length);
+	clock_gettime(CLOCK_MONOTONIC,&end_time);
+	Encoding_Byte_Count_List[0] += encoded_length;
+	Encoding_Time_List[0] += Time_Difference(start_time,end_time);
+	/* v2, and compressed */
+	if(retval)
+	{
+		clock_gettime(CLOCK_MONOTONIC,&start_time);
+		retval = Log_UDP_Encode_V2(log_record,log_context_count,log_context_list,NULL,NULL,message_buffer,
+					   message_buffer_length,&encoded_length);
+		clock_gettime(CLOCK_MONOTONIC,&end_time);
+		encode_time = Time_Difference(start_time,end_time);
+		Encoding_Byte_Count_List[1] += encoded_length;
+		Encoding_Time_List[1] += encode_time;
+	}
+	if(retval)
+	{
+		clock_gettime(CLOCK_MONOTONIC,&start_time);
+		retval = Compress_Packet(message_buffer,encoded_length,compressed_buffer,compressed_buffer_length,
+					 &packet_length);
+		clock_gettime(CLOCK_MONOTONIC,&end_time);
+		Encoding_Byte_Count_List[3] += packet_length;
+		Encoding_Time_List[3] += encode_time+Time_Difference(start_time,end_time);
+	}
+	/* v2 with dictionary, and compressed */
+	if(retval)
+	{
+		clock_gettime(CLOCK_MONOTONIC,&start_time);
+		retval = Log_UDP_Encode_V2(log_record,log_context_count,log_context_list,dictionary,NULL,
+					   message_buffer,message_buffer_length,&encoded_length);
+		Log_UDP_Dictionary_Packet_End(dictionary,retval);
+		clock_gettime(CLOCK_MONOTONIC,&end_time);
+		encode_time = Time_Difference(start_time,end_time);
+		Encoding_Byte_Count_List[2] += encoded_length;
+		Encoding_Time_List[2] += encode_time;
+	}
+	if(retval)
+	{
+		clock_gettime(CLOCK_MONOTONIC,&start_time);
+		retval = Compress_Packet(message_buffer,encoded_length,compressed_buffer,compressed_buffer_length,
+					 &packet_length);
+		clock_gettime(CLOCK_MONOTONIC,&end_time);
+		Encoding_Byte_Count_List[4] += packet_length;
+		Encoding_Time_List[4] += encode_time+Time_Difference(start_time,end_time);
+	}
+	free(message_buffer);
+	free(compressed_buffer);
+	return retval;
+}
+
+/**
+ * Compress a version 2 packet if it is at least Compression_Threshold bytes long, and return the length of
+ * the packet that would be sent: the compressed packet if it is shorter, otherwise the original.
+ * @param message_buffer The encoded version 2 packet.
+ * @param message_buffer_length The length of the packet in bytes.
+ * @param compressed_buffer The buffer to compress into.
+ * @param compressed_buffer_length The length of compressed_buffer in bytes.
+ * @param packet_length The address of a size_t, filled in with the length of the packet that would be sent.
+ * @return The routine returns TRUE on success and FALSE on failure.
+ * @see #Compression_Threshold
+ * @see ../cdocs/log_udp_wire.html#Log_UDP_Compress_V2
+ */
+static int Compress_Packet(char *message_buffer,size_t message_buffer_length,char *compressed_buffer,
+			   size_t compressed_buffer_length,size_t *packet_length)
+{
+	size_t compressed_length;
+
+	(*packet_length) = message_buffer_length;
+	if(message_buffer_length < (size_t)Compression_Threshold)
+		return TRUE;
+	if(!Log_UDP_Compress_V2(message_buffer,message_buffer_length,compressed_buffer,compressed_buffer_length,
+				&compressed_length))
+		return FALSE;
+	if(compressed_length < message_buffer_length)
+		(*packet_length) = compressed_length;
+	return TRUE;
+}
+
+/**
+ * Return the difference between two times in seconds.
+ * @param start_time The start time.
+ * @param end_time The end time.
+ * @return The difference in seconds.
+ * @see #ONE_SECOND_NS
+ */
+static double Time_Difference(struct timespec start_time,struct timespec end_time)
+{
+	return ((double)(end_time.tv_sec-start_time.tv_sec))+
+		(((double)(end_time.tv_nsec-start_time.tv_nsec))/((double)ONE_SECOND_NS));
+}
+
+/**
+ * Routine to parse command line arguments.
+ * @param argc The number of arguments sent to the program.
+ * @param argv An array of argument strings.
+ * @see #Help
+ * @see #Messages_Filename
+ * @see #TCS_Filename
+ * @see #Compression_Threshold
+ */
+static int Parse_Arguments(int argc, char *argv[])
+{
+	int i,retval;
+
+	for(i=1;i<argc;i++)
+	{
+		if(strcmp(argv[i],"-help")==0)
+		{
+			Help();
+			exit(0);
+		}
+		else if((strcmp(argv[i],"-messages")==0)||(strcmp(argv[i],"-m")==0))
+		{
+			if((i+1)<argc)
+			{
+				Messages_Filename = strdup(argv[i+1]);
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"wire_size_benchmark:Parse_Arguments:Messages requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if((strcmp(argv[i],"-tcs")==0)||(strcmp(argv[i],"-t")==0))
+		{
+			if((i+1)<argc)
+			{
+				TCS_Filename = strdup(argv[i+1]);
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"wire_size_benchmark:Parse_Arguments:TCS requires a filename.\n");
+				return FALSE;
+			}
+		}
+		else if(strcmp(argv[i],"-threshold")==0)
+		{
+			if((i+1)<argc)
+			{
+				retval = sscanf(argv[i+1],"%d",&Compression_Threshold);
+				if((retval != 1)||(Compression_Threshold < 0))
+				{
+					fprintf(stderr,"wire_size_benchmark:Parse_Arguments:"
+						"Failed to parse compression threshold '%s'.\n",argv[i+1]);
+					return FALSE;
+				}
+				i++;
+			}
+			else
+			{
+				fprintf(stderr,"wire_size_benchmark:Parse_Arguments:Threshold requires a number.\n");
+				return FALSE;
+			}
+		}
+		else
+		{
+			fprintf(stderr,"wire_size_benchmark:Parse_Arguments:argument '%s' not recognized.\n",argv[i]);
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * Help routine.
+ */
+static void Help(void)
+{
+	fprintf(stdout,"wire_size_benchmark help.\n");
+	fprintf(stdout,"wire_size_benchmark encodes each line of a /var/log/messages or TCS log file in each wire\n");
+	fprintf(stdout,"format, with and without compression, and prints the number of bytes each format would send\n");
+	fprintf(stdout,"and the time taken to encode.\n");
+	fprintf(stdout,"wire_size_benchmark -m[essages] <filename>|-t[cs] <filename> [-threshold <bytes>][-help]\n");
+}
+
+/*
+** $Log$
+*/